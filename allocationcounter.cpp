@@ -0,0 +1,125 @@
+#include "allocationcounter.h"
+
+#ifdef DRONES_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<quint64> allocationCount{0}; ///< Number of heap allocations.
+
+#if defined(__GLIBC__)
+
+// Qt containers (QString, QVector, QByteArray) allocate through QArrayData with
+// malloc/realloc, not operator new: the C allocator is replaced, and forwards to the
+// glibc implementation. Since the program defines these symbols, they are also used by
+// the shared libraries. operator new goes through malloc and is counted there.
+#define DRONES_COUNT_MALLOC
+
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *p, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+void *malloc(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);  // Growing a QVector in place is counted too
+    return __libc_realloc(p, size);
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void *memalign(std::size_t alignment, std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **result, std::size_t alignment, std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *result = p;
+    return 0;
+}
+}
+
+#endif
+
+/**
+ * @brief Allocate memory and count the allocation.
+ * @param size The size in bytes.
+ * @return The memory, or nullptr on failure.
+ */
+static void *countedAlloc(std::size_t size) {
+#ifndef DRONES_COUNT_MALLOC
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+#endif
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size) {
+    void *p = countedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t size) {
+    void *p = countedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+bool AllocationCounter::isEnabled() {
+    return true;
+}
+
+quint64 AllocationCounter::count() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled() {
+    return false;
+}
+
+quint64 AllocationCounter::count() {
+    return 0;
+}
+
+#endif
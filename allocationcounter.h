@@ -0,0 +1,36 @@
+/**
+ * @file allocationcounter.h
+ * @brief Counting of heap allocations, used to check the simulation loop.
+ *
+ * When the project is built with CONFIG+=alloc_check (which defines
+ * DRONES_COUNT_ALLOCATIONS), the global operator new is replaced by a version that
+ * counts the allocations, and with glibc so are malloc, calloc, realloc and the aligned
+ * allocators, through which the Qt containers allocate. Otherwise the counter is
+ * disabled and always returns 0.
+ *
+ * tools/alloccheck uses it to check that a steady-state simulation step does not
+ * allocate.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+namespace AllocationCounter {
+
+/**
+ * @brief Check if the allocations are counted in this build.
+ * @return True if the project was built with DRONES_COUNT_ALLOCATIONS.
+ */
+bool isEnabled();
+
+/**
+ * @brief Get the number of heap allocations made by the program, in all threads.
+ * @return The number of allocations (and reallocations) since the start of the program.
+ */
+quint64 count();
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,117 @@
+/**
+ * @file boundedqueue.h
+ * @brief Bounded lock-free queue with several producers and one consumer.
+ *
+ * This file declares the BoundedQueue class template, used to hand commands received
+ * by I/O threads to the simulation loop without locks.
+ */
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * @class BoundedQueue
+ * @brief Fixed-capacity ring of cells, each with a sequence number.
+ *
+ * Producers claim a position with a compare-and-swap on the enqueue counter, write the
+ * value in the cell and publish it through the sequence of the cell. The consumer
+ * reads the cells in order and gives them back by advancing their sequence by one
+ * lap. Neither side ever waits for the other: tryPush() fails when the queue is full
+ * and tryPop() fails when the next cell is not published yet.
+ *
+ * The cells are allocated once by the constructor, so pushing and popping do not
+ * allocate memory (besides what moving the values themselves does).
+ *
+ * @tparam T The type of the values, which must be default constructible and movable.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief Constructs an empty queue.
+     * @param capacity The maximum number of values, rounded up to a power of two.
+     */
+    explicit BoundedQueue(int capacity) {
+        std::size_t size = 2;
+        while (size < std::size_t(capacity)) {
+            size *= 2;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /**
+     * @brief Get the maximum number of values.
+     * @return The capacity.
+     */
+    inline int capacity() const { return int(mask + 1); }
+
+    /**
+     * @brief Add a value at the end of the queue (any thread).
+     * @param value The value, moved into the queue on success.
+     * @return False if the queue is full.
+     */
+    bool tryPush(T &value) {
+        std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells[position & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t lag = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+            if (lag == 0) {
+                // The cell is free for this lap: try to claim the position
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;  // The cell of the previous lap is not consumed yet: full
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);  // Another producer claimed it
+            }
+        }
+    }
+
+    /**
+     * @brief Take the value at the start of the queue (consumer thread only).
+     * @param value Receives the value.
+     * @return False if the queue is empty.
+     */
+    bool tryPop(T &value) {
+        Cell &cell = cells[dequeuePosition & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);  // Free for the next lap
+        dequeuePosition++;
+        return true;
+    }
+
+private:
+    /**
+     * @brief Cell of the ring, on its own cache line so that producers do not share lines.
+     */
+    struct alignas(64) Cell {
+        std::atomic<std::size_t> sequence; ///< Position that may use the cell next, + 1 once the value is published.
+        T value; ///< The value.
+    };
+
+    std::unique_ptr<Cell[]> cells; ///< The ring of cells.
+    std::size_t mask; ///< Capacity - 1.
+    alignas(64) std::atomic<std::size_t> enqueuePosition{0}; ///< Next position claimed by a producer.
+    alignas(64) std::size_t dequeuePosition = 0; ///< Next position read by the consumer.
+};
+
+#endif // BOUNDEDQUEUE_H
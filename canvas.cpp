@@ -7,8 +7,11 @@
  */
 
 #include "canvas.h"
+#include <QElapsedTimer>
 #include <QPainter>
-#include <QResizeEvent>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <cmath>
 
 /*!
  * @brief Constructor for the Canvas class.
@@ -17,42 +20,96 @@
 Canvas::Canvas(QWidget *parent) : QWidget{parent} {
     droneImg.load("../../media/drone.png"); // Load the drone image from the specified path.
     setMouseTracking(true); // Enable mouse tracking for interaction.
+    connect(&background, SIGNAL(tileReady()), this, SLOT(update()));  // Draw the tiles as they are computed
 }
 
 /*!
- * @brief Sets the list of servers and regenerates the Voronoi image.
+ * @brief Sets the list of servers, computes the Voronoi tiles again and shows the whole map.
  * @param servers The list of servers to display.
  */
 void Canvas::setServers(const QVector<Server> &servers) {
     this->servers = servers;
-    generateVoronoiImage(); // Regenerate the Voronoi diagram.
+    QVector<QRgb> colors;
+    colors.reserve(servers.size());
+    sites.resize(0);
+    for (const Server &server : servers) {
+        colors.append(server.getColor().rgb());
+        sites.append(server.getPosition());
+    }
+    background.setPalette(colors);
+    background.setSites(sites);
+    triangulate();
+    fitView();
     repaint(); // Trigger a repaint of the canvas.
 }
 
 /*!
- * @brief Generates the Voronoi diagram image for the current canvas size.
+ * @brief Triangulates the servers and sets their neighbours.
  */
-void Canvas::generateVoronoiImage() {
-    voronoiImage = QImage(size(), QImage::Format_ARGB32);
-    QPainter painter(&voronoiImage);
+void Canvas::triangulate() {
+    delaunay.build(sites, mapBounds());
+    for (int i = 0; i < servers.size(); i++) {
+        updateNeighbors(i);
+    }
+}
 
-    for (int x = 0; x < width(); ++x) {
-        for (int y = 0; y < height(); ++y) {
-            Vector2D point(x, y);
-            QColor color = Qt::white;
-            double minDistance = std::numeric_limits<double>::max();
+/*!
+ * @brief Sets the neighbours of a server from the triangulation.
+ * @param index The index of the server.
+ */
+void Canvas::updateNeighbors(int index) {
+    servers[index].clearServer();
+    for (int neighbor : delaunay.neighbors(index)) {
+        servers[index].addNeighbor(&servers[neighbor]);
+    }
+}
 
-            for (const Server &server : servers) {
-                double distance = (server.getPosition() - point).length();
-                if (distance < minDistance) {
-                    minDistance = distance;
-                    color = server.getColor();
-                }
-            }
+/*!
+ * @brief Moves a server and repairs the Voronoi cells around it.
+ *
+ * The pixels that change of cell are in the old cell of the server or in its new
+ * cell, so the cached tiles are only computed again in the union of their bounding
+ * boxes, and the pixels of the old cell are shared among its neighbours.
+ *
+ * @param index The index of the server.
+ * @param position The new position of the server.
+ */
+void Canvas::moveServer(int index, const Vector2D &position) {
+    if (index < 0 || index >= servers.size() || sites[index] == position) {
+        return;
+    }
+    const QVector<int> before = delaunay.neighbors(index);
+    QRectF area = delaunay.cellBounds(index);
+    servers[index].setPosition(position);
+    sites[index] = position;
+    if (delaunay.move(index, position)) {
+        background.moveSite(sites, index, before, area.united(delaunay.cellBounds(index)), delaunay.exactArea());
+    } else {
+        background.setSites(sites);  // Coincident servers, or a server far away: rare, computed in full
+    }
+    const QVector<int> after = delaunay.neighbors(index);
 
-            painter.setPen(color);
-            painter.drawPoint(x, y);
-        }
+    updateNeighbors(index);
+    for (int neighbor : before) {
+        updateNeighbors(neighbor);
+    }
+    for (int neighbor : after) {
+        updateNeighbors(neighbor);
+    }
+    update();
+}
+
+/*!
+ * @brief Moves the servers whose position changed in the simulation.
+ * @param updated The servers of the simulation, in the order given to setServers().
+ */
+void Canvas::updateServers(const QVector<Server> &updated) {
+    if (updated.size() != servers.size()) {
+        setServers(updated);
+        return;
+    }
+    for (int i = 0; i < updated.size(); i++) {
+        moveServer(i, updated[i].getPosition());
     }
 }
 
@@ -70,95 +127,508 @@ Server* Canvas::findServerByName(const QString &name) {
     return nullptr;
 }
 
+/*!
+ * @brief Gets the transform from the map to the surface.
+ * @return The transform.
+ */
+QTransform Canvas::Viewport::transform() const {
+    QTransform transform;
+    transform.scale(zoom, zoom);
+    transform.translate(-origin.x(), -origin.y());
+    return transform;
+}
+
+/*!
+ * @brief Gets the bounding box of the servers, with a margin of the collision distance.
+ * @return The area in world coordinates, empty if there is no server.
+ */
+QRectF Canvas::mapBounds() const {
+    if (sites.isEmpty()) {
+        return QRectF();
+    }
+    float left = sites[0].x, top = sites[0].y, right = left, bottom = top;
+    for (const Vector2D &site : sites) {
+        left = qMin(left, site.x);
+        top = qMin(top, site.y);
+        right = qMax(right, site.x);
+        bottom = qMax(bottom, site.y);
+    }
+    return QRectF(left, top, right - left, bottom - top).adjusted(-droneCollisionDistance, -droneCollisionDistance, droneCollisionDistance, droneCollisionDistance);
+}
+
+/*!
+ * @brief Shows the whole map: at the actual size if it fits in the canvas, else reduced to fit.
+ */
+void Canvas::fitView() {
+    const QRectF bounds = mapBounds();
+    if (bounds.isEmpty() || QRectF(rect()).contains(bounds)) {
+        resetView();
+        return;
+    }
+    zoom = qBound(minZoom, qMin(width() / bounds.width(), height() / bounds.height()), maxZoom);
+    viewOrigin = bounds.center() - QPointF(width(), height()) / (2 * zoom);
+    update();
+}
+
+/*!
+ * @brief Shows the map at the actual size (one pixel per world unit) from the origin.
+ */
+void Canvas::resetView() {
+    zoom = 1;
+    viewOrigin = QPointF();
+    update();
+}
+
 /**
  * @brief Handle the paint event (redraw the canvas)
  * @param event The paint event
  */
-void Canvas::paintEvent(QPaintEvent *) {
+void Canvas::paintEvent(QPaintEvent *event) {
+    QElapsedTimer paintTimer;  // Cost of the frame, for the quality governor
+    paintTimer.start();
     QPainter painter(this);  // Create a QPainter to draw on the canvas
+    drawScene(painter, widgetView(), event->rect(), false);
+    painter.end();
+    lastPaintTime = paintTimer.nsecsElapsed();
+}
+
+/*!
+ * @brief Renders the part of the map shown by the canvas into an image, independently of the widget.
+ *
+ * The visible area is scaled to the width of the image, and the missing Voronoi
+ * tiles are computed before drawing, so that the image is complete (video export).
+ * @param frame The image, of any size, in a format QPainter can draw on.
+ */
+void Canvas::renderFrame(QImage &frame) {
+    const Viewport view{viewOrigin, zoom * frame.width() / qMax(1, width()), frame.size()};
+    QPainter painter(&frame);
+    drawScene(painter, view, frame.rect(), true);
+}
+
+/*!
+ * @brief Draws the map, the servers and the drones on a surface.
+ * @param painter The painter of the surface, in surface pixels.
+ * @param view The part of the map drawn on the surface.
+ * @param exposed The part of the surface to draw, in surface pixels.
+ * @param complete True to compute the missing Voronoi tiles before drawing, false to queue them.
+ */
+void Canvas::drawScene(QPainter &painter, const Viewport &view, const QRect &exposed, bool complete) {
+    frameQuality = complete ? RenderGovernor::full : quality;  // Exported frames are not in a hurry
     QBrush whiteBrush(Qt::SolidPattern);  // White brush for the background
-    QPen penCol(Qt::DashDotDotLine);  // Pen for collision visualization
-    penCol.setColor(Qt::lightGray);
-    penCol.setWidth(3);
     whiteBrush.setColor(Qt::white);
-    painter.fillRect(0, 0, width(), height(), whiteBrush);  // Fill the background with white
+    painter.fillRect(0, 0, view.size.width(), view.size.height(), whiteBrush);  // Fill the background with white
+
+    // The map is drawn in world coordinates, in the exposed area only
+    const QTransform transform = view.transform();
+    const QRectF area = QRectF(view.origin + QPointF(exposed.topLeft()) / view.zoom, QSizeF(exposed.width() / view.zoom, exposed.height() / view.zoom));
+    painter.setTransform(transform);
+    background.draw(painter, area, view.zoom, complete);  // Draw the Voronoi cells, queuing or computing the missing tiles
 
-    painter.drawImage(0, 0, voronoiImage);  // Draw the Voronoi image
+    // Draw the traffic heatmap, one pixel per cell, over the Voronoi cells
+    if (heatmap && !heatmap->isEmpty()) {
+        painter.drawImage(heatmap->area(), heatmap->overlay());
+    }
 
-    painter.setRenderHint(QPainter::Antialiasing, true);  // Enable antialiasing for smooth rendering
+    painter.setRenderHint(QPainter::Antialiasing, frameQuality < RenderGovernor::noAntialiasing);  // Smooth rendering unless overloaded
 
-    // Draw each server
+    // Draw the no-fly zones in the exposed area
+    if (simulation) {
+        const NoFlyZones &zones = simulation->getNoFlyZones();
+        QPen zonePen(Qt::red, 2);
+        zonePen.setCosmetic(true);  // Same width at any zoom
+        painter.setPen(zonePen);
+        painter.setBrush(QColor(255, 0, 0, 48));  // Translucent, over the Voronoi cells
+        zones.query(area, [&](int zone) {
+            QPolygonF polygon;
+            for (const Vector2D &vertex : zones.polygon(zone)) {
+                polygon << QPointF(vertex.x, vertex.y);
+            }
+            painter.drawPolygon(polygon);
+        });
+    }
+
+    // Draw each server, at the same size at any zoom, with its label taking its place first
+    painter.resetTransform();
+    painter.setPen(Qt::black);  // Black outline and text
+    labelPlacer.begin(view.size);
     for (const Server &server : servers) {
-        Vector2D pos = server.getPosition();  // Server position
-        QString name = server.getName();  // Server name
+        QPointF pos = transform.map(QPointF(server.getPosition().x, server.getPosition().y));  // Server position on the canvas
 
         painter.setBrush(server.getColor());  // Server color
-        painter.setPen(Qt::black);  // Black outline
-        painter.drawEllipse(pos.x, pos.y, 12, 12);  // Draw a circle representing the server
-
-        painter.setPen(Qt::black);  // Black text
-        painter.setFont(QFont("Arial", 10, QFont::Bold));  // Bold font
-        painter.drawText(pos.x + 15, pos.y + 10, name);  // Display the server name
-    }
-
-    // Draw each drone
-    if (mapDrones) {
-        Vector2D p;
-        QRect rect(-droneIconSize / 2, -droneIconSize / 2, droneIconSize, droneIconSize);  // Rectangle for the drone icon
-        QRect rectCol(-droneCollisionDistance / 2, -droneCollisionDistance / 2, droneCollisionDistance, droneCollisionDistance);  // Rectangle for the collision zone
-
-        for (auto &drone : *mapDrones) {
-            painter.save();  // Save the painter state
-            painter.translate(drone->getPosition().x, drone->getPosition().y);  // Translate to the drone's position
-            painter.rotate(drone->getAzimut());  // Apply rotation based on the drone's azimuth
-            painter.drawImage(rect, droneImg);  // Draw the drone image
-
-            // Draw status indicators (LEDs) for the drone
-            if (drone->getStatus() != Drone::landed) {
-                painter.setPen(Qt::NoPen);
-                painter.setBrush(Qt::red);
-                painter.drawEllipse((-185.0 / 511.0) * droneIconSize, (-185.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize);
-                painter.drawEllipse((115.0 / 511.0) * droneIconSize, (-185.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize);
-                painter.setBrush(Qt::green);
-                painter.drawEllipse((-185.0 / 511.0) * droneIconSize, (115.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize);
-                painter.drawEllipse((115.0 / 511.0) * droneIconSize, (115.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize);
+        painter.drawEllipse(QRectF(pos.x(), pos.y(), 12, 12));  // Draw a circle representing the server
+
+        const QStaticText &label = serverLabels.label(server.getName());  // Shaped once
+        const QPointF labelPos(pos.x() + 15, pos.y() + 10 - serverLabels.ascent());  // Baseline 10 pixels below the server
+        painter.drawStaticText(labelPos, label);
+        labelPlacer.occupy(QRectF(labelPos, label.size()));
+    }
+
+    // Draw each drone, from the published buffer of the shared fleet if any
+    const Drone *first = nullptr, *last = nullptr;
+    quint32 sequence = 0;
+    int buffer = -1;
+    if (fleet) {
+        buffer = fleet->beginRead(sequence);
+        if (buffer < 0) {
+            update();  // The buffer is being published: draw the drones at the next frame
+        } else {
+            first = fleet->buffer(buffer);
+            last = first + fleet->droneCount();
+        }
+    } else if (simulation) {
+        first = simulation->getDrones().begin();
+        last = simulation->getDrones().end();
+    }
+    const Drone *selected = fleet || !simulation ? nullptr : simulation->getDrones().find(selectedDrone);
+    if (first != last) {
+        if (view.zoom * droneIconSize >= spriteMinSize) {
+            painter.setTransform(transform);
+            drawSprites(painter, first, last, selected, area);
+            if (droneLabelsShown) {
+                drawDroneLabels(painter, view);
             }
+        } else {
+            drawDensity(painter, view, first, last, selected);
+        }
+    }
+    if (buffer >= 0 && !fleet->endRead(buffer, sequence)) {
+        update();  // Torn frame: the buffer was reused while it was drawn, draw it again
+    }
+}
+
+/*!
+ * @brief Draws the drones in an area as icons, over their trails.
+ *
+ * The drones of the simulation are found with its spatial index, those of a shared
+ * fleet by a scan of the buffer.
+ *
+ * @param painter The painter, in world coordinates.
+ * @param first The first drone.
+ * @param last The end of the drones.
+ * @param selected The selected drone, or nullptr.
+ * @param area The world area to draw.
+ */
+void Canvas::drawSprites(QPainter &painter, const Drone *first, const Drone *last, const Drone *selected, const QRectF &area) {
+    const double margin = droneCollisionDistance / 2;  // The collision circle is the largest part of a drone
+    const QRectF reach = area.adjusted(-margin, -margin, margin, margin);
+    const DroneRegistry &drones = simulation->getDrones();
+    visibleDrones.resize(0);  // Keeps the capacity
+    visibleIds.resize(0);
+    if (fleet) {
+        for (const Drone *it = first; it != last; ++it) {
+            if (reach.contains(QPointF(it->getPosition().x, it->getPosition().y))) {
+                visibleDrones.append(it);
+                visibleIds.append(drones.idAt(int(it - first)));  // The buffer has the order of the registry
+            }
+        }
+    } else {
+        for (DroneId id : simulation->dronesInRect(reach)) {
+            visibleDrones.append(drones.find(id));
+            visibleIds.append(id);
+        }
+    }
+
+    if (trails) {
+        drawTrails(painter);
+    }
+    if (frameQuality >= RenderGovernor::pointMarkers) {
+        drawMarkers(painter, selected);
+        return;
+    }
+    for (const Drone *drone : visibleDrones) {
+        drawDrone(painter, *drone, drone == selected);
+    }
+}
+
+/*!
+ * @brief Draws the visible drones as points, in a single call (lowest quality).
+ * @param painter The painter, in world coordinates.
+ * @param selected The selected drone, or nullptr.
+ */
+void Canvas::drawMarkers(QPainter &painter, const Drone *selected) {
+    markers.resize(0);  // Keeps the capacity
+    for (const Drone *drone : visibleDrones) {
+        markers.append(QPointF(drone->getPosition().x, drone->getPosition().y));
+    }
+    QPen markerPen(QColor(16, 16, 64), 6);
+    markerPen.setCosmetic(true);  // Same size at any zoom
+    painter.setPen(markerPen);
+    painter.drawPoints(markers.constData(), markers.size());
+    if (selected) {
+        QPen selectedPen(Qt::blue, 3);
+        selectedPen.setCosmetic(true);
+        painter.setPen(selectedPen);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawEllipse(QPointF(selected->getPosition().x, selected->getPosition().y), droneIconSize / 2.0, droneIconSize / 2.0);
+    }
+}
 
-            // Draw the collision zone if a collision is detected
-            if (drone->hasCollision()) {
-                painter.setPen(penCol);
-                painter.setBrush(Qt::NoBrush);
-                painter.drawEllipse(rectCol);
+/*!
+ * @brief Draws the trails of the visible drones, one path per colour.
+ *
+ * A trail is drawn in a darker colour of the target server of its drone, and ends at
+ * the current position of the drone. The trails of the same colour are batched into
+ * a single path, so that the number of draw calls does not depend on the number of
+ * drones.
+ *
+ * @param painter The painter, in world coordinates.
+ */
+void Canvas::drawTrails(QPainter &painter) {
+    const int serverCount = servers.size();
+    trailPaths.resize(serverCount + 1);  // The last one for the drones without target
+    for (QPainterPath &path : trailPaths) {
+        path.clear();
+    }
+    for (int i = 0; i < visibleDrones.size(); i++) {
+        const Drone &drone = *visibleDrones[i];
+        const int target = drone.getTargetServer();
+        QPainterPath &path = trailPaths[target >= 0 && target < serverCount ? target : serverCount];
+        bool started = false;
+        const int count = trails->visit(visibleIds[i], [&path, &started](const Vector2D &point) {
+            if (started) {
+                path.lineTo(point.x, point.y);
+            } else {
+                path.moveTo(point.x, point.y);
+                started = true;
             }
-            painter.restore();  // Restore the painter state
+        });
+        if (count > 0) {
+            path.lineTo(drone.getPosition().x, drone.getPosition().y);
+        }
+    }
+
+    for (int i = 0; i <= serverCount; i++) {
+        if (trailPaths[i].isEmpty()) {
+            continue;
+        }
+        QColor color = i < serverCount ? servers[i].getColor().darker(150) : QColor(Qt::darkGray);
+        color.setAlpha(160);
+        QPen pen(color, 2);
+        pen.setCosmetic(true);  // Same width at any zoom
+        painter.strokePath(trailPaths[i], pen);
+    }
+}
+
+/*!
+ * @brief Draws the names of the visible drones where they do not overlap.
+ *
+ * The icons are obstacles, in addition to the server labels; each name is then put on
+ * the first free side of its drone, starting from the side of the previous frame.
+ * At most maxDroneLabels names are drawn.
+ *
+ * @param painter The painter.
+ * @param view The part of the map drawn on the surface.
+ */
+void Canvas::drawDroneLabels(QPainter &painter, const Viewport &view) {
+    const QTransform transform = view.transform();
+    const qreal radius = view.zoom * droneIconSize / 2;
+    painter.resetTransform();
+    for (const Drone *drone : visibleDrones) {
+        const QPointF pos = transform.map(QPointF(drone->getPosition().x, drone->getPosition().y));
+        labelPlacer.occupy(QRectF(pos.x() - radius, pos.y() - radius, 2 * radius, 2 * radius));
+    }
+
+    const DroneRegistry &drones = simulation->getDrones();
+    painter.setPen(Qt::black);
+    int placed = 0;
+    for (int i = 0; i < visibleDrones.size() && placed < maxDroneLabels; i++) {
+        const DroneId id = visibleIds[i];
+        const QPointF pos = transform.map(QPointF(visibleDrones[i]->getPosition().x, visibleDrones[i]->getPosition().y));
+        const QStaticText &label = droneLabels.label(drones.name(id));
+        QPointF labelPos;
+        if (labelPlacer.place((quint64(id.index) << 32) | id.generation, pos, label.size(), radius + 2, labelPos)) {
+            painter.drawStaticText(labelPos, label);
+            placed++;
         }
     }
 }
 
+/*!
+ * @brief Shows or hides the names of the drones drawn as icons.
+ * @param shown True to show the names.
+ */
+void Canvas::showDroneLabels(bool shown) {
+    droneLabelsShown = shown;
+    labelPlacer.clear();
+    update();
+}
+
+/*!
+ * @brief Draws the drones as the number of drones in each aggregation square.
+ *
+ * The drones are counted in squares of aggregateCell pixels, and each square is drawn
+ * darker as it holds more drones (on a logarithmic scale), in a single image.
+ *
+ * @param painter The painter, in surface pixels.
+ * @param view The part of the map drawn on the surface.
+ * @param first The first drone.
+ * @param last The end of the drones.
+ * @param selected The selected drone, or nullptr.
+ */
+void Canvas::drawDensity(QPainter &painter, const Viewport &view, const Drone *first, const Drone *last, const Drone *selected) {
+    const int columns = view.size.width() / aggregateCell + 1, rows = view.size.height() / aggregateCell + 1;
+    densityBins.fill(0, columns * rows);
+    const double scale = view.zoom / aggregateCell;
+    int peak = 0;
+    for (const Drone *it = first; it != last; ++it) {
+        const int column = int(std::floor((it->getPosition().x - view.origin.x()) * scale));
+        const int row = int(std::floor((it->getPosition().y - view.origin.y()) * scale));
+        if (column >= 0 && column < columns && row >= 0 && row < rows) {
+            peak = qMax(peak, ++densityBins[row * columns + column]);
+        }
+    }
+    if (peak == 0) {
+        return;
+    }
+
+    if (density.width() != columns || density.height() != rows) {
+        density = QImage(columns, rows, QImage::Format_ARGB32);
+    }
+    const double logPeak = std::log(1.0 + peak);
+    for (int row = 0; row < rows; row++) {
+        QRgb *out = reinterpret_cast<QRgb*>(density.scanLine(row));
+        const int *counts = densityBins.constData() + row * columns;
+        for (int column = 0; column < columns; column++) {
+            const int alpha = counts[column] == 0 ? 0 : 96 + int(159 * std::log(1.0 + counts[column]) / logPeak);
+            out[column] = qRgba(16, 16, 64, alpha);
+        }
+    }
+    painter.resetTransform();
+    painter.drawImage(QRect(0, 0, columns * aggregateCell, rows * aggregateCell), density);
+
+    // Highlight the selected drone
+    if (selected) {
+        const QPointF pos = view.transform().map(QPointF(selected->getPosition().x, selected->getPosition().y));
+        painter.setPen(QPen(Qt::blue, 3));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawEllipse(pos, 8.0, 8.0);
+    }
+}
+
+/*!
+ * @brief Draws the icon of a drone.
+ * @param painter The painter, in world coordinates.
+ * @param drone The drone.
+ * @param selected True if the drone is selected.
+ */
+void Canvas::drawDrone(QPainter &painter, const Drone &drone, bool selected) const {
+    QPen penCol(Qt::DashDotDotLine);  // Pen for collision visualization
+    penCol.setColor(Qt::lightGray);
+    penCol.setWidth(3);
+    QRect rect(-droneIconSize / 2, -droneIconSize / 2, droneIconSize, droneIconSize);  // Rectangle for the drone icon
+    QRect rectCol(-droneCollisionDistance / 2, -droneCollisionDistance / 2, droneCollisionDistance, droneCollisionDistance);  // Rectangle for the collision zone
+
+    painter.save();  // Save the painter state
+    painter.translate(drone.getPosition().x, drone.getPosition().y);  // Translate to the drone's position
+    if (frameQuality < RenderGovernor::unrotatedSprites) {
+        painter.rotate(drone.getAzimut());  // Apply rotation based on the drone's azimuth
+    }
+    painter.drawImage(rect, droneImg);  // Draw the drone image
+
+    // Draw status indicators (LEDs) for the drone
+    if (drone.getStatus() != Drone::landed && frameQuality < RenderGovernor::noRotorLights) {
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::red);
+        painter.drawEllipse((-185.0 / 511.0) * droneIconSize, (-185.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize);
+        painter.drawEllipse((115.0 / 511.0) * droneIconSize, (-185.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize, (65.0 / 511.0) * droneIconSize);
+        painter.setBrush(Qt::green);
+        painter.drawEllipse((-185.0 / 511.0) * droneIconSize, (115.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize);
+        painter.drawEllipse((115.0 / 511.0) * droneIconSize, (115.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize, (70.0 / 511.0) * droneIconSize);
+    }
+
+    // Highlight the selected drone
+    if (selected) {
+        painter.setPen(QPen(Qt::blue, 3));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawEllipse(rect);
+    }
+
+    // Draw the collision zone if a collision is detected
+    if (drone.hasCollision()) {
+        painter.setPen(penCol);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawEllipse(rectCol);
+    }
+    painter.restore();  // Restore the painter state
+}
+
 /*!
  * @brief Mouse press event handler for setting drone goals.
+ *
+ * The click is converted to the map. The right and middle buttons start dragging the
+ * map instead, also for a shared fleet.
  * @param event The mouse press event.
  */
 void Canvas::mousePressEvent(QMouseEvent *event) {
-    auto it = mapDrones->begin();
-    while (it != mapDrones->end() && (*it)->getStatus() != Drone::landed) {
-        ++it;
+    if (event->button() != Qt::LeftButton) {
+        panning = true;
+        panStart = event->pos();
+        return;
+    }
+    if (!simulation || fleet) {
+        return;
+    }
+    const QPointF world = toWorld(event->pos());
+    const Vector2D click(world.x(), world.y());
+    DroneRegistry &drones = simulation->getDrones();
+
+    // Hit test with the spatial index of the simulation rather than a scan of the fleet
+    const QVector<DroneId> hit = simulation->nearestDrones(click, 1);
+    const double reach = qMax(droneIconSize / 2.0, pickRadius / zoom);  // Icons, or points when zoomed out
+    if (!hit.isEmpty() && drones.find(hit.first())->getPosition().distanceSquared(click) <= reach * reach) {
+        selectedDrone = hit.first();
+        emit droneSelected(selectedDrone);
+        update();
+        return;
     }
-    if (it != mapDrones->end()) {
-        (*it)->setGoalPosition(Vector2D(event->pos().x(), event->pos().y()));
-        (*it)->start();
+
+    int i = 0;
+    while (i < drones.size() && drones[i].getStatus() != Drone::landed) {
+        i++;
+    }
+    if (i < drones.size()) {
+        drones[i].setGoalPosition(click);
+        simulation->start(drones.idAt(i));
     }
     repaint();
 }
 
 /*!
- * @brief Resize event handler to regenerate the Voronoi diagram.
- * @param event The resize event.
+ * @brief Mouse move event handler, dragging the map.
+ * @param event The mouse move event.
  */
-void Canvas::resizeEvent(QResizeEvent *event) {
-    QWidget::resizeEvent(event);
-    generateVoronoiImage();
-    repaint();
+void Canvas::mouseMoveEvent(QMouseEvent *event) {
+    if (!panning) {
+        return;
+    }
+    viewOrigin -= QPointF(event->pos() - panStart) / zoom;
+    panStart = event->pos();
+    update();
+}
+
+/*!
+ * @brief Mouse release event handler, ending the drag of the map.
+ * @param event The mouse release event.
+ */
+void Canvas::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) {
+        panning = false;
+    }
+}
+
+/*!
+ * @brief Wheel event handler, zooming around the cursor.
+ *
+ * The world position under the cursor stays under the cursor.
+ * @param event The wheel event.
+ */
+void Canvas::wheelEvent(QWheelEvent *event) {
+    const QPointF anchor = event->position();
+    const QPointF world = toWorld(anchor);
+    zoom = qBound(minZoom, zoom * std::pow(zoomStep, event->angleDelta().y() / 120.0), maxZoom);
+    viewOrigin = world - anchor / zoom;
+    event->accept();
+    update();
 }
 
 /*!
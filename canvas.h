@@ -18,15 +18,31 @@
 #include <QWidget>
 #include <QMouseEvent>
 #include <QPaintEvent>
+#include <QWheelEvent>
+#include <QTransform>
+#include <QPainterPath>
 #include <QVector>
 #include <QMap>
 #include "server.h"
 #include "voronoi.h"
-#include "drone.h"
+#include "delaunay.h"
+#include "tilepyramid.h"
+#include "trafficheatmap.h"
+#include "dronetrails.h"
+#include "labelcache.h"
+#include "rendergovernor.h"
+#include "simulation.h"
+#include "sharedfleet.h"
 
 /*!
  * @class Canvas
  * @brief A class to manage the graphical representation of an interactive map with drones and servers.
+ *
+ * The canvas shows a part of the map through a view transform (zoom and pan): the wheel
+ * zooms around the cursor and the right or middle button drags the map. The Voronoi
+ * cells are drawn from a TilePyramid, and only the drones in view are drawn; when their
+ * icons would be smaller than spriteMinSize pixels, the drones are drawn as a density
+ * of points instead.
  */
 class Canvas : public QWidget {
     Q_OBJECT
@@ -42,6 +58,41 @@ public:
      */
     const double droneCollisionDistance = droneIconSize * 1.5;
 
+    /*!
+     * @brief Smallest zoom factor (screen pixels per world unit), that of the coarsest tiles.
+     */
+    const double minZoom = 1.0 / (1 << TilePyramid::maxLevel);
+
+    /*!
+     * @brief Largest zoom factor (screen pixels per world unit).
+     */
+    const double maxZoom = 8;
+
+    /*!
+     * @brief Zoom factor of one step of the mouse wheel.
+     */
+    const double zoomStep = 1.25;
+
+    /*!
+     * @brief Size in screen pixels under which the drone icons are replaced by aggregated points.
+     */
+    const int spriteMinSize = 8;
+
+    /*!
+     * @brief Side in screen pixels of the squares in which the drones are aggregated.
+     */
+    const int aggregateCell = 3;
+
+    /*!
+     * @brief Distance in screen pixels under which a click hits a drone drawn as a point.
+     */
+    const int pickRadius = 4;
+
+    /*!
+     * @brief Maximum number of drone names drawn in a frame.
+     */
+    const int maxDroneLabels = 1000;
+
     /*!
      * @brief Constructor for the Canvas class.
      * @param parent Pointer to the parent widget (default is nullptr).
@@ -49,10 +100,30 @@ public:
     explicit Canvas(QWidget *parent = nullptr);
 
     /*!
-     * @brief Sets the map of drones identified by their names.
-     * @param map A map of "drone name" to "drone pointer".
+     * @brief Sets the simulation whose drones are displayed on the canvas.
+     * @param sim The simulation.
+     */
+    inline void setSimulation(Simulation *sim) { simulation = sim; }
+
+    /*!
+     * @brief Sets the shared fleet whose drones are displayed instead of those of the simulation.
+     *
+     * The drones are read in place from the published buffer, and the canvas is read-only.
+     * @param sharedFleet The shared fleet, or nullptr to display the simulation.
+     */
+    inline void setFleet(const SharedFleet *sharedFleet) { fleet = sharedFleet; }
+
+    /*!
+     * @brief Sets the traffic heatmap drawn over the Voronoi cells.
+     * @param map The heatmap, or nullptr to hide it.
      */
-    inline void setMap(QMap<QString, Drone*> *map) { mapDrones = map; }
+    inline void setHeatmap(TrafficHeatmap *map) { heatmap = map; update(); }
+
+    /*!
+     * @brief Sets the recent positions drawn behind the drones shown as icons.
+     * @param droneTrails The trails, indexed like the drones of the simulation, or nullptr to hide them.
+     */
+    inline void setTrails(const DroneTrails *droneTrails) { trails = droneTrails; update(); }
 
     /*!
      * @brief Handles the paint event to redraw the canvas.
@@ -62,10 +133,71 @@ public:
 
     /*!
      * @brief Handles mouse press events for drone interaction.
+     *
+     * A click on a drone selects it; elsewhere, it sends the first landed drone to the
+     * clicked position. The other buttons start dragging the map.
      * @param event The mouse press event.
      */
     void mousePressEvent(QMouseEvent *event) override;
 
+    /*!
+     * @brief Handles mouse move events, dragging the map.
+     * @param event The mouse move event.
+     */
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    /*!
+     * @brief Handles mouse release events, ending the drag of the map.
+     * @param event The mouse release event.
+     */
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    /*!
+     * @brief Handles wheel events, zooming around the cursor.
+     * @param event The wheel event.
+     */
+    void wheelEvent(QWheelEvent *event) override;
+
+    /*!
+     * @brief Sets the quality of the drawing of the widget (exported frames are always at full quality).
+     * @param level The quality.
+     */
+    inline void setQuality(RenderGovernor::Quality level) { quality = level; }
+
+    /*!
+     * @brief Gets the wall time of the last paint of the widget.
+     * @return The time in ns.
+     */
+    inline qint64 getLastPaintTime() const { return lastPaintTime; }
+
+    /*!
+     * @brief Converts a position of the canvas to the map.
+     * @param point The position in widget pixels.
+     * @return The position in world coordinates.
+     */
+    inline QPointF toWorld(const QPointF &point) const { return viewOrigin + point / zoom; }
+
+    /*!
+     * @brief Gets the part of the map shown by the canvas.
+     * @return The area in world coordinates.
+     */
+    inline QRectF visibleArea() const { return QRectF(viewOrigin, QSizeF(width() / zoom, height() / zoom)); }
+
+    /*!
+     * @brief Renders the part of the map shown by the canvas into an image, independently of the widget.
+     *
+     * The visible area is scaled to the width of the image, and the missing Voronoi
+     * tiles are computed before drawing, so that the image is complete (video export).
+     * @param frame The image, of any size, in a format QPainter can draw on.
+     */
+    void renderFrame(QImage &frame);
+
+    /*!
+     * @brief Gets the bounding box of the servers, with a margin of the collision distance.
+     * @return The area in world coordinates, empty if there is no server.
+     */
+    QRectF mapBounds() const;
+
     /*!
      * @brief Sets the list of servers displayed on the canvas.
      * @param servers A vector of server objects.
@@ -73,10 +205,23 @@ public:
     void setServers(const QVector<Server> &servers);
 
     /*!
-     * @brief Handles resize events and regenerates the Voronoi diagram.
-     * @param event The resize event.
+     * @brief Moves a server and repairs the Voronoi cells around it.
+     *
+     * The triangulation of the servers is repaired by local flips, and only the pixels
+     * of the bounding box of the old and new cells of the server are computed again.
+     * The repaired raster is not cached: a moving server rarely comes back to the same
+     * configuration.
+     *
+     * @param index The index of the server.
+     * @param position The new position of the server.
      */
-    void resizeEvent(QResizeEvent *event) override;
+    void moveServer(int index, const Vector2D &position);
+
+    /*!
+     * @brief Moves the servers whose position changed in the simulation.
+     * @param updated The servers of the simulation, in the order given to setServers().
+     */
+    void updateServers(const QVector<Server> &updated);
 
     /*!
      * @brief Finds a server by its name.
@@ -90,18 +235,148 @@ public:
      */
     void clearServers();
 
+public slots:
+    /*!
+     * @brief Shows the whole map: at the actual size if it fits in the canvas, else reduced to fit.
+     */
+    void fitView();
+
+    /*!
+     * @brief Shows the map at the actual size (one pixel per world unit) from the origin.
+     */
+    void resetView();
+
+    /*!
+     * @brief Shows or hides the names of the drones drawn as icons.
+     * @param shown True to show the names.
+     */
+    void showDroneLabels(bool shown);
+
 signals:
+    /*!
+     * @brief Emitted when the user clicks on a drone.
+     * @param id The handle of the drone.
+     */
+    void droneSelected(DroneId id);
 
 private:
-    QMap<QString, Drone*> *mapDrones = nullptr; ///< Map of drones identified by their names.
+    /*!
+     * @brief Part of the map drawn on a surface (the widget or an offscreen image).
+     */
+    struct Viewport {
+        QPointF origin; ///< World position of the top left corner of the surface.
+        double zoom; ///< Surface pixels per world unit.
+        QSize size; ///< Size of the surface in pixels.
+
+        /*!
+         * @brief Gets the transform from the map to the surface.
+         * @return The transform.
+         */
+        QTransform transform() const;
+    };
+
+    Simulation *simulation = nullptr; ///< Simulation of the drones.
+    const SharedFleet *fleet = nullptr; ///< Shared fleet of a multi-process simulation, displayed if set.
+    TrafficHeatmap *heatmap = nullptr; ///< Traffic heatmap drawn over the Voronoi cells, if set.
+    const DroneTrails *trails = nullptr; ///< Trails drawn behind the drone icons, if set.
+    QVector<const Drone*> visibleDrones; ///< Drones drawn as icons in the current frame, reused from one frame to the next.
+    QVector<DroneId> visibleIds; ///< Handles of the visible drones.
+    QVector<QPainterPath> trailPaths; ///< Trails of each target server colour, the last one without target.
+    LabelCache serverLabels{QFont("Arial", 10, QFont::Bold)}; ///< Shaped names of the servers.
+    LabelCache droneLabels{QFont("Arial", 8)}; ///< Shaped names of the drones.
+    LabelPlacer labelPlacer; ///< Places the names of the drones around the server labels and the icons.
+    bool droneLabelsShown = false; ///< True if the names of the drones are drawn.
+    RenderGovernor::Quality quality = RenderGovernor::full; ///< Quality of the drawing of the widget.
+    RenderGovernor::Quality frameQuality = RenderGovernor::full; ///< Quality of the surface being drawn.
+    qint64 lastPaintTime = 0; ///< Wall time of the last paint of the widget, in ns.
+    QVector<QPointF> markers; ///< Positions of the drones drawn as points, reused from one frame to the next.
     QImage droneImg; ///< Image representing the drone on the canvas.
+    DroneId selectedDrone; ///< Drone selected by a click, highlighted.
     QVector<Server> servers; ///< List of servers on the canvas.
-    QImage voronoiImage; ///< Precomputed Voronoi diagram image.
+    QVector<Vector2D> sites; ///< Positions of the servers, contiguous for the raster.
+    Delaunay delaunay; ///< Triangulation of the servers, giving their neighbours and the extent of their cells.
+    TilePyramid background; ///< Voronoi cells at every zoom level, computed on demand.
+    QPointF viewOrigin; ///< World position of the top left corner of the canvas.
+    double zoom = 1; ///< Screen pixels per world unit.
+    bool panning = false; ///< True while the map is dragged.
+    QPoint panStart; ///< Last cursor position of the drag.
+    QVector<int> densityBins; ///< Number of drones in each aggregation square, reused from one frame to the next.
+    QImage density; ///< Aggregated drones, one pixel per aggregation square.
+
+    /*!
+     * @brief Gets the part of the map shown by the widget.
+     * @return The viewport of the widget.
+     */
+    inline Viewport widgetView() const { return Viewport{viewOrigin, zoom, size()}; }
+
+    /*!
+     * @brief Draws the map, the servers and the drones on a surface.
+     * @param painter The painter of the surface, in surface pixels.
+     * @param view The part of the map drawn on the surface.
+     * @param exposed The part of the surface to draw, in surface pixels.
+     * @param complete True to compute the missing Voronoi tiles before drawing, false to queue them.
+     */
+    void drawScene(QPainter &painter, const Viewport &view, const QRect &exposed, bool complete);
+
+
+    /*!
+     * @brief Draws the drones in an area as icons, over their trails.
+     * @param painter The painter, in world coordinates.
+     * @param first The first drone.
+     * @param last The end of the drones.
+     * @param selected The selected drone, or nullptr.
+     * @param area The world area to draw.
+     */
+    void drawSprites(QPainter &painter, const Drone *first, const Drone *last, const Drone *selected, const QRectF &area);
+
+    /*!
+     * @brief Draws the visible drones as points, in a single call (lowest quality).
+     * @param painter The painter, in world coordinates.
+     * @param selected The selected drone, or nullptr.
+     */
+    void drawMarkers(QPainter &painter, const Drone *selected);
+
+    /*!
+     * @brief Draws the trails of the visible drones, one path per colour.
+     * @param painter The painter, in world coordinates.
+     */
+    void drawTrails(QPainter &painter);
+
+    /*!
+     * @brief Draws the names of the visible drones where they do not overlap.
+     * @param painter The painter.
+     * @param view The part of the map drawn on the surface.
+     */
+    void drawDroneLabels(QPainter &painter, const Viewport &view);
+
+    /*!
+     * @brief Draws the drones as the number of drones in each aggregation square.
+     * @param painter The painter, in surface pixels.
+     * @param view The part of the map drawn on the surface.
+     * @param first The first drone.
+     * @param last The end of the drones.
+     * @param selected The selected drone, or nullptr.
+     */
+    void drawDensity(QPainter &painter, const Viewport &view, const Drone *first, const Drone *last, const Drone *selected);
+
+    /*!
+     * @brief Draws the icon of a drone.
+     * @param painter The painter, in world coordinates.
+     * @param drone The drone.
+     * @param selected True if the drone is selected.
+     */
+    void drawDrone(QPainter &painter, const Drone &drone, bool selected) const;
+
+    /*!
+     * @brief Triangulates the servers and sets their neighbours.
+     */
+    void triangulate();
 
     /*!
-     * @brief Generates the Voronoi diagram image for the current set of servers.
+     * @brief Sets the neighbours of a server from the triangulation.
+     * @param index The index of the server.
      */
-    void generateVoronoiImage();
+    void updateNeighbors(int index);
 };
 
 #endif // CANVAS_H
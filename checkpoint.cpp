@@ -0,0 +1,143 @@
+#include "checkpoint.h"
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <cstring>
+
+/**
+ * @brief Round an offset up to a multiple of 64 bytes.
+ * @param offset The offset.
+ * @return The aligned offset.
+ */
+static quint64 align(quint64 offset) {
+    return (offset + 63) / 64 * 64;
+}
+
+/**
+ * @brief Save a snapshot to a checkpoint file.
+ * @param filePath The path of the file.
+ * @param snapshot The snapshot.
+ * @return True if the file was written successfully.
+ */
+bool Checkpoint::save(const QString &filePath, const SimulationSnapshot &snapshot) {
+    QByteArray names;
+    QDataStream out(&names, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << snapshot.names;
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = magic;
+    header.version = version;
+    header.recordSize = quint32(sizeof(Drone));
+    header.droneCount = quint32(snapshot.drones.size());
+    header.time = snapshot.time;
+    header.recordsOffset = align(sizeof(Header));
+    header.namesOffset = header.recordsOffset + quint64(snapshot.drones.size()) * sizeof(Drone);
+    header.namesSize = quint64(names.size());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not open file:" << filePath;
+        return false;
+    }
+    const QByteArray padding(int(header.recordsOffset - sizeof(Header)), '\0');
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(padding);
+    file.write(reinterpret_cast<const char*>(snapshot.drones.constData()), qint64(snapshot.drones.size()) * qint64(sizeof(Drone)));
+    file.write(names);
+    return file.commit();
+}
+
+/**
+ * @brief Load a snapshot from a checkpoint file.
+ * @param filePath The path of the file.
+ * @param snapshot Receives the snapshot.
+ * @return True if the file is a valid checkpoint of this program.
+ */
+bool Checkpoint::load(const QString &filePath, SimulationSnapshot &snapshot) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open file:" << filePath;
+        return false;
+    }
+    const quint64 size = quint64(file.size());
+    const uchar *data = size >= sizeof(Header) ? file.map(0, qint64(size)) : nullptr;
+    if (!data) {
+        qWarning() << "Invalid checkpoint file:" << filePath;
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    const quint64 recordsSize = quint64(header.droneCount) * sizeof(Drone);
+    // Offsets and sizes are compared with what is left of the file, so that a corrupt header cannot wrap around
+    if (header.magic != magic || header.version != version || header.recordSize != sizeof(Drone)
+        || header.recordsOffset % alignof(Drone) != 0 || header.recordsOffset > size || recordsSize > size - header.recordsOffset
+        || header.namesOffset < header.recordsOffset + recordsSize || header.namesOffset > size
+        || header.namesSize > size - header.namesOffset) {
+        qWarning() << "Invalid checkpoint file, or written by another build:" << filePath;
+        return false;
+    }
+
+    snapshot.time = header.time;
+    snapshot.drones.resize(int(header.droneCount));
+    std::memcpy(static_cast<void*>(snapshot.drones.data()), data + header.recordsOffset, recordsSize);
+
+    QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char*>(data + header.namesOffset), qsizetype(header.namesSize)));
+    in.setVersion(QDataStream::Qt_6_0);
+    snapshot.names.clear();
+    in >> snapshot.names;
+    if (in.status() != QDataStream::Ok || snapshot.names.size() != snapshot.drones.size()) {
+        qWarning() << "Invalid checkpoint file:" << filePath;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Constructs an idle writer.
+ */
+CheckpointWriter::CheckpointWriter() {}
+
+/**
+ * @brief Waits for the checkpoint being written, if any.
+ */
+CheckpointWriter::~CheckpointWriter() {
+    wait();
+}
+
+/**
+ * @brief Start saving a snapshot.
+ * @param filePath The path of the file.
+ * @param snapshot The snapshot, shared with the thread.
+ * @return False if the previous checkpoint is still being written.
+ */
+bool CheckpointWriter::start(const QString &filePath, const SimulationSnapshot &snapshot) {
+    if (isBusy()) {
+        return false;
+    }
+    thread.reset(QThread::create([filePath, snapshot]() {
+        Checkpoint::save(filePath, snapshot);
+    }));
+    thread->start();
+    return true;
+}
+
+/**
+ * @brief Check if a checkpoint is being written.
+ * @return True if the thread is running.
+ */
+bool CheckpointWriter::isBusy() const {
+    return thread && thread->isRunning();
+}
+
+/**
+ * @brief Wait for the checkpoint being written, if any.
+ */
+void CheckpointWriter::wait() {
+    if (thread) {
+        thread->wait();
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file checkpoint.h
+ * @brief Binary checkpoints of the state of a simulation.
+ *
+ * This file declares the Checkpoint functions, which save and restore a
+ * SimulationSnapshot, and the CheckpointWriter class, which saves snapshots on a
+ * background thread while the simulation goes on.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QString>
+#include <QThread>
+#include <memory>
+#include "simulation.h"
+
+/**
+ * @brief Saving and loading of checkpoint files.
+ *
+ * A checkpoint file starts with a Checkpoint::Header, followed by the drone records as
+ * they are in memory (aligned on 64 bytes), followed by the names of the drones
+ * (QDataStream). Loading maps the file and copies the records in one block, so that
+ * restoring a large fleet takes milliseconds.
+ *
+ * The records are stored in the layout of the program that wrote them: a checkpoint
+ * is only valid for the same build and the same scenario (flight models and servers),
+ * unlike scenario files, which are the interchange format.
+ */
+namespace Checkpoint {
+
+static constexpr quint32 magic = 0x504B4344; ///< Magic number of checkpoint files ("DCKP").
+static constexpr quint32 version = 2; ///< Version of the checkpoint format (2: landing slots in the drone records).
+static constexpr const char *suffix = "dck"; ///< File extension of checkpoint files.
+
+/**
+ * @brief Header of a checkpoint file.
+ */
+struct Header {
+    quint32 magic; ///< Checkpoint::magic.
+    quint32 version; ///< Checkpoint::version.
+    quint32 recordSize; ///< sizeof(Drone) of the program that wrote the file.
+    quint32 droneCount; ///< Number of drones.
+    double time; ///< Simulated time in seconds.
+    quint64 recordsOffset; ///< Offset of the drone records in the file.
+    quint64 namesOffset; ///< Offset of the names in the file.
+    quint64 namesSize; ///< Size of the names in bytes.
+};
+
+/**
+ * @brief Save a snapshot to a checkpoint file.
+ *
+ * The file is replaced atomically: a crash while saving keeps the previous checkpoint.
+ *
+ * @param filePath The path of the file.
+ * @param snapshot The snapshot.
+ * @return True if the file was written successfully.
+ */
+bool save(const QString &filePath, const SimulationSnapshot &snapshot);
+
+/**
+ * @brief Load a snapshot from a checkpoint file.
+ * @param filePath The path of the file.
+ * @param snapshot Receives the snapshot.
+ * @return True if the file is a valid checkpoint of this program.
+ */
+bool load(const QString &filePath, SimulationSnapshot &snapshot);
+
+} // namespace Checkpoint
+
+/**
+ * @class CheckpointWriter
+ * @brief Saves snapshots on a background thread.
+ *
+ * Only one checkpoint is written at a time: a checkpoint requested while the previous
+ * one is still being written is skipped, so that a slow disk never delays the
+ * simulation.
+ */
+class CheckpointWriter {
+public:
+    /**
+     * @brief Constructs an idle writer.
+     */
+    CheckpointWriter();
+
+    /**
+     * @brief Waits for the checkpoint being written, if any.
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    /**
+     * @brief Start saving a snapshot.
+     * @param filePath The path of the file.
+     * @param snapshot The snapshot, shared with the thread.
+     * @return False if the previous checkpoint is still being written.
+     */
+    bool start(const QString &filePath, const SimulationSnapshot &snapshot);
+
+    /**
+     * @brief Check if a checkpoint is being written.
+     * @return True if the thread is running.
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief Wait for the checkpoint being written, if any.
+     */
+    void wait();
+
+private:
+    std::unique_ptr<QThread> thread; ///< Thread writing the last checkpoint.
+};
+
+#endif // CHECKPOINT_H
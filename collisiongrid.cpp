@@ -0,0 +1,98 @@
+#include "collisiongrid.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Sort positions into the grid.
+ *
+ * The side of the cells is the collision distance, or larger when the drones are
+ * sparse, so that there are about as many cells as drones, and at most
+ * maxCellsPerSide cells per side.
+ *
+ * @param own The positions of the drones of the group.
+ * @param ownCount The number of positions in own.
+ * @param halo The positions of other drones near the group, may be nullptr.
+ * @param haloCount The number of positions in halo.
+ * @param range The collision distance, the minimum side of the cells.
+ */
+void CollisionGrid::build(const Vector2D *own, int ownCount, const Vector2D *halo, int haloCount, float range) {
+    const int count = ownCount + haloCount;
+    entries.resize(count);
+    positions.resize(count);
+    cellOf.resize(count);
+    if (ownCount == 0) {
+        columns = rows = 0;
+        cellStart.fill(0, 1);
+        return;  // No drone to update
+    }
+
+    auto position = [own, ownCount, halo](int i) -> const Vector2D & {
+        return i < ownCount ? own[i] : halo[i - ownCount];
+    };
+    Vector2D low = own[0], high = low;
+    for (int i = 1; i < count; i++) {
+        const Vector2D &p = position(i);
+        low = Vector2D(qMin(low.x, p.x), qMin(low.y, p.y));
+        high = Vector2D(qMax(high.x, p.x), qMax(high.y, p.y));
+    }
+    const float width = high.x - low.x, height = high.y - low.y;
+    const float cellSize = qMax(qMax(range, std::sqrt(width * height / count)), qMax(qMax(width, height) / maxCellsPerSide, 1e-3f));
+    origin = low;
+    inverseCellSize = 1 / cellSize;
+    columns = qMin(int(width * inverseCellSize) + 1, maxCellsPerSide);
+    rows = qMin(int(height * inverseCellSize) + 1, maxCellsPerSide);
+
+    // Counting sort by cell: sizes, then starts, then placement
+    const int cells = columns * rows;
+    cellStart.fill(0, cells + 1);
+    for (int i = 0; i < count; i++) {
+        int cell = cellAt(position(i));
+        cellOf[i] = cell;
+        cellStart[cell + 1]++;
+    }
+    for (int c = 0; c < cells; c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    for (int i = 0; i < count; i++) {
+        int slot = cellStart[cellOf[i]]++;
+        entries[slot] = i;
+        positions[slot] = position(i);
+    }
+    // Each start was moved to the start of the next cell: shift them back
+    std::copy_backward(cellStart.begin(), cellStart.end() - 1, cellStart.end());
+    cellStart[0] = 0;
+}
+
+/**
+ * @brief Get the positions of the drones in the cells around a drone of the group.
+ *
+ * The three cells of a row of the neighbourhood are contiguous in the sorted arrays.
+ *
+ * @param self The index of the drone in the own array given to build().
+ * @param result Receives the positions, without the one of the drone itself.
+ * @return The number of positions.
+ */
+int CollisionGrid::candidates(int self, QVector<Vector2D> &result) const {
+    result.clear();
+    const int cell = cellOf[self];
+    const int row = cell / columns, column = cell % columns;
+    const int first = qMax(column - 1, 0), last = qMin(column + 1, columns - 1);
+    for (int r = qMax(row - 1, 0); r <= qMin(row + 1, rows - 1); r++) {
+        const int end = cellStart[r * columns + last + 1];
+        for (int k = cellStart[r * columns + first]; k < end; k++) {
+            if (entries[k] != self) {
+                result.append(positions[k]);
+            }
+        }
+    }
+    return result.size();
+}
+
+/**
+ * @brief Get the memory used by the grid, which only grows with the number of drones.
+ * @return The capacity of the arrays of the grid, in bytes.
+ */
+std::size_t CollisionGrid::capacity() const {
+    return std::size_t(cellStart.capacity() + entries.capacity() + cellOf.capacity()) * sizeof(int)
+           + std::size_t(positions.capacity()) * sizeof(Vector2D);
+}
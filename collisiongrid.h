@@ -0,0 +1,81 @@
+/**
+ * @file collisiongrid.h
+ * @brief Uniform grid of the drones of a step, giving the candidates of the collision forces.
+ *
+ * This file declares the CollisionGrid class, which limits the collision test of a
+ * drone to the drones in the cells around it instead of all the drones of its group.
+ */
+
+#ifndef COLLISIONGRID_H
+#define COLLISIONGRID_H
+
+#include <QVector>
+#include "vector2d.h"
+
+/**
+ * @class CollisionGrid
+ * @brief Uniform grid of positions with cells at least as large as the collision distance.
+ *
+ * The grid is built from the positions of a group of drones (the drones updated by a
+ * thread) and from the positions of the drones near the group (the halo of a shard).
+ * Since the cells are at least as large as the collision distance, the drones closer
+ * than this distance to a drone of the group are in the 3 x 3 cells around its cell.
+ *
+ * Like DroneIndex, the positions are sorted by cell with a counting sort, and the
+ * arrays only grow, so that a step does not allocate once the fleet has been seen.
+ */
+class CollisionGrid {
+public:
+    /**
+     * @brief Constructs an empty grid.
+     */
+    CollisionGrid() {}
+
+    /**
+     * @brief Sort positions into the grid.
+     * @param own The positions of the drones of the group.
+     * @param ownCount The number of positions in own.
+     * @param halo The positions of other drones near the group, may be nullptr.
+     * @param haloCount The number of positions in halo.
+     * @param range The collision distance, the minimum side of the cells.
+     */
+    void build(const Vector2D *own, int ownCount, const Vector2D *halo, int haloCount, float range);
+
+    /**
+     * @brief Get the positions of the drones in the cells around a drone of the group.
+     * @param self The index of the drone in the own array given to build().
+     * @param result Receives the positions, without the one of the drone itself.
+     * @return The number of positions.
+     */
+    int candidates(int self, QVector<Vector2D> &result) const;
+
+    /**
+     * @brief Get the memory used by the grid, which only grows with the number of drones.
+     * @return The capacity of the arrays of the grid, in bytes.
+     */
+    std::size_t capacity() const;
+
+private:
+    /**
+     * @brief Get the cell of a position.
+     * @param p The position.
+     * @return The index of the cell, row by row, clamped to the grid.
+     */
+    inline int cellAt(const Vector2D &p) const {
+        return qBound(0, int((p.y - origin.y) * inverseCellSize), rows - 1) * columns
+               + qBound(0, int((p.x - origin.x) * inverseCellSize), columns - 1);
+    }
+
+    static constexpr int maxCellsPerSide = 1024; ///< Maximum number of columns (or rows) of the grid.
+
+    Vector2D origin; ///< Top left corner of the grid.
+    float inverseCellSize = 1; ///< 1 / side of a cell.
+    int columns = 0; ///< Number of columns of the grid.
+    int rows = 0; ///< Number of rows of the grid.
+    QVector<int> cellStart; ///< Start of each cell in entries, plus the end of the last cell.
+    QVector<int> entries; ///< Index of each position (own, then halo), cell after cell.
+    QVector<Vector2D> positions; ///< Positions, in the order of entries.
+    QVector<int> cellOf; ///< Cell of each position (own, then halo).
+};
+
+#endif // COLLISIONGRID_H
@@ -0,0 +1,95 @@
+#include "commandinput.h"
+#include <QFile>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDebug>
+#include <cstdio>
+
+/**
+ * @brief Constructs an input, not started yet.
+ * @param q The queue receiving the commands.
+ * @param name The name of the local socket to listen on, empty to read the standard input.
+ * @param parent The parent object.
+ */
+CommandInput::CommandInput(CommandQueue *q, const QString &name, QObject *parent)
+    : QThread(parent), queue(q), socketName(name) {}
+
+/**
+ * @brief Stops the thread.
+ *
+ * The local socket is served by the event loop of the thread, which is stopped. A
+ * blocking read of the standard input cannot be interrupted portably, so the thread
+ * is terminated if it does not end by itself.
+ */
+CommandInput::~CommandInput() {
+    requestInterruption();
+    quit();
+    if (!wait(100)) {
+        terminate();
+        wait();
+    }
+}
+
+/**
+ * @brief Parse a line and push its command into the queue.
+ * @param line The line, without its end of line.
+ */
+void CommandInput::push(const QByteArray &line) {
+    if (line.trimmed().isEmpty()) {
+        return;
+    }
+    DroneCommand command;
+    QString error;
+    if (!DroneCommand::fromJson(line, command, error)) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        qWarning() << "Invalid command:" << error << line;
+        return;
+    }
+    while (!queue->tryPush(command)) {
+        if (isInterruptionRequested()) {
+            return;
+        }
+        QThread::usleep(100);  // Full: wait for the simulation to drain the queue
+    }
+}
+
+/**
+ * @brief Read the commands until the source is closed or the thread is interrupted.
+ */
+void CommandInput::run() {
+    if (socketName.isEmpty()) {
+        QFile input;
+        if (!input.open(stdin, QIODevice::ReadOnly)) {
+            qWarning() << "Cannot read the commands from the standard input";
+            return;
+        }
+        while (!isInterruptionRequested()) {
+            QByteArray line = input.readLine();
+            if (line.isEmpty()) {
+                return;  // End of the input
+            }
+            push(line);
+        }
+        return;
+    }
+
+    // Serve the clients of the local socket with the event loop of this thread
+    QLocalServer server;
+    QLocalServer::removeServer(socketName);
+    if (!server.listen(socketName)) {
+        qWarning() << "Cannot listen for commands on" << socketName << ":" << server.errorString();
+        return;
+    }
+    connect(&server, &QLocalServer::newConnection, &server, [this, &server]() {
+        while (server.hasPendingConnections()) {
+            QLocalSocket *client = server.nextPendingConnection();
+            connect(client, &QLocalSocket::readyRead, client, [this, client]() {
+                while (client->canReadLine()) {
+                    push(client->readLine());
+                }
+            });
+            connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+        }
+    });
+    exec();
+}
@@ -0,0 +1,66 @@
+/**
+ * @file commandinput.h
+ * @brief I/O thread receiving drone commands as newline-delimited JSON.
+ *
+ * This file declares the CommandInput class, which reads commands from the standard
+ * input or from the clients of a local socket, and pushes them into a CommandQueue.
+ */
+
+#ifndef COMMANDINPUT_H
+#define COMMANDINPUT_H
+
+#include <QThread>
+#include <QString>
+#include <atomic>
+#include "dronecommand.h"
+
+/**
+ * @class CommandInput
+ * @brief Thread parsing the commands of one source and pushing them into a queue.
+ *
+ * Parsing is done on this thread, so that the simulation loop only applies ready
+ * commands. When the queue is full, the thread waits for the simulation to drain it:
+ * back pressure is applied to the source of the commands, never to the simulation.
+ * Several inputs can share the same queue.
+ */
+class CommandInput : public QThread {
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs an input, not started yet.
+     * @param queue The queue receiving the commands.
+     * @param socketName The name of the local socket to listen on, empty to read the standard input.
+     * @param parent The parent object.
+     */
+    CommandInput(CommandQueue *queue, const QString &socketName = QString(), QObject *parent = nullptr);
+
+    /**
+     * @brief Stops the thread.
+     */
+    ~CommandInput();
+
+    /**
+     * @brief Get the number of lines rejected because they are not valid commands.
+     * @return The number of invalid lines.
+     */
+    inline quint64 getRejectedCount() const { return rejected.load(std::memory_order_relaxed); }
+
+protected:
+    /**
+     * @brief Read the commands until the source is closed or the thread is interrupted.
+     */
+    void run() override;
+
+private:
+    /**
+     * @brief Parse a line and push its command into the queue.
+     * @param line The line, without its end of line.
+     */
+    void push(const QByteArray &line);
+
+    CommandQueue *queue; ///< Queue receiving the commands.
+    QString socketName; ///< Name of the local socket, empty for the standard input.
+    std::atomic<quint64> rejected{0}; ///< Number of invalid lines.
+};
+
+#endif // COMMANDINPUT_H
@@ -0,0 +1,392 @@
+#include "delaunay.h"
+#include <cmath>
+
+/**
+ * @brief Triangulate a set of sites.
+ * @param sites The positions of the sites.
+ * @param area An area where the sites may move, included in the enclosing triangle.
+ */
+void Delaunay::build(const QVector<Vector2D> &sites, const QRectF &area) {
+    siteCount = sites.size();
+    points.resize(siteCount + 3);
+    for (int i = 0; i < siteCount; i++) {
+        points[i] = Vector2Dd(sites[i]);
+    }
+    this->area = area;
+    enclose();
+    rebuild();
+}
+
+/**
+ * @brief Move a site and repair the triangulation around it.
+ *
+ * The site goes towards its new position by steps which keep it inside the polygon of
+ * its incident triangles, so that the triangulation stays valid, and the edges of
+ * these triangles are flipped after each step until they are Delaunay again. A step
+ * is halved until the site stays inside the polygon; the flips then give it a new
+ * polygon for the next step.
+ *
+ * @param site The index of the site.
+ * @param position The new position of the site.
+ * @return False if the triangulation had to be rebuilt (site leaving the enclosing triangle, or coincident sites).
+ */
+bool Delaunay::move(int site, const Vector2D &position) {
+    const Vector2Dd target(position);
+    if (isMovable(site) && bounds.contains(QPointF(target.x, target.y))) {
+        for (int s = 0; s < maxMoveSteps; s++) {
+            const Vector2Dd from = points[site];
+            if (from == target) {
+                return true;
+            }
+            collectStar(site, star);
+            Vector2Dd p = target;
+            bool inside = false;
+            for (int h = 0; h < maxStepHalvings && !inside; h++) {
+                if (h > 0) {
+                    p = from + std::ldexp(1.0, -h) * (target - from);
+                }
+                inside = true;
+                for (int k = 0; k < star.size() && inside; k++) {
+                    const Triangle &t = triangles[star[k]];
+                    int i = indexIn(t, site);
+                    inside = orient(p, points[t.v[(i + 1) % 3]], points[t.v[(i + 2) % 3]]) > 0;
+                }
+            }
+            if (!inside) {
+                break;  // Blocked on an edge of its polygon (another site on the way)
+            }
+            points[site] = p;
+            for (int t : star) {
+                pushEdges(t);
+            }
+            legalize();
+        }
+    }
+
+    // The site could not move locally
+    points[site] = target;
+    enclose();
+    rebuild();
+    return false;
+}
+
+/**
+ * @brief Get the sites whose Voronoi cells touch the cell of a site.
+ * @param site The index of the site.
+ * @return The indices of the neighbours, empty if the site is not in the triangulation.
+ */
+QVector<int> Delaunay::neighbors(int site) const {
+    QVector<int> result;
+    if (site < 0 || site >= siteCount || vertexTriangle[site] < 0) {
+        return result;
+    }
+    QVector<int> around;
+    collectStar(site, around);
+    for (int k : around) {
+        const Triangle &t = triangles[k];
+        int other = t.v[(indexIn(t, site) + 1) % 3];
+        if (other < siteCount) {
+            result.append(other);  // Not a vertex of the enclosing triangle
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Get the bounding box of the Voronoi cell of a site.
+ *
+ * The cell is the convex polygon of the circumcentres of the triangles around the site.
+ *
+ * @param site The index of the site.
+ * @return The bounding box, empty if the site is not in the triangulation.
+ */
+QRectF Delaunay::cellBounds(int site) const {
+    if (site < 0 || site >= siteCount || vertexTriangle[site] < 0) {
+        return QRectF();
+    }
+    QVector<int> around;
+    collectStar(site, around);
+    double left = points[site].x, right = left, top = points[site].y, bottom = top;
+    for (int k : around) {
+        const Triangle &t = triangles[k];
+        const Vector2Dd &a = points[t.v[0]];
+        const Vector2Dd b = points[t.v[1]] - a;
+        const Vector2Dd c = points[t.v[2]] - a;
+        double d = 2 * (b ^ c);
+        if (d == 0) {
+            continue;
+        }
+        double x = a.x + (c.y * b.lengthSquared() - b.y * c.lengthSquared()) / d;
+        double y = a.y + (b.x * c.lengthSquared() - c.x * b.lengthSquared()) / d;
+        left = qMin(left, x);
+        right = qMax(right, x);
+        top = qMin(top, y);
+        bottom = qMax(bottom, y);
+    }
+    return QRectF(left, top, right - left, bottom - top);
+}
+
+/**
+ * @brief Place the enclosing triangle around the area and the sites.
+ *
+ * The vertices of the triangle are twenty times the size of the area away, so that
+ * the sites can move in twice the area without leaving the triangle, and that no
+ * point of the area is nearer to them than to a site.
+ */
+void Delaunay::enclose() {
+    double left = area.left(), right = area.right(), top = area.top(), bottom = area.bottom();
+    for (int i = 0; i < siteCount; i++) {
+        left = qMin(left, points[i].x);
+        right = qMax(right, points[i].x);
+        top = qMin(top, points[i].y);
+        bottom = qMax(bottom, points[i].y);
+    }
+    const double cx = (left + right) / 2, cy = (top + bottom) / 2;
+    const double extent = qMax(qMax(right - left, bottom - top), 1.0);
+    bounds = QRectF(cx - 2 * extent, cy - 2 * extent, 4 * extent, 4 * extent);
+    points[siteCount] = Vector2Dd(cx - 20 * extent, cy - 20 * extent);
+    points[siteCount + 1] = Vector2Dd(cx + 20 * extent, cy - 20 * extent);
+    points[siteCount + 2] = Vector2Dd(cx, cy + 20 * extent);
+}
+
+/**
+ * @brief Triangulate the points again, from the enclosing triangle.
+ *
+ * The sites are inserted in the order of their indices, so that of two coincident
+ * sites, the first one is in the triangulation (like the nearest site of a pixel is
+ * the first one in VoronoiRaster).
+ */
+void Delaunay::rebuild() {
+    const int n = siteCount;
+    triangles.clear();
+    triangles.reserve(2 * n + 1);
+    triangles.append(Triangle{{n, n + 1, n + 2}, {-1, -1, -1}});
+    vertexTriangle.fill(-1, n + 3);
+    vertexTriangle[n] = vertexTriangle[n + 1] = vertexTriangle[n + 2] = 0;
+    last = 0;
+    hidden.clear();
+    for (int i = 0; i < n; i++) {
+        if (!insert(i)) {
+            hidden.append(i);
+        }
+    }
+}
+
+/**
+ * @brief Check if a site can move without rebuilding the triangulation.
+ *
+ * A hidden site has no triangles to move, and a site hiding another one must leave
+ * it in the triangulation at its place.
+ *
+ * @param site The index of the site.
+ * @return False if the site is hidden, or hides another site.
+ */
+bool Delaunay::isMovable(int site) const {
+    if (vertexTriangle[site] < 0) {
+        return false;
+    }
+    for (int h : hidden) {
+        if (points[h] == points[site]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Insert a point in the triangulation.
+ *
+ * The triangle containing the point is split in three, or the two triangles sharing
+ * the edge containing the point are split in two each, and the new edges are flipped
+ * until the triangulation is Delaunay.
+ *
+ * @param vertex The index of the point.
+ * @return False if the point is at the position of a vertex, and is not inserted.
+ */
+bool Delaunay::insert(int vertex) {
+    const Vector2Dd &p = points[vertex];
+    const int t = locate(p);
+    const Triangle tri = triangles[t];
+    int edge = -1, zeros = 0;
+    for (int i = 0; i < 3; i++) {
+        if (orient(points[tri.v[(i + 1) % 3]], points[tri.v[(i + 2) % 3]], p) == 0) {
+            edge = i;
+            zeros++;
+        }
+    }
+    if (zeros > 1) {
+        return false;  // On a vertex
+    }
+
+    const int a = tri.v[0], b = tri.v[1], c = tri.v[2];
+    if (edge < 0 || tri.adj[edge] < 0) {
+        // Inside: (a, b, p), (b, c, p) and (c, a, p)
+        const int t1 = triangles.size(), t2 = t1 + 1;
+        triangles[t] = Triangle{{a, b, vertex}, {t1, t2, tri.adj[2]}};
+        triangles.append(Triangle{{b, c, vertex}, {t2, t, tri.adj[0]}});
+        triangles.append(Triangle{{c, a, vertex}, {t, t1, tri.adj[1]}});
+        replaceNeighbor(tri.adj[0], t, t1);
+        replaceNeighbor(tri.adj[1], t, t2);
+        vertexTriangle[a] = vertexTriangle[b] = vertexTriangle[vertex] = t;
+        vertexTriangle[c] = t1;
+        pushEdges(t);
+        pushEdges(t1);
+        pushEdges(t2);
+    } else {
+        // On the edge between ea, eb and ec, and the triangle u on the other side (ed, ec, eb)
+        const int ea = tri.v[edge], eb = tri.v[(edge + 1) % 3], ec = tri.v[(edge + 2) % 3];
+        const int tB = tri.adj[(edge + 1) % 3], tC = tri.adj[(edge + 2) % 3];
+        const int u = tri.adj[edge];
+        const Triangle other = triangles[u];
+        const int j = other.adj[0] == t ? 0 : (other.adj[1] == t ? 1 : 2);
+        const int ed = other.v[j];
+        const int uC = other.adj[(j + 1) % 3], uB = other.adj[(j + 2) % 3];
+        const int t2 = triangles.size(), t4 = t2 + 1;
+        triangles[t] = Triangle{{ea, eb, vertex}, {u, t2, tC}};
+        triangles.append(Triangle{{ea, vertex, ec}, {t4, tB, t}});
+        triangles[u] = Triangle{{ed, vertex, eb}, {t, uC, t4}};
+        triangles.append(Triangle{{ed, ec, vertex}, {t2, u, uB}});
+        replaceNeighbor(tB, t, t2);
+        replaceNeighbor(uB, u, t4);
+        vertexTriangle[ea] = vertexTriangle[eb] = vertexTriangle[vertex] = t;
+        vertexTriangle[ec] = t2;
+        vertexTriangle[ed] = u;
+        pushEdges(t);
+        pushEdges(t2);
+        pushEdges(u);
+        pushEdges(t4);
+    }
+    legalize();
+    return true;
+}
+
+/**
+ * @brief Find the triangle containing a point, by walking from the last triangle found.
+ *
+ * The walk crosses the first edge which has the point on its other side; it reaches
+ * the triangle in a Delaunay triangulation. All the triangles are tested if it takes
+ * too long (rounding errors).
+ *
+ * @param p The point, inside the enclosing triangle.
+ * @return The index of the triangle.
+ */
+int Delaunay::locate(const Vector2Dd &p) {
+    int t = last < triangles.size() ? last : 0;
+    for (int steps = 0; steps < triangles.size(); steps++) {
+        const Triangle &tri = triangles[t];
+        int next = t;
+        for (int i = 0; i < 3 && next == t; i++) {
+            if (tri.adj[i] >= 0 && orient(points[tri.v[(i + 1) % 3]], points[tri.v[(i + 2) % 3]], p) < 0) {
+                next = tri.adj[i];
+            }
+        }
+        if (next == t) {
+            last = t;
+            return t;
+        }
+        t = next;
+    }
+    for (t = 0; t < triangles.size(); t++) {
+        const Triangle &tri = triangles[t];
+        if (orient(points[tri.v[0]], points[tri.v[1]], p) >= 0 && orient(points[tri.v[1]], points[tri.v[2]], p) >= 0
+            && orient(points[tri.v[2]], points[tri.v[0]], p) >= 0) {
+            break;
+        }
+    }
+    last = t < triangles.size() ? t : 0;
+    return last;
+}
+
+/**
+ * @brief Get the triangles around a vertex, counterclockwise.
+ * @param vertex The index of the vertex, which is not a vertex of the enclosing triangle.
+ * @param result Receives the indices of the triangles.
+ */
+void Delaunay::collectStar(int vertex, QVector<int> &result) const {
+    result.resize(0);
+    const int start = vertexTriangle[vertex];
+    int t = start;
+    do {
+        result.append(t);
+        const Triangle &tri = triangles[t];
+        t = tri.adj[(indexIn(tri, vertex) + 1) % 3];
+    } while (t != start && t >= 0 && result.size() <= triangles.size());
+}
+
+/**
+ * @brief Flip the edges waiting in the stack until they are all Delaunay.
+ *
+ * An edge is flipped if the vertex across it is inside the circumcircle of the
+ * triangle, and the four edges of the two new triangles are checked in turn. The
+ * number of flips is bounded in case rounding errors make nearly cocircular vertices
+ * flip back and forth.
+ */
+void Delaunay::legalize() {
+    int flips = 0;
+    const int maxFlips = 16 * triangles.size() + 64;
+    while (!pending.isEmpty() && flips < maxFlips) {
+        const int e = pending.takeLast();
+        const int t = e / 3, i = e % 3;
+        const Triangle tri = triangles[t];
+        const int u = tri.adj[i];
+        if (u < 0) {
+            continue;
+        }
+        const Triangle other = triangles[u];
+        const int j = other.adj[0] == t ? 0 : (other.adj[1] == t ? 1 : 2);
+        const int a = tri.v[i], b = tri.v[(i + 1) % 3], c = tri.v[(i + 2) % 3], d = other.v[j];
+        if (!inCircle(points[a], points[b], points[c], points[d])) {
+            continue;
+        }
+
+        // Replace the edge (b, c) by (a, d): triangles (a, b, d) and (a, d, c)
+        const int tB = tri.adj[(i + 1) % 3], tC = tri.adj[(i + 2) % 3];
+        const int uC = other.adj[(j + 1) % 3], uB = other.adj[(j + 2) % 3];
+        triangles[t] = Triangle{{a, b, d}, {uC, u, tC}};
+        triangles[u] = Triangle{{a, d, c}, {uB, tB, t}};
+        replaceNeighbor(uC, u, t);
+        replaceNeighbor(tB, t, u);
+        vertexTriangle[a] = vertexTriangle[b] = vertexTriangle[d] = t;
+        vertexTriangle[c] = u;
+        pushEdges(t);
+        pushEdges(u);
+        flips++;
+    }
+    pending.resize(0);
+}
+
+/**
+ * @brief Replace a neighbour of a triangle.
+ * @param t The index of the triangle, may be -1.
+ * @param from The index of the old neighbour.
+ * @param to The index of the new neighbour.
+ */
+void Delaunay::replaceNeighbor(int t, int from, int to) {
+    if (t < 0) {
+        return;
+    }
+    for (int &adj : triangles[t].adj) {
+        if (adj == from) {
+            adj = to;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Twice the signed area of a triangle.
+ * @return Positive if a, b, c are counterclockwise (in a frame with y upwards).
+ */
+double Delaunay::orient(const Vector2Dd &a, const Vector2Dd &b, const Vector2Dd &c) {
+    return (b - a) ^ (c - a);
+}
+
+/**
+ * @brief Check if a point is inside the circumcircle of a counterclockwise triangle.
+ * @return True if d is strictly inside the circle through a, b, c.
+ */
+bool Delaunay::inCircle(const Vector2Dd &a, const Vector2Dd &b, const Vector2Dd &c, const Vector2Dd &d) {
+    const Vector2Dd ad = a - d, bd = b - d, cd = c - d;
+    const double det = ad.lengthSquared() * (bd ^ cd) + bd.lengthSquared() * (cd ^ ad) + cd.lengthSquared() * (ad ^ bd);
+    return det > 0;
+}
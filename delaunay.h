@@ -0,0 +1,191 @@
+/**
+ * @file delaunay.h
+ * @brief Delaunay triangulation of the servers, repaired by local flips when a server moves.
+ *
+ * This file declares the Delaunay class, which gives the neighbours of the Voronoi
+ * cell of each server and the bounds of the cell, so that the cells can be updated
+ * locally when a server moves.
+ */
+
+#ifndef DELAUNAY_H
+#define DELAUNAY_H
+
+#include <QRectF>
+#include <QVector>
+#include "vector2d.h"
+
+/**
+ * @class Delaunay
+ * @brief Incremental Delaunay triangulation of a set of sites.
+ *
+ * The sites are inserted one by one in a triangle enclosing them all (three far away
+ * vertices, which are never the nearest vertex of a point of the area of the sites),
+ * and the triangulation is made Delaunay again after each insertion by edge flips.
+ *
+ * A site moves kinetically: as long as its new position stays in the polygon formed
+ * by its incident triangles, the position is changed in place and the edges around it
+ * are flipped until they are Delaunay again, which only touches the triangles near the
+ * site. Longer moves are split into such steps. Sites at the position of another site
+ * are not part of the triangulation (their cell is empty).
+ *
+ * The Voronoi cell of a site is the polygon of the circumcentres of its incident
+ * triangles, and its neighbours are the other ends of its incident edges.
+ */
+class Delaunay {
+public:
+    /**
+     * @brief Constructs an empty triangulation.
+     */
+    Delaunay() {}
+
+    /**
+     * @brief Triangulate a set of sites.
+     * @param sites The positions of the sites.
+     * @param area An area where the sites may move, included in the enclosing triangle.
+     */
+    void build(const QVector<Vector2D> &sites, const QRectF &area);
+
+    /**
+     * @brief Move a site and repair the triangulation around it.
+     * @param site The index of the site.
+     * @param position The new position of the site.
+     * @return False if the triangulation had to be rebuilt (site leaving the enclosing triangle, or coincident sites).
+     */
+    bool move(int site, const Vector2D &position);
+
+    /**
+     * @brief Get the sites whose Voronoi cells touch the cell of a site.
+     * @param site The index of the site.
+     * @return The indices of the neighbours, empty if the site is not in the triangulation.
+     */
+    QVector<int> neighbors(int site) const;
+
+    /**
+     * @brief Get the bounding box of the Voronoi cell of a site.
+     *
+     * The cells on the convex hull of the sites are bounded by the far away vertices,
+     * their box extends well beyond the area of the sites.
+     *
+     * @param site The index of the site.
+     * @return The bounding box, empty if the site is not in the triangulation.
+     */
+    QRectF cellBounds(int site) const;
+
+    /**
+     * @brief Get an area where the cells given by the triangulation are exact.
+     *
+     * Far from the sites, the far away vertices can be nearer than the sites, and the
+     * cells on the convex hull are cut there.
+     *
+     * @return The area, around the area given to build().
+     */
+    inline const QRectF &exactArea() const { return bounds; }
+
+    /**
+     * @brief Get the number of sites.
+     * @return The number of sites.
+     */
+    inline int size() const { return siteCount; }
+
+private:
+    /**
+     * @brief Triangle, counterclockwise.
+     */
+    struct Triangle {
+        int v[3]; ///< Vertices.
+        int adj[3]; ///< Triangle across the edge opposite each vertex, -1 on the enclosing triangle.
+    };
+
+    /**
+     * @brief Place the enclosing triangle around the area and the sites.
+     */
+    void enclose();
+
+    /**
+     * @brief Triangulate the points again, from the enclosing triangle.
+     */
+    void rebuild();
+
+    /**
+     * @brief Check if a site can move without rebuilding the triangulation.
+     * @param site The index of the site.
+     * @return False if the site is hidden, or hides another site.
+     */
+    bool isMovable(int site) const;
+
+    /**
+     * @brief Insert a point in the triangulation.
+     * @param vertex The index of the point.
+     * @return False if the point is at the position of a vertex, and is not inserted.
+     */
+    bool insert(int vertex);
+
+    /**
+     * @brief Find the triangle containing a point, by walking from the last triangle found.
+     * @param p The point.
+     * @return The index of the triangle.
+     */
+    int locate(const Vector2Dd &p);
+
+    /**
+     * @brief Get the triangles around a vertex, counterclockwise.
+     * @param vertex The index of the vertex.
+     * @param result Receives the indices of the triangles.
+     */
+    void collectStar(int vertex, QVector<int> &result) const;
+
+    /**
+     * @brief Flip the edges waiting in the stack until they are all Delaunay.
+     */
+    void legalize();
+
+    /**
+     * @brief Push the three edges of a triangle on the stack of legalize().
+     * @param t The index of the triangle.
+     */
+    inline void pushEdges(int t) { pending << t * 3 << t * 3 + 1 << t * 3 + 2; }
+
+    /**
+     * @brief Replace a neighbour of a triangle.
+     * @param t The index of the triangle, may be -1.
+     * @param from The index of the old neighbour.
+     * @param to The index of the new neighbour.
+     */
+    void replaceNeighbor(int t, int from, int to);
+
+    /**
+     * @brief Get the index of a vertex in a triangle.
+     * @param t The triangle.
+     * @param vertex The index of the vertex.
+     * @return 0, 1 or 2.
+     */
+    static inline int indexIn(const Triangle &t, int vertex) { return t.v[0] == vertex ? 0 : (t.v[1] == vertex ? 1 : 2); }
+
+    /**
+     * @brief Twice the signed area of a triangle.
+     * @return Positive if a, b, c are counterclockwise (in a frame with y upwards).
+     */
+    static double orient(const Vector2Dd &a, const Vector2Dd &b, const Vector2Dd &c);
+
+    /**
+     * @brief Check if a point is inside the circumcircle of a counterclockwise triangle.
+     * @return True if d is strictly inside the circle through a, b, c.
+     */
+    static bool inCircle(const Vector2Dd &a, const Vector2Dd &b, const Vector2Dd &c, const Vector2Dd &d);
+
+    static constexpr int maxMoveSteps = 64; ///< Maximum number of steps of a kinetic move before rebuilding.
+    static constexpr int maxStepHalvings = 20; ///< Maximum number of halvings of a step to keep the site in its polygon.
+
+    QVector<Vector2Dd> points; ///< Positions of the sites, then of the three vertices of the enclosing triangle.
+    QVector<Triangle> triangles; ///< Triangles.
+    QVector<int> vertexTriangle; ///< A triangle incident to each point, -1 if the point is not in the triangulation.
+    QVector<int> pending; ///< Edges to check by legalize(), as triangle * 3 + opposite vertex.
+    QVector<int> star; ///< Scratch list of the triangles around a vertex.
+    QVector<int> hidden; ///< Sites not in the triangulation (at the position of another site).
+    QRectF area; ///< Area where the sites may move, given to build().
+    QRectF bounds; ///< Area enclosed by the enclosing triangle with a margin, where moves are local.
+    int siteCount = 0; ///< Number of sites.
+    int last = 0; ///< Last triangle found by locate(), start of the next walk.
+};
+
+#endif // DELAUNAY_H
@@ -1,190 +1,227 @@
 #include "drone.h"
-#include <QPainter>
-#include <QStyle>
-#include <QDebug>
+#include <cstring>
 
 /**
  * @brief Constructor for the Drone class
- * @param n The name of the drone
- * @param parent The parent widget
+ * @param modelIndex The index of the flight model profile in the simulation
+ * @param model The flight model profile
  */
-Drone::Drone(const QString &n, QWidget *parent)
-    : QWidget{parent}, name(n) {
+Drone::Drone(int modelIndex, const FlightModel &model) {
     status = landed;  // Initialize the drone's status to "landed"
+    height = 0;  // The drone is on the ground
     speed = 0;  // Initial speed is 0
-    power = maxPower / 2.0;  // Initial power is half of the maximum power
+    speedSetpoint = model.maxSpeed;  // No speed limitation
+    power = model.maxPower / 2.0;  // Initial power is half of the maximum power
     V.set(0, 0);  // Initialize the velocity vector to 0
     ForceCollision.set(0, 0);  // Initialize the collision force to 0
     position = Vector2D(50, 50);  // Initial position of the drone
     goalPosition = Vector2D(550, 600);  // Initial target position
     showCollision = false;  // No collision detected initially
     azimut = 0;  // Initial angle is 0
+    targetServer = -1;  // No target server
+    flightModel = quint16(modelIndex);
+    clearance = unscheduled;  // No landing slot asked
+    pad = 0;
+    phaseStart = 0;  // The drone starts charging at the beginning of the simulation
+    phase = 0;
+}
 
-    // Initialize progress bars for speed and power
-    speedPB = new QProgressBar(this);
-    speedPB->setValue(speed);
-    speedPB->setMaximum(maxSpeed);
-    speedPB->setMinimum(0);
-    speedPB->setFormat(name + " speed %p%");
-    speedPB->setAlignment(Qt::AlignCenter);
-
-    powerPB = new QProgressBar(this);
-    powerPB->setValue(power);
-    powerPB->setMaximum(maxPower);
-    powerPB->setMinimum(0);
-    powerPB->setFormat("power %p%");
-    powerPB->setAlignment(Qt::AlignCenter);
-
-    setBaseSize(barSpace + compasSize, 2 * compasSize);  // Set the base size of the widget
-    setMinimumHeight(2 * compasSize);  // Set the minimum height
-    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);  // Set the size policy
-
-    // Load images for the drone's UI
-    compasImg.load("../../media/compas.png");
-    stopImg.load("../../media/stop.png");
-    takeoffImg.load("../../media/takeoff.png");
-    landingImg.load("../../media/landing.png");
+/**
+ * @brief Make the drone takeoff to move to a target position
+ *
+ * The charge accumulated while landed is added to the power before the takeoff starts.
+ *
+ * @param model The flight model profile of the drone
+ * @param time The current simulated time
+ */
+void Drone::start(const FlightModel &model, double time) {
+    if (status != landed) {
+        return;
+    }
+    power = powerAt(model, time);
+    status = takeoff;
+    height = 0;
+    beginPhase(time);
 }
 
 /**
- * @brief Destructor for the Drone class
+ * @brief Ask for landing
+ * @param model The flight model profile of the drone
+ * @param time The current simulated time
  */
-Drone::~Drone() {
-    delete speedPB;  // Free the memory of the speed progress bar
-    delete powerPB;  // Free the memory of the power progress bar
+void Drone::stop(const FlightModel &model, double time) {
+    if (status == landed || status == landing) {
+        return;
+    }
+    power = powerAt(model, time);
+    height = getHeight(model, time);
+    speed = 0;
+    V.set(0, 0);
+    status = landing;
+    beginPhase(time);
 }
 
 /**
- * @brief Handle the paint event (redraw the drone)
- * @param event The paint event
+ * @brief Get the power of the drone at a given time
+ *
+ * The battery charges while landed and discharges linearly during takeoff and landing.
+ *
+ * @param model The flight model profile of the drone
+ * @param time The simulated time
+ * @return The power, in the unit of FlightModel::maxPower
  */
-void Drone::paintEvent(QPaintEvent *) {
-    QPainter painter(this);
-    QBrush whiteBrush(Qt::SolidPattern);
-    whiteBrush.setColor(Qt::white);
-    QRect rect(0, 0, compasSize, compasSize);
+double Drone::powerAt(const FlightModel &model, double time) const {
+    double elapsed = time - phaseStart;
+    if (status == landed) {
+        double charged = power + elapsed * model.chargingSpeed;  // Charge the drone's battery
+        return charged > model.maxPower ? model.maxPower : charged;
+    }
+    if (status == takeoff || status == landing) {
+        return power - elapsed * model.powerConsumption;  // Consume power
+    }
+    return power;
+}
 
-    // Draw the image corresponding to the drone's status
-    switch (status) {
-    case landed: painter.drawImage(rect, stopImg); break;
-    case takeoff: painter.drawImage(rect, takeoffImg); break;
-    case landing: painter.drawImage(rect, landingImg); break;
-    default : {
-        painter.drawImage(rect, compasImg);
-        QPointF *points = new QPointF[3];
-        points[0] = QPointF(-compasSize / 5.0, 0);
-        points[1] = QPointF(compasSize / 5.0, 0);
-        points[2] = QPointF(0, compasSize / 2.2);
-        painter.save();
-        painter.translate(compasSize / 2.0, compasSize / 2.0);
-        painter.rotate(azimut);
-        painter.setBrush(Qt::white);
-        painter.setPen(Qt::black);
-        painter.drawPolygon(points, 3);
-        painter.setBrush(Qt::red);
-        painter.rotate(180);
-        painter.drawPolygon(points, 3);
-        painter.restore();
+/**
+ * @brief Get the height of the drone
+ * @param model The flight model profile of the drone
+ * @param time The current simulated time
+ * @return The height in units
+ */
+double Drone::getHeight(const FlightModel &model, double time) const {
+    double elapsed = time - phaseStart;
+    if (status == takeoff) {
+        double h = height + elapsed * model.takeoffSpeed;  // Increase the drone's height
+        return h > model.hoveringHeight ? model.hoveringHeight : h;
     }
+    if (status == landing) {
+        double h = height - elapsed * model.takeoffSpeed;  // Decrease the drone's height
+        return h < 0 ? 0 : h;
     }
+    return height;
 }
 
 /**
- * @brief Handle the resize event
- * @param event The resize event
+ * @brief Get the time at which the current analytic phase ends
+ *
+ * A landed drone is fully charged, a drone taking off reaches the hovering height
+ * unless its power gets too low first, and a landing drone touches down.
+ *
+ * @param model The flight model profile of the drone
+ * @return The simulated time of the end of the phase, or infinity if no event is expected
  */
-void Drone::resizeEvent(QResizeEvent *) {
-    QRect rect(compasSize + 5, 0, width() - compasSize - 5, compasSize / 2);
-    speedPB->setGeometry(rect);  // Resize the speed progress bar
-    rect.setRect(compasSize + 5, compasSize / 2, width() - compasSize - 5, compasSize / 2);
-    powerPB->setGeometry(rect);  // Resize the power progress bar
+double Drone::nextEventTime(const FlightModel &model) const {
+    const double never = std::numeric_limits<double>::infinity();
+    switch (status) {
+    case landed:
+        return power < model.maxPower ? phaseStart + (model.maxPower - power) / model.chargingSpeed : never;
+    case takeoff: {
+        double hover = phaseStart + (model.hoveringHeight - height) / model.takeoffSpeed;
+        double low = model.powerConsumption > 0 ? phaseStart + (power - lowPowerThreshold(model)) / model.powerConsumption : never;
+        return low < hover ? low : hover;
+    }
+    case landing:
+        return phaseStart + height / model.takeoffSpeed;
+    default:
+        return never;
+    }
 }
 
 /**
- * @brief Update the drone's state
- * @param dt The time elapsed since the last update
+ * @brief End the current analytic phase at the time given by nextEventTime()
+ * @param model The flight model profile of the drone
+ * @param time The simulated time of the event
+ * @return The event that ended the phase
  */
-void Drone::update(double dt) {
+Drone::phaseEvent Drone::endPhase(const FlightModel &model, double time) {
+    double newPower = powerAt(model, time);
     if (status == landed) {
-        power += dt * chargingSpeed;  // Charge the drone's battery
-        if (power > maxPower) {
-            power = maxPower;
-        }
-        powerPB->setValue(power);  // Update the power progress bar
-        repaint();  // Redraw the drone
-        return;
+        power = newPower;
+        beginPhase(time);
+        return fullyCharged;
     }
-
     if (status == takeoff) {
-        height += dt * takeoffSpeed;  // Increase the drone's height
-        if (height >= hoveringHeight) {
-            height = hoveringHeight;
-            status = hovering;  // Switch to "hovering" mode
-        }
-        power -= dt * powerConsumption;  // Consume power
-        if (power < 20 + powerConsumption / takeoffSpeed) {
-            status = landing;  // Switch to "landing" mode if power is too low
+        double hover = phaseStart + (model.hoveringHeight - height) / model.takeoffSpeed;
+        power = newPower;
+        if (time < hover) {
+            height = getHeight(model, time);
             speed = 0;
+            status = landing;  // Switch to "landing" mode if power is too low
+            beginPhase(time);
+            return lowPower;
         }
-        powerPB->setValue(power);  // Update the power progress bar
-        repaint();  // Redraw the drone
-        return;
-    }
-
-    if (status == landing) {
-        height -= dt * takeoffSpeed;  // Decrease the drone's height
-        if (height <= 0) {
-            height = 0;
-            status = landed;  // Switch to "landed" mode
-            showCollision = false;  // Reset collision detection
-        }
-        power -= dt * powerConsumption;  // Consume power
-        powerPB->setValue(power);  // Update the power progress bar
-        repaint();  // Redraw the drone
-        return;
+        height = model.hoveringHeight;
+        status = hovering;  // Switch to "hovering" mode
+        beginPhase(time);
+        return hoverReached;
     }
+    // Landing
+    power = newPower;
+    height = 0;
+    status = landed;  // Switch to "landed" mode
+    showCollision = false;  // Reset collision detection
+    beginPhase(time);
+    return touchedDown;
+}
 
+/**
+ * @brief Update the drone's state during a flight phase
+ * @param model The flight model profile of the drone
+ * @param method The method used to integrate the motion
+ * @param time The simulated time at the start of the update
+ * @param dt The time elapsed since the last update
+ */
+template<typename Model>
+void Drone::update(const Model &model, Integrator::Method method, double time, double dt) {
     if (status >= hovering) {
         Vector2D toGoal = goalPosition - position;  // Vector to the target position
         double distance = toGoal.length();  // Distance to the target
 
-        double damp = 1 - dt * (1 - damping);  // Calculate the damping factor
-        V = damp * V + ((maxPower * dt / distance) * toGoal) + dt * ForceCollision;  // Update the velocity
-        position += dt * V;  // Update the position
+        if (clearance == holding && distance < 1.0 && ForceCollision.lengthSquared() == 0) {
+            V.set(0, 0);  // On its hold point and not pushed: hover in place
+        } else {
+            Integrator::integrate(method, model, position, V, goalPosition, ForceCollision, dt);  // Update the velocity and the position
+        }
         speed = V.length();  // Update the speed
-        Vector2D Vn = (1.0 / speed) * V;  // Normalized velocity vector
 
-        // Calculate the azimuth based on the drone's direction
-        if (Vn.y == 0) {
-            if (Vn.x > 0) {
-                azimut = -90;
+        // Calculate the azimuth based on the drone's direction, kept while the drone does not move
+        if (speed > 0) {
+            Vector2D Vn = (1.0 / speed) * V;  // Normalized velocity vector
+            if (Vn.y == 0) {
+                if (Vn.x > 0) {
+                    azimut = -90;
+                } else {
+                    azimut = 90.0;
+                }
+            } else if (Vn.y > 0) {
+                azimut = 180.0 - 180.0 * atan(Vn.x / Vn.y) / M_PI;
             } else {
-                azimut = 90.0;
+                azimut = -180.0 * atan(Vn.x / Vn.y) / M_PI;
             }
-        } else if (Vn.y > 0) {
-            azimut = 180.0 - 180.0 * atan(Vn.x / Vn.y) / M_PI;
-        } else {
-            azimut = -180.0 * atan(Vn.x / Vn.y) / M_PI;
         }
 
-        // If the drone is close to the target and at low speed, switch to "landing" mode
-        if (toGoal.length() < 1.0 && speed < 10) {
+        // If the drone is close to the target and at low speed, switch to "landing" mode, unless it waits for a pad
+        if (distance < 1.0 && speed < 10 && clearance != holding) {
             V.set(0, 0);
             speed = 0;
             status = landing;
+            beginPhase(time + dt);
         }
-        speedPB->setValue(speed);  // Update the speed progress bar
-        power -= dt * powerConsumption;  // Consume power
-        if (power < 20 + powerConsumption / takeoffSpeed) {
+        power -= dt * model.powerConsumption;  // Consume power
+        if (power < 20 + model.powerConsumption / model.takeoffSpeed) {
             speed = 0;
             V.set(0, 0);
-            status = landing;  // Switch to "landing" mode if power is too low
+            if (status != landing) {
+                status = landing;  // Switch to "landing" mode if power is too low
+                beginPhase(time + dt);
+            }
         }
-        powerPB->setValue(power);  // Update the power progress bar
     }
-    repaint();  // Redraw the drone
 }
 
+template void Drone::update<FlightModel>(const FlightModel &model, Integrator::Method method, double time, double dt);
+template void Drone::update<DefaultFlightModel>(const DefaultFlightModel &model, Integrator::Method method, double time, double dt);
+
 /**
  * @brief Prepare data for collision detection
  */
@@ -197,12 +234,35 @@ void Drone::initCollision() {
  * @brief Add a collision force if another drone is too close
  * @param B The position of the other drone
  * @param threshold The collision detection distance
+ * @param coefCollision The coefficient of the collision force
  */
-void Drone::addCollision(const Vector2D &B, float threshold) {
+void Drone::addCollision(const Vector2D &B, float threshold, double coefCollision) {
     Vector2D AB = B - position;  // Vector between the two drones
-    double l = AB.length();  // Distance between the two drones
-    if (l < threshold) {
+    if (AB.lengthSquared() < threshold * threshold) {  // Compare squared distances to avoid a square root
         ForceCollision += (-coefCollision / threshold) * AB;  // Add a collision force
         showCollision = true;  // Indicate that a collision has been detected
     }
 }
+
+/**
+ * @brief Add an external force (no-fly zones), integrated with the collision force
+ * @param force The force
+ */
+void Drone::addForce(const Vector2D &force) {
+    ForceCollision += force;
+}
+
+/**
+ * @brief Check the enumerations of a record copied from a file
+ *
+ * The status is read as raw memory, since a record copied from a corrupt file may hold
+ * a value outside of the enumeration.
+ *
+ * @return True if the status and the landing slot are values of their enumerations
+ */
+bool Drone::hasValidState() const {
+    std::underlying_type<droneStatus>::type rawStatus;
+    static_assert(sizeof(rawStatus) == sizeof(status), "The status is read as its underlying type");
+    std::memcpy(&rawStatus, &status, sizeof(rawStatus));
+    return rawStatus >= landed && rawStatus <= flying && clearance <= cleared;
+}
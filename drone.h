@@ -6,58 +6,99 @@
 #ifndef DRONE_H
 #define DRONE_H
 
-#include <QWidget>
-#include <QProgressBar>
+#include <limits>
+#include <type_traits>
+#include <QtGlobal>
 #include <vector2d.h>
-#include <QImage>
+#include "flightmodel.h"
+#include "integrator.h"
 
 /**
- * @brief Drone class representing a drone in the simulation
+ * @brief Drone class representing the state of a drone in the simulation
+ *
+ * Drones are plain records stored contiguously by the DroneRegistry; their name is
+ * kept by the registry, their target server is an index in the simulation and their
+ * display is done by DroneWidget.
+ * The characteristics of the drone are not stored in the record: the drone references
+ * a FlightModel profile of the simulation by index, and the profile is given to the
+ * methods that need it.
+ *
+ * Only the flight phases (hovering, turning, flying) are updated at each step. The
+ * other phases are linear in time: the drone keeps its state at the start of the
+ * phase, the state at a given time is computed on demand, and the simulation
+ * schedules the end of the phase, given by nextEventTime(), as an event.
  */
-class Drone : public QWidget {
-    Q_OBJECT
+class Drone {
 public:
-    const double maxSpeed = 50; ///< Max speed in pixels per second
-    const double maxPower = 200; ///< Max power of drone motors
-    const double takeoffSpeed = 2.5; ///< Takeoff speed in units per second
-    const double hoveringHeight = 5; ///< Hovering height in units
-    const double coefCollision = 1000; ///< Coefficient for collision avoidance
-    const double damping = 0.2; ///< Damping for motion simulation
-    const double chargingSpeed = 10; ///< Charging speed in power per second
-    const double powerConsumption = 5; ///< Power consumption in power per second
-
     /**
      * @brief Enum representing the status of the drone
      */
     enum droneStatus { landed, takeoff, landing, hovering, turning, flying };
 
+    /**
+     * @brief Enum representing the events ending the analytic phases
+     */
+    enum phaseEvent { fullyCharged, hoverReached, lowPower, touchedDown };
+
+    /**
+     * @brief Enum representing the landing slot of the drone at a scheduled server (see LandingScheduler)
+     */
+    enum landingClearance { unscheduled, holding, cleared };
+
     /**
      * @brief Drone constructor
-     * @param p_name The name of the drone
-     * @param parent The parent widget
+     * @param modelIndex The index of the flight model profile in the simulation
+     * @param model The flight model profile
      */
-    explicit Drone(const QString &p_name, QWidget *parent = nullptr);
+    explicit Drone(int modelIndex = 0, const FlightModel &model = FlightModel());
 
     /**
-     * @brief Drone destructor
+     * @brief Get the flight model profile of the drone
+     * @return The index of the profile in the simulation
      */
-    ~Drone();
+    inline int getFlightModel() const { return flightModel; }
 
     /**
      * @brief Make the drone takeoff to move to a target position
+     * @param model The flight model profile of the drone
+     * @param time The current simulated time
      */
-    inline void start() { status = takeoff; height = 0; repaint(); }
+    void start(const FlightModel &model, double time);
 
     /**
      * @brief Ask for landing
+     * @param model The flight model profile of the drone
+     * @param time The current simulated time
+     */
+    void stop(const FlightModel &model, double time);
+
+    /**
+     * @brief Get the counter of the phase changes of the drone
+     * @return The counter, incremented each time a phase starts
+     */
+    inline quint32 getPhase() const { return phase; }
+
+    /**
+     * @brief Get the time at which the current analytic phase ends
+     * @param model The flight model profile of the drone
+     * @return The simulated time of the end of the phase, or infinity if no event is expected
      */
-    inline void stop() { status = landing; }
+    double nextEventTime(const FlightModel &model) const;
+
+    /**
+     * @brief End the current analytic phase at the time given by nextEventTime()
+     * @param model The flight model profile of the drone
+     * @param time The simulated time of the event
+     * @return The event that ended the phase
+     */
+    phaseEvent endPhase(const FlightModel &model, double time);
 
     /**
      * @brief Set the speed of the drone
      * @param s The speed to set
+     * @param model The flight model profile of the drone
      */
-    inline void setSpeed(double s) { speedSetpoint = (s > maxSpeed ? maxSpeed : s); }
+    inline void setSpeed(double s, const FlightModel &model) { speedSetpoint = (s > model.maxSpeed ? model.maxSpeed : s); }
 
     /**
      * @brief Set the initial position of the drone (takeoff place)
@@ -75,49 +116,61 @@ public:
      * @brief Get the current position of the drone
      * @return The current position
      */
-    inline Vector2D getPosition() { return position; }
+    inline const Vector2D &getPosition() const { return position; }
 
     /**
-     * @brief Get the current status of the drone
-     * @return The current status
+     * @brief Get the current velocity of the drone
+     * @return The velocity vector in pixels per second
      */
-    inline droneStatus getStatus() { return status; }
+    inline const Vector2D &getVelocity() const { return V; }
 
     /**
-     * @brief Get the name of the drone
-     * @return The name of the drone
+     * @brief Get the current status of the drone
+     * @return The current status
      */
-    inline QString getName() { return name; }
+    inline droneStatus getStatus() const { return status; }
 
     /**
      * @brief Get the direction of motion of the drone (angle in degrees relative to the y direction)
      * @return The angle in degrees
      */
-    inline double getAzimut() { return azimut; }
+    inline double getAzimut() const { return azimut; }
 
     /**
-     * @brief Get the power level of the drone (between 0 and 100)
-     * @return The power level
+     * @brief Get the current speed of the drone
+     * @return The speed in pixels per second
      */
-    inline double getPower() { return 100.0 * power / maxPower; }
+    inline double getSpeed() const { return speed; }
 
     /**
-     * @brief Handle the paint event
-     * @param event The paint event
+     * @brief Get the power level of the drone (between 0 and 100)
+     * @param model The flight model profile of the drone
+     * @param time The current simulated time
+     * @return The power level
      */
-    void paintEvent(QPaintEvent*) override;
+    inline double getPower(const FlightModel &model, double time) const { return 100.0 * powerAt(model, time) / model.maxPower; }
 
     /**
-     * @brief Handle the resize event
-     * @param event The resize event
+     * @brief Get the height of the drone
+     * @param model The flight model profile of the drone
+     * @param time The current simulated time
+     * @return The height in units
      */
-    void resizeEvent(QResizeEvent *event) override;
+    double getHeight(const FlightModel &model, double time) const;
 
     /**
-     * @brief Update the drone's state
+     * @brief Update the drone's state during a flight phase
+     *
+     * Instantiated for FlightModel and for DefaultFlightModel, whose constants are
+     * folded by the compiler. Drones in an analytic phase are not modified.
+     *
+     * @param model The flight model profile of the drone
+     * @param method The method used to integrate the motion
+     * @param time The simulated time at the start of the update
      * @param dt The time elapsed since the last update
      */
-    void update(double dt);
+    template<typename Model>
+    void update(const Model &model, Integrator::Method method, double time, double dt);
 
     /**
      * @brief Prepare data for collision detection
@@ -128,35 +181,85 @@ public:
      * @brief Add a collision force
      * @param A The position of the other drone to test
      * @param threshold The distance for collision detection
+     * @param coefCollision The coefficient of the collision force (from the flight model)
      */
-    void addCollision(const Vector2D& A, float threshold);
+    void addCollision(const Vector2D& A, float threshold, double coefCollision);
+
+    /**
+     * @brief Add an external force (no-fly zones), integrated with the collision force
+     * @param force The force
+     */
+    void addForce(const Vector2D &force);
 
     /**
      * @brief Check if a collision has occurred
      * @return True if a collision has occurred
      */
-    bool hasCollision() { return showCollision; }
+    bool hasCollision() const { return showCollision; }
 
     /**
      * @brief Set the target server for the drone
-     * @param serverName The name of the target server
+     * @param serverIndex The index of the target server in the simulation, -1 for none
      */
-    void setTargetServer(const QString &serverName) { targetServer = serverName; }
+    void setTargetServer(int serverIndex) { targetServer = serverIndex; }
 
     /**
      * @brief Get the target server of the drone
-     * @return The name of the target server
+     * @return The index of the target server in the simulation, -1 for none
+     */
+    int getTargetServer() const { return targetServer; }
+
+    /**
+     * @brief Get the landing slot of the drone at its target server
+     * @return unscheduled if the drone has not asked for one, holding while it waits, cleared once it has a pad
+     */
+    inline landingClearance getClearance() const { return landingClearance(clearance); }
+
+    /**
+     * @brief Get the pad given to the drone, or its hold position while it waits
+     * @return The index of the pad at the target server if the drone is cleared, of its hold position if it is holding
+     */
+    inline int getPad() const { return pad; }
+
+    /**
+     * @brief Set the landing slot of the drone; a holding drone hovers at its goal instead of landing
+     * @param state The new state
+     * @param padIndex The index of the pad at the target server if cleared, of the hold position if holding
+     */
+    inline void setClearance(landingClearance state, int padIndex = 0) { clearance = quint8(state); pad = quint16(padIndex); }
+
+    /**
+     * @brief Check the enumerations of a record copied from a file
+     * @return True if the status and the landing slot are values of their enumerations
      */
-    QString getTargetServer() const { return targetServer; }
+    bool hasValidState() const;
 
 private:
-    const int compasSize = 48; ///< Size of the compass image
-    const int barSpace = 150; ///< Minimum size of the progress bar
+    /**
+     * @brief Get the power of the drone at a given time
+     * @param model The flight model profile of the drone
+     * @param time The simulated time
+     * @return The power, in the unit of FlightModel::maxPower
+     */
+    double powerAt(const FlightModel &model, double time) const;
+
+    /**
+     * @brief Start a new phase from the current state
+     * @param time The simulated time of the start of the phase
+     */
+    inline void beginPhase(double time) { phaseStart = time; phase++; }
+
+    /**
+     * @brief Get the power under which the drone must land
+     * @param model The flight model profile of the drone
+     * @return The power threshold
+     */
+    static inline double lowPowerThreshold(const FlightModel &model) { return 20 + model.powerConsumption / model.takeoffSpeed; }
+
     droneStatus status; ///< Current status of the drone
-    double height; ///< Current height of the drone
-    QString name; ///< Name of the drone
-    QProgressBar *speedPB; ///< Progress bar for speed
-    QProgressBar *powerPB; ///< Progress bar for power
+    double phaseStart; ///< Simulated time of the start of the phase, origin of the analytic state
+    quint32 phase; ///< Counter of the phase changes, used to detect stale events
+    double height; ///< Height of the drone (at the start of the phase in analytic phases)
     Vector2D position; ///< Current position of the drone
     Vector2D goalPosition; ///< Goal position of the drone
     Vector2D direction; ///< Current direction of the drone
@@ -164,11 +267,15 @@ private:
     Vector2D ForceCollision; ///< Force generated by collision detection
     double speed; ///< Current speed
     double speedSetpoint; ///< Speed to reach if possible
-    double power; ///< Current power
+    double power; ///< Power of the drone (at the start of the phase in analytic phases)
     double azimut; ///< Rotation angle of the drone
-    QImage compasImg, stopImg, takeoffImg, landingImg; ///< Images for the drone's UI
     bool showCollision; ///< True if a collision is detected
-    QString targetServer; ///< Target server name
+    int targetServer; ///< Index of the target server, -1 for none
+    quint16 flightModel; ///< Index of the flight model profile
+    quint8 clearance; ///< Landing slot at the target server (landingClearance)
+    quint16 pad; ///< Pad given at the target server, if cleared
 };
 
+static_assert(std::is_trivially_copyable<Drone>::value, "Drone records are copied as raw memory");
+
 #endif // DRONE_H
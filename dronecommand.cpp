@@ -0,0 +1,54 @@
+#include "dronecommand.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+
+/**
+ * @brief Parse a command from a line of JSON.
+ * @param line The JSON object of the command.
+ * @param command Receives the command.
+ * @param error Receives the reason when the line is not a valid command.
+ * @return True if the line is a valid command.
+ */
+bool DroneCommand::fromJson(const QByteArray &line, DroneCommand &command, QString &error) {
+    static const struct { const char *name; Type type; } types[] = {
+        {"goto", goTo}, {"land", land}, {"retarget", retarget}, {"add", add}, {"remove", remove},
+        {"moveserver", moveServer}
+    };
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (!doc.isObject()) {
+        error = parseError.error != QJsonParseError::NoError ? parseError.errorString() : QString("not an object");
+        return false;
+    }
+    QJsonObject obj = doc.object();
+
+    QString name = obj["cmd"].toString();
+    int t = 0;
+    while (t < int(sizeof(types) / sizeof(types[0])) && name != types[t].name) {
+        t++;
+    }
+    if (t == int(sizeof(types) / sizeof(types[0]))) {
+        error = "unknown command \"" + name + "\"";
+        return false;
+    }
+    command.type = types[t].type;
+    command.drone = obj["drone"].toString();
+    command.server = obj["server"].toString();
+    command.model = obj["model"].toString();
+    command.position = Vector2D(float(obj["x"].toDouble()), float(obj["y"].toDouble()));
+
+    if (command.drone.isEmpty() && command.type != moveServer) {
+        error = "missing drone name";
+        return false;
+    }
+    if ((command.type == goTo || command.type == add || command.type == moveServer) && !(obj.contains("x") && obj.contains("y"))) {
+        error = "missing position";
+        return false;
+    }
+    if ((command.type == retarget || command.type == moveServer) && command.server.isEmpty()) {
+        error = "missing server name";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file dronecommand.h
+ * @brief Commands sent to a running simulation by an external dispatch system.
+ *
+ * This file declares the DroneCommand structure, parsed from newline-delimited JSON,
+ * and the CommandQueue handing the commands to the simulation.
+ */
+
+#ifndef DRONECOMMAND_H
+#define DRONECOMMAND_H
+
+#include <QByteArray>
+#include <QString>
+#include "boundedqueue.h"
+#include "vector2d.h"
+
+/**
+ * @brief Command on a drone of the simulation.
+ *
+ * One command per line of JSON, for example:
+ *   {"cmd": "goto", "drone": "D1", "x": 120, "y": 300}
+ *   {"cmd": "land", "drone": "D1"}
+ *   {"cmd": "retarget", "drone": "D1", "server": "S2"}
+ *   {"cmd": "add", "drone": "D9", "x": 50, "y": 60, "server": "S1", "model": "heavy"}
+ *   {"cmd": "remove", "drone": "D9"}
+ *   {"cmd": "moveserver", "server": "S2", "x": 400, "y": 250}
+ */
+struct DroneCommand {
+    /**
+     * @brief Kind of command.
+     */
+    enum Type {
+        goTo, ///< Fly to a position (taking off if landed), forgetting the target server.
+        land, ///< Land where the drone is.
+        retarget, ///< Fly to a server (taking off if landed).
+        add, ///< Add a landed drone.
+        remove, ///< Remove a drone.
+        moveServer ///< Move a server (no drone).
+    };
+
+    Type type = goTo; ///< Kind of command.
+    QString drone; ///< Name of the drone (empty for moveserver).
+    QString server; ///< Name of the server (retarget and moveserver, optional for add).
+    QString model; ///< Name of the flight model profile (optional for add).
+    Vector2D position; ///< Goal position (goto), initial position (add) or new server position (moveserver).
+
+    /**
+     * @brief Parse a command from a line of JSON.
+     * @param line The JSON object of the command.
+     * @param command Receives the command.
+     * @param error Receives the reason when the line is not a valid command.
+     * @return True if the line is a valid command.
+     */
+    static bool fromJson(const QByteArray &line, DroneCommand &command, QString &error);
+};
+
+typedef BoundedQueue<DroneCommand> CommandQueue; ///< Queue of the commands, filled by I/O threads and drained by the simulation.
+
+#endif // DRONECOMMAND_H
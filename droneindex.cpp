@@ -0,0 +1,205 @@
+#include "droneindex.h"
+#include "vector2dbatch.h"
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Index the positions of the drones.
+ *
+ * The side of the cells gives about one drone per cell for drones spread uniformly
+ * over their bounding box, with at most maxCellsPerSide cells per side.
+ *
+ * @param records The drones.
+ * @param count The number of drones.
+ */
+void DroneIndex::build(const Drone *records, int count) {
+    entries.resize(count);
+    positions.resize(count);
+    cellOf.resize(count);
+    if (count == 0) {
+        columns = rows = 0;
+        cellStart.fill(0, 1);
+        return;
+    }
+
+    Vector2D low = records[0].getPosition(), high = low;
+    for (int i = 1; i < count; i++) {
+        const Vector2D p = records[i].getPosition();
+        low = Vector2D(qMin(low.x, p.x), qMin(low.y, p.y));
+        high = Vector2D(qMax(high.x, p.x), qMax(high.y, p.y));
+    }
+    const float width = high.x - low.x, height = high.y - low.y;
+    origin = low;
+    cellSize = qMax(qMax(std::sqrt(width * height / count), qMax(width, height) / maxCellsPerSide), 1e-3f);
+    inverseCellSize = 1 / cellSize;
+    columns = qMin(int(width * inverseCellSize) + 1, maxCellsPerSide);
+    rows = qMin(int(height * inverseCellSize) + 1, maxCellsPerSide);
+
+    // Counting sort by cell: sizes, then starts, then placement
+    const int cells = columns * rows;
+    cellStart.fill(0, cells + 1);
+    for (int i = 0; i < count; i++) {
+        const Vector2D p = records[i].getPosition();
+        int cell = row(p.y) * columns + column(p.x);
+        cellOf[i] = cell;
+        cellStart[cell + 1]++;
+    }
+    for (int c = 0; c < cells; c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    for (int i = 0; i < count; i++) {
+        int slot = cellStart[cellOf[i]]++;
+        entries[slot] = i;
+        positions[slot] = records[i].getPosition();
+    }
+    // Each start was moved to the start of the next cell: shift them back
+    std::copy_backward(cellStart.begin(), cellStart.end() - 1, cellStart.end());
+    cellStart[0] = 0;
+}
+
+/**
+ * @brief Compute the squared distances of a range of entries to a point.
+ * @param begin The first entry.
+ * @param end The entry after the last one.
+ * @param p The point.
+ * @return The squared distances, indexed from begin (scratch array of the index).
+ */
+const float *DroneIndex::spanDistances(int begin, int end, const Vector2D &p) const {
+    if (distances.size() < end - begin) {
+        distances.resize(end - begin);
+    }
+    Vector2DBatch::distanceSquared(positions.constData() + begin, end - begin, p, distances.data());
+    return distances.constData();
+}
+
+/**
+ * @brief Find the drones within a distance of a point.
+ *
+ * The cells overlapping the bounding square of the circle are read row by row.
+ *
+ * @param center The point.
+ * @param radius The distance.
+ * @param result Receives the dense indices of the drones, in no particular order.
+ */
+void DroneIndex::inRadius(const Vector2D &center, float radius, QVector<int> &result) const {
+    result.resize(0);
+    if (entries.isEmpty() || radius < 0) {
+        return;
+    }
+    const float limit = radius * radius;
+    const int c0 = column(center.x - radius), c1 = column(center.x + radius);
+    const int r1 = row(center.y + radius);
+    for (int r = row(center.y - radius); r <= r1; r++) {
+        const int begin = cellStart[r * columns + c0], end = cellStart[r * columns + c1 + 1];
+        const float *d = spanDistances(begin, end, center);
+        for (int e = begin; e < end; e++) {
+            if (d[e - begin] <= limit) {
+                result.append(entries[e]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Find the drones inside a rectangle.
+ * @param rect The rectangle.
+ * @param result Receives the dense indices of the drones, in no particular order.
+ */
+void DroneIndex::inRect(const QRectF &rect, QVector<int> &result) const {
+    result.resize(0);
+    if (entries.isEmpty() || rect.isEmpty()) {
+        return;
+    }
+    const float left = float(rect.left()), right = float(rect.right());
+    const float top = float(rect.top()), bottom = float(rect.bottom());
+    const int c0 = column(left), c1 = column(right);
+    const int r1 = row(bottom);
+    for (int r = row(top); r <= r1; r++) {
+        const int begin = cellStart[r * columns + c0], end = cellStart[r * columns + c1 + 1];
+        for (int e = begin; e < end; e++) {
+            const Vector2D &p = positions[e];
+            if (p.x >= left && p.x <= right && p.y >= top && p.y <= bottom) {
+                result.append(entries[e]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Find the drones nearest to a point.
+ *
+ * The cells are read in square rings of growing size around the cell of the point,
+ * keeping the k best drones in a heap, until the distance of the point to the cells
+ * not read yet exceeds the distance of the k-th drone.
+ *
+ * @param center The point.
+ * @param k The number of drones.
+ * @param result Receives the dense indices of the k nearest drones (fewer if there are not k drones), nearest first.
+ */
+void DroneIndex::nearest(const Vector2D &center, int k, QVector<int> &result) const {
+    result.resize(0);
+    k = qMin(k, int(entries.size()));
+    if (k <= 0) {
+        return;
+    }
+    QVector<QPair<float, int>> best;  // Max-heap on the distance
+    best.reserve(k);
+    auto visit = [&](int begin, int end) {
+        const float *d = spanDistances(begin, end, center);
+        for (int e = begin; e < end; e++) {
+            const float distance = d[e - begin];
+            if (best.size() < k) {
+                best.append(qMakePair(distance, entries[e]));
+                std::push_heap(best.begin(), best.end());
+            } else if (distance < best.first().first) {
+                std::pop_heap(best.begin(), best.end());
+                best.last() = qMakePair(distance, entries[e]);
+                std::push_heap(best.begin(), best.end());
+            }
+        }
+    };
+
+    const int cx = column(center.x), cy = row(center.y);
+    for (int ring = 0; ; ring++) {
+        const int c0 = cx - ring, c1 = cx + ring, r0 = cy - ring, r1 = cy + ring;
+        for (int r = qMax(r0, 0); r <= qMin(r1, rows - 1); r++) {
+            const int line = r * columns;
+            if (r == r0 || r == r1) {
+                visit(cellStart[line + qMax(c0, 0)], cellStart[line + qMin(c1, columns - 1) + 1]);
+            } else {
+                if (c0 >= 0) {
+                    visit(cellStart[line + c0], cellStart[line + c0 + 1]);
+                }
+                if (c1 < columns) {
+                    visit(cellStart[line + c1], cellStart[line + c1 + 1]);
+                }
+            }
+        }
+
+        // Distance from the point to the cells outside the rings read so far
+        float gap = std::numeric_limits<float>::infinity();
+        if (c0 > 0) {
+            gap = qMin(gap, center.x - (origin.x + c0 * cellSize));
+        }
+        if (c1 < columns - 1) {
+            gap = qMin(gap, origin.x + (c1 + 1) * cellSize - center.x);
+        }
+        if (r0 > 0) {
+            gap = qMin(gap, center.y - (origin.y + r0 * cellSize));
+        }
+        if (r1 < rows - 1) {
+            gap = qMin(gap, origin.y + (r1 + 1) * cellSize - center.y);
+        }
+        if (std::isinf(gap) || (best.size() == k && gap > 0 && gap * gap >= best.first().first)) {
+            break;  // The whole grid is read, or no other drone can be nearer
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    result.reserve(best.size());
+    for (const QPair<float, int> &entry : best) {
+        result.append(entry.second);
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file droneindex.h
+ * @brief Spatial index of the drones, answering radius, rectangle and nearest queries.
+ *
+ * This file declares the DroneIndex class, a uniform grid over the positions of the
+ * drones, rebuilt from the records of the registry.
+ */
+
+#ifndef DRONEINDEX_H
+#define DRONEINDEX_H
+
+#include <QRectF>
+#include <QVector>
+#include "drone.h"
+#include "vector2d.h"
+
+/**
+ * @class DroneIndex
+ * @brief Uniform grid of the drone positions, stored cell by cell.
+ *
+ * The grid covers the bounding box of the drones with about one cell per drone. The
+ * drones are sorted by cell with a counting sort (two passes over the records), and
+ * their positions are copied in the same order, so that a query reads the few cells
+ * it overlaps as contiguous arrays for the batch distance kernel.
+ *
+ * The results are dense indices in the records given to build().
+ */
+class DroneIndex {
+public:
+    /**
+     * @brief Constructs an empty index.
+     */
+    DroneIndex() {}
+
+    /**
+     * @brief Index the positions of the drones.
+     * @param records The drones.
+     * @param count The number of drones.
+     */
+    void build(const Drone *records, int count);
+
+    /**
+     * @brief Find the drones within a distance of a point.
+     * @param center The point.
+     * @param radius The distance.
+     * @param result Receives the dense indices of the drones, in no particular order.
+     */
+    void inRadius(const Vector2D &center, float radius, QVector<int> &result) const;
+
+    /**
+     * @brief Find the drones inside a rectangle.
+     * @param rect The rectangle.
+     * @param result Receives the dense indices of the drones, in no particular order.
+     */
+    void inRect(const QRectF &rect, QVector<int> &result) const;
+
+    /**
+     * @brief Find the drones nearest to a point.
+     * @param center The point.
+     * @param k The number of drones.
+     * @param result Receives the dense indices of the k nearest drones (fewer if there are not k drones), nearest first.
+     */
+    void nearest(const Vector2D &center, int k, QVector<int> &result) const;
+
+    /**
+     * @brief Get the number of indexed drones.
+     * @return The number of drones.
+     */
+    inline int size() const { return entries.size(); }
+
+private:
+    /**
+     * @brief Get the column of the grid of an abscissa.
+     * @param x The abscissa.
+     * @return The column, clamped to the grid.
+     */
+    inline int column(float x) const { return qBound(0, int((x - origin.x) * inverseCellSize), columns - 1); }
+
+    /**
+     * @brief Get the row of the grid of an ordinate.
+     * @param y The ordinate.
+     * @return The row, clamped to the grid.
+     */
+    inline int row(float y) const { return qBound(0, int((y - origin.y) * inverseCellSize), rows - 1); }
+
+    /**
+     * @brief Compute the squared distances of a range of entries to a point.
+     *
+     * The cells of a row of the grid are contiguous, so a range covers several cells.
+     *
+     * @param begin The first entry.
+     * @param end The entry after the last one.
+     * @param p The point.
+     * @return The squared distances, indexed from begin (scratch array of the index).
+     */
+    const float *spanDistances(int begin, int end, const Vector2D &p) const;
+
+    static constexpr int maxCellsPerSide = 1024; ///< Maximum number of columns (or rows) of the grid.
+
+    Vector2D origin; ///< Top left corner of the grid.
+    float cellSize = 1; ///< Side of a cell.
+    float inverseCellSize = 1; ///< 1 / cellSize.
+    int columns = 0; ///< Number of columns of the grid.
+    int rows = 0; ///< Number of rows of the grid.
+    QVector<int> cellStart; ///< Start of each cell in entries, plus the end of the last cell.
+    QVector<int> entries; ///< Dense indices of the drones, cell after cell.
+    QVector<Vector2D> positions; ///< Positions of the drones, in the order of entries.
+    QVector<int> cellOf; ///< Cell of each drone, scratch of build().
+    mutable QVector<float> distances; ///< Squared distances of the drones of a cell, scratch of the queries.
+};
+
+#endif // DRONEINDEX_H
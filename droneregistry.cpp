@@ -0,0 +1,95 @@
+#include "droneregistry.h"
+
+/**
+ * @brief Add a drone to the registry.
+ *
+ * A free slot is reused if there is one, otherwise a new slot is created.
+ *
+ * @param name The name of the drone, which must be unique.
+ * @param drone The initial state of the drone.
+ * @return The handle of the new drone, or an invalid handle if the name is already used.
+ */
+DroneId DroneRegistry::add(const QString &name, const Drone &drone) {
+    if (nameToId.contains(name)) {
+        return DroneId();
+    }
+
+    quint32 slot;
+    if (!freeSlots.isEmpty()) {
+        slot = freeSlots.takeLast();
+    } else {
+        slot = quint32(slotTable.size());
+        slotTable.append(Slot{0, 0});
+    }
+    slotTable[slot].dense = quint32(drones.size());
+
+    drones.append(drone);
+    names.append(name);
+    denseSlots.append(slot);
+
+    DroneId id{slot, slotTable[slot].generation};
+    nameToId.insert(name, id);
+    return id;
+}
+
+/**
+ * @brief Remove a drone from the registry.
+ *
+ * The last drone of the dense array is moved into the place of the removed one and
+ * its slot is updated. The slot of the removed drone gets a new generation and is
+ * made available for future drones.
+ *
+ * @param id The handle of the drone.
+ * @return True if the drone was found and removed.
+ */
+bool DroneRegistry::remove(DroneId id) {
+    int i = indexOf(id);
+    if (i < 0) {
+        return false;
+    }
+    nameToId.remove(names[i]);
+
+    int last = int(drones.size()) - 1;
+    if (i != last) {
+        drones[i] = drones[last];
+        names[i] = names[last];
+        denseSlots[i] = denseSlots[last];
+        slotTable[denseSlots[i]].dense = quint32(i);
+    }
+    drones.removeLast();
+    names.removeLast();
+    denseSlots.removeLast();
+
+    slotTable[id.index].generation++;
+    freeSlots.append(id.index);
+    return true;
+}
+
+/**
+ * @brief Remove all the drones.
+ *
+ * The generation of every slot is increased, so that no previous handle stays valid.
+ */
+void DroneRegistry::clear() {
+    drones.clear();
+    names.clear();
+    denseSlots.clear();
+    nameToId.clear();
+    freeSlots.clear();
+    for (quint32 slot = quint32(slotTable.size()); slot-- > 0;) {
+        slotTable[slot].generation++;
+        freeSlots.append(slot);
+    }
+}
+
+/**
+ * @brief Reserve memory for a number of drones.
+ * @param n The number of drones.
+ */
+void DroneRegistry::reserve(int n) {
+    drones.reserve(n);
+    names.reserve(n);
+    denseSlots.reserve(n);
+    slotTable.reserve(n);
+    nameToId.reserve(n);
+}
@@ -0,0 +1,230 @@
+/**
+ * @file droneregistry.h
+ * @brief Flat storage of the drones of the simulation.
+ *
+ * This file declares the DroneId handle and the DroneRegistry class, which stores the
+ * drones contiguously and gives them stable integer identifiers.
+ */
+
+#ifndef DRONEREGISTRY_H
+#define DRONEREGISTRY_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include "drone.h"
+
+/**
+ * @brief Stable handle of a drone in a DroneRegistry.
+ *
+ * The index designates a slot of the registry and the generation counts the drones
+ * that used this slot: the handle of a removed drone is detected as stale even when
+ * its slot has been reused.
+ */
+struct DroneId {
+    static constexpr quint32 invalidIndex = 0xFFFFFFFF; ///< Index of an invalid handle.
+
+    quint32 index = invalidIndex; ///< Slot of the drone in the registry.
+    quint32 generation = 0; ///< Generation of the slot when the drone was added.
+
+    /**
+     * @brief Check if the handle designates a drone (which may have been removed since).
+     * @return True if the handle is not the invalid handle.
+     */
+    constexpr bool isValid() const { return index != invalidIndex; }
+
+    friend constexpr bool operator==(const DroneId &a, const DroneId &b) { return a.index == b.index && a.generation == b.generation; }
+    friend constexpr bool operator!=(const DroneId &a, const DroneId &b) { return !(a == b); }
+};
+
+/**
+ * @brief Hash a drone handle, to use it as a key of QHash and QSet.
+ * @param id The handle.
+ * @param seed The seed of the hash.
+ * @return The hash of the index and the generation.
+ */
+inline size_t qHash(const DroneId &id, size_t seed = 0) {
+    return qHash((quint64(id.generation) << 32) | id.index, seed);
+}
+
+/**
+ * @class DroneRegistry
+ * @brief Contiguous storage of drones with O(1) access by identifier.
+ *
+ * Drones are stored densely in an array that the simulation loops iterate directly.
+ * A slot table translates the stable DroneId handles into positions in this array.
+ * Removing a drone moves the last drone into its place (swap and pop), so the dense
+ * position of a drone may change but its DroneId never does.
+ * Names are only used at the API boundary, through findByName() and name().
+ */
+class DroneRegistry {
+public:
+    /**
+     * @brief Add a drone to the registry.
+     * @param name The name of the drone, which must be unique.
+     * @param drone The initial state of the drone.
+     * @return The handle of the new drone, or an invalid handle if the name is already used.
+     */
+    DroneId add(const QString &name, const Drone &drone = Drone());
+
+    /**
+     * @brief Remove a drone from the registry.
+     * @param id The handle of the drone.
+     * @return True if the drone was found and removed.
+     */
+    bool remove(DroneId id);
+
+    /**
+     * @brief Remove all the drones.
+     *
+     * The generation of every slot is increased, so that no previous handle stays valid.
+     */
+    void clear();
+
+    /**
+     * @brief Reserve memory for a number of drones.
+     * @param n The number of drones.
+     */
+    void reserve(int n);
+
+    /**
+     * @brief Get the dense position of a drone.
+     * @param id The handle of the drone.
+     * @return The position in the dense array, or -1 if the handle is stale.
+     */
+    inline int indexOf(DroneId id) const {
+        if (id.index >= quint32(slotTable.size()) || slotTable[id.index].generation != id.generation) {
+            return -1;
+        }
+        return int(slotTable[id.index].dense);
+    }
+
+    /**
+     * @brief Check if a handle designates a drone of the registry.
+     * @param id The handle of the drone.
+     * @return True if the drone exists.
+     */
+    inline bool contains(DroneId id) const { return indexOf(id) >= 0; }
+
+    /**
+     * @brief Find a drone by its handle.
+     * @param id The handle of the drone.
+     * @return A pointer to the drone, or nullptr if the handle is stale.
+     */
+    inline Drone *find(DroneId id) {
+        int i = indexOf(id);
+        return i < 0 ? nullptr : &drones[i];
+    }
+
+    /**
+     * @brief Find a drone by its handle.
+     * @param id The handle of the drone.
+     * @return A pointer to the drone, or nullptr if the handle is stale.
+     */
+    inline const Drone *find(DroneId id) const {
+        int i = indexOf(id);
+        return i < 0 ? nullptr : &drones[i];
+    }
+
+    /**
+     * @brief Find the handle of a drone from its name.
+     * @param name The name of the drone.
+     * @return The handle, or an invalid handle if no drone has this name.
+     */
+    inline DroneId findByName(const QString &name) const { return nameToId.value(name); }
+
+    /**
+     * @brief Get the name of a drone.
+     * @param id The handle of the drone.
+     * @return The name, or an empty string if the handle is stale.
+     */
+    inline QString name(DroneId id) const {
+        int i = indexOf(id);
+        return i < 0 ? QString() : names[i];
+    }
+
+    /**
+     * @brief Get the name of the drone at a dense position.
+     * @param i The dense position.
+     * @return The name of the drone.
+     */
+    inline const QString &nameAt(int i) const { return names[i]; }
+
+    /**
+     * @brief Get the handle of the drone at a dense position.
+     * @param i The dense position.
+     * @return The handle of the drone.
+     */
+    inline DroneId idAt(int i) const { return DroneId{denseSlots[i], slotTable[denseSlots[i]].generation}; }
+
+    /**
+     * @brief Get the number of drones.
+     * @return The number of drones.
+     */
+    inline int size() const { return int(drones.size()); }
+
+    /**
+     * @brief Check if the registry is empty.
+     * @return True if there is no drone.
+     */
+    inline bool isEmpty() const { return drones.isEmpty(); }
+
+    /**
+     * @brief Access the drone at a dense position.
+     * @param i The dense position.
+     * @return A reference to the drone.
+     */
+    inline Drone &operator[](int i) { return drones[i]; }
+
+    /**
+     * @brief Access the drone at a dense position.
+     * @param i The dense position.
+     * @return A reference to the drone.
+     */
+    inline const Drone &operator[](int i) const { return drones[i]; }
+
+    /**
+     * @brief Get the dense array of drones.
+     *
+     * The array is implicitly shared: a copy costs nothing until the registry modifies
+     * a drone, which then copies the array once (copy-on-write).
+     * @return The drones, in dense order.
+     */
+    inline const QVector<Drone> &records() const { return drones; }
+
+    /**
+     * @brief Get the names of the drones.
+     * @return The names, parallel to records().
+     */
+    inline const QVector<QString> &nameList() const { return names; }
+
+    /**
+     * @brief Make the dense array unshared, before several threads access the drones.
+     *
+     * Modifying a shared array copies it, which must not happen concurrently.
+     */
+    inline void detach() { drones.detach(); }
+
+    inline Drone *begin() { return drones.data(); } ///< Start of the dense array.
+    inline Drone *end() { return drones.data() + drones.size(); } ///< End of the dense array.
+    inline const Drone *begin() const { return drones.constData(); } ///< Start of the dense array.
+    inline const Drone *end() const { return drones.constData() + drones.size(); } ///< End of the dense array.
+
+private:
+    /**
+     * @brief Entry of the slot table.
+     */
+    struct Slot {
+        quint32 dense; ///< Position of the drone in the dense array.
+        quint32 generation; ///< Current generation of the slot.
+    };
+
+    QVector<Drone> drones; ///< Dense array of drones.
+    QVector<QString> names; ///< Names of the drones, parallel to the dense array.
+    QVector<quint32> denseSlots; ///< Slot of each drone, parallel to the dense array.
+    QVector<Slot> slotTable; ///< Slots indexed by DroneId::index.
+    QVector<quint32> freeSlots; ///< Slots available for new drones.
+    QHash<QString, DroneId> nameToId; ///< Name to handle translation.
+};
+
+#endif // DRONEREGISTRY_H
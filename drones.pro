@@ -9,20 +9,88 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    allocationcounter.cpp \
     canvas.cpp \
+    checkpoint.cpp \
+    collisiongrid.cpp \
+    commandinput.cpp \
+    delaunay.cpp \
     drone.cpp \
+    dronecommand.cpp \
+    dronetrails.cpp \
+    droneindex.cpp \
+    droneregistry.cpp \
+    dronewidget.cpp \
+    eventscheduler.cpp \
+    fleetprocess.cpp \
+    framearena.cpp \
+    frameexporter.cpp \
+    integrator.cpp \
+    labelcache.cpp \
+    landingscheduler.cpp \
     main.cpp \
     mainwindow.cpp \
+    noflyzones.cpp \
+    regionmap.cpp \
+    regionshard.cpp \
+    rendergovernor.cpp \
+    scenario.cpp \
     server.cpp \
-    vector2d.cpp \
-    voronoi.cpp
+    sharedfleet.cpp \
+    simulation.cpp \
+    telemetry.cpp \
+    tilepyramid.cpp \
+    tilestore.cpp \
+    trafficheatmap.cpp \
+    voronoi.cpp \
+    voronoiraster.cpp \
+    workerpool.cpp
 HEADERS += \
+    allocationcounter.h \
+    boundedqueue.h \
     canvas.h \
+    checkpoint.h \
+    collisiongrid.h \
+    commandinput.h \
+    delaunay.h \
     drone.h \
+    dronecommand.h \
+    dronetrails.h \
+    droneindex.h \
+    droneregistry.h \
+    dronewidget.h \
+    eventscheduler.h \
+    fleetprocess.h \
+    flightmodel.h \
+    framearena.h \
+    frameexporter.h \
+    integrator.h \
+    labelcache.h \
+    landingscheduler.h \
     mainwindow.h \
+    noflyzones.h \
+    regionmap.h \
+    regionshard.h \
+    rendergovernor.h \
+    scenario.h \
     server.h \
+    sharedfleet.h \
+    simulation.h \
+    spscring.h \
+    telemetry.h \
+    tilepyramid.h \
+    tilestore.h \
+    trafficheatmap.h \
     vector2d.h \
-    voronoi.h
+    vector2dbatch.h \
+    voronoi.h \
+    voronoiraster.h \
+    workerpool.h
+
+# Count heap allocations to check that the simulation step does not allocate:
+#   qmake CONFIG+=alloc_check
+# tools/alloccheck runs the same check without the GUI and fails if a step allocates.
+alloc_check: DEFINES += DRONES_COUNT_ALLOCATIONS
 
 FORMS += \
     mainwindow.ui
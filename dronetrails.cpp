@@ -0,0 +1,57 @@
+#include "dronetrails.h"
+
+/**
+ * @brief Set the number of positions kept per drone, emptying the trails.
+ * @param points The number of positions, at least 2.
+ */
+void DroneTrails::setCapacity(int points) {
+    capacity = qMax(2, points);
+    clear();
+}
+
+/**
+ * @brief Empty the trails.
+ */
+void DroneTrails::clear() {
+    trails.clear();
+    points.clear();
+    nextSample = 0;
+}
+
+/**
+ * @brief Add the position of each drone in the air, if a sample is due.
+ *
+ * The arrays grow to the largest slot of the registry, which only happens when drones
+ * are added.
+ *
+ * @param drones The registry, giving the handle of each drone.
+ * @param records The state of the drones, in the dense order of the registry.
+ * @param time The simulated time of the records.
+ */
+void DroneTrails::record(const DroneRegistry &drones, const Drone *records, double time) {
+    if (time < nextSample) {
+        return;
+    }
+    nextSample = interval > 0 ? qMax(nextSample + interval, time) : time;
+
+    for (int i = 0; i < drones.size(); i++) {
+        const DroneId id = drones.idAt(i);
+        if (id.index >= quint32(trails.size())) {
+            trails.resize(id.index + 1);
+            points.resize(qsizetype(id.index + 1) * capacity);
+        }
+        Trail &trail = trails[id.index];
+        if (trail.generation != id.generation) {
+            trail = Trail();  // The slot was reused
+            trail.generation = id.generation;
+        }
+        const Drone &drone = records[i];
+        if (drone.getStatus() == Drone::landed) {
+            trail.count = 0;
+            continue;
+        }
+        points[qsizetype(id.index) * capacity + trail.head] = drone.getPosition();
+        trail.head = trail.head + 1 == capacity ? 0 : trail.head + 1;
+        trail.count = qMin(trail.count + 1, capacity);
+    }
+}
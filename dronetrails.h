@@ -0,0 +1,99 @@
+/**
+ * @file dronetrails.h
+ * @brief Recent positions of the drones in the air, for drawing their tracks.
+ *
+ * This file declares the DroneTrails class, which samples the positions of the flying
+ * drones at a fixed interval of simulated time into a ring buffer per drone.
+ */
+
+#ifndef DRONETRAILS_H
+#define DRONETRAILS_H
+
+#include <QVector>
+#include "droneregistry.h"
+#include "vector2d.h"
+
+/**
+ * @class DroneTrails
+ * @brief Fixed-capacity ring buffers of positions, one per slot of a DroneRegistry.
+ *
+ * The rings of all the drones are stored contiguously in a single array, the ring of
+ * slot s at s * capacity, so that recording a sample is a pass over the registry
+ * without allocation once the array covers the slots in use. A ring is emptied when
+ * its drone lands, and when its slot is reused by another drone (its generation
+ * changed).
+ */
+class DroneTrails {
+public:
+    static constexpr int defaultCapacity = 32; ///< Default number of positions per drone.
+    static constexpr double defaultInterval = 0.25; ///< Default simulated time between two samples, in seconds.
+
+    /**
+     * @brief Set the number of positions kept per drone, emptying the trails.
+     * @param points The number of positions, at least 2.
+     */
+    void setCapacity(int points);
+
+    /**
+     * @brief Get the number of positions kept per drone.
+     * @return The number of positions.
+     */
+    inline int getCapacity() const { return capacity; }
+
+    /**
+     * @brief Set the simulated time between two samples.
+     * @param seconds The interval in seconds, 0 to sample at each call of record().
+     */
+    inline void setInterval(double seconds) { interval = seconds; }
+
+    /**
+     * @brief Empty the trails.
+     */
+    void clear();
+
+    /**
+     * @brief Add the position of each drone in the air, if a sample is due.
+     * @param drones The registry, giving the handle of each drone.
+     * @param records The state of the drones, in the dense order of the registry.
+     * @param time The simulated time of the records.
+     */
+    void record(const DroneRegistry &drones, const Drone *records, double time);
+
+    /**
+     * @brief Visit the recorded positions of a drone, oldest first.
+     * @param id The handle of the drone.
+     * @param visitor The function called with each position (const Vector2D &).
+     * @return The number of positions visited.
+     */
+    template<typename Visitor>
+    int visit(DroneId id, Visitor visitor) const {
+        if (id.index >= quint32(trails.size()) || trails[id.index].generation != id.generation) {
+            return 0;
+        }
+        const Trail &trail = trails[id.index];
+        const Vector2D *ring = points.constData() + std::size_t(id.index) * capacity;
+        const int start = trail.head - trail.count + (trail.head < trail.count ? capacity : 0);
+        for (int i = 0; i < trail.count; i++) {
+            visitor(ring[start + i < capacity ? start + i : start + i - capacity]);
+        }
+        return trail.count;
+    }
+
+private:
+    /**
+     * @brief Ring of a slot.
+     */
+    struct Trail {
+        quint32 generation = 0; ///< Generation of the drone whose positions are recorded.
+        int head = 0; ///< Position of the next sample in the ring.
+        int count = 0; ///< Number of positions in the ring.
+    };
+
+    QVector<Trail> trails; ///< Ring of each slot.
+    QVector<Vector2D> points; ///< Positions of all the rings, capacity per slot.
+    int capacity = defaultCapacity; ///< Number of positions per ring.
+    double interval = defaultInterval; ///< Simulated time between two samples.
+    double nextSample = 0; ///< Simulated time of the next sample.
+};
+
+#endif // DRONETRAILS_H
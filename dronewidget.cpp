@@ -0,0 +1,126 @@
+#include "dronewidget.h"
+#include <QPainter>
+#include <QStyle>
+
+QImage DroneWidget::compasImg;
+QImage DroneWidget::stopImg;
+QImage DroneWidget::takeoffImg;
+QImage DroneWidget::landingImg;
+
+/**
+ * @brief Constructor for the DroneWidget class
+ * @param s The simulation containing the drone
+ * @param id The handle of the drone to display
+ * @param parent The parent widget
+ */
+DroneWidget::DroneWidget(const Simulation *s, DroneId id, QWidget *parent)
+    : QWidget{parent}, simulation(s), droneId(id), paintedStatus(Drone::landed), paintedAzimut(0) {
+    const Drone *drone = simulation->getDrones().find(droneId);
+    QString name = simulation->getDrones().name(droneId);
+    if (drone) {
+        paintedStatus = drone->getStatus();
+        paintedAzimut = drone->getAzimut();
+    }
+    const FlightModel &model = simulation->getFlightModel(drone ? drone->getFlightModel() : 0);
+
+    // Initialize progress bars for speed and power
+    speedPB = new QProgressBar(this);
+    speedPB->setValue(drone ? drone->getSpeed() : 0);
+    speedPB->setMaximum(model.maxSpeed);
+    speedPB->setMinimum(0);
+    speedPB->setFormat(name + " speed %p%");
+    speedPB->setAlignment(Qt::AlignCenter);
+
+    powerPB = new QProgressBar(this);
+    powerPB->setValue(drone ? drone->getPower(model, simulation->getTime()) : 0);
+    powerPB->setMaximum(100);
+    powerPB->setMinimum(0);
+    powerPB->setFormat("power %p%");
+    powerPB->setAlignment(Qt::AlignCenter);
+
+    setBaseSize(barSpace + compasSize, 2 * compasSize);  // Set the base size of the widget
+    setMinimumHeight(2 * compasSize);  // Set the minimum height
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);  // Set the size policy
+
+    // Load images for the drone's UI once for all the widgets
+    if (compasImg.isNull()) {
+        compasImg.load("../../media/compas.png");
+        stopImg.load("../../media/stop.png");
+        takeoffImg.load("../../media/takeoff.png");
+        landingImg.load("../../media/landing.png");
+    }
+}
+
+/**
+ * @brief Update the progress bars and redraw the widget from the drone state
+ */
+void DroneWidget::refresh() {
+    const Drone *drone = simulation->getDrones().find(droneId);
+    if (drone) {
+        refresh(*drone, simulation->getTime());
+    }
+}
+
+/**
+ * @brief Update the progress bars and redraw the widget from a record of the drone
+ * @param drone The record of the drone
+ * @param time The simulated time of the record
+ */
+void DroneWidget::refresh(const Drone &drone, double time) {
+    speedPB->setValue(drone.getSpeed());  // Update the speed progress bar
+    powerPB->setValue(drone.getPower(simulation->getFlightModel(drone.getFlightModel()), time));  // Update the power progress bar
+
+    // Only redraw the icon when it changes (parked drones keep the same icon)
+    if (drone.getStatus() != paintedStatus || (drone.getStatus() >= Drone::hovering && drone.getAzimut() != paintedAzimut)) {
+        paintedStatus = drone.getStatus();
+        paintedAzimut = drone.getAzimut();
+        update();  // Schedule a redraw of the drone
+    }
+}
+
+/**
+ * @brief Handle the paint event (redraw the drone)
+ *
+ * The widget draws the state recorded by the last refresh, so that painting does not
+ * read the drone, which may be updated by another process.
+ * @param event The paint event
+ */
+void DroneWidget::paintEvent(QPaintEvent *) {
+    QPainter painter(this);
+    QRect rect(0, 0, compasSize, compasSize);
+
+    // Draw the image corresponding to the drone's status, as of the last refresh
+    switch (paintedStatus) {
+    case Drone::landed: painter.drawImage(rect, stopImg); break;
+    case Drone::takeoff: painter.drawImage(rect, takeoffImg); break;
+    case Drone::landing: painter.drawImage(rect, landingImg); break;
+    default : {
+        painter.drawImage(rect, compasImg);
+        QPointF points[3];
+        points[0] = QPointF(-compasSize / 5.0, 0);
+        points[1] = QPointF(compasSize / 5.0, 0);
+        points[2] = QPointF(0, compasSize / 2.2);
+        painter.save();
+        painter.translate(compasSize / 2.0, compasSize / 2.0);
+        painter.rotate(paintedAzimut);
+        painter.setBrush(Qt::white);
+        painter.setPen(Qt::black);
+        painter.drawPolygon(points, 3);
+        painter.setBrush(Qt::red);
+        painter.rotate(180);
+        painter.drawPolygon(points, 3);
+        painter.restore();
+    }
+    }
+}
+
+/**
+ * @brief Handle the resize event
+ * @param event The resize event
+ */
+void DroneWidget::resizeEvent(QResizeEvent *) {
+    QRect rect(compasSize + 5, 0, width() - compasSize - 5, compasSize / 2);
+    speedPB->setGeometry(rect);  // Resize the speed progress bar
+    rect.setRect(compasSize + 5, compasSize / 2, width() - compasSize - 5, compasSize / 2);
+    powerPB->setGeometry(rect);  // Resize the power progress bar
+}
@@ -0,0 +1,80 @@
+/**
+ * @brief Drone_demo project
+ * @author B.Piranda
+ * @date dec. 2024
+ **/
+#ifndef DRONEWIDGET_H
+#define DRONEWIDGET_H
+
+#include <QWidget>
+#include <QProgressBar>
+#include <QImage>
+#include "simulation.h"
+
+/**
+ * @brief Widget displaying the state of a drone in the drone list
+ *
+ * The widget shows the status of the drone as an icon (or a compass giving its
+ * direction when flying) and its speed and power as progress bars.
+ * It reads the drone from the registry of the simulation through its handle, so it
+ * stays attached to the same drone when the registry moves drones around.
+ */
+class DroneWidget : public QWidget {
+    Q_OBJECT
+public:
+    static constexpr int compasSize = 48; ///< Size of the compass image
+    static constexpr int barSpace = 150; ///< Minimum size of the progress bar
+
+    /**
+     * @brief DroneWidget constructor
+     * @param simulation The simulation containing the drone
+     * @param id The handle of the drone to display
+     * @param parent The parent widget
+     */
+    DroneWidget(const Simulation *simulation, DroneId id, QWidget *parent = nullptr);
+
+    /**
+     * @brief Get the handle of the displayed drone
+     * @return The handle of the drone
+     */
+    inline DroneId getDroneId() const { return droneId; }
+
+    /**
+     * @brief Update the progress bars and redraw the widget from the drone state
+     */
+    void refresh();
+
+    /**
+     * @brief Update the progress bars and redraw the widget from a record of the drone
+     *
+     * Used when the state of the drone is kept outside of the simulation (shared fleet
+     * of a multi-process simulation). The record is only read during the call.
+     *
+     * @param drone The record of the drone
+     * @param time The simulated time of the record
+     */
+    void refresh(const Drone &drone, double time);
+
+    /**
+     * @brief Handle the paint event
+     * @param event The paint event
+     */
+    void paintEvent(QPaintEvent*) override;
+
+    /**
+     * @brief Handle the resize event
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    const Simulation *simulation; ///< Simulation containing the drone
+    DroneId droneId; ///< Handle of the displayed drone
+    QProgressBar *speedPB; ///< Progress bar for speed
+    QProgressBar *powerPB; ///< Progress bar for power
+    Drone::droneStatus paintedStatus; ///< Status of the drone drawn by the widget
+    double paintedAzimut; ///< Direction of the drone drawn by the widget
+    static QImage compasImg, stopImg, takeoffImg, landingImg; ///< Images for the drone's UI, shared by all the widgets
+};
+
+#endif // DRONEWIDGET_H
@@ -0,0 +1,33 @@
+#include "eventscheduler.h"
+#include <algorithm>
+
+/**
+ * @brief Order of the heap: true if a happens after b, so that the next event is on top.
+ * @param a The first event.
+ * @param b The second event.
+ * @return True if a must be taken after b.
+ */
+static bool isLater(const SimulationEvent &a, const SimulationEvent &b) {
+    if (a.time != b.time) {
+        return a.time > b.time;
+    }
+    return a.drone.index > b.drone.index;
+}
+
+/**
+ * @brief Add an event.
+ * @param event The event to schedule.
+ */
+void EventScheduler::schedule(const SimulationEvent &event) {
+    heap.append(event);
+    std::push_heap(heap.begin(), heap.end(), isLater);
+}
+
+/**
+ * @brief Remove and return the next event.
+ * @return The event with the smallest time (the scheduler must not be empty).
+ */
+SimulationEvent EventScheduler::takeNext() {
+    std::pop_heap(heap.begin(), heap.end(), isLater);
+    return heap.takeLast();
+}
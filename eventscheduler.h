@@ -0,0 +1,82 @@
+/**
+ * @file eventscheduler.h
+ * @brief Priority queue of the events of the simulation, ordered by simulated time.
+ *
+ * This file declares the SimulationEvent record and the EventScheduler class, used by
+ * the simulation to end the phases of the drones that are computed analytically
+ * (charging, takeoff and landing) instead of being updated at every step.
+ */
+
+#ifndef EVENTSCHEDULER_H
+#define EVENTSCHEDULER_H
+
+#include <QVector>
+#include "droneregistry.h"
+
+/**
+ * @brief Scheduled end of the current phase of a drone.
+ */
+struct SimulationEvent {
+    double time; ///< Simulated time of the event in seconds.
+    DroneId drone; ///< Drone concerned by the event.
+    quint32 phase; ///< Phase counter of the drone when the event was scheduled.
+};
+
+/**
+ * @class EventScheduler
+ * @brief Min-heap of SimulationEvent ordered by time.
+ *
+ * Events are never removed before their time: when the phase of a drone changes
+ * before its event, the event is detected as stale from its phase counter when it
+ * is taken. Events with the same time are taken in the order of their drone slot, so
+ * that the simulation stays deterministic.
+ */
+class EventScheduler {
+public:
+    /**
+     * @brief Add an event.
+     * @param event The event to schedule.
+     */
+    void schedule(const SimulationEvent &event);
+
+    /**
+     * @brief Check if an event is due.
+     * @param time The current simulated time.
+     * @return True if the next event happens at or before this time.
+     */
+    inline bool hasEventBefore(double time) const { return !heap.isEmpty() && heap.first().time <= time; }
+
+    /**
+     * @brief Remove and return the next event.
+     * @return The event with the smallest time (the scheduler must not be empty).
+     */
+    SimulationEvent takeNext();
+
+    /**
+     * @brief Remove all the events.
+     */
+    inline void clear() { heap.clear(); }
+
+    /**
+     * @brief Reserve memory for a number of pending events.
+     * @param count The number of events.
+     */
+    inline void reserve(int count) { heap.reserve(count); }
+
+    /**
+     * @brief Get the number of pending events (including stale ones).
+     * @return The number of events.
+     */
+    inline int size() const { return heap.size(); }
+
+    /**
+     * @brief Get the number of events that can be pending without reallocation.
+     * @return The capacity of the heap.
+     */
+    inline int capacity() const { return heap.capacity(); }
+
+private:
+    QVector<SimulationEvent> heap; ///< Binary heap of the events, the next one first.
+};
+
+#endif // EVENTSCHEDULER_H
@@ -0,0 +1,222 @@
+#include "fleetprocess.h"
+#include "sharedfleet.h"
+#include "simulation.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+
+namespace FleetProcess {
+
+static constexpr unsigned long pollInterval = 50; ///< Sleep between two polls of the counters, in microseconds.
+static constexpr int processCheckPolls = 20; ///< Polls between two checks of the worker processes.
+static constexpr qint64 idleTimeout = 10000; ///< Time after which a worker without tick assumes the coordinator is gone, in ms.
+
+/**
+ * @brief Start a worker process.
+ * @param options The options of the simulation.
+ * @param rank The index of the worker.
+ * @return The process, or nullptr if it could not be started.
+ */
+static QProcess *startWorker(const Options &options, int rank) {
+    QProcess *process = new QProcess();
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    process->start(QCoreApplication::applicationFilePath(),
+                   {"--worker", "--key", options.key, "--scenario", options.scenario,
+                    "--rank", QString::number(rank), "--integrator", Integrator::name(options.integrator)});
+    if (!process->waitForStarted()) {
+        delete process;
+        return nullptr;
+    }
+    return process;
+}
+
+/**
+ * @brief Run the coordinator.
+ *
+ * At each tick, the back buffer is marked as being written, the tick is requested from
+ * the workers through the epoch counter, and the coordinator waits for all the workers
+ * to publish it. A worker that dies is started again: it rebuilds its state from the
+ * front buffer, which is not modified during a tick, and completes the tick.
+ * Then the back buffer is closed and becomes the front buffer.
+ *
+ * @param options The options of the simulation.
+ * @return The exit code of the process.
+ */
+int runCoordinator(const Options &options) {
+    Scenario scenario;
+    if (!scenario.load(options.scenario)) {
+        qCritical() << "Cannot load scenario:" << options.scenario;
+        return 1;
+    }
+    Simulation simulation;
+    simulation.load(scenario);
+    DroneRegistry &drones = simulation.getDrones();
+    if (options.takeoff) {
+        for (int i = 0; i < drones.size(); i++) {
+            simulation.start(drones.idAt(i));
+        }
+    }
+
+    SharedFleet fleet(options.key);
+    if (!fleet.create(drones.size(), options.workers)) {
+        qCritical() << "Cannot create the shared fleet" << options.key << ":" << fleet.errorString();
+        return 1;
+    }
+    SharedFleet::Header *header = fleet.header();
+    std::copy(drones.begin(), drones.end(), fleet.buffer(0));
+    std::copy(drones.begin(), drones.end(), fleet.buffer(1));
+
+    QVector<QProcess*> workers(options.workers, nullptr);
+    auto stopWorkers = [&]() {
+        header->stopped.store(1, std::memory_order_release);
+        for (QProcess *process : workers) {
+            if (process && !process->waitForFinished(1000)) {
+                process->kill();
+                process->waitForFinished();
+            }
+            delete process;
+        }
+    };
+    for (int rank = 0; rank < options.workers; rank++) {
+        workers[rank] = startWorker(options, rank);
+        if (!workers[rank]) {
+            qCritical() << "Cannot start worker" << rank;
+            stopWorkers();
+            return 1;
+        }
+    }
+
+    const qint64 tickInterval = options.speed > 0 ? qint64(options.dt / options.speed * 1e9) : 0;
+    QElapsedTimer clock;
+    clock.start();
+    double time = 0;
+    quint64 epoch = 0;
+    int restarts = 0;
+    while (options.duration <= 0 || time < options.duration) {
+        // Follow the wall clock multiplied by the speed
+        qint64 due = qint64(epoch) * tickInterval;
+        while (clock.nsecsElapsed() < due) {
+            QThread::usleep(qMin<qint64>(1000, (due - clock.nsecsElapsed()) / 1000 + 1));
+        }
+
+        const int back = 1 - int(header->front.load(std::memory_order_relaxed));
+        header->sequence[back].fetch_add(1, std::memory_order_acq_rel);  // Odd: readers retry
+        header->dt = options.dt;
+        header->epoch.store(++epoch, std::memory_order_release);
+
+        // Wait for all the workers, and restart those that died
+        for (int polls = 1, rank = 0; rank < options.workers; polls++) {
+            if (header->done[rank].load(std::memory_order_acquire) >= epoch) {
+                rank++;
+                continue;
+            }
+            QThread::usleep(pollInterval);
+            if (polls % processCheckPolls == 0) {
+                for (int r = rank; r < options.workers; r++) {
+                    QProcess *&process = workers[r];
+                    if (process->state() == QProcess::NotRunning || process->waitForFinished(0)) {
+                        qWarning() << "Worker" << r << "exited with code" << process->exitCode() << "at tick" << epoch << ", restarting it";
+                        delete process;
+                        process = startWorker(options, r);
+                        restarts++;
+                        if (!process) {
+                            qCritical() << "Cannot restart worker" << r;
+                            stopWorkers();
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+
+        time += options.dt;
+        header->time[back] = time;
+        header->sequence[back].fetch_add(1, std::memory_order_release);  // Even: consistent again
+        header->front.store(quint32(back), std::memory_order_release);
+    }
+
+    stopWorkers();
+    qInfo() << "Simulated" << time << "s in" << epoch << "ticks with" << options.workers << "workers,"
+            << clock.nsecsElapsed() * 1e-6 / qMax<quint64>(epoch, 1) << "ms per tick," << restarts << "restarts";
+    return 0;
+}
+
+/**
+ * @brief Run a worker.
+ *
+ * The worker owns a range of the drones of the scenario (SharedFleet::workerRange()),
+ * except the drones targeting servers with a limited capacity, and all the drones of
+ * the scheduled servers of its rank (see Simulation::setPartition()).
+ * At each tick, it imports the other drones from the front buffer as obstacles, steps
+ * its own drones, writes them to the back buffer and publishes the tick.
+ *
+ * @param key The key of the shared memory segment.
+ * @param scenarioFile The scenario file loaded by the coordinator.
+ * @param rank The index of the worker, which gives its range of drones.
+ * @param integrator The integration method.
+ * @return The exit code of the process.
+ */
+int runWorker(const QString &key, const QString &scenarioFile, int rank, Integrator::Method integrator) {
+    SharedFleet fleet(key);
+    if (!fleet.attach(false)) {
+        qCritical() << "Worker" << rank << "cannot attach to the shared fleet" << key << ":" << fleet.errorString();
+        return 1;
+    }
+    SharedFleet::Header *header = fleet.header();
+    const int workerCount = int(header->workerCount);
+    if (rank < 0 || rank >= workerCount) {
+        qCritical() << "Invalid worker rank:" << rank;
+        return 1;
+    }
+
+    Scenario scenario;
+    if (!scenario.load(scenarioFile)) {
+        qCritical() << "Worker" << rank << "cannot load scenario:" << scenarioFile;
+        return 1;
+    }
+    Simulation simulation;
+    simulation.load(scenario);
+    simulation.setIntegrator(integrator);
+    const int count = fleet.droneCount();
+    if (simulation.getDrones().size() != count) {
+        qCritical() << "Worker" << rank << "loaded" << simulation.getDrones().size() << "drones instead of" << count;
+        return 1;
+    }
+    int begin, end;
+    SharedFleet::workerRange(rank, workerCount, count, begin, end);
+    simulation.setPartition(begin, end, rank, workerCount);
+
+    // The front buffer is not modified until all the workers have completed the tick
+    int front = int(header->front.load(std::memory_order_acquire));
+    simulation.restore(fleet.buffer(front), count, header->time[front]);
+
+    quint64 done = header->done[rank].load(std::memory_order_relaxed);
+    QElapsedTimer idle;
+    idle.start();
+    while (!header->stopped.load(std::memory_order_acquire)) {
+        quint64 epoch = header->epoch.load(std::memory_order_acquire);
+        if (epoch == done) {
+            if (idle.elapsed() > idleTimeout) {
+                qWarning() << "Worker" << rank << "received no tick for" << idleTimeout << "ms, exiting";
+                return 1;
+            }
+            QThread::usleep(pollInterval);
+            continue;
+        }
+        front = int(header->front.load(std::memory_order_acquire));
+        const Drone *records = fleet.buffer(front);
+        simulation.importDrones(records, 0, count);
+        simulation.step(header->dt);
+        simulation.exportDrones(fleet.buffer(1 - front));
+        header->done[rank].store(epoch, std::memory_order_release);
+        done = epoch;
+        idle.restart();
+    }
+    return 0;
+}
+
+} // namespace FleetProcess
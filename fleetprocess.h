@@ -0,0 +1,53 @@
+/**
+ * @file fleetprocess.h
+ * @brief Coordinator and worker processes of the multi-process simulation.
+ *
+ * The coordinator creates the SharedFleet segment from a scenario, starts one worker
+ * process per range of drones and owns the tick. The workers load the same scenario,
+ * step their drones (their range, and the drones of the servers with a limited capacity
+ * that they own) and publish them in the segment. A viewer (MainWindow) can attach to
+ * the segment read-only to display the fleet.
+ */
+
+#ifndef FLEETPROCESS_H
+#define FLEETPROCESS_H
+
+#include <QString>
+#include "integrator.h"
+
+namespace FleetProcess {
+
+/**
+ * @brief Options of the coordinator, passed on to the workers.
+ */
+struct Options {
+    QString key = "drones-fleet"; ///< Key of the shared memory segment.
+    QString scenario; ///< Scenario file (.json or .dsb).
+    int workers = 2; ///< Number of worker processes.
+    double dt = 0.02; ///< Duration of a tick in seconds.
+    double speed = 1; ///< Simulated seconds per wall clock second (0 for as fast as possible).
+    double duration = 0; ///< Simulated duration in seconds (0 to run until killed).
+    bool takeoff = false; ///< True to make all the drones take off at the start.
+    Integrator::Method integrator = Integrator::semiImplicitEuler; ///< Integration method of the workers.
+};
+
+/**
+ * @brief Run the coordinator.
+ * @param options The options of the simulation.
+ * @return The exit code of the process.
+ */
+int runCoordinator(const Options &options);
+
+/**
+ * @brief Run a worker.
+ * @param key The key of the shared memory segment.
+ * @param scenarioFile The scenario file loaded by the coordinator.
+ * @param rank The index of the worker, which gives its range of drones.
+ * @param integrator The integration method.
+ * @return The exit code of the process.
+ */
+int runWorker(const QString &key, const QString &scenarioFile, int rank, Integrator::Method integrator);
+
+} // namespace FleetProcess
+
+#endif // FLEETPROCESS_H
@@ -0,0 +1,61 @@
+/**
+ * @file flightmodel.h
+ * @brief Flight characteristics shared by the drones of a same type.
+ *
+ * This file declares the FlightModel profile, referenced by index from the drones so
+ * that a fleet can mix several types of drones, and DefaultFlightModel, the same
+ * constants known at compile time, used by the simulation as a fast path for the
+ * drones of the default type.
+ */
+
+#ifndef FLIGHTMODEL_H
+#define FLIGHTMODEL_H
+
+/**
+ * @brief Characteristics of the default type of drone, known at compile time.
+ *
+ * It has the same members as FlightModel, so that the code of the drone can be
+ * instantiated for both; with this one the constants are folded by the compiler.
+ */
+struct DefaultFlightModel {
+    static constexpr double maxSpeed = 50; ///< Max speed in pixels per second
+    static constexpr double maxPower = 200; ///< Max power of drone motors
+    static constexpr double takeoffSpeed = 2.5; ///< Takeoff speed in units per second
+    static constexpr double hoveringHeight = 5; ///< Hovering height in units
+    static constexpr double coefCollision = 1000; ///< Coefficient for collision avoidance
+    static constexpr double damping = 0.2; ///< Damping for motion simulation
+    static constexpr double chargingSpeed = 10; ///< Charging speed in power per second
+    static constexpr double powerConsumption = 5; ///< Power consumption in power per second
+};
+
+/**
+ * @brief Characteristics of a type of drone, loaded from a scenario.
+ *
+ * The default values are those of DefaultFlightModel.
+ */
+struct FlightModel {
+    double maxSpeed = DefaultFlightModel::maxSpeed; ///< Max speed in pixels per second
+    double maxPower = DefaultFlightModel::maxPower; ///< Max power of drone motors
+    double takeoffSpeed = DefaultFlightModel::takeoffSpeed; ///< Takeoff speed in units per second
+    double hoveringHeight = DefaultFlightModel::hoveringHeight; ///< Hovering height in units
+    double coefCollision = DefaultFlightModel::coefCollision; ///< Coefficient for collision avoidance
+    double damping = DefaultFlightModel::damping; ///< Damping for motion simulation
+    double chargingSpeed = DefaultFlightModel::chargingSpeed; ///< Charging speed in power per second
+    double powerConsumption = DefaultFlightModel::powerConsumption; ///< Power consumption in power per second
+
+    /**
+     * @brief Check if the profile has the characteristics of DefaultFlightModel.
+     * @return True if all the values are the default ones.
+     */
+    bool isDefault() const { return *this == FlightModel(); }
+
+    friend bool operator==(const FlightModel &a, const FlightModel &b) {
+        return a.maxSpeed == b.maxSpeed && a.maxPower == b.maxPower && a.takeoffSpeed == b.takeoffSpeed
+            && a.hoveringHeight == b.hoveringHeight && a.coefCollision == b.coefCollision
+            && a.damping == b.damping && a.chargingSpeed == b.chargingSpeed
+            && a.powerConsumption == b.powerConsumption;
+    }
+    friend bool operator!=(const FlightModel &a, const FlightModel &b) { return !(a == b); }
+};
+
+#endif // FLIGHTMODEL_H
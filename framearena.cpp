@@ -0,0 +1,88 @@
+#include "framearena.h"
+#include <cstdint>
+#include <new>
+
+/**
+ * @brief Constructs an arena.
+ * @param initialSize The size of the first memory block, in bytes.
+ */
+FrameArena::FrameArena(std::size_t initialSize) {
+    addBlock(initialSize);
+}
+
+/**
+ * @brief Destructor, frees all the memory blocks.
+ */
+FrameArena::~FrameArena() {
+    for (const Block &block : blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+/**
+ * @brief Add a memory block.
+ * @param size The minimum size of the block in bytes.
+ */
+void FrameArena::addBlock(std::size_t size) {
+    Block block;
+    block.size = size;
+    block.data = static_cast<char *>(::operator new(size));  // Counted by AllocationCounter
+    blocks.append(block);
+    offset = 0;
+}
+
+/**
+ * @brief Allocate raw memory.
+ *
+ * A new block, at least twice as large as the current one, is added if the request
+ * does not fit in the current block.
+ *
+ * @param bytes The size in bytes.
+ * @param align The alignment of the memory.
+ * @return A pointer to the memory.
+ */
+void *FrameArena::allocateBytes(std::size_t bytes, std::size_t align) {
+    const Block *block = &blocks.last();
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block->data);
+    std::size_t start = ((base + offset + align - 1) & ~std::uintptr_t(align - 1)) - base;
+    if (start + bytes > block->size) {
+        addBlock(qMax(2 * block->size, bytes + align));
+        block = &blocks.last();
+        base = reinterpret_cast<std::uintptr_t>(block->data);
+        start = ((base + align - 1) & ~std::uintptr_t(align - 1)) - base;
+    }
+    offset = start + bytes;
+    usedBytes += bytes;
+    return block->data + start;
+}
+
+/**
+ * @brief Make all the memory available again.
+ *
+ * If the last tick needed several blocks, they are replaced by one block holding
+ * their total size.
+ */
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        std::size_t total = capacity();
+        for (const Block &block : blocks) {
+            ::operator delete(block.data);
+        }
+        blocks.clear();
+        addBlock(total);
+    }
+    offset = 0;
+    usedBytes = 0;
+}
+
+/**
+ * @brief Get the total size of the memory blocks.
+ * @return The capacity in bytes.
+ */
+std::size_t FrameArena::capacity() const {
+    std::size_t total = 0;
+    for (const Block &block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
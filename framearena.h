@@ -0,0 +1,101 @@
+/**
+ * @file framearena.h
+ * @brief Scratch memory for the data of one simulation tick.
+ *
+ * This file declares the FrameArena class, a bump allocator that is reset at the
+ * beginning of every tick so that temporary arrays do not cost heap allocations.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <type_traits>
+#include <QVector>
+
+/**
+ * @class FrameArena
+ * @brief Bump allocator for per-tick scratch data.
+ *
+ * Allocations only move an offset in a memory block. Nothing is freed individually:
+ * reset() makes the whole memory available again for the next tick. When a tick needs
+ * more memory than available, a new block is added; at the following reset the blocks
+ * are merged into a single one large enough for the whole tick, so that a steady-state
+ * tick does not allocate any heap memory.
+ * Only trivially destructible types can be allocated, as no destructor is ever called.
+ */
+class FrameArena {
+public:
+    /**
+     * @brief Constructs an arena.
+     * @param initialSize The size of the first memory block, in bytes.
+     */
+    explicit FrameArena(std::size_t initialSize = 64 * 1024);
+
+    /**
+     * @brief Destructor, frees all the memory blocks.
+     */
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /**
+     * @brief Allocate an uninitialized array.
+     * @param n The number of elements.
+     * @return A pointer to the array, valid until the next reset().
+     */
+    template <typename T>
+    T *allocate(std::size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena cannot call destructors");
+        return static_cast<T *>(allocateBytes(n * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Make all the memory available again.
+     *
+     * Pointers returned by allocate() become invalid.
+     */
+    void reset();
+
+    /**
+     * @brief Get the total size of the memory blocks.
+     * @return The capacity in bytes.
+     */
+    std::size_t capacity() const;
+
+    /**
+     * @brief Get the number of bytes allocated since the last reset.
+     * @return The used size in bytes.
+     */
+    inline std::size_t used() const { return usedBytes; }
+
+private:
+    /**
+     * @brief A memory block of the arena.
+     */
+    struct Block {
+        char *data; ///< Start of the block.
+        std::size_t size; ///< Size of the block in bytes.
+    };
+
+    QVector<Block> blocks; ///< Memory blocks, the last one being the current one.
+    std::size_t offset = 0; ///< Offset of the free memory in the current block.
+    std::size_t usedBytes = 0; ///< Bytes allocated since the last reset.
+
+    /**
+     * @brief Allocate raw memory.
+     * @param bytes The size in bytes.
+     * @param align The alignment of the memory.
+     * @return A pointer to the memory.
+     */
+    void *allocateBytes(std::size_t bytes, std::size_t align);
+
+    /**
+     * @brief Add a memory block.
+     * @param size The minimum size of the block in bytes.
+     */
+    void addBlock(std::size_t size);
+};
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,203 @@
+#include "frameexporter.h"
+#include <QDebug>
+#include <cstdio>
+
+static const char *const formatNames[] = { "png", "raw" }; ///< Names of FrameExporter::Format.
+static constexpr double timeTolerance = 1e-6; ///< Rounding error of the simulated time accepted for a frame, in seconds.
+
+/**
+ * @brief Find a format from its name.
+ * @param name The name of the format ("png" or "raw").
+ * @param format Receives the format.
+ * @return True if the name designates a format.
+ */
+bool FrameExporter::formatFromName(const QString &name, Format &format) {
+    for (int i = 0; i < 2; i++) {
+        if (name.compare(formatNames[i], Qt::CaseInsensitive) == 0) {
+            format = Format(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Constructs a closed exporter.
+ */
+FrameExporter::FrameExporter() {}
+
+/**
+ * @brief Encodes the queued frames and closes the exporter.
+ */
+FrameExporter::~FrameExporter() {
+    close();
+}
+
+/**
+ * @brief Create the output and start the encoder threads.
+ *
+ * The frame buffers are allocated here, so that the export does not allocate them
+ * while the simulation runs.
+ *
+ * @param path The directory of the PNG files, or the file of the raw frames ("-" for the standard output).
+ * @param opts The options of the export.
+ * @param start The simulated time of the first frame.
+ * @return True if the output was created.
+ */
+bool FrameExporter::open(const QString &path, const Options &opts, double start) {
+    close();
+    options = opts;
+    if (options.frameRate <= 0 || options.size.isEmpty()) {
+        error = "Invalid frame rate or size";
+        return false;
+    }
+    options.capacity = qMax(1, options.capacity);
+    if (options.format == raw) {
+        options.encoderCount = 1;  // The frames of a stream are written in order
+        bool opened;
+        if (path == "-") {
+            opened = output.open(stdout, QIODevice::WriteOnly);
+        } else {
+            output.setFileName(path);
+            opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        }
+        if (!opened) {
+            error = output.errorString();
+            return false;
+        }
+    } else {
+        options.encoderCount = qMax(1, options.encoderCount);
+        directory.setPath(path);
+        if (!directory.mkpath(".")) {
+            error = "Cannot create the directory";
+            return false;
+        }
+    }
+
+    frames.clear();
+    freeFrames.clear();
+    for (int i = 0; i < options.capacity; i++) {
+        frames.append(QImage(options.size, QImage::Format_RGB32));
+        freeFrames.append(i);
+    }
+    pending.clear();
+    pending.reserve(options.capacity);
+    stopping = false;
+    failed = 0;
+    startTime = start;
+    frameCount = 0;
+    stalls = 0;
+    for (int i = 0; i < options.encoderCount; i++) {
+        QThread *encoder = QThread::create([this]() { encodeLoop(); });
+        encoder->start(QThread::LowPriority);  // The simulation comes first
+        encoders.append(encoder);
+    }
+    return true;
+}
+
+/**
+ * @brief Encode the queued frames, stop the encoder threads and close the output.
+ */
+void FrameExporter::close() {
+    if (encoders.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+    }
+    frameQueued.wakeAll();
+    for (QThread *encoder : encoders) {
+        encoder->wait();
+    }
+    qDeleteAll(encoders);
+    encoders.clear();
+    frames.clear();  // Releases the buffers
+    output.close();
+    if (failed > 0) {
+        qWarning() << "Frame export failed to write" << failed << "of" << frameCount << "frames";
+    }
+}
+
+/**
+ * @brief Check if the next frame must be rendered (simulation thread).
+ * @param time The simulated time.
+ * @return True if the exporter is open and the time of the next frame is reached.
+ */
+bool FrameExporter::isDue(double time) const {
+    // Computed from the frame number, so that the frame times do not drift
+    return !encoders.isEmpty() && time + timeTolerance >= startTime + frameCount / options.frameRate;
+}
+
+/**
+ * @brief Get a free buffer to render the next frame into, waiting for the encoders if there is none (simulation thread).
+ * @return The buffer, of the size of the frames, with undefined content.
+ */
+QImage &FrameExporter::beginFrame() {
+    QMutexLocker locker(&mutex);
+    if (freeFrames.isEmpty()) {
+        stalls++;  // The encoders cannot keep up: slow the simulation down rather than drop a frame
+        while (freeFrames.isEmpty()) {
+            frameFree.wait(&mutex);
+        }
+    }
+    current = freeFrames.takeLast();
+    return frames[current];
+}
+
+/**
+ * @brief Queue the frame rendered into the buffer of beginFrame() for the encoders (simulation thread).
+ */
+void FrameExporter::endFrame() {
+    {
+        QMutexLocker locker(&mutex);
+        pending.append(Pending{current, frameCount});
+    }
+    frameCount++;
+    current = -1;
+    frameQueued.wakeOne();
+}
+
+/**
+ * @brief Body of the encoder threads.
+ *
+ * Each encoder takes the oldest queued frame, writes it without holding the lock and
+ * gives its buffer back. The encoders stop once the queue is empty after close().
+ */
+void FrameExporter::encodeLoop() {
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        while (pending.isEmpty() && !stopping) {
+            frameQueued.wait(&mutex);
+        }
+        if (pending.isEmpty()) {
+            return;
+        }
+        const Pending frame = pending.takeFirst();
+        locker.unlock();
+
+        const bool written = write(frames.at(frame.buffer), frame.number);  // Read-only: the buffer is not detached
+
+        locker.relock();
+        if (!written) {
+            failed++;
+        }
+        freeFrames.append(frame.buffer);
+        frameFree.wakeOne();
+    }
+}
+
+/**
+ * @brief Write a frame to the output (encoder threads).
+ * @param frame The frame.
+ * @param number The number of the frame.
+ * @return True if the frame was written.
+ */
+bool FrameExporter::write(const QImage &frame, quint64 number) {
+    if (options.format == raw) {
+        // Rows of 32-bit pixels are contiguous: the whole frame is written at once
+        return output.write(reinterpret_cast<const char*>(frame.constBits()), frame.sizeInBytes()) == frame.sizeInBytes();
+    }
+    const QString name = QString("frame_%1.png").arg(number, 6, 10, QChar('0'));
+    return frame.save(directory.filePath(name), "PNG");
+}
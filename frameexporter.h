@@ -0,0 +1,188 @@
+/**
+ * @file frameexporter.h
+ * @brief Export of rendered frames as an image sequence or a raw video stream.
+ *
+ * This file declares the FrameExporter class, which takes frames rendered offscreen
+ * at a fixed rate of simulated time and encodes them on a pool of threads, as numbered
+ * PNG files or as raw pixels for an external encoder.
+ */
+
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * @class FrameExporter
+ * @brief Encodes frames on worker threads through a bounded pool of frame buffers.
+ *
+ * The simulation thread asks isDue() after each step; for each frame due, it renders
+ * into the buffer given by beginFrame() and queues it with endFrame(). The frames are
+ * numbered from 0, frame n showing the simulation at the start time plus n / frameRate,
+ * whatever the speed of the simulation.
+ *
+ * The buffers are allocated by open() and reused: the queue never holds more than
+ * Options::capacity frames. The simulation only waits in beginFrame() when all the
+ * buffers are waiting for the encoders; these waits are counted, and a frame is never
+ * dropped.
+ *
+ * A PNG sequence is written to a directory as frame_000000.png, frame_000001.png...
+ * by all the encoders in parallel. Raw frames are written in order by a single encoder,
+ * as Options::size pixels of 4 bytes (B, G, R, 255 on little-endian machines), without
+ * header, for example for `ffmpeg -f rawvideo -pixel_format bgra -video_size 1280x720
+ * -framerate 30 -i pipe:`.
+ */
+class FrameExporter {
+public:
+    /**
+     * @brief Format of the frames.
+     */
+    enum Format {
+        png, ///< One PNG file per frame in a directory.
+        raw ///< Raw pixels to a file, a named pipe or the standard output.
+    };
+
+    /**
+     * @brief Options of the export.
+     */
+    struct Options {
+        Format format = png; ///< Format of the frames.
+        double frameRate = 30; ///< Frames per simulated second.
+        QSize size = QSize(1280, 720); ///< Size of the frames in pixels.
+        int encoderCount = qMax(1, QThread::idealThreadCount() / 2); ///< Number of encoder threads (1 for raw frames).
+        int capacity = 8; ///< Number of frame buffers.
+    };
+
+    /**
+     * @brief Find a format from its name.
+     * @param name The name of the format ("png" or "raw").
+     * @param format Receives the format.
+     * @return True if the name designates a format.
+     */
+    static bool formatFromName(const QString &name, Format &format);
+
+    /**
+     * @brief Constructs a closed exporter.
+     */
+    FrameExporter();
+
+    /**
+     * @brief Encodes the queued frames and closes the exporter.
+     */
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter &) = delete;
+    FrameExporter &operator=(const FrameExporter &) = delete;
+
+    /**
+     * @brief Create the output and start the encoder threads.
+     * @param path The directory of the PNG files, or the file of the raw frames ("-" for the standard output).
+     * @param options The options of the export.
+     * @param startTime The simulated time of the first frame.
+     * @return True if the output was created.
+     */
+    bool open(const QString &path, const Options &options, double startTime);
+
+    /**
+     * @brief Encode the queued frames, stop the encoder threads and close the output.
+     */
+    void close();
+
+    /**
+     * @brief Check if the exporter is open.
+     * @return True if open() succeeded and close() was not called.
+     */
+    inline bool isOpen() const { return !encoders.isEmpty(); }
+
+    /**
+     * @brief Get the error of the last open().
+     * @return A description of the error.
+     */
+    inline QString errorString() const { return error; }
+
+    /**
+     * @brief Get the size of the frames.
+     * @return The size in pixels.
+     */
+    inline QSize frameSize() const { return options.size; }
+
+    /**
+     * @brief Check if the next frame must be rendered (simulation thread).
+     * @param time The simulated time.
+     * @return True if the exporter is open and the time of the next frame is reached.
+     */
+    bool isDue(double time) const;
+
+    /**
+     * @brief Get a free buffer to render the next frame into, waiting for the encoders if there is none (simulation thread).
+     * @return The buffer, of the size of the frames, with undefined content.
+     */
+    QImage &beginFrame();
+
+    /**
+     * @brief Queue the frame rendered into the buffer of beginFrame() for the encoders (simulation thread).
+     */
+    void endFrame();
+
+    /**
+     * @brief Get the number of frames queued since open().
+     * @return The number of frames.
+     */
+    inline quint64 getFrameCount() const { return frameCount; }
+
+    /**
+     * @brief Get the number of frames for which the simulation waited for a free buffer.
+     * @return The number of waits.
+     */
+    inline quint64 getStallCount() const { return stalls; }
+
+private:
+    /**
+     * @brief Frame waiting for an encoder.
+     */
+    struct Pending {
+        int buffer; ///< Index of the buffer in frames.
+        quint64 number; ///< Number of the frame.
+    };
+
+    /**
+     * @brief Body of the encoder threads.
+     */
+    void encodeLoop();
+
+    /**
+     * @brief Write a frame to the output (encoder threads).
+     * @param frame The frame.
+     * @param number The number of the frame.
+     * @return True if the frame was written.
+     */
+    bool write(const QImage &frame, quint64 number);
+
+    Options options; ///< Options of the export.
+    QDir directory; ///< Directory of the PNG files.
+    QFile output; ///< Output of the raw frames, used by the single encoder.
+    QVector<QThread*> encoders; ///< Encoder threads, empty when the exporter is closed.
+    QVector<QImage> frames; ///< Frame buffers.
+    QMutex mutex; ///< Protects freeFrames, pending, stopping and failed.
+    QWaitCondition frameFree; ///< Signalled when an encoder releases a buffer.
+    QWaitCondition frameQueued; ///< Signalled when a frame is queued or the encoders must stop.
+    QVector<int> freeFrames; ///< Buffers that can be rendered into.
+    QVector<Pending> pending; ///< Frames waiting for an encoder, the oldest first.
+    bool stopping = false; ///< True when the encoders must stop once the queue is empty.
+    quint64 failed = 0; ///< Number of frames that could not be written.
+    QString error; ///< Error of the last open().
+    int current = -1; ///< Buffer given by the last beginFrame().
+    double startTime = 0; ///< Simulated time of the first frame.
+    quint64 frameCount = 0; ///< Number of frames queued.
+    quint64 stalls = 0; ///< Number of waits for a free buffer.
+};
+
+#endif // FRAMEEXPORTER_H
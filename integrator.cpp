@@ -0,0 +1,30 @@
+#include "integrator.h"
+
+/**
+ * @brief Get the name of a method, as used on the command line.
+ * @param method The method.
+ * @return The name ("euler", "verlet" or "rk4").
+ */
+QString Integrator::name(Method method) {
+    switch (method) {
+    case velocityVerlet: return "verlet";
+    case rungeKutta4: return "rk4";
+    default: return "euler";
+    }
+}
+
+/**
+ * @brief Find a method from its name.
+ * @param name The name of the method (case insensitive).
+ * @param method The method found.
+ * @return True if the name designates a method.
+ */
+bool Integrator::fromName(const QString &name, Method &method) {
+    for (int i = 0; i < methodCount; i++) {
+        if (name.compare(Integrator::name(Method(i)), Qt::CaseInsensitive) == 0) {
+            method = Method(i);
+            return true;
+        }
+    }
+    return false;
+}
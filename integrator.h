@@ -0,0 +1,117 @@
+/**
+ * @file integrator.h
+ * @brief Numerical integrators of the flight dynamics of the drones.
+ *
+ * The motion of a flying drone is the solution of x' = v, v' = a(x, v), where the
+ * acceleration pulls the drone towards its goal with the power of its motors, is
+ * damped proportionally to its speed, and includes the collision force of the step
+ * (constant during the step). This file provides several integration methods for
+ * this system, selected at run time with Integrator::Method.
+ */
+
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <QString>
+#include "vector2d.h"
+
+namespace Integrator {
+
+/**
+ * @brief Integration methods, from the cheapest to the most accurate.
+ */
+enum Method {
+    semiImplicitEuler, ///< Velocity first, then position with the new velocity (1 evaluation).
+    velocityVerlet, ///< Position from the current acceleration, velocity from the mean acceleration (2 evaluations).
+    rungeKutta4, ///< Classic fourth order Runge-Kutta (4 evaluations).
+    methodCount ///< Number of methods.
+};
+
+/**
+ * @brief Get the name of a method, as used on the command line.
+ * @param method The method.
+ * @return The name ("euler", "verlet" or "rk4").
+ */
+QString name(Method method);
+
+/**
+ * @brief Find a method from its name.
+ * @param name The name of the method (case insensitive).
+ * @param method The method found.
+ * @return True if the name designates a method.
+ */
+bool fromName(const QString &name, Method &method);
+
+/**
+ * @brief Acceleration of a flying drone.
+ *
+ * The thrust has no direction on the goal itself: it is then zero.
+ *
+ * @param model The flight model of the drone (FlightModel or DefaultFlightModel).
+ * @param position The position of the drone.
+ * @param velocity The velocity of the drone.
+ * @param goal The goal position of the drone.
+ * @param force The collision force, constant during the step.
+ * @return The acceleration.
+ */
+template<typename Model>
+inline Vector2D acceleration(const Model &model, const Vector2D &position, const Vector2D &velocity,
+                             const Vector2D &goal, const Vector2D &force) {
+    Vector2D toGoal = goal - position;
+    Vector2D a = force;
+    float distance = toGoal.length();
+    if (distance > 0) {
+        a.addScaled(float(model.maxPower / distance), toGoal);  // Thrust towards the goal, none once on it
+    }
+    a.addScaled(float(model.damping - 1), velocity);  // Damping
+    return a;
+}
+
+/**
+ * @brief Advance the position and velocity of a drone by one step.
+ * @param method The integration method.
+ * @param model The flight model of the drone (FlightModel or DefaultFlightModel).
+ * @param position The position of the drone, updated.
+ * @param velocity The velocity of the drone, updated.
+ * @param goal The goal position of the drone.
+ * @param force The collision force, constant during the step.
+ * @param dt The duration of the step.
+ */
+template<typename Model>
+inline void integrate(Method method, const Model &model, Vector2D &position, Vector2D &velocity,
+                      const Vector2D &goal, const Vector2D &force, double dt) {
+    const float h = float(dt);
+    switch (method) {
+    case velocityVerlet: {
+        Vector2D a0 = acceleration(model, position, velocity, goal, force);
+        position.addScaled(h, velocity).addScaled(0.5f * h * h, a0);
+        Vector2D predicted = velocity;  // Velocity predicted with the initial acceleration
+        predicted.addScaled(h, a0);
+        Vector2D a1 = acceleration(model, position, predicted, goal, force);
+        velocity.addScaled(0.5f * h, a0 + a1);
+        break;
+    }
+    case rungeKutta4: {
+        const Vector2D x0 = position, v0 = velocity;
+        Vector2D k1x = v0;
+        Vector2D k1v = acceleration(model, x0, v0, goal, force);
+        Vector2D k2x = v0 + (0.5f * h) * k1v;
+        Vector2D k2v = acceleration(model, x0 + (0.5f * h) * k1x, k2x, goal, force);
+        Vector2D k3x = v0 + (0.5f * h) * k2v;
+        Vector2D k3v = acceleration(model, x0 + (0.5f * h) * k2x, k3x, goal, force);
+        Vector2D k4x = v0 + h * k3v;
+        Vector2D k4v = acceleration(model, x0 + h * k3x, k4x, goal, force);
+        position.addScaled(h / 6.0f, k1x + 2.0f * (k2x + k3x) + k4x);
+        velocity.addScaled(h / 6.0f, k1v + 2.0f * (k2v + k3v) + k4v);
+        break;
+    }
+    default:
+        velocity.addScaled(h, acceleration(model, position, velocity, goal, force));
+        position.addScaled(h, velocity);
+        break;
+    }
+}
+
+} // namespace Integrator
+
+#endif // INTEGRATOR_H
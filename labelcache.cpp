@@ -0,0 +1,144 @@
+#include "labelcache.h"
+#include <QFontMetrics>
+#include <cmath>
+
+/**
+ * @brief Constructs an empty cache.
+ * @param font The font of the labels.
+ * @param capacity The number of labels kept.
+ */
+LabelCache::LabelCache(const QFont &font, int capacity)
+    : labels(capacity) {
+    setFont(font);
+}
+
+/**
+ * @brief Change the font of the labels, emptying the cache.
+ * @param font The font.
+ */
+void LabelCache::setFont(const QFont &font) {
+    labelFont = font;
+    labelAscent = QFontMetrics(font).ascent();
+    labels.clear();
+}
+
+/**
+ * @brief Get the label of a text, shaping it if it is not cached.
+ *
+ * The returned label may be evicted by the next call, which may insert another one.
+ * @param text The text.
+ * @return The label, valid until the next call.
+ */
+const QStaticText &LabelCache::label(const QString &text) {
+    if (const QStaticText *cached = labels.object(text)) {
+        return *cached;
+    }
+    QStaticText *label = new QStaticText(text);
+    label->setTextFormat(Qt::PlainText);
+    label->setPerformanceHint(QStaticText::AggressiveCaching);  // Keep the glyph positions for the paint engine
+    label->prepare(QTransform(), labelFont);
+    labels.insert(text, label);
+    return *label;
+}
+
+/**
+ * @brief Start a frame: empty the surface.
+ * @param surface The size of the surface in pixels.
+ */
+void LabelPlacer::begin(const QSize &surface) {
+    columns = qMax(1, (surface.width() + cellSize - 1) / cellSize);
+    rows = qMax(1, (surface.height() + cellSize - 1) / cellSize);
+    heads.fill(-1, columns * rows);
+    next.resize(0);  // Keeps the capacity
+    entryRect.resize(0);
+    rects.resize(0);
+}
+
+/**
+ * @brief Mark a rectangle as taken, whether it overlaps others or not.
+ * @param rect The rectangle in surface pixels.
+ */
+void LabelPlacer::occupy(const QRectF &rect) {
+    const QRect cells = cellsOf(rect);
+    if (cells.isEmpty()) {
+        return;  // Outside of the surface
+    }
+    const int index = rects.size();
+    rects.append(rect);
+    for (int row = cells.top(); row <= cells.bottom(); row++) {
+        for (int column = cells.left(); column <= cells.right(); column++) {
+            int &head = heads[row * columns + column];
+            next.append(head);
+            entryRect.append(index);
+            head = next.size() - 1;
+        }
+    }
+}
+
+/**
+ * @brief Find a free side of an anchor for a label, and take it.
+ *
+ * The sides are tried from the one chosen at the last frame, then in the order right,
+ * left, above and below.
+ *
+ * @param key The identifier of the label, to try its previous side first.
+ * @param anchor The centre of the object labelled, in surface pixels.
+ * @param size The size of the label.
+ * @param offset The distance from the anchor to the label.
+ * @param topLeft Receives the position of the label.
+ * @return True if the label was placed, false if the four sides are taken.
+ */
+bool LabelPlacer::place(quint64 key, const QPointF &anchor, const QSizeF &size, qreal offset, QPointF &topLeft) {
+    const QPointF candidates[4] = {
+        QPointF(anchor.x() + offset, anchor.y() - size.height() / 2),  // Right
+        QPointF(anchor.x() - offset - size.width(), anchor.y() - size.height() / 2),  // Left
+        QPointF(anchor.x() - size.width() / 2, anchor.y() - offset - size.height()),  // Above
+        QPointF(anchor.x() - size.width() / 2, anchor.y() + offset)  // Below
+    };
+    const int previous = sides.value(key, 0);
+    for (int i = 0; i < 4; i++) {
+        const int side = (previous + i) % 4;
+        const QRectF rect(candidates[side], size);
+        if (!overlaps(rect)) {
+            occupy(rect);
+            if (side != previous) {
+                sides.insert(key, quint8(side));
+            }
+            topLeft = candidates[side];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Check if a rectangle overlaps a taken one.
+ * @param rect The rectangle in surface pixels.
+ * @return True if it overlaps.
+ */
+bool LabelPlacer::overlaps(const QRectF &rect) const {
+    const QRect cells = cellsOf(rect);
+    for (int row = cells.top(); row <= cells.bottom(); row++) {
+        for (int column = cells.left(); column <= cells.right(); column++) {
+            for (int entry = heads[row * columns + column]; entry >= 0; entry = next[entry]) {
+                if (rects[entryRect[entry]].intersects(rect)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get the cells of the grid overlapped by a rectangle, clamped to the grid.
+ * @param rect The rectangle in surface pixels.
+ * @return The first and last column and row of the cells, empty if the rectangle is outside.
+ */
+QRect LabelPlacer::cellsOf(const QRectF &rect) const {
+    const int left = qMax(0, int(std::floor(rect.left() / cellSize)));
+    const int top = qMax(0, int(std::floor(rect.top() / cellSize)));
+    const int right = qMin(columns - 1, int(std::floor(rect.right() / cellSize)));
+    const int bottom = qMin(rows - 1, int(std::floor(rect.bottom() / cellSize)));
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
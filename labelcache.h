@@ -0,0 +1,142 @@
+/**
+ * @file labelcache.h
+ * @brief Text labels of the canvas, laid out once and placed without overlap.
+ *
+ * This file declares the LabelCache class, which keeps the shaped text of the labels
+ * from one frame to the next, and the LabelPlacer class, which chooses a side of its
+ * anchor for each label so that the labels do not overlap.
+ */
+
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QRectF>
+#include <QSize>
+#include <QStaticText>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class LabelCache
+ * @brief Prepared QStaticText of the labels drawn with a font, by text.
+ *
+ * Shaping a text is the expensive part of drawing it: the cache shapes each label
+ * once, and keeps the most recently drawn ones. The labels are keyed by their text
+ * and the font of the cache, so a renamed server or drone simply gets a new entry,
+ * and changing the font empties the cache.
+ */
+class LabelCache {
+public:
+    static constexpr int defaultCapacity = 4096; ///< Default number of labels kept.
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param font The font of the labels.
+     * @param capacity The number of labels kept.
+     */
+    explicit LabelCache(const QFont &font, int capacity = defaultCapacity);
+
+    /**
+     * @brief Change the font of the labels, emptying the cache.
+     * @param font The font.
+     */
+    void setFont(const QFont &font);
+
+    /**
+     * @brief Get the font of the labels.
+     * @return The font.
+     */
+    inline const QFont &font() const { return labelFont; }
+
+    /**
+     * @brief Get the distance from the top of a label to its baseline.
+     * @return The ascent of the font in pixels.
+     */
+    inline qreal ascent() const { return labelAscent; }
+
+    /**
+     * @brief Get the label of a text, shaping it if it is not cached.
+     * @param text The text.
+     * @return The label, valid until the next call.
+     */
+    const QStaticText &label(const QString &text);
+
+private:
+    QFont labelFont; ///< Font of the labels.
+    qreal labelAscent; ///< Ascent of the font.
+    QCache<QString, QStaticText> labels; ///< Shaped labels, least recently used first out.
+};
+
+/**
+ * @class LabelPlacer
+ * @brief Places labels beside their anchors without overlapping what is already placed.
+ *
+ * A frame starts with begin(); obstacles (icons, fixed labels) are added with occupy(),
+ * then place() tries the four sides of each anchor. The side chosen for a key is
+ * remembered and tried first at the next frame, so that a label only moves when its
+ * place is taken: the layout is updated incrementally instead of being recomputed.
+ *
+ * The occupied rectangles are bucketed in a grid of cellSize pixels, so that a test
+ * only looks at the rectangles near the label. The memory is reused from one frame to
+ * the next.
+ */
+class LabelPlacer {
+public:
+    static constexpr int cellSize = 64; ///< Side of the cells of the occupancy grid, in pixels.
+
+    /**
+     * @brief Start a frame: empty the surface.
+     * @param surface The size of the surface in pixels.
+     */
+    void begin(const QSize &surface);
+
+    /**
+     * @brief Mark a rectangle as taken, whether it overlaps others or not.
+     * @param rect The rectangle in surface pixels.
+     */
+    void occupy(const QRectF &rect);
+
+    /**
+     * @brief Find a free side of an anchor for a label, and take it.
+     * @param key The identifier of the label, to try its previous side first.
+     * @param anchor The centre of the object labelled, in surface pixels.
+     * @param size The size of the label.
+     * @param offset The distance from the anchor to the label.
+     * @param topLeft Receives the position of the label.
+     * @return True if the label was placed, false if the four sides are taken.
+     */
+    bool place(quint64 key, const QPointF &anchor, const QSizeF &size, qreal offset, QPointF &topLeft);
+
+    /**
+     * @brief Forget the sides chosen for the labels.
+     */
+    inline void clear() { sides.clear(); }
+
+private:
+    /**
+     * @brief Check if a rectangle overlaps a taken one.
+     * @param rect The rectangle in surface pixels.
+     * @return True if it overlaps.
+     */
+    bool overlaps(const QRectF &rect) const;
+
+    /**
+     * @brief Get the cells of the grid overlapped by a rectangle, clamped to the grid.
+     * @param rect The rectangle in surface pixels.
+     * @return The first and last column and row of the cells.
+     */
+    QRect cellsOf(const QRectF &rect) const;
+
+    QHash<quint64, quint8> sides; ///< Side chosen at the last frame for each key.
+    int columns = 0; ///< Number of columns of the grid.
+    int rows = 0; ///< Number of rows of the grid.
+    QVector<int> heads; ///< First entry of each cell, -1 if none.
+    QVector<int> next; ///< Next entry of the same cell, -1 if none.
+    QVector<int> entryRect; ///< Rectangle of each entry.
+    QVector<QRectF> rects; ///< Taken rectangles.
+};
+
+#endif // LABELCACHE_H
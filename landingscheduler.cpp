@@ -0,0 +1,259 @@
+#include "landingscheduler.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Order of the heaps: true if a is served after b, so that the next request is on top.
+ * @param a The first request.
+ * @param b The second request.
+ * @return True if a must be taken after b.
+ */
+static bool isLater(const LandingRequest &a, const LandingRequest &b) {
+    if (a.eta != b.eta) {
+        return a.eta > b.eta;
+    }
+    if (a.power != b.power) {
+        return a.power > b.power;  // The drone with less power lands first
+    }
+    return a.drone.index > b.drone.index;
+}
+
+/**
+ * @brief Set the distance between the pads and between the holding drones.
+ * @param distance The collision distance in pixels.
+ */
+void LandingScheduler::setSpacing(float distance) {
+    spacing = distance;
+    for (Station &station : stations) {
+        if (station.pads > 0) {
+            layOut(station);
+        }
+    }
+}
+
+/**
+ * @brief Replace the servers, emptying the queues.
+ *
+ * A server with charging slots but no landing pads gets one pad.
+ *
+ * @param servers The servers of the simulation, with their capacity.
+ */
+void LandingScheduler::setServers(const QVector<Server> &servers) {
+    stations.clear();
+    stations.resize(servers.size());
+    for (int i = 0; i < servers.size(); i++) {
+        const Server &server = servers[i];
+        if (server.getLandingPads() == 0 && server.getChargingSlots() == 0) {
+            continue;  // Not scheduled
+        }
+        Station &station = stations[i];
+        station.pads = qMax(1, server.getLandingPads());
+        station.chargingSlots = server.getChargingSlots();
+        station.position = server.getPosition();
+        layOut(station);
+        reset(station);
+    }
+}
+
+/**
+ * @brief Free all the pads and slots and empty the queues, keeping the servers.
+ */
+void LandingScheduler::clear() {
+    for (Station &station : stations) {
+        reset(station);
+    }
+}
+
+/**
+ * @brief Free the pads and slots of a station and empty its queue.
+ * @param station The station.
+ */
+void LandingScheduler::reset(Station &station) {
+    station.charging = 0;
+    station.queue.clear();
+    station.holdsTaken.clear();
+    station.freePads.resize(station.pads);
+    for (int pad = 0; pad < station.pads; pad++) {
+        station.freePads[pad] = quint16(station.pads - 1 - pad);  // Pad 0 is given first
+    }
+}
+
+/**
+ * @brief Lay out the pads and the holding ring of a station.
+ *
+ * The pads are on a circle around the server, spacing apart; a single pad is on the
+ * server. The holding ring is holdingFactor spacings outside the circle of the pads,
+ * with hold positions about spacing apart.
+ *
+ * @param station The station.
+ */
+void LandingScheduler::layOut(Station &station) const {
+    const float radius = station.pads > 1 ? spacing / (2 * std::sin(float(M_PI) / station.pads)) : 0;
+    station.padOffsets.resize(station.pads);
+    for (int pad = 0; pad < station.pads; pad++) {
+        const float angle = 2 * float(M_PI) * pad / station.pads;
+        station.padOffsets[pad] = Vector2D(radius * std::cos(angle), radius * std::sin(angle));
+    }
+    station.holdingRadius = radius + holdingFactor * spacing;
+    station.holdsPerRing = qMax(1, int(2 * float(M_PI) * station.holdingRadius / spacing));
+}
+
+/**
+ * @brief Get the point where a holding drone waits.
+ *
+ * Hold position h is on ring h / holdsPerRing, one spacing further out per ring.
+ *
+ * @param server The index of a scheduled server.
+ * @param hold The index of the hold position given to the drone.
+ * @return The position on the holding rings.
+ */
+Vector2D LandingScheduler::holdPosition(int server, int hold) const {
+    const Station &station = stations[server];
+    const float radius = station.holdingRadius + (hold / station.holdsPerRing) * spacing;
+    const float angle = 2 * float(M_PI) * (hold % station.holdsPerRing) / station.holdsPerRing;
+    return station.position + Vector2D(radius * std::cos(angle), radius * std::sin(angle));
+}
+
+/**
+ * @brief Give the free hold position nearest to a direction.
+ *
+ * The positions of the first ring are tried from the direction of the drone, on both
+ * sides alternately, then those of the next ring.
+ *
+ * @param station The station.
+ * @param toDrone The direction from the server to the arriving drone.
+ * @return The index of the hold position.
+ */
+int LandingScheduler::takeHold(Station &station, const Vector2D &toDrone) {
+    const int perRing = station.holdsPerRing;
+    const float turns = std::atan2(toDrone.y, toDrone.x) / (2 * float(M_PI));  // Between -0.5 and 0.5
+    const int preferred = (int(std::lround(turns * perRing)) % perRing + perRing) % perRing;
+    for (int first = 0;; first += perRing) {
+        if (station.holdsTaken.size() < first + perRing) {
+            station.holdsTaken.resize(first + perRing);  // A new ring, all free
+        }
+        for (int offset = 0; offset <= perRing / 2; offset++) {
+            for (int side : {preferred + offset, preferred - offset}) {
+                const int hold = first + (side % perRing + perRing) % perRing;
+                if (!station.holdsTaken[hold]) {
+                    station.holdsTaken[hold] = true;
+                    return hold;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Queue a drone arriving at its target server, and give the free slots.
+ *
+ * The drone holds at the free hold position nearest to where it crosses the holding
+ * ring: each waiting drone has its own point, so that they do not push each other.
+ *
+ * @param drones The registry of the drones.
+ * @param id The handle of the drone, unscheduled and in the air.
+ * @param eta The simulated time at which the drone reaches the server.
+ * @param power The power level of the drone.
+ */
+void LandingScheduler::request(DroneRegistry &drones, DroneId id, double eta, double power) {
+    Drone &drone = *drones.find(id);
+    const int server = drone.getTargetServer();
+    Station &station = stations[server];
+
+    const int hold = takeHold(station, drone.getPosition() - station.position);
+    drone.setGoalPosition(holdPosition(server, hold));
+    drone.setClearance(Drone::holding, hold);
+
+    station.queue.append(LandingRequest{eta, power, id, drone.getPhase()});
+    std::push_heap(station.queue.begin(), station.queue.end(), isLater);
+    dispatch(drones, server);
+}
+
+/**
+ * @brief Take back the pad and slot of a drone that is already cleared, without dispatching them.
+ * @param drone The drone, cleared.
+ */
+void LandingScheduler::adopt(const Drone &drone) {
+    Station &station = stations[drone.getTargetServer()];
+    station.charging++;
+    if (drone.getStatus() != Drone::landed) {
+        station.freePads.removeOne(quint16(drone.getPad()));
+    }
+}
+
+/**
+ * @brief Release the pad of a drone that touched down; its slot too if it landed away from its pad.
+ *
+ * A holding drone that touched down has landed out of power or on command: it leaves
+ * the queue.
+ *
+ * @param drones The registry of the drones.
+ * @param drone The drone, which just landed.
+ */
+void LandingScheduler::touchedDown(DroneRegistry &drones, Drone &drone) {
+    const int server = drone.getTargetServer();
+    Station &station = stations[server];
+    if (drone.getClearance() != Drone::cleared) {
+        freeHold(station, drone.getPad());
+        drone.setClearance(Drone::unscheduled);
+        return;
+    }
+    station.freePads.append(quint16(drone.getPad()));
+    const float tolerance = spacing / 2;
+    if (drone.getPosition().distanceSquared(padPosition(server, drone.getPad())) > tolerance * tolerance) {
+        station.charging--;  // Landed before reaching the pad
+        drone.setClearance(Drone::unscheduled);
+    }
+    dispatch(drones, server);
+}
+
+/**
+ * @brief Release the pad and slot of a drone, which goes back to unscheduled.
+ * @param drones The registry of the drones.
+ * @param drone The drone, holding or cleared (e.g. taking off, retargeted or removed).
+ */
+void LandingScheduler::release(DroneRegistry &drones, Drone &drone) {
+    const Drone::landingClearance clearance = drone.getClearance();
+    if (clearance == Drone::unscheduled) {
+        return;
+    }
+    const int server = drone.getTargetServer();
+    Station &station = stations[server];
+    if (clearance == Drone::holding) {
+        freeHold(station, drone.getPad());  // The request is left stale in the queue
+        drone.setClearance(Drone::unscheduled);
+        return;
+    }
+    drone.setClearance(Drone::unscheduled);
+    station.charging--;
+    if (drone.getStatus() != Drone::landed) {
+        station.freePads.append(quint16(drone.getPad()));
+    }
+    dispatch(drones, server);
+}
+
+/**
+ * @brief Clear the waiting drones of a server while it has free pads and slots.
+ *
+ * A cleared drone takes a pad until it touches down, and reserves a charging slot
+ * until it is fully charged or takes off.
+ *
+ * @param drones The registry of the drones.
+ * @param server The index of a scheduled server.
+ */
+void LandingScheduler::dispatch(DroneRegistry &drones, int server) {
+    Station &station = stations[server];
+    while (!station.queue.isEmpty() && !station.freePads.isEmpty()
+           && (station.chargingSlots == 0 || station.charging < station.chargingSlots)) {
+        std::pop_heap(station.queue.begin(), station.queue.end(), isLater);
+        const LandingRequest request = station.queue.takeLast();
+        Drone *drone = drones.find(request.drone);
+        if (!drone || drone->getPhase() != request.phase || drone->getClearance() != Drone::holding
+            || drone->getTargetServer() != server) {
+            continue;  // The drone was removed, landed or retargeted since it asked
+        }
+        freeHold(station, drone->getPad());
+        drone->setClearance(Drone::cleared, station.freePads.takeLast());
+        station.charging++;
+    }
+}
@@ -0,0 +1,233 @@
+/**
+ * @file landingscheduler.h
+ * @brief Landing slots of the servers with a limited capacity.
+ *
+ * This file declares the LandingRequest record and the LandingScheduler class, used by
+ * the simulation to give the pads and charging slots of the servers to the drones
+ * arriving at them, one at a time, instead of letting them converge on the server and
+ * push each other away.
+ */
+
+#ifndef LANDINGSCHEDULER_H
+#define LANDINGSCHEDULER_H
+
+#include <QVector>
+#include "droneregistry.h"
+#include "server.h"
+#include "vector2d.h"
+
+/**
+ * @brief Request of a landing slot by a drone arriving at a server.
+ */
+struct LandingRequest {
+    double eta; ///< Simulated time at which the drone reaches the server, in seconds.
+    double power; ///< Power level of the drone when it asked (between 0 and 100).
+    DroneId drone; ///< Drone asking for the slot.
+    quint32 phase; ///< Phase counter of the drone when it asked.
+};
+
+/**
+ * @class LandingScheduler
+ * @brief Per-server queues of the drones waiting for a landing pad and a charging slot.
+ *
+ * A server is scheduled when its landing pads or its charging slots are limited (see
+ * Server::setCapacity(), a server with charging slots only has one pad). Its pads are
+ * laid out around it, collisionDistance apart, so that drones landing at the same time
+ * do not repel each other.
+ *
+ * A drone entering the approach area of a scheduled server asks for a slot: it holds on
+ * a ring around the server (Drone::holding), at the free hold position nearest to where
+ * it arrives, and is cleared (Drone::cleared) when a pad and a charging slot are free.
+ * The hold positions are spacing apart on the ring; when the ring is full, the next
+ * drones hold on a ring one spacing further out. The waiting
+ * drones are taken in the order of their arrival time, the drones with less power
+ * first for the same time. The pad is released when the drone touches down, the
+ * charging slot when it is fully charged or takes off.
+ *
+ * The queues are binary heaps: each request and each release costs O(log n) for n
+ * waiting drones. Like the events of the simulation, the requests are not removed when
+ * a drone leaves the queue (removed, retargeted, or landing out of power): they are
+ * detected as stale when they reach the top.
+ *
+ * In the multi-process engine, all the drones targeting a scheduled server are updated
+ * by the same worker (see Simulation::setPartition()), whose scheduler gives the whole
+ * capacity of the server.
+ */
+class LandingScheduler {
+public:
+    static constexpr float holdingFactor = 3; ///< Distance from the pads to the holding ring, in collision distances.
+
+    /**
+     * @brief Set the distance between the pads and between the holding drones.
+     * @param distance The collision distance in pixels.
+     */
+    void setSpacing(float distance);
+
+    /**
+     * @brief Replace the servers, emptying the queues.
+     * @param servers The servers of the simulation, with their capacity.
+     */
+    void setServers(const QVector<Server> &servers);
+
+    /**
+     * @brief Reserve the queue of a server, so that requests do not allocate during a step.
+     * @param server The index of the server.
+     * @param count The number of requests, e.g. the number of drones targeting the server.
+     */
+    inline void reserve(int server, int count) {
+        if (isScheduled(server)) {
+            stations[server].queue.reserve(count);
+            stations[server].holdsTaken.reserve(count + stations[server].holdsPerRing);
+        }
+    }
+
+    /**
+     * @brief Free all the pads and slots and empty the queues, keeping the servers.
+     */
+    void clear();
+
+    /**
+     * @brief Move a server with its pads and holding ring.
+     * @param server The index of the server.
+     * @param position The new position of the server.
+     */
+    inline void moveServer(int server, const Vector2D &position) {
+        if (isScheduled(server)) {
+            stations[server].position = position;
+        }
+    }
+
+    /**
+     * @brief Check if the landings at a server are scheduled.
+     * @param server The index of the server, -1 for none.
+     * @return True if the server has a limited capacity.
+     */
+    inline bool isScheduled(int server) const { return server >= 0 && server < stations.size() && stations[server].pads > 0; }
+
+    /**
+     * @brief Check if a server has a pad.
+     * @param server The index of the server, -1 for none.
+     * @param pad The index of the pad.
+     * @return True if the server is scheduled and has this pad.
+     */
+    inline bool hasPad(int server, int pad) const { return isScheduled(server) && pad >= 0 && pad < stations[server].pads; }
+
+    /**
+     * @brief Get the distance under which a drone asks for a slot.
+     * @param server The index of a scheduled server.
+     * @return The radius of the holding ring of the server.
+     */
+    inline float approachRadius(int server) const { return stations[server].holdingRadius; }
+
+    /**
+     * @brief Get the position of a pad.
+     * @param server The index of a scheduled server.
+     * @param pad The index of the pad.
+     * @return The position of the pad.
+     */
+    inline Vector2D padPosition(int server, int pad) const { return stations[server].position + stations[server].padOffsets[pad]; }
+
+    /**
+     * @brief Get the point where a holding drone waits.
+     * @param server The index of a scheduled server.
+     * @param hold The index of the hold position given to the drone.
+     * @return The position on the holding rings.
+     */
+    Vector2D holdPosition(int server, int hold) const;
+
+    /**
+     * @brief Queue a drone arriving at its target server, and give the free slots.
+     * @param drones The registry of the drones.
+     * @param id The handle of the drone, unscheduled and in the air.
+     * @param eta The simulated time at which the drone reaches the server.
+     * @param power The power level of the drone.
+     */
+    void request(DroneRegistry &drones, DroneId id, double eta, double power);
+
+    /**
+     * @brief Take back the pad and slot of a drone that is already cleared, without dispatching them.
+     *
+     * Used to rebuild the state of the scheduler from the records of the drones.
+     *
+     * @param drone The drone, cleared.
+     */
+    void adopt(const Drone &drone);
+
+    /**
+     * @brief Release the pad of a drone that touched down; its slot too if it landed away from its pad.
+     * @param drones The registry of the drones.
+     * @param drone The drone, which just landed.
+     */
+    void touchedDown(DroneRegistry &drones, Drone &drone);
+
+    /**
+     * @brief Release the pad and slot of a drone, which goes back to unscheduled.
+     *
+     * A drone descending onto its pad is only released when it is removed: otherwise the
+     * pad would be given to another drone while it still lands on it.
+     *
+     * @param drones The registry of the drones.
+     * @param drone The drone, holding or cleared (e.g. taking off, retargeted or removed).
+     */
+    void release(DroneRegistry &drones, Drone &drone);
+
+    /**
+     * @brief Clear the waiting drones of a server while it has free pads and slots.
+     * @param drones The registry of the drones.
+     * @param server The index of a scheduled server.
+     */
+    void dispatch(DroneRegistry &drones, int server);
+
+private:
+    /**
+     * @brief Capacity, free pads and queue of a scheduled server.
+     */
+    struct Station {
+        int pads = 0; ///< Number of landing pads, 0 if the server is not scheduled.
+        int chargingSlots = 0; ///< Number of charging slots, 0 for unlimited.
+        int charging = 0; ///< Charging slots taken or reserved by cleared drones.
+        Vector2D position; ///< Position of the server.
+        float holdingRadius = 0; ///< Distance from the server to the holding ring.
+        QVector<Vector2D> padOffsets; ///< Positions of the pads relative to the server.
+        QVector<quint16> freePads; ///< Pads not given to a drone, the next one last.
+        int holdsPerRing = 1; ///< Number of hold positions on each holding ring.
+        QVector<bool> holdsTaken; ///< True for the hold positions given to holding drones, ring after ring.
+        QVector<LandingRequest> queue; ///< Binary heap of the requests, the next one first.
+    };
+
+    /**
+     * @brief Lay out the pads and the holding ring of a station.
+     * @param station The station.
+     */
+    void layOut(Station &station) const;
+
+    /**
+     * @brief Give the free hold position nearest to a direction.
+     * @param station The station.
+     * @param toDrone The direction from the server to the arriving drone.
+     * @return The index of the hold position.
+     */
+    static int takeHold(Station &station, const Vector2D &toDrone);
+
+    /**
+     * @brief Free the hold position of a drone leaving the holding ring.
+     * @param station The station.
+     * @param hold The index of the hold position.
+     */
+    static inline void freeHold(Station &station, int hold) {
+        if (hold < station.holdsTaken.size()) {
+            station.holdsTaken[hold] = false;
+        }
+    }
+
+    /**
+     * @brief Free the pads and slots of a station and empty its queue.
+     * @param station The station.
+     */
+    static void reset(Station &station);
+
+    float spacing = 96; ///< Distance between the pads and between the holding drones.
+    QVector<Station> stations; ///< Stations of the servers, indexed like the servers.
+};
+
+#endif // LANDINGSCHEDULER_H
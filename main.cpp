@@ -1,11 +1,172 @@
 #include "mainwindow.h"
+#include "fleetprocess.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <cstring>
+
+/**
+ * @brief Check if an option is on the command line, before the application is created.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param option The option, with its dashes.
+ * @return True if the option is present.
+ */
+static bool hasOption(int argc, char *argv[], const char *option) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], option) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Run the coordinator or a worker of the multi-process simulation, without GUI.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @return The exit code of the process.
+ */
+static int runFleetProcess(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    FleetProcess::Options options;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Multi-process drone simulation sharing the fleet state in shared memory.");
+    parser.addHelpOption();
+    QCommandLineOption coordinatorOption("coordinator", "Run the coordinator, which starts the workers.");
+    QCommandLineOption workerOption("worker", "Run a worker (started by the coordinator).");
+    QCommandLineOption keyOption("key", "Key of the shared memory segment.", "key", options.key);
+    QCommandLineOption scenarioOption("scenario", "Scenario file (.json or .dsb).", "file");
+    QCommandLineOption workersOption("workers", "Number of worker processes.", "count", QString::number(qMax(1, QThread::idealThreadCount())));
+    QCommandLineOption rankOption("rank", "Index of the worker.", "rank", "0");
+    QCommandLineOption speedOption("speed", "Simulated seconds per wall clock second (0 for as fast as possible).", "scale", QString::number(options.speed));
+    QCommandLineOption durationOption("duration", "Simulated duration (0 to run until killed).", "seconds", QString::number(options.duration));
+    QCommandLineOption takeoffOption("takeoff", "Make all the drones take off at the start.");
+    QCommandLineOption integratorOption("integrator", "Integration method (euler, verlet or rk4).", "method", Integrator::name(options.integrator));
+    parser.addOptions({coordinatorOption, workerOption, keyOption, scenarioOption, workersOption, rankOption,
+                       speedOption, durationOption, takeoffOption, integratorOption});
+    parser.process(app);
+
+    if (!parser.isSet(scenarioOption)) {
+        qCritical() << "Missing --scenario";
+        return 1;
+    }
+    if (!Integrator::fromName(parser.value(integratorOption), options.integrator)) {
+        qCritical() << "Unknown integrator:" << parser.value(integratorOption);
+        return 1;
+    }
+    options.key = parser.value(keyOption);
+    options.scenario = parser.value(scenarioOption);
+    if (parser.isSet(workerOption)) {
+        return FleetProcess::runWorker(options.key, options.scenario, parser.value(rankOption).toInt(), options.integrator);
+    }
+    options.workers = parser.value(workersOption).toInt();
+    options.speed = parser.value(speedOption).toDouble();
+    options.duration = parser.value(durationOption).toDouble();
+    options.takeoff = parser.isSet(takeoffOption);
+    return FleetProcess::runCoordinator(options);
+}
 
 int main(int argc, char *argv[])
 {
+    if (hasOption(argc, argv, "--coordinator") || hasOption(argc, argv, "--worker")) {
+        return runFleetProcess(argc, argv);
+    }
+
+    if (hasOption(argc, argv, "--headless") && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");  // No display needed
+    }
     QApplication a(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption attachOption("attach", "Display the fleet of a running coordinator (read-only).", "key");
+    QCommandLineOption scenarioOption("scenario", "Scenario file, the one of the coordinator with --attach.", "file");
+    QCommandLineOption commandsStdinOption("commands-stdin", "Read drone commands (newline-delimited JSON) from the standard input.");
+    QCommandLineOption commandsSocketOption("commands-socket", "Read drone commands (newline-delimited JSON) from the clients of a local socket.", "name");
+    QCommandLineOption telemetryOption("telemetry", "Write the state of the drones after each step to a file.", "file");
+    QCommandLineOption telemetryFormatOption("telemetry-format", "Format of the telemetry (csv, ndjson or binary).", "format", "csv");
+    QCommandLineOption telemetryIntervalOption("telemetry-interval", "Simulated time between two telemetry samples (0 for every step).", "seconds", "0");
+    QCommandLineOption telemetryStrideOption("telemetry-stride", "Record one drone out of this number.", "count", "1");
+    QCommandLineOption checkpointOption("checkpoint", "Save checkpoints periodically to a file.", "file");
+    QCommandLineOption checkpointIntervalOption("checkpoint-interval", "Simulated time between two checkpoints.", "seconds", "60");
+    QCommandLineOption restoreOption("restore", "Restore a checkpoint of the scenario at the start.", "file");
+    const FrameExporter::Options exportDefaults;
+    QCommandLineOption exportOption("export", "Render the canvas offscreen at a fixed rate of simulated time: PNG files in a directory, or raw frames to a file, a named pipe or - for the standard output.", "path");
+    QCommandLineOption exportFormatOption("export-format", "Format of the exported frames (png or raw BGRA pixels).", "format", "png");
+    QCommandLineOption exportFpsOption("export-fps", "Exported frames per simulated second.", "rate", QString::number(exportDefaults.frameRate));
+    QCommandLineOption exportSizeOption("export-size", "Size of the exported frames.", "WxH",
+                                        QString::number(exportDefaults.size.width()) + "x" + QString::number(exportDefaults.size.height()));
+    QCommandLineOption exportThreadsOption("export-threads", "Number of threads encoding the PNG frames.", "count", QString::number(exportDefaults.encoderCount));
+    QCommandLineOption trailsOption("trails", "Draw the recent positions of the flying drones.");
+    QCommandLineOption trailIntervalOption("trail-interval", "Simulated time between two positions of a trail.", "seconds", QString::number(DroneTrails::defaultInterval));
+    QCommandLineOption trailPointsOption("trail-points", "Number of positions of a trail.", "count", QString::number(DroneTrails::defaultCapacity));
+    QCommandLineOption headlessOption("headless", "Run without window as fast as possible for --duration, then quit.");
+    QCommandLineOption durationOption("duration", "Simulated duration of a headless run.", "seconds");
+    parser.addOptions({attachOption, scenarioOption, commandsStdinOption, commandsSocketOption,
+                       telemetryOption, telemetryFormatOption, telemetryIntervalOption, telemetryStrideOption,
+                       checkpointOption, checkpointIntervalOption, restoreOption,
+                       exportOption, exportFormatOption, exportFpsOption, exportSizeOption, exportThreadsOption,
+                       trailsOption, trailIntervalOption, trailPointsOption, headlessOption, durationOption});
+    parser.process(a);
+
+    const bool headless = parser.isSet(headlessOption);
+    if (headless && (parser.isSet(attachOption) || !parser.isSet(durationOption))) {
+        qCritical() << "--headless needs --duration and cannot be used with --attach";
+        return 1;
+    }
+
     MainWindow w;
-    w.show();
+    if (parser.isSet(trailsOption)) {
+        w.enableTrails(parser.value(trailIntervalOption).toDouble(), parser.value(trailPointsOption).toInt());
+    }
+    if (parser.isSet(attachOption)) {
+        if (!w.attachFleet(parser.value(attachOption), parser.value(scenarioOption))) {
+            return 1;
+        }
+    } else {
+        if (parser.isSet(scenarioOption)) {
+            w.loadJson(parser.value(scenarioOption));
+        }
+        if (parser.isSet(restoreOption) && !w.restoreCheckpoint(parser.value(restoreOption))) {
+            return 1;
+        }
+        if (parser.isSet(checkpointOption)) {
+            w.setPeriodicCheckpoint(parser.value(checkpointOption), parser.value(checkpointIntervalOption).toDouble());
+        }
+        w.listenCommands(parser.isSet(commandsStdinOption), parser.value(commandsSocketOption));
+        if (parser.isSet(telemetryOption)) {
+            TelemetryStream::Options telemetry;
+            if (!TelemetryStream::formatFromName(parser.value(telemetryFormatOption), telemetry.format)) {
+                qCritical() << "Unknown telemetry format:" << parser.value(telemetryFormatOption);
+                return 1;
+            }
+            telemetry.interval = parser.value(telemetryIntervalOption).toDouble();
+            telemetry.droneStride = parser.value(telemetryStrideOption).toInt();
+            if (!w.startTelemetry(parser.value(telemetryOption), telemetry)) {
+                return 1;
+            }
+        }
+        if (parser.isSet(exportOption)) {
+            FrameExporter::Options frames;
+            if (!FrameExporter::formatFromName(parser.value(exportFormatOption), frames.format)) {
+                qCritical() << "Unknown export format:" << parser.value(exportFormatOption);
+                return 1;
+            }
+            const QStringList size = parser.value(exportSizeOption).split('x');
+            frames.size = size.size() == 2 ? QSize(size[0].toInt(), size[1].toInt()) : QSize();
+            frames.frameRate = parser.value(exportFpsOption).toDouble();
+            frames.encoderCount = parser.value(exportThreadsOption).toInt();
+            if (!w.startExport(parser.value(exportOption), frames)) {
+                return 1;
+            }
+        }
+    }
+    if (headless) {
+        w.runHeadless(parser.value(durationOption).toDouble());
+    } else {
+        w.show();
+    }
     return a.exec();
 }
@@ -1,36 +1,119 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QListWidgetItem>
+#include <QActionGroup>
+#include <QMenuBar>
+#include <QThread>
+#include <cmath>
+#include <limits>
+#include "allocationcounter.h"
 
 /**
  * @brief Constructor for the MainWindow class.
  *
- * This constructor sets up the UI, initializes a timer for regular updates,
- * and starts the elapsed timer to track simulation time.
+ * This constructor sets up the UI, initializes the timers of the simulation steps
+ * and of the display, and starts the elapsed timer to track simulation time.
  * @param parent The parent widget (optional).
  */
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , ui(new Ui::MainWindow) {
+    , ui(new Ui::MainWindow)
+    , commands(commandCapacity) {
     ui->setupUi(this);
+    simulation.setCollisionDistance(ui->widget->droneCollisionDistance);
+    simulation.setCommandQueue(&commands);
 
-    // Create a timer for simulation updates
+    // Create the menu selecting the integration method of the simulation
+    QMenu *integratorMenu = menuBar()->addMenu("&Integrator");
+    QActionGroup *integratorGroup = new QActionGroup(this);
+    for (int i = 0; i < Integrator::methodCount; i++) {
+        QAction *action = integratorMenu->addAction(Integrator::name(Integrator::Method(i)));
+        action->setCheckable(true);
+        action->setChecked(i == simulation.getIntegrator());
+        action->setData(i);
+        integratorGroup->addAction(action);
+    }
+    connect(integratorGroup, SIGNAL(triggered(QAction*)), this, SLOT(selectIntegrator(QAction*)));
+
+    // Create the menu selecting the engine of the simulation
+    QMenu *engineMenu = menuBar()->addMenu("&Engine");
+    QActionGroup *engineGroup = new QActionGroup(this);
+    const int threads = QThread::idealThreadCount();
+    QAction *singleAction = engineMenu->addAction("Single thread");
+    QAction *shardedAction = engineMenu->addAction("Sharded by server region (" + QString::number(threads) + " threads)");
+    singleAction->setData(0);
+    shardedAction->setData(threads);
+    for (QAction *action : {singleAction, shardedAction}) {
+        action->setCheckable(true);
+        engineGroup->addAction(action);
+    }
+    singleAction->setChecked(true);
+    connect(engineGroup, SIGNAL(triggered(QAction*)), this, SLOT(selectEngine(QAction*)));
+
+    // Create the menu selecting the speed of the simulation
+    static const double speeds[] = { 0, 1, 2, 5, 10, 100, std::numeric_limits<double>::infinity() };
+    QMenu *speedMenu = menuBar()->addMenu("&Speed");
+    QActionGroup *speedGroup = new QActionGroup(this);
+    for (double speed : speeds) {
+        QString text = speed == 0 ? QString("Pause") : std::isinf(speed) ? QString("As fast as possible") : "x" + QString::number(speed);
+        QAction *action = speedMenu->addAction(text);
+        action->setCheckable(true);
+        action->setChecked(speed == timeScale);
+        action->setData(speed);
+        speedGroup->addAction(action);
+    }
+    connect(speedGroup, SIGNAL(triggered(QAction*)), this, SLOT(selectSpeed(QAction*)));
+
+    // Create the menu of the checkpoints
+    QMenu *checkpointMenu = menuBar()->addMenu("&Checkpoint");
+    connect(checkpointMenu->addAction("Save..."), SIGNAL(triggered()), this, SLOT(saveCheckpoint()));
+    connect(checkpointMenu->addAction("Restore..."), SIGNAL(triggered()), this, SLOT(openCheckpoint()));
+
+    // Create the menu of the view of the map (the wheel zooms, the right button drags)
+    QMenu *viewMenu = menuBar()->addMenu("&View");
+    connect(viewMenu->addAction("Fit map"), SIGNAL(triggered()), ui->widget, SLOT(fitView()));
+    connect(viewMenu->addAction("Actual size"), SIGNAL(triggered()), ui->widget, SLOT(resetView()));
+    viewMenu->addSeparator();
+    QAction *heatmapAction = viewMenu->addAction("Traffic heatmap");
+    heatmapAction->setCheckable(true);
+    connect(heatmapAction, SIGNAL(toggled(bool)), this, SLOT(showHeatmap(bool)));
+    trailsAction = viewMenu->addAction("Drone trails");
+    trailsAction->setCheckable(true);
+    connect(trailsAction, SIGNAL(toggled(bool)), this, SLOT(showTrails(bool)));
+    QAction *labelsAction = viewMenu->addAction("Drone names");
+    labelsAction->setCheckable(true);
+    connect(labelsAction, SIGNAL(toggled(bool)), ui->widget, SLOT(showDroneLabels(bool)));
+
+    // Select the drones clicked on the canvas in the drone list
+    connect(ui->widget, SIGNAL(droneSelected(DroneId)), this, SLOT(selectDrone(DroneId)));
+
+    // Create a timer for the simulation steps, independent of the display
+    physicsTimer = new QTimer(this);
+    physicsTimer->setInterval(physicsInterval);
+    connect(physicsTimer, SIGNAL(timeout()), this, SLOT(advanceSimulation()));
+    physicsTimer->start();
+
+    // Create a timer for the display updates
     timer = new QTimer(this);
-    timer->setInterval(100);  // Set the update interval to 100 ms
-    connect(timer, SIGNAL(timeout()), this, SLOT(update()));  // Connect the update slot
+    timer->setInterval(renderInterval);
+    connect(timer, SIGNAL(timeout()), this, SLOT(render()));
     timer->start();  // Start the timer
 
     elapsedTimer.start();  // Start measuring elapsed time for the simulation
+    lastAdvance = elapsedTimer.nsecsElapsed();
+    lastRender = lastAdvance;
 }
 
 /**
  * @brief Destructor for the MainWindow class.
  *
- * This destructor cleans up allocated resources, including the UI and timer.
+ * This destructor cleans up allocated resources, including the command inputs, the UI and timers.
  */
 MainWindow::~MainWindow() {
+    qDeleteAll(commandInputs);  // Stop the inputs before the queue they fill is destroyed
     delete ui;  ///< Free memory allocated for the UI.
     delete timer;  ///< Free memory allocated for the timer.
+    delete physicsTimer;  ///< Free memory allocated for the physics timer.
 }
 
 /**
@@ -49,7 +132,7 @@ void MainWindow::on_actionQuit_triggered() {
  * from the selected file into the simulation.
  */
 void MainWindow::on_actionLoad_triggered() {
-    QString filePath = QFileDialog::getOpenFileName(this, "Open JSON File", "", "JSON Files (*.json)");
+    QString filePath = QFileDialog::getOpenFileName(this, "Open Scenario File", "", "Scenario Files (*.json *.dsb)");
     if (!filePath.isEmpty()) {
         loadJson(filePath);  // Load the JSON file if the path is not empty
     }
@@ -58,126 +141,516 @@ void MainWindow::on_actionLoad_triggered() {
 /**
  * @brief Load a JSON file containing drone and server data.
  *
- * This function loads drone and server data from a given JSON file, clears the existing
+ * This function loads drone and server data from a given scenario file (JSON, or binary
+ * with the .dsb extension), clears the existing
  * data from the UI, and sets up new servers and drones in the simulation.
  *
- * @param filePath The path to the JSON file containing the data.
+ * @param filePath The path to the scenario file containing the data.
  */
 void MainWindow::loadJson(const QString &filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Could not open file:" << filePath;
+    Scenario scenario;
+    if (!scenario.load(filePath)) {
         return;
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc(QJsonDocument::fromJson(data));
-    QJsonObject json = doc.object();
-
-    // Clear the existing servers and drones in the UI
+    // Clear the existing servers in the UI
     ui->widget->clearServers();  // Clear the server list from the canvas
-    for (auto &drone : mapDrones) {
-        delete drone;  // Free the memory for each drone
-    }
-    mapDrones.clear();  // Clear the map of drones
-    ui->listDronesInfo->clear();  // Clear the drone list widget
 
-    QVector<Server> servers;
+    simulation.load(scenario);  // Replace the servers and drones of the simulation
 
-    // Load servers from the JSON file
-    QJsonArray serverArray = json["servers"].toArray();
-    for (const QJsonValue &serverValue : serverArray) {
-        QJsonObject server = serverValue.toObject();
-        QString name = server["name"].toString();
-        QString positionStr = server["position"].toString();
-        QString colorStr = server["color"].toString();
+    for (const Server &server : simulation.getServers()) {
+        qDebug() << "Loaded server:" << server.getName() << "at position:" << server.getPosition().x << server.getPosition().y << "with color:" << server.getColor().name();
+    }
+    ui->widget->setServers(simulation.getServers());  // Set the list of servers in the canvas
+    shownServerRevision = simulation.getServerRevision();
+
+    resetDroneList();
+    const DroneRegistry &drones = simulation.getDrones();
+    for (int i = 0; i < drones.size(); i++) {
+        qDebug() << "Loaded drone:" << drones.nameAt(i) << "at position:" << drones[i].getPosition().x << drones[i].getPosition().y;
+    }
 
-        QStringList posList = positionStr.split(",");
-        Vector2D position(posList[0].toFloat(), posList[1].toFloat());
-        QColor color(colorStr);
+    ui->widget->setSimulation(&simulation);  // Set the simulation displayed in the canvas
+    resetHeatmap();  // The traffic of the previous scenario is meaningless
+    trails.clear();
+}
 
-        servers.append(Server(name, position, color));
-        qDebug() << "Loaded server:" << name << "at position:" << positionStr << "with color:" << colorStr;
+/**
+ * @brief Show or hide the traffic heatmap from the View menu.
+ *
+ * The heatmap is only accumulated while it is shown, and starts empty each time.
+ * @param shown True to accumulate the traffic from now on and draw it.
+ */
+void MainWindow::showHeatmap(bool shown) {
+    heatmapShown = shown;
+    if (shown && !heatmap) {
+        heatmap.reset(new TrafficHeatmap());
     }
+    resetHeatmap();
+    ui->widget->setHeatmap(shown ? heatmap.get() : nullptr);
+}
 
-    ui->widget->setServers(servers);  // Set the list of servers in the canvas
+/**
+ * @brief Empty the traffic heatmap, if shown, and fit its grid to the map.
+ *
+ * The grid extends beyond the servers by a tenth of the size of the map, since the
+ * drones fly around them.
+ */
+void MainWindow::resetHeatmap() {
+    if (!heatmapShown) {
+        return;
+    }
+    const QRectF bounds = ui->widget->mapBounds();
+    const double margin = qMax(bounds.width(), bounds.height()) / 10;
+    heatmap->reset(bounds.adjusted(-margin, -margin, margin, margin));
+}
 
-    // Load drones from the JSON file
-    QJsonArray droneArray = json["drones"].toArray();
-    for (const QJsonValue &droneValue : droneArray) {
-        QJsonObject drone = droneValue.toObject();
-        QString name = drone["name"].toString();
-        QString positionStr = drone["position"].toString();
-        QString colorStr = drone["color"].toString();
-        QString server = drone["server"].toString();
+/**
+ * @brief Draw the recent positions of the flying drones behind their icons.
+ * @param interval The simulated time between two recorded positions, in seconds.
+ * @param points The number of positions kept per drone.
+ */
+void MainWindow::enableTrails(double interval, int points) {
+    trails.setInterval(interval);
+    trails.setCapacity(points);
+    trailsAction->setChecked(true);
+}
 
-        QStringList posList = positionStr.split(",");
-        Vector2D position(posList[0].toFloat(), posList[1].toFloat());
+/**
+ * @brief Show or hide the drone trails from the View menu.
+ *
+ * The trails are only recorded while they are shown, and start empty each time.
+ * @param shown True to record the positions from now on and draw them.
+ */
+void MainWindow::showTrails(bool shown) {
+    trailsShown = shown;
+    trails.clear();
+    ui->widget->setTrails(shown ? &trails : nullptr);
+}
 
-        Drone *newDrone = new Drone(name);
-        newDrone->setInitialPosition(position);
-        newDrone->setTargetServer(server);
+/**
+ * @brief Select the widget of a drone in the drone list.
+ * @param id The handle of the drone.
+ */
+void MainWindow::selectDrone(DroneId id) {
+    for (int i = 0; i < droneWidgets.size(); i++) {
+        if (droneWidgets[i]->getDroneId() == id) {
+            ui->listDronesInfo->setCurrentRow(i);
+            ui->listDronesInfo->scrollToItem(ui->listDronesInfo->item(i));
+            return;
+        }
+    }
+}
 
-        mapDrones[name] = newDrone;
+/**
+ * @brief Remove the rows of the removed drones from the drone list, and add rows for the new drones.
+ *
+ * Called when commands add or remove drones: the rows of the other drones and their
+ * widgets are kept, so that a stream of commands does not recreate the whole list.
+ * The new drones are added at the end of the list.
+ */
+void MainWindow::updateDroneList() {
+    const DroneRegistry &drones = simulation.getDrones();
+    int kept = 0;
+    for (DroneWidget *droneWidget : droneWidgets) {
+        const DroneId id = droneWidget->getDroneId();
+        if (drones.contains(id)) {
+            droneWidgets[kept++] = droneWidget;
+            continue;
+        }
+        listedDrones.remove(id);
+        QListWidgetItem *item = ui->listDronesInfo->item(kept);  // The rows before it were kept or removed
+        ui->listDronesInfo->removeItemWidget(item);  // Deletes the drone widget
+        delete item;
+    }
+    droneWidgets.resize(kept);
 
+    for (int i = 0; i < drones.size(); i++) {
+        const DroneId id = drones.idAt(i);
+        if (listedDrones.contains(id)) {
+            continue;
+        }
+        listedDrones.insert(id);
+        DroneWidget *droneWidget = new DroneWidget(&simulation, id);
+        droneWidgets.append(droneWidget);
         QListWidgetItem *LWitems = new QListWidgetItem(ui->listDronesInfo);
         ui->listDronesInfo->addItem(LWitems);
-        ui->listDronesInfo->setItemWidget(LWitems, newDrone);
+        ui->listDronesInfo->setItemWidget(LWitems, droneWidget);
+    }
+    listedRevision = simulation.getFleetRevision();
+}
+
+/**
+ * @brief Create the drone list again, when the whole fleet is replaced.
+ *
+ * Called when a scenario or a checkpoint is loaded: the handles of the new drones may
+ * be those of the previous ones.
+ */
+void MainWindow::resetDroneList() {
+    ui->listDronesInfo->clear();  // Clear the drone list widget (deletes the drone widgets)
+    droneWidgets.clear();
+    listedDrones.clear();
+    droneWidgets.reserve(simulation.getDrones().size());
+    updateDroneList();
+}
 
-        qDebug() << "Loaded drone:" << name << "at position:" << positionStr << "with color:" << colorStr << "and server:" << server;
+/**
+ * @brief Receive drone commands as newline-delimited JSON while the simulation runs.
+ *
+ * Each source is read by its own CommandInput thread; the commands are applied by the
+ * simulation at the start of its next step.
+ *
+ * @param fromStdin True to read commands from the standard input.
+ * @param socketName The name of a local socket to read commands from, empty for none.
+ */
+void MainWindow::listenCommands(bool fromStdin, const QString &socketName) {
+    if (fromStdin) {
+        commandInputs.append(new CommandInput(&commands));
+    }
+    if (!socketName.isEmpty()) {
+        commandInputs.append(new CommandInput(&commands, socketName));
     }
+    for (CommandInput *input : commandInputs) {
+        if (!input->isRunning()) {
+            input->start();
+        }
+    }
+}
 
-    ui->widget->setMap(&mapDrones);  // Set the map of drones in the canvas
+/**
+ * @brief Display the fleet of a multi-process simulation instead of simulating it.
+ *
+ * The segment is attached read-only and the local simulation is no longer stepped
+ * (the Integrator, Engine and Speed menus have no effect); it only provides the
+ * servers, names and flight models of the drones.
+ *
+ * @param key The key of the shared memory segment.
+ * @param filePath The scenario file of the coordinator.
+ * @return True if the scenario is loaded and the segment is attached.
+ */
+bool MainWindow::attachFleet(const QString &key, const QString &filePath) {
+    loadJson(filePath);
+    std::unique_ptr<SharedFleet> attached(new SharedFleet(key));
+    if (!attached->attach(true)) {
+        qCritical() << "Cannot attach to the shared fleet" << key << ":" << attached->errorString();
+        return false;
+    }
+    if (attached->droneCount() != simulation.getDrones().size()) {
+        qCritical() << "The shared fleet has" << attached->droneCount() << "drones, the scenario" << simulation.getDrones().size();
+        return false;
+    }
+    fleet = std::move(attached);
+    physicsTimer->stop();
+    ui->actionLoad->setEnabled(false);  // The scenario is the one of the coordinator
+    ui->widget->setFleet(fleet.get());
+    return true;
+}
 
-    file.close();
+/**
+ * @brief Write the state of the drones after each step to a telemetry file.
+ * @param filePath The path of the file.
+ * @param options The format and decimation of the telemetry.
+ * @return True if the file was created.
+ */
+bool MainWindow::startTelemetry(const QString &filePath, const TelemetryStream::Options &options) {
+    if (!telemetry.open(filePath, options)) {
+        qCritical() << "Cannot create the telemetry file" << filePath << ":" << telemetry.errorString();
+        return false;
+    }
+    return true;
 }
 
 /**
- * @brief Update the simulation at regular intervals.
+ * @brief Render the canvas offscreen at a fixed rate of simulated time and export the frames.
  *
- * This method updates each drone's position and checks for collisions with other drones.
- * It adjusts the number of simulation steps based on elapsed time to ensure smooth performance.
+ * The frames show the part of the map shown by the canvas, scaled to their width. The
+ * first frame, of the current state, is rendered by the next advance of the simulation.
+ * @param path The directory of the PNG files, or the file of the raw frames ("-" for the standard output).
+ * @param options The format, rate and size of the frames.
+ * @return True if the output was created.
  */
-void MainWindow::update() {
-    static int last = elapsedTimer.elapsed();  // Last update time
-    static int steps = 5;  // Number of simulation steps per update
-    int current = elapsedTimer.elapsed();  // Current time
-    double dt = (current - last) / (1000.0 * steps);  // Time difference between updates
+bool MainWindow::startExport(const QString &path, const FrameExporter::Options &options) {
+    if (!exporter.open(path, options, simulation.getTime())) {
+        qCritical() << "Cannot export the frames to" << path << ":" << exporter.errorString();
+        return false;
+    }
+    return true;
+}
 
-    // Update each drone in the simulation
-    for (int step = 0; step < steps; step++) {
-        for (auto &drone : mapDrones) {
-            QString targetServerName = drone->getTargetServer();
-            Server* targetServer = ui->widget->findServerByName(targetServerName);
+/**
+ * @brief Run the simulation as fast as possible without display, then quit.
+ *
+ * The display timer is stopped: the frames of an export are rendered offscreen by
+ * the steps. A hidden window has no layout, so the canvas takes the size of the
+ * frames and shows the whole map. The telemetry and the export are completed before
+ * quitting.
+ * @param duration The simulated duration, in seconds.
+ */
+void MainWindow::runHeadless(double duration) {
+    if (exporter.isOpen()) {
+        ui->widget->resize(exporter.frameSize());
+        ui->widget->fitView();
+    }
+    stopTime = simulation.getTime() + duration;
+    timeScale = std::numeric_limits<double>::infinity();
+    pendingTime = 0;
+    physicsTimer->setInterval(0);
+    timer->stop();
+}
 
-            if (targetServer) {
-                drone->setGoalPosition(targetServer->getPosition());  // Set the drone's goal position
-            }
+/**
+ * @brief Save checkpoints of the simulation periodically.
+ * @param filePath The path of the checkpoint file, replaced at each checkpoint.
+ * @param interval The simulated time between two checkpoints, in seconds.
+ */
+void MainWindow::setPeriodicCheckpoint(const QString &filePath, double interval) {
+    checkpointPath = filePath;
+    checkpointInterval = interval;
+    nextCheckpoint = simulation.getTime() + interval;
+}
 
-            // Handle collisions between drones
-            if (drone->getStatus() != Drone::landed) {
-                drone->initCollision();  // Reset collision state
-                for (auto &obs : mapDrones) {
-                    if (obs->getStatus() != Drone::landed && obs->getName() != drone->getName()) {
-                        Vector2D B = obs->getPosition();  // Position of another drone
-                        drone->addCollision(B, ui->widget->droneCollisionDistance);  // Add collision force
-                    }
-                }
-            }
+/**
+ * @brief Restore the fleet from a checkpoint of the loaded scenario.
+ * @param filePath The path of the checkpoint file.
+ * @return True if the checkpoint was restored.
+ */
+bool MainWindow::restoreCheckpoint(const QString &filePath) {
+    SimulationSnapshot snapshot;
+    if (!Checkpoint::load(filePath, snapshot) || !simulation.restoreSnapshot(snapshot)) {
+        return false;
+    }
+    nextCheckpoint = simulation.getTime() + checkpointInterval;
+    resetDroneList();
+    resetHeatmap();
+    trails.clear();  // The handles of the drones changed
+    return true;
+}
+
+/**
+ * @brief Save a checkpoint to a file chosen by the user.
+ *
+ * The snapshot is taken between two steps and saved by the checkpoint thread.
+ */
+void MainWindow::saveCheckpoint() {
+    QString filePath = QFileDialog::getSaveFileName(this, "Save Checkpoint", "", "Checkpoint Files (*." + QString(Checkpoint::suffix) + ")");
+    if (!filePath.isEmpty()) {
+        checkpointWriter.wait();  // A periodic checkpoint may be in progress
+        snapshotShared = checkpointWriter.start(filePath, simulation.takeSnapshot());
+    }
+}
+
+/**
+ * @brief Restore a checkpoint from a file chosen by the user.
+ */
+void MainWindow::openCheckpoint() {
+    QString filePath = QFileDialog::getOpenFileName(this, "Restore Checkpoint", "", "Checkpoint Files (*." + QString(Checkpoint::suffix) + ")");
+    if (!filePath.isEmpty()) {
+        restoreCheckpoint(filePath);
+    }
+}
+
+/**
+ * @brief Select the integration method from the Integrator menu.
+ * @param action The action of the selected method (its data is the method).
+ */
+void MainWindow::selectIntegrator(QAction *action) {
+    simulation.setIntegrator(Integrator::Method(action->data().toInt()));
+}
+
+/**
+ * @brief Select the engine of the simulation from the Engine menu.
+ * @param action The action of the selected engine (its data is the number of threads, 0 for single-threaded).
+ */
+void MainWindow::selectEngine(QAction *action) {
+    simulation.setThreadCount(action->data().toInt());
+}
+
+/**
+ * @brief Select the speed of the simulation from the Speed menu.
+ * @param action The action of the selected speed (its data is the time scale).
+ */
+void MainWindow::selectSpeed(QAction *action) {
+    timeScale = action->data().toDouble();
+    pendingTime = 0;
+    // Run the steps whenever the event loop is idle when going as fast as possible
+    physicsTimer->setInterval(std::isinf(timeScale) ? 0 : physicsInterval);
+}
+
+/**
+ * @brief Advance the simulation to follow the wall clock multiplied by the time scale.
+ *
+ * The simulation always uses steps of the same duration. The simulated time owed since
+ * the last call is computed from the wall clock and the time scale, and the steps are
+ * run until it is paid back or the time budget of the call is spent, so that the
+ * display timer still gets its turn. The display is therefore updated less often when
+ * the simulation is busy, but the simulation does not slow down as long as it can
+ * keep up; when it cannot, the delay is bounded by maxLag.
+ */
+void MainWindow::advanceSimulation() {
+    qint64 now = elapsedTimer.nsecsElapsed();
+    const bool asFastAsPossible = std::isinf(timeScale);
+    if (!asFastAsPossible) {
+        pendingTime += (now - lastAdvance) * 1e-9 * timeScale;  // Simulated time owed to the wall clock
+    }
+    lastAdvance = now;
+    const qint64 deadline = now + physicsBudget;
+    exportFrames();  // The first frame of an export, before any step
+
+    quint64 allocations = AllocationCounter::count();
+    std::size_t scratchCapacity = simulation.getScratchCapacity();
+    quint64 revision = simulation.getFleetRevision();
+    const bool copiesSnapshot = snapshotShared;  // The first step after a snapshot copies the records
+    snapshotShared = false;
+    quint64 exportAllocations = 0;
+    while ((asFastAsPossible || pendingTime >= stepDuration) && simulation.getTime() < stopTime
+           && elapsedTimer.nsecsElapsed() < deadline) {
+        simulation.step(stepDuration);
+        telemetry.record(simulation);
+        if (heatmapShown) {
+            heatmap->accumulate(simulation.getDrones().begin(), simulation.getDrones().end(), stepDuration);
+        }
+        if (trailsShown) {
+            trails.record(simulation.getDrones(), simulation.getDrones().begin(), simulation.getTime());
+        }
+        if (exporter.isDue(simulation.getTime())) {
+            const quint64 before = AllocationCounter::count();  // Rendering allocates, the steps must not
+            exportFrames();
+            exportAllocations += AllocationCounter::count() - before;
+        }
+        pendingTime -= stepDuration;
+        stepCount++;
+    }
+    allocations = AllocationCounter::count() - allocations - exportAllocations;
+    // Adding drones grows the registry, which is not scratch memory
+    bool warmedUp = scratchCapacity == simulation.getScratchCapacity() && revision == simulation.getFleetRevision() && !copiesSnapshot;
+
+    // The snapshot shares the records: the next step copies them, the thread saves them
+    if (!checkpointPath.isEmpty() && simulation.getTime() >= nextCheckpoint) {
+        if (checkpointWriter.start(checkpointPath, simulation.takeSnapshot())) {
+            nextCheckpoint = simulation.getTime() + checkpointInterval;
+            snapshotShared = true;
+        }
+    }
+
+    if (asFastAsPossible) {
+        pendingTime = 0;
+    } else if (pendingTime > maxLag) {
+        pendingTime = maxLag;  // The simulation cannot keep up: forget the delay beyond maxLag
+    }
 
-            drone->update(dt);  // Update the drone's state
+    if (AllocationCounter::isEnabled()) {
+        // Steps may allocate while the scratch memory grows, but not once it has its final size
+        allocationCount += allocations;
+        if (allocations > 0 && warmedUp) {
+            qWarning() << "Simulation step made" << allocations << "heap allocations";
         }
     }
+    simulationTime += elapsedTimer.nsecsElapsed() - now;
+
+    if (simulation.getTime() >= stopTime) {
+        // End of a headless run: write everything before quitting
+        physicsTimer->stop();
+        exporter.close();
+        telemetry.close();
+        checkpointWriter.wait();
+        QApplication::quit();
+    }
+}
 
-    int d = elapsedTimer.elapsed() - current;  // Time elapsed in this update
-    ui->statusbar->showMessage("duration:" + QString::number(d) + " steps=" + QString::number(steps));  // Show the duration in the status bar
+/**
+ * @brief Move the servers of the canvas that moved in the simulation.
+ */
+void MainWindow::syncServers() {
+    if (shownServerRevision != simulation.getServerRevision()) {
+        ui->widget->updateServers(simulation.getServers());  // Servers moved by commands
+        shownServerRevision = simulation.getServerRevision();
+    }
+}
 
-    // Adjust the number of steps based on elapsed time
-    if (d > 90) {
-        steps /= 2;
+/**
+ * @brief Render and queue the frames of the export due at the current simulated time.
+ *
+ * The frames are rendered between two steps, on the simulation thread, and encoded by
+ * the threads of the exporter. When a step is longer than a frame, its state is
+ * rendered for each frame due, so that the frame rate of the export stays fixed.
+ */
+void MainWindow::exportFrames() {
+    while (exporter.isDue(simulation.getTime())) {
+        syncServers();
+        ui->widget->renderFrame(exporter.beginFrame());
+        exporter.endFrame();
+    }
+}
+
+/**
+ * @brief Update the display at regular intervals.
+ *
+ * The drone list and the canvas are refreshed from the current state of the
+ * simulation. The canvas is only scheduled for repainting, so that repaints are
+ * merged when the event loop is busy with the simulation.
+ */
+void MainWindow::render() {
+    qint64 now = elapsedTimer.nsecsElapsed();
+    double wall = (now - lastRender) * 1e-9;  // Duration since the last display update
+
+    // Cut cosmetic work before the simulation falls behind; as fast as possible, the steps take whatever time is left
+    const bool asFastAsPossible = std::isinf(timeScale);
+    const RenderGovernor::Quality quality = governor.update(ui->widget->getLastPaintTime(), asFastAsPossible ? 0 : simulationTime,
+                                                            now - lastRender, !asFastAsPossible && pendingTime > governorLag);
+    ui->widget->setQuality(quality);
+    simulationTime = 0;
+    lastRender = now;
+
+    // Update the drone list once per frame rather than at each simulation step
+    if (fleet) {
+        // Read the published buffer in place; a torn frame is corrected at the next one
+        quint32 sequence;
+        int buffer = fleet->beginRead(sequence);
+        if (buffer >= 0) {
+            const Drone *records = fleet->buffer(buffer);
+            double time = fleet->header()->time[buffer];
+            const DroneRegistry &drones = simulation.getDrones();
+            for (DroneWidget *droneWidget : droneWidgets) {
+                droneWidget->refresh(records[drones.indexOf(droneWidget->getDroneId())], time);
+            }
+            if (trailsShown) {
+                trails.record(drones, records, time);  // A torn frame only moves one sample
+            }
+            if (fleet->endRead(buffer, sequence)) {
+                fleetTime = time;
+            }
+        }
     } else {
-        if (steps < 10) steps++;
+        if (listedRevision != simulation.getFleetRevision()) {
+            updateDroneList();  // Drones added or removed by commands
+        }
+        syncServers();
+        for (DroneWidget *droneWidget : droneWidgets) {
+            droneWidget->refresh();
+        }
+    }
+
+    QString message = "time:" + QString::number(fleet ? fleetTime : simulation.getTime(), 'f', 1) + "s"
+                      + " steps/s=" + QString::number(qRound(stepCount / wall))
+                      + " fps=" + QString::number(wall > 0 ? 1 / wall : 0, 'f', 1);
+    if (!asFastAsPossible && pendingTime >= maxLag) {
+        message += " (behind)";
+    }
+    if (telemetry.getDroppedCount() > 0) {
+        message += " telemetry dropped=" + QString::number(telemetry.getDroppedCount());
     }
-    last = current;  // Update the last update time
-    ui->widget->repaint();  // Redraw the widget to reflect changes
+    if (quality != RenderGovernor::full) {
+        message += " quality=" + QString(RenderGovernor::name(quality));
+    }
+    if (exporter.getStallCount() > 0) {
+        message += " export stalls=" + QString::number(exporter.getStallCount());
+    }
+    if (AllocationCounter::isEnabled()) {
+        message += " allocations=" + QString::number(allocationCount);
+        allocationCount = 0;
+    }
+    ui->statusbar->showMessage(message);  // Show the state of the simulation in the status bar
+    stepCount = 0;
+
+    ui->widget->update();  // Schedule a redraw of the canvas
 }
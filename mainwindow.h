@@ -11,9 +11,20 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <drone.h>
+#include "dronewidget.h"
+#include "scenario.h"
+#include "simulation.h"
+#include "sharedfleet.h"
+#include "commandinput.h"
+#include "telemetry.h"
+#include "checkpoint.h"
+#include "frameexporter.h"
+#include "trafficheatmap.h"
+#include "dronetrails.h"
+#include "rendergovernor.h"
 #include <QListWidget>
 #include <QMap>
+#include <QSet>
 #include <QTimer>
 #include <QElapsedTimer>
 #include <QFileDialog>
@@ -21,6 +32,8 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDebug>
+#include <limits>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -51,11 +64,74 @@ public:
     ~MainWindow();
 
     /**
-     * @brief Load a JSON file containing drone and server data.
-     * @param filePath The path to the JSON file.
+     * @brief Load a scenario file (JSON or binary) containing drone and server data.
+     * @param filePath The path to the scenario file.
      */
     void loadJson(const QString &filePath);
 
+    /**
+     * @brief Display the fleet of a multi-process simulation instead of simulating it.
+     *
+     * The scenario gives the servers, the names and the flight models of the drones;
+     * their state is read from the shared memory segment of the coordinator.
+     * @param key The key of the shared memory segment.
+     * @param filePath The scenario file of the coordinator.
+     * @return True if the scenario is loaded and the segment is attached.
+     */
+    bool attachFleet(const QString &key, const QString &filePath);
+
+    /**
+     * @brief Receive drone commands as newline-delimited JSON while the simulation runs.
+     * @param fromStdin True to read commands from the standard input.
+     * @param socketName The name of a local socket to read commands from, empty for none.
+     */
+    void listenCommands(bool fromStdin, const QString &socketName);
+
+    /**
+     * @brief Write the state of the drones after each step to a telemetry file.
+     * @param filePath The path of the file.
+     * @param options The format and decimation of the telemetry.
+     * @return True if the file was created.
+     */
+    bool startTelemetry(const QString &filePath, const TelemetryStream::Options &options);
+
+    /**
+     * @brief Render the canvas offscreen at a fixed rate of simulated time and export the frames.
+     *
+     * The frames show the part of the map shown by the canvas, scaled to their width.
+     * @param path The directory of the PNG files, or the file of the raw frames ("-" for the standard output).
+     * @param options The format, rate and size of the frames.
+     * @return True if the output was created.
+     */
+    bool startExport(const QString &path, const FrameExporter::Options &options);
+
+    /**
+     * @brief Draw the recent positions of the flying drones behind their icons.
+     * @param interval The simulated time between two recorded positions, in seconds.
+     * @param points The number of positions kept per drone.
+     */
+    void enableTrails(double interval, int points);
+
+    /**
+     * @brief Run the simulation as fast as possible without display, then quit.
+     * @param duration The simulated duration, in seconds.
+     */
+    void runHeadless(double duration);
+
+    /**
+     * @brief Save checkpoints of the simulation periodically.
+     * @param filePath The path of the checkpoint file, replaced at each checkpoint.
+     * @param interval The simulated time between two checkpoints, in seconds.
+     */
+    void setPeriodicCheckpoint(const QString &filePath, double interval);
+
+    /**
+     * @brief Restore the fleet from a checkpoint of the loaded scenario.
+     * @param filePath The path of the checkpoint file.
+     * @return True if the checkpoint was restored.
+     */
+    bool restoreCheckpoint(const QString &filePath);
+
 private slots:
     /**
      * @brief Handle the quit action from the menu.
@@ -68,15 +144,129 @@ private slots:
     void on_actionLoad_triggered();
 
     /**
-     * @brief Update the simulation at regular intervals.
+     * @brief Select the integration method from the Integrator menu.
+     * @param action The action of the selected method.
      */
-    void update();
+    void selectIntegrator(QAction *action);
+
+    /**
+     * @brief Select the engine of the simulation from the Engine menu.
+     * @param action The action of the selected engine.
+     */
+    void selectEngine(QAction *action);
+
+    /**
+     * @brief Select the speed of the simulation from the Speed menu.
+     * @param action The action of the selected speed.
+     */
+    void selectSpeed(QAction *action);
+
+    /**
+     * @brief Save a checkpoint to a file chosen by the user.
+     */
+    void saveCheckpoint();
+
+    /**
+     * @brief Restore a checkpoint from a file chosen by the user.
+     */
+    void openCheckpoint();
+
+    /**
+     * @brief Show or hide the traffic heatmap from the View menu.
+     * @param shown True to accumulate the traffic from now on and draw it.
+     */
+    void showHeatmap(bool shown);
+
+    /**
+     * @brief Show or hide the drone trails from the View menu.
+     * @param shown True to record the positions from now on and draw them.
+     */
+    void showTrails(bool shown);
+
+    /**
+     * @brief Select the widget of a drone in the drone list.
+     * @param id The handle of the drone.
+     */
+    void selectDrone(DroneId id);
+
+    /**
+     * @brief Advance the simulation to follow the wall clock multiplied by the time scale.
+     */
+    void advanceSimulation();
+
+    /**
+     * @brief Update the display at regular intervals.
+     */
+    void render();
 
 private:
+    /**
+     * @brief Remove the rows of the removed drones from the drone list, and add rows for the new drones.
+     */
+    void updateDroneList();
+
+    /**
+     * @brief Create the drone list again, when the whole fleet is replaced.
+     */
+    void resetDroneList();
+
+    /**
+     * @brief Move the servers of the canvas that moved in the simulation.
+     */
+    void syncServers();
+
+    /**
+     * @brief Empty the traffic heatmap, if shown, and fit its grid to the map.
+     */
+    void resetHeatmap();
+
+    /**
+     * @brief Render and queue the frames of the export due at the current simulated time.
+     */
+    void exportFrames();
+
+    static constexpr int commandCapacity = 4096; ///< Maximum number of commands waiting for the next step.
+    static constexpr double stepDuration = 0.02; ///< Duration of a simulation step in seconds.
+    static constexpr double maxLag = 1.0; ///< Maximum delay of the simulation behind the requested speed, in seconds.
+    static constexpr int physicsInterval = 5; ///< Interval of the physics timer in ms.
+    static constexpr int renderInterval = 33; ///< Interval of the display timer in ms (30 frames per second).
+    static constexpr qint64 physicsBudget = 25000000; ///< Maximum duration of the steps run by one physics timer event, in ns.
+    static constexpr double governorLag = 0.1; ///< Delay of the simulation, in seconds, over which the rendering quality is lowered.
+
     Ui::MainWindow *ui; ///< UI object for managing the user interface.
-    QMap<QString, Drone*> mapDrones; ///< Map of drone names to Drone objects.
-    QTimer *timer; ///< Timer for simulating updates at regular intervals.
+    Simulation simulation; ///< Simulation engine (servers and drones).
+    QVector<DroneWidget*> droneWidgets; ///< Widgets of the drone list, in the order of the rows (owned by the list).
+    QSet<DroneId> listedDrones; ///< Drones having a row in the drone list.
+    quint64 listedRevision = 0; ///< Revision of the fleet displayed in the drone list.
+    quint64 shownServerRevision = 0; ///< Revision of the servers displayed in the canvas.
+    CommandQueue commands; ///< Commands received by the inputs, applied by the simulation steps.
+    QVector<CommandInput*> commandInputs; ///< Threads receiving the commands.
+    TelemetryStream telemetry; ///< Telemetry of the steps, written if open.
+    FrameExporter exporter; ///< Frames of the canvas at a fixed rate of simulated time, exported if open.
+    std::unique_ptr<TrafficHeatmap> heatmap; ///< Traffic accumulated while shown, null until first shown.
+    bool heatmapShown = false; ///< True if the heatmap is accumulated and drawn.
+    DroneTrails trails; ///< Recent positions of the drones, recorded while shown.
+    bool trailsShown = false; ///< True if the trails are recorded and drawn.
+    QAction *trailsAction; ///< Action of the View menu showing the trails.
+    CheckpointWriter checkpointWriter; ///< Thread saving the checkpoints.
+    QString checkpointPath; ///< File of the periodic checkpoints, empty for none.
+    double checkpointInterval = 0; ///< Simulated time between two periodic checkpoints.
+    double nextCheckpoint = 0; ///< Simulated time of the next periodic checkpoint.
+    bool snapshotShared = false; ///< True if a snapshot shares the records since the last steps.
+    std::unique_ptr<SharedFleet> fleet; ///< Shared fleet displayed in attached mode, null otherwise.
+    double fleetTime = 0; ///< Simulated time of the last consistent frame of the shared fleet.
+    QTimer *timer; ///< Timer of the display updates.
+    QTimer *physicsTimer; ///< Timer of the simulation steps.
     QElapsedTimer elapsedTimer; ///< Timer for measuring elapsed time in the simulation.
+    qint64 lastAdvance = 0; ///< Wall clock time of the last simulation advance, in ns.
+    qint64 lastRender = 0; ///< Wall clock time of the last display update, in ns.
+    double timeScale = 1; ///< Simulated seconds per wall clock second (0 to pause, infinity for as fast as possible).
+    double pendingTime = 0; ///< Simulated time owed to the wall clock, in seconds.
+    double stopTime = std::numeric_limits<double>::infinity(); ///< Simulated time at which a headless run quits.
+    int stepCount = 0; ///< Number of steps since the last display update.
+    qint64 simulationTime = 0; ///< Wall time of the steps since the last display update, in ns.
+    RenderGovernor governor{qint64(renderInterval) * 1000000}; ///< Quality of the canvas, lowered before the simulation slows down.
+    quint64 allocationCount = 0; ///< Heap allocations of the steps since the last display update.
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,277 @@
+#include "noflyzones.h"
+#include "vector2dbatch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Nearest point of the border and crossings of a range of edges.
+ */
+struct EdgeScan {
+    float distanceSquared = std::numeric_limits<float>::infinity(); ///< Squared distance to the nearest edge.
+    Vector2D offset; ///< Point minus its projection on the nearest edge.
+    int crossings = 0; ///< Number of edges crossed by the horizontal ray from the point towards +x.
+};
+
+/**
+ * @brief Test a point against a range of edges stored as structures of arrays.
+ *
+ * For each edge (a, b): the projection of the point on the segment gives the distance
+ * to the edge, and the edge is crossed by the ray if it straddles the ordinate of the
+ * point and its abscissa there is beyond the point (even-odd rule).
+ */
+static EdgeScan scanEdges(const float *startX, const float *startY, const float *endY, const float *deltaX,
+                          const float *deltaY, const float *inverseLength, const float *slope,
+                          int begin, int end, const Vector2D &p) {
+    EdgeScan scan;
+    int i = begin;
+#if defined(VECTOR2D_BATCH_AVX)
+    const __m256 px = _mm256_set1_ps(p.x), py = _mm256_set1_ps(p.y);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1);
+    __m256 best = _mm256_set1_ps(std::numeric_limits<float>::infinity()), bestX = zero, bestY = zero, crossed = zero;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 ax = _mm256_loadu_ps(startX + i), ay = _mm256_loadu_ps(startY + i);
+        const __m256 dx = _mm256_loadu_ps(deltaX + i), dy = _mm256_loadu_ps(deltaY + i);
+        const __m256 wx = _mm256_sub_ps(px, ax), wy = _mm256_sub_ps(py, ay);
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(wx, dx), _mm256_mul_ps(wy, dy)), _mm256_loadu_ps(inverseLength + i));
+        t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+        const __m256 rx = _mm256_sub_ps(wx, _mm256_mul_ps(t, dx)), ry = _mm256_sub_ps(wy, _mm256_mul_ps(t, dy));
+        const __m256 d = _mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry));
+        const __m256 closer = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+        best = _mm256_blendv_ps(best, d, closer);
+        bestX = _mm256_blendv_ps(bestX, rx, closer);
+        bestY = _mm256_blendv_ps(bestY, ry, closer);
+        const __m256 straddle = _mm256_xor_ps(_mm256_cmp_ps(ay, py, _CMP_GT_OQ), _mm256_cmp_ps(_mm256_loadu_ps(endY + i), py, _CMP_GT_OQ));
+        const __m256 beyond = _mm256_cmp_ps(px, _mm256_add_ps(ax, _mm256_mul_ps(wy, _mm256_loadu_ps(slope + i))), _CMP_LT_OQ);
+        crossed = _mm256_add_ps(crossed, _mm256_and_ps(_mm256_and_ps(straddle, beyond), one));
+    }
+    alignas(32) float lanes[4][8];
+    _mm256_store_ps(lanes[0], best);
+    _mm256_store_ps(lanes[1], bestX);
+    _mm256_store_ps(lanes[2], bestY);
+    _mm256_store_ps(lanes[3], crossed);
+    for (int l = 0; l < 8; l++) {
+        if (lanes[0][l] < scan.distanceSquared) {
+            scan.distanceSquared = lanes[0][l];
+            scan.offset = Vector2D(lanes[1][l], lanes[2][l]);
+        }
+        scan.crossings += int(lanes[3][l]);
+    }
+#elif defined(VECTOR2D_BATCH_SSE)
+    const __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1);
+    __m128 best = _mm_set1_ps(std::numeric_limits<float>::infinity()), bestX = zero, bestY = zero, crossed = zero;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 ax = _mm_loadu_ps(startX + i), ay = _mm_loadu_ps(startY + i);
+        const __m128 dx = _mm_loadu_ps(deltaX + i), dy = _mm_loadu_ps(deltaY + i);
+        const __m128 wx = _mm_sub_ps(px, ax), wy = _mm_sub_ps(py, ay);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(wx, dx), _mm_mul_ps(wy, dy)), _mm_loadu_ps(inverseLength + i));
+        t = _mm_min_ps(_mm_max_ps(t, zero), one);
+        const __m128 rx = _mm_sub_ps(wx, _mm_mul_ps(t, dx)), ry = _mm_sub_ps(wy, _mm_mul_ps(t, dy));
+        const __m128 d = _mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry));
+        const __m128 closer = _mm_cmplt_ps(d, best);  // No blend before SSE4.1: select with masks
+        best = _mm_or_ps(_mm_and_ps(closer, d), _mm_andnot_ps(closer, best));
+        bestX = _mm_or_ps(_mm_and_ps(closer, rx), _mm_andnot_ps(closer, bestX));
+        bestY = _mm_or_ps(_mm_and_ps(closer, ry), _mm_andnot_ps(closer, bestY));
+        const __m128 straddle = _mm_xor_ps(_mm_cmpgt_ps(ay, py), _mm_cmpgt_ps(_mm_loadu_ps(endY + i), py));
+        const __m128 beyond = _mm_cmplt_ps(px, _mm_add_ps(ax, _mm_mul_ps(wy, _mm_loadu_ps(slope + i))));
+        crossed = _mm_add_ps(crossed, _mm_and_ps(_mm_and_ps(straddle, beyond), one));
+    }
+    alignas(16) float lanes[4][4];
+    _mm_store_ps(lanes[0], best);
+    _mm_store_ps(lanes[1], bestX);
+    _mm_store_ps(lanes[2], bestY);
+    _mm_store_ps(lanes[3], crossed);
+    for (int l = 0; l < 4; l++) {
+        if (lanes[0][l] < scan.distanceSquared) {
+            scan.distanceSquared = lanes[0][l];
+            scan.offset = Vector2D(lanes[1][l], lanes[2][l]);
+        }
+        scan.crossings += int(lanes[3][l]);
+    }
+#endif
+    for (; i < end; i++) {
+        const float wx = p.x - startX[i], wy = p.y - startY[i];
+        const float t = qBound(0.0f, (wx * deltaX[i] + wy * deltaY[i]) * inverseLength[i], 1.0f);
+        const float rx = wx - t * deltaX[i], ry = wy - t * deltaY[i];
+        const float d = rx * rx + ry * ry;
+        if (d < scan.distanceSquared) {
+            scan.distanceSquared = d;
+            scan.offset = Vector2D(rx, ry);
+        }
+        if ((startY[i] > p.y) != (endY[i] > p.y) && p.x < startX[i] + wy * slope[i]) {
+            scan.crossings++;
+        }
+    }
+    return scan;
+}
+
+/**
+ * @brief Replace the zones and pack the R-tree.
+ *
+ * The zones are sorted in Sort-Tile-Recursive order and grouped by nodeCapacity into
+ * leaves, then the leaves are sorted and grouped into the nodes of the level above,
+ * and so on up to the root. The nodes of each level are stored contiguously, so that
+ * the children of a node are a range.
+ *
+ * @param zones The zones of the scenario.
+ */
+void NoFlyZones::setZones(const QVector<NoFlyZoneSpec> &zones) {
+    clear();
+    if (zones.isEmpty()) {
+        return;
+    }
+    names.reserve(zones.size());
+    polygons.reserve(zones.size());
+    bounds.reserve(zones.size());
+    edgeStart.reserve(zones.size() + 1);
+    for (const NoFlyZoneSpec &zone : zones) {
+        names.append(zone.name);
+        polygons.append(zone.polygon);
+        edgeStart.append(startX.size());
+        Box box{zone.polygon[0].x, zone.polygon[0].y, zone.polygon[0].x, zone.polygon[0].y};
+        const int n = zone.polygon.size();
+        for (int v = 0; v < n; v++) {
+            const Vector2D &a = zone.polygon[v];
+            const Vector2D &b = zone.polygon[(v + 1) % n];
+            const Vector2D delta = b - a;
+            const float length = delta.lengthSquared();
+            startX.append(a.x);
+            startY.append(a.y);
+            endY.append(b.y);
+            deltaX.append(delta.x);
+            deltaY.append(delta.y);
+            inverseLength.append(length > 0 ? 1 / length : 0);
+            slope.append(delta.y != 0 ? delta.x / delta.y : 0);  // Unused for horizontal edges, which never straddle
+            box = Box{qMin(box.left, a.x), qMin(box.top, a.y), qMax(box.right, a.x), qMax(box.bottom, a.y)};
+        }
+        bounds.append(box);
+    }
+    edgeStart.append(startX.size());
+
+    // Leaves over the zones, then the levels of inner nodes up to the root
+    QVector<Node> level;
+    level.reserve(zones.size());
+    for (int z = 0; z < bounds.size(); z++) {
+        level.append(Node{bounds[z], z, 0, false});
+    }
+    sortTiles(level);
+    items.reserve(level.size());
+    for (const Node &entry : level) {
+        items.append(entry.first);
+    }
+    level = group(level, 0, true);
+    while (level.size() > 1) {
+        sortTiles(level);
+        const int first = nodes.size();
+        nodes += level;
+        level = group(level, first, false);
+    }
+    nodes.append(level.first());
+}
+
+/**
+ * @brief Remove all the zones.
+ */
+void NoFlyZones::clear() {
+    names.clear();
+    polygons.clear();
+    bounds.clear();
+    edgeStart.clear();
+    startX.clear();
+    startY.clear();
+    endY.clear();
+    deltaX.clear();
+    deltaY.clear();
+    inverseLength.clear();
+    slope.clear();
+    nodes.clear();
+    items.clear();
+}
+
+/**
+ * @brief Test a point against a zone.
+ * @param zone The index of the zone.
+ * @param p The point.
+ * @return Whether the point is inside, and its distance to the border.
+ */
+NoFlyZones::Proximity NoFlyZones::proximity(int zone, const Vector2D &p) const {
+    const EdgeScan scan = scanEdges(startX.constData(), startY.constData(), endY.constData(), deltaX.constData(),
+                                    deltaY.constData(), inverseLength.constData(), slope.constData(),
+                                    edgeStart[zone], edgeStart[zone + 1], p);
+    Proximity result;
+    result.inside = (scan.crossings & 1) != 0;
+    result.distance = std::sqrt(scan.distanceSquared);
+    if (result.distance > 0) {
+        result.away = (1 / result.distance) * scan.offset;
+    }
+    return result;
+}
+
+/**
+ * @brief Compute the force pushing a drone out of the zones and away from their borders.
+ *
+ * Only the zones whose bounding box is within the margin of the drone are tested.
+ *
+ * @param p The position of the drone.
+ * @param margin The distance from a zone under which the drone is pushed away.
+ * @param coefficient The magnitude of the force on the border.
+ * @return The sum of the forces of the zones near the drone.
+ */
+Vector2D NoFlyZones::force(const Vector2D &p, float margin, float coefficient) const {
+    Vector2D total;
+    query(QRectF(p.x - margin, p.y - margin, 2 * margin, 2 * margin), [&](int zone) {
+        const Proximity near = proximity(zone, p);
+        if (near.inside) {
+            total.addScaled(-coefficient * (1 + near.distance / margin), near.away);  // Towards the nearest border
+        } else if (near.distance < margin) {
+            total.addScaled(coefficient * (1 - near.distance / margin), near.away);
+        }
+    });
+    return total;
+}
+
+/**
+ * @brief Sort boxes in Sort-Tile-Recursive order: slices by x, then by y in each slice.
+ *
+ * With P = ceil(n / nodeCapacity) nodes to fill, the boxes sorted by the abscissa of
+ * their centre are cut in ceil(sqrt(P)) vertical slices of whole nodes, and each slice
+ * is sorted by ordinate, so that consecutive boxes are close in both directions.
+ *
+ * @param entries The boxes (as nodes), sorted in place.
+ */
+void NoFlyZones::sortTiles(QVector<Node> &entries) {
+    const int n = entries.size();
+    const int parents = (n + nodeCapacity - 1) / nodeCapacity;
+    const int sliceSize = int(std::ceil(std::sqrt(double(parents)))) * nodeCapacity;
+    std::sort(entries.begin(), entries.end(), [](const Node &a, const Node &b) {
+        return a.box.left + a.box.right < b.box.left + b.box.right;
+    });
+    for (int s = 0; s < n; s += sliceSize) {
+        std::sort(entries.begin() + s, entries.begin() + qMin(s + sliceSize, n), [](const Node &a, const Node &b) {
+            return a.box.top + a.box.bottom < b.box.top + b.box.bottom;
+        });
+    }
+}
+
+/**
+ * @brief Group consecutive boxes into nodes of nodeCapacity children.
+ * @param entries The boxes, in Sort-Tile-Recursive order.
+ * @param first The index of the first box in its array (nodes or items).
+ * @param leaf True if the boxes are zones.
+ * @return The parent nodes.
+ */
+QVector<NoFlyZones::Node> NoFlyZones::group(const QVector<Node> &entries, int first, bool leaf) {
+    QVector<Node> parents;
+    parents.reserve((entries.size() + nodeCapacity - 1) / nodeCapacity);
+    for (int c = 0; c < entries.size(); c += nodeCapacity) {
+        const int count = qMin(nodeCapacity, int(entries.size()) - c);
+        Box box = entries[c].box;
+        for (int k = 1; k < count; k++) {
+            const Box &child = entries[c + k].box;
+            box = Box{qMin(box.left, child.left), qMin(box.top, child.top), qMax(box.right, child.right), qMax(box.bottom, child.bottom)};
+        }
+        parents.append(Node{box, first + c, count, leaf});
+    }
+    return parents;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file noflyzones.h
+ * @brief No-fly zones of a scenario, indexed by an R-tree.
+ *
+ * This file declares the NoFlyZones class, which finds the zones near a drone and
+ * computes the force keeping the drone out of them.
+ */
+
+#ifndef NOFLYZONES_H
+#define NOFLYZONES_H
+
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include "scenario.h"
+#include "vector2d.h"
+
+/**
+ * @class NoFlyZones
+ * @brief Polygonal no-fly zones, with an R-tree over their bounding boxes.
+ *
+ * The zones are static: the R-tree is packed once when the zones are set (Sort-Tile-
+ * Recursive packing, nodeCapacity boxes per node), and query() descends it with a
+ * fixed stack, so that the simulation threads can query it concurrently without
+ * allocating.
+ *
+ * The edges of all the polygons are stored as structures of arrays (start, end, and
+ * precomputed direction terms), zone after zone, so that the distance to the edges
+ * and the crossings of the point-in-polygon test are computed for 4 or 8 edges at a
+ * time with the SSE or AVX instructions (see vector2dbatch.h).
+ */
+class NoFlyZones {
+public:
+    static constexpr int nodeCapacity = 8; ///< Number of children of a node of the R-tree.
+
+    /**
+     * @brief Result of the test of a point against a zone.
+     */
+    struct Proximity {
+        bool inside = false; ///< True if the point is inside the polygon.
+        float distance = 0; ///< Distance from the point to the border of the polygon.
+        Vector2D away; ///< Unit vector from the nearest point of the border to the point (zero at distance 0).
+    };
+
+    /**
+     * @brief Constructs an empty set of zones.
+     */
+    NoFlyZones() {}
+
+    /**
+     * @brief Replace the zones and pack the R-tree.
+     * @param zones The zones of the scenario.
+     */
+    void setZones(const QVector<NoFlyZoneSpec> &zones);
+
+    /**
+     * @brief Remove all the zones.
+     */
+    void clear();
+
+    /**
+     * @brief Check if there is no zone.
+     * @return True if there is no zone.
+     */
+    inline bool isEmpty() const { return names.isEmpty(); }
+
+    /**
+     * @brief Get the number of zones.
+     * @return The number of zones.
+     */
+    inline int size() const { return names.size(); }
+
+    /**
+     * @brief Get the name of a zone.
+     * @param zone The index of the zone.
+     * @return The name.
+     */
+    inline const QString &name(int zone) const { return names[zone]; }
+
+    /**
+     * @brief Get the vertices of a zone.
+     * @param zone The index of the zone.
+     * @return The vertices of the polygon.
+     */
+    inline const QVector<Vector2D> &polygon(int zone) const { return polygons[zone]; }
+
+    /**
+     * @brief Call a function for each zone whose bounding box overlaps a rectangle.
+     * @param area The rectangle.
+     * @param visit The function, called with the index of each zone.
+     */
+    template<typename Visitor>
+    void query(const QRectF &area, Visitor &&visit) const;
+
+    /**
+     * @brief Test a point against a zone.
+     * @param zone The index of the zone.
+     * @param p The point.
+     * @return Whether the point is inside, and its distance to the border.
+     */
+    Proximity proximity(int zone, const Vector2D &p) const;
+
+    /**
+     * @brief Compute the force pushing a drone out of the zones and away from their borders.
+     *
+     * Outside a zone, the force grows from 0 at the margin to coefficient on the border;
+     * inside, it keeps growing with the depth, towards the nearest border.
+     *
+     * @param p The position of the drone.
+     * @param margin The distance from a zone under which the drone is pushed away.
+     * @param coefficient The magnitude of the force on the border.
+     * @return The sum of the forces of the zones near the drone.
+     */
+    Vector2D force(const Vector2D &p, float margin, float coefficient) const;
+
+private:
+    /**
+     * @brief Axis-aligned box.
+     */
+    struct Box {
+        float left, top, right, bottom; ///< Bounds of the box.
+
+        /**
+         * @brief Check if two boxes overlap (borders included).
+         * @param other The other box.
+         * @return True if the boxes overlap.
+         */
+        inline bool overlaps(const Box &other) const {
+            return left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom;
+        }
+    };
+
+    /**
+     * @brief Node of the R-tree.
+     */
+    struct Node {
+        Box box; ///< Bounding box of the children.
+        int first; ///< First child, in nodes (inner node) or in items (leaf).
+        int count; ///< Number of children.
+        bool leaf; ///< True if the children are zones.
+    };
+
+    /**
+     * @brief Sort boxes in Sort-Tile-Recursive order: slices by x, then by y in each slice.
+     * @param entries The boxes (as nodes), sorted in place.
+     */
+    static void sortTiles(QVector<Node> &entries);
+
+    /**
+     * @brief Group consecutive boxes into nodes of nodeCapacity children.
+     * @param entries The boxes, in Sort-Tile-Recursive order.
+     * @param first The index of the first box in its array (nodes or items).
+     * @param leaf True if the boxes are zones.
+     * @return The parent nodes.
+     */
+    static QVector<Node> group(const QVector<Node> &entries, int first, bool leaf);
+
+    static constexpr int maxStack = 128; ///< Size of the stack of query(), enough for any tree of nodeCapacity children.
+
+    QVector<QString> names; ///< Name of each zone.
+    QVector<QVector<Vector2D>> polygons; ///< Vertices of each zone, for display.
+    QVector<Box> bounds; ///< Bounding box of each zone.
+    QVector<int> edgeStart; ///< First edge of each zone, plus the end of the last zone.
+    QVector<float> startX; ///< Abscissa of the start of each edge.
+    QVector<float> startY; ///< Ordinate of the start of each edge.
+    QVector<float> endY; ///< Ordinate of the end of each edge (exact, for the crossing test).
+    QVector<float> deltaX; ///< Abscissa of the vector of each edge.
+    QVector<float> deltaY; ///< Ordinate of the vector of each edge.
+    QVector<float> inverseLength; ///< 1 / squared length of each edge (0 for an empty edge).
+    QVector<float> slope; ///< deltaX / deltaY of each edge, for the crossing test.
+    QVector<Node> nodes; ///< Nodes of the R-tree, the root last.
+    QVector<int> items; ///< Zones referenced by the leaves, in Sort-Tile-Recursive order.
+};
+
+/**
+ * @brief Call a function for each zone whose bounding box overlaps a rectangle.
+ * @param area The rectangle.
+ * @param visit The function, called with the index of each zone.
+ */
+template<typename Visitor>
+void NoFlyZones::query(const QRectF &area, Visitor &&visit) const {
+    if (nodes.isEmpty()) {
+        return;
+    }
+    const Box box{float(area.left()), float(area.top()), float(area.right()), float(area.bottom())};
+    int stack[maxStack];
+    int top = 0;
+    stack[top++] = nodes.size() - 1;
+    while (top > 0) {
+        const Node &node = nodes[stack[--top]];
+        for (int c = node.first; c < node.first + node.count; c++) {
+            if (node.leaf) {
+                if (bounds[items[c]].overlaps(box)) {
+                    visit(items[c]);
+                }
+            } else if (nodes[c].box.overlaps(box)) {
+                stack[top++] = c;
+            }
+        }
+    }
+}
+
+#endif // NOFLYZONES_H
@@ -0,0 +1,151 @@
+#include "regionmap.h"
+
+/**
+ * @brief Triangulate the servers and compute the lists of all the regions.
+ * @param servers The positions of the servers.
+ * @param range The collision distance.
+ */
+void RegionMap::build(const QVector<Vector2D> &servers, float range) {
+    sites = servers;
+    this->range = range;
+    QRectF area;
+    if (!sites.isEmpty()) {
+        float left = sites[0].x, top = sites[0].y, right = left, bottom = top;
+        for (const Vector2D &site : sites) {
+            left = qMin(left, site.x);
+            top = qMin(top, site.y);
+            right = qMax(right, site.x);
+            bottom = qMax(bottom, site.y);
+        }
+        area = QRectF(left, top, right - left, bottom - top).adjusted(-range, -range, range, range);
+    }
+    delaunay.build(sites, area);
+    updateLists();
+}
+
+/**
+ * @brief Move a server, repair the triangulation and update the lists.
+ *
+ * The triangulation is repaired locally, but the lists are all computed again: the
+ * cost is linear in the number of servers, like the move of the server itself.
+ *
+ * @param index The index of the server.
+ * @param position The new position of the server.
+ */
+void RegionMap::moveServer(int index, const Vector2D &position) {
+    sites[index] = position;
+    delaunay.move(index, position);
+    updateLists();
+}
+
+/**
+ * @brief Change the collision distance, which defines the halo regions.
+ * @param range The collision distance.
+ */
+void RegionMap::setRange(float range) {
+    this->range = range;
+    updateLists();
+}
+
+/**
+ * @brief Find the region of a point, by walking from a region.
+ *
+ * In the area where the cells are exact, the walk goes to the neighbour nearest to the
+ * point until no neighbour is nearer than the current region: the segment from a
+ * server to the point leaves its cell through the cell of a neighbour nearer to the
+ * point. Elsewhere, all the servers are compared. Of two servers at the same distance,
+ * the first one is kept, like in Vector2DBatch::nearest().
+ *
+ * @param p The point.
+ * @param start The region to start from, usually the previous region of the point.
+ * @return The index of the nearest server.
+ */
+int RegionMap::locate(const Vector2D &p, int start) const {
+    if (start < 0 || !isExact(p)) {
+        int best = -1;
+        float bestDistance = 0;
+        for (int i = 0; i < sites.size(); i++) {
+            float distance = p.distanceSquared(sites[i]);
+            if (best < 0 || distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return best;
+    }
+    int current = start;
+    float bestDistance = p.distanceSquared(sites[current]);
+    for (;;) {
+        int next = current;
+        for (int k : adjacency[current]) {
+            float distance = p.distanceSquared(sites[k]);
+            if (distance < bestDistance || (distance == bestDistance && k < next)) {
+                bestDistance = distance;
+                next = k;
+            }
+        }
+        if (next == current) {
+            return current;  // (distance, index) decreases at each move: the walk ends
+        }
+        current = next;
+    }
+}
+
+/**
+ * @brief Compute the neighbours and the halo regions of all the regions.
+ *
+ * The halo regions of a region are searched from its neighbours, through the regions
+ * whose cell bounds intersect the bounds of its cell grown by the collision distance.
+ * The cells near the region form a connected set of regions, so the search finds them
+ * all. The bounds are cut to the area where the cells are exact, since the cells of
+ * the servers on the convex hull extend to the far away vertices of the triangulation.
+ */
+void RegionMap::updateLists() {
+    const int n = sites.size();
+    exact = delaunay.exactArea().adjusted(range, range, -range, -range);
+    adjacency.resize(n);
+    halo.resize(n);
+    visited.fill(-1, n);
+    QVector<QRectF> bounds(n);
+    QVector<int> hidden;
+    for (int i = 0; i < n; i++) {
+        adjacency[i] = delaunay.neighbors(i);
+        bounds[i] = delaunay.cellBounds(i).intersected(delaunay.exactArea());
+        if (adjacency[i].isEmpty() && n > 1) {
+            hidden.append(i);  // At the position of another server
+        }
+    }
+
+    QVector<int> pending;
+    for (int i = 0; i < n; i++) {
+        halo[i].clear();
+        if (adjacency[i].isEmpty()) {
+            continue;
+        }
+        const QRectF reach = bounds[i].adjusted(-range, -range, range, range);
+        visited[i] = i;
+        pending = adjacency[i];
+        while (!pending.isEmpty()) {
+            int k = pending.takeLast();
+            if (visited[k] == i) {
+                continue;
+            }
+            visited[k] = i;
+            if (reach.intersects(bounds[k])) {
+                halo[i].append(k);
+                pending += adjacency[k];
+            }
+        }
+        halo[i] += hidden;
+    }
+    for (int h : hidden) {
+        adjacency[h].clear();
+        halo[h].clear();
+        for (int j = 0; j < n; j++) {
+            if (j != h) {
+                adjacency[h].append(j);
+                halo[h].append(j);
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file regionmap.h
+ * @brief Adjacency of the server regions, for the sharded engine of the simulation.
+ *
+ * This file declares the RegionMap class, which keeps the Delaunay triangulation of
+ * the servers and derives from it the regions a shard exchanges drones with, so that
+ * the cost of the halo exchange and of the migrations does not grow with the number
+ * of servers.
+ */
+
+#ifndef REGIONMAP_H
+#define REGIONMAP_H
+
+#include <QRectF>
+#include <QVector>
+#include "delaunay.h"
+#include "vector2d.h"
+
+/**
+ * @class RegionMap
+ * @brief Neighbouring regions of each server, from the Delaunay triangulation.
+ *
+ * Two kinds of lists are kept for each region:
+ * - its neighbours, the regions whose cells touch its cell: a drone leaving a region
+ *   is found by walking from region to neighbouring region towards the drone, since a
+ *   region that is not the nearest one always has a neighbour nearer to the drone;
+ * - its halo regions, the regions whose cells may be closer than the collision
+ *   distance to its cell (the neighbours, and the regions beyond a short edge between
+ *   two neighbours), found from the bounding boxes of the cells.
+ *
+ * The cells given by the triangulation are only exact in an area around the servers
+ * (see Delaunay::exactArea()). For a drone beyond this area, minus the collision
+ * distance, the lists do not apply, and all the regions are considered.
+ *
+ * A server at the position of another one is not in the triangulation: its region is
+ * empty, it has all the other regions as neighbours, and it is a halo region of all
+ * the others, until its drones have moved to the region of the other server.
+ */
+class RegionMap {
+public:
+    /**
+     * @brief Constructs an empty map.
+     */
+    RegionMap() {}
+
+    /**
+     * @brief Triangulate the servers and compute the lists of all the regions.
+     * @param servers The positions of the servers.
+     * @param range The collision distance.
+     */
+    void build(const QVector<Vector2D> &servers, float range);
+
+    /**
+     * @brief Move a server, repair the triangulation and update the lists.
+     * @param index The index of the server.
+     * @param position The new position of the server.
+     */
+    void moveServer(int index, const Vector2D &position);
+
+    /**
+     * @brief Change the collision distance, which defines the halo regions.
+     * @param range The collision distance.
+     */
+    void setRange(float range);
+
+    /**
+     * @brief Find the region of a point, by walking from a region.
+     * @param p The point.
+     * @param start The region to start from, usually the previous region of the point.
+     * @return The index of the nearest server.
+     */
+    int locate(const Vector2D &p, int start) const;
+
+    /**
+     * @brief Check if the lists apply to a point.
+     * @param p The point.
+     * @return True if the point is in the area where the cells are exact, one collision distance away from its border.
+     */
+    inline bool isExact(const Vector2D &p) const { return exact.contains(QPointF(p.x, p.y)); }
+
+    /**
+     * @brief Get the position of the server of a region.
+     * @param region The index of the region.
+     * @return The position.
+     */
+    inline const Vector2D &position(int region) const { return sites[region]; }
+
+    /**
+     * @brief Get the regions whose cells may be closer than the collision distance to the cell of a region.
+     * @param region The index of the region.
+     * @return The indices of the regions, without the region itself.
+     */
+    inline const QVector<int> &haloRegions(int region) const { return halo[region]; }
+
+    /**
+     * @brief Get the number of regions.
+     * @return The number of servers.
+     */
+    inline int size() const { return sites.size(); }
+
+private:
+    /**
+     * @brief Compute the neighbours and the halo regions of all the regions.
+     */
+    void updateLists();
+
+    Delaunay delaunay; ///< Triangulation of the servers.
+    QVector<Vector2D> sites; ///< Positions of the servers.
+    QVector<QVector<int>> adjacency; ///< Neighbours of each region.
+    QVector<QVector<int>> halo; ///< Halo regions of each region.
+    QVector<int> visited; ///< Last region whose halo search visited each region, scratch of updateLists().
+    QRectF exact; ///< Area where the lists apply.
+    float range = 0; ///< Collision distance.
+};
+
+#endif // REGIONMAP_H
@@ -0,0 +1,123 @@
+#include "regionshard.h"
+#include <cmath>
+
+/**
+ * @brief Remove all the drones of the shard.
+ */
+void RegionShard::clear() {
+    drones.clear();
+    records.clear();
+    positions.clear();
+    halo.clear();
+    landings.clear();
+    arrivals.clear();
+    emigrants.clear();
+    destinations.clear();
+}
+
+/**
+ * @brief Drop the drones that have landed and take a snapshot of the positions of the others.
+ * @param registry The registry of the drones.
+ */
+void RegionShard::snapshot(DroneRegistry &registry) {
+    records.resize(drones.size());
+    positions.resize(drones.size());
+    int count = 0;
+    for (int i = 0; i < drones.size(); i++) {
+        Drone *drone = registry.find(drones[i]);
+        if (drone && drone->getStatus() != Drone::landed) {
+            drones[count] = drones[i];
+            records[count] = drone;
+            positions[count] = drone->getPosition();
+            count++;
+        }
+    }
+    drones.resize(count);
+    records.resize(count);
+    positions.resize(count);
+    halo.clear();
+    landings.clear();
+    arrivals.clear();
+    emigrants.clear();
+    destinations.clear();
+}
+
+/**
+ * @brief Collect the positions of the drones of the other shards near the border of the region.
+ * @param shards All the shards, indexed by their region.
+ * @param regions The regions of the servers.
+ * @param range The collision distance.
+ */
+void RegionShard::gatherHalo(const QVector<RegionShard> &shards, const RegionMap &regions, float range) {
+    if (drones.isEmpty()) {
+        return;  // No drone to protect
+    }
+    bool exact = true;
+    for (const Vector2D &p : positions) {
+        exact = exact && regions.isExact(p);
+    }
+    const QVector<int> &near = regions.haloRegions(cell);
+    const int count = exact ? near.size() : shards.size();
+    const Vector2D &own = regions.position(cell);
+    for (int k = 0; k < count; k++) {
+        const int j = exact ? near[k] : k;
+        if (j == cell) {
+            continue;
+        }
+        const Vector2D &other = regions.position(j);
+        // Coincident servers give 0, which puts all the drones of one region in the halo of the other
+        const float spacing = std::sqrt(own.distanceSquared(other));
+        const float scale = spacing > 0 ? 1 / (2 * spacing) : 0;
+        for (const Vector2D &p : shards[j].positions) {
+            // Distance of p to the bisector of the two servers
+            if ((p.distanceSquared(own) - p.distanceSquared(other)) * scale < range) {
+                halo.append(p);
+            }
+        }
+    }
+    grid.build(positions.constData(), positions.size(), halo.constData(), halo.size(), range);
+}
+
+/**
+ * @brief Get the positions of the drones that may collide with a drone of the shard.
+ * @param self The index of the drone in the shard.
+ * @return The number of positions, stored in nearby. The distances array can hold them.
+ */
+int RegionShard::gatherCandidates(int self) {
+    const int count = grid.candidates(self, nearby);
+    if (distances.size() < count) {
+        distances.resize(count);
+    }
+    return count;
+}
+
+/**
+ * @brief Move out of the shard the drones that are now over another region.
+ * @param regions The regions of the servers.
+ */
+void RegionShard::collectEmigrants(const RegionMap &regions) {
+    int count = 0;
+    for (int i = 0; i < drones.size(); i++) {
+        int region = regions.locate(records[i]->getPosition(), cell);
+        if (region == cell) {
+            drones[count++] = drones[i];
+        } else {
+            emigrants.append(drones[i]);
+            destinations.append(region);
+        }
+    }
+    drones.resize(count);
+}
+
+/**
+ * @brief Get the memory used by the shard, which only grows when the shard gets more drones.
+ * @return The capacity of the arrays of the shard, in bytes.
+ */
+std::size_t RegionShard::capacity() const {
+    return std::size_t(drones.capacity() + landings.capacity() + arrivals.capacity() + emigrants.capacity()) * sizeof(DroneId)
+           + std::size_t(records.capacity()) * sizeof(Drone*)
+           + std::size_t(positions.capacity() + halo.capacity() + nearby.capacity()) * sizeof(Vector2D)
+           + grid.capacity()
+           + std::size_t(distances.capacity()) * sizeof(float)
+           + std::size_t(destinations.capacity()) * sizeof(int);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file regionshard.h
+ * @brief Part of the fleet flying over the region of a server.
+ *
+ * This file declares the RegionShard class used by the sharded engine of the
+ * simulation: the map is split into the nearest-server regions drawn by Voronoi, and
+ * the drones in the air over each region are simulated by their own shard.
+ */
+
+#ifndef REGIONSHARD_H
+#define REGIONSHARD_H
+
+#include <QVector>
+#include "collisiongrid.h"
+#include "droneregistry.h"
+#include "regionmap.h"
+
+/**
+ * @class RegionShard
+ * @brief Drones in the air over one server region, with the halo of its neighbors.
+ *
+ * Since collision forces only act under the collision distance, a shard only needs
+ * its own drones and the drones of the other shards that are closer than this distance
+ * to its border (the halo) to update its drones. The halo is read from the regions near
+ * the region only (see RegionMap), and the drones leaving the region are located by
+ * walking from the region to its neighbours, so that the cost of a shard does not
+ * depend on the number of servers. The collision candidates of a drone are read from a
+ * grid of the shard and its halo. A step of the sharded engine runs in
+ * phases, each one executed for all the shards in parallel:
+ * - snapshot(): drop the landed drones and copy the positions of the others,
+ * - gatherHalo(): read the positions of the other shards near the border, and sort
+ *   them with the own drones into the grid,
+ * - (update of the drones, done by the simulation),
+ * - collectEmigrants(): move out the drones that have crossed to another region.
+ * Each phase only writes to its own shard, and only reads the data of the other shards
+ * that the previous phases have finished writing. Between steps the simulation moves
+ * the emigrants to their new shard.
+ */
+class RegionShard {
+public:
+    /**
+     * @brief Constructs a shard.
+     * @param cell The index of the server whose region the shard covers.
+     */
+    explicit RegionShard(int cell = -1) : cell(cell) {}
+
+    /**
+     * @brief Get the region covered by the shard.
+     * @return The index of the server of the region.
+     */
+    inline int getCell() const { return cell; }
+
+    /**
+     * @brief Add a drone flying over the region.
+     * @param id The handle of the drone.
+     */
+    inline void addDrone(DroneId id) { drones.append(id); }
+
+    /**
+     * @brief Remove all the drones of the shard.
+     */
+    void clear();
+
+    /**
+     * @brief Drop the drones that have landed and take a snapshot of the positions of the others.
+     * @param registry The registry of the drones.
+     */
+    void snapshot(DroneRegistry &registry);
+
+    /**
+     * @brief Collect the positions of the drones of the other shards near the border of the region.
+     *
+     * A drone of region j is in the halo of region i when its distance to the bisector of
+     * the two servers is under the collision distance. This is a conservative test: the
+     * distance to region i can only be larger. Only the halo regions of the region are
+     * read, or all the regions if a drone of the shard is beyond the area of the map.
+     * The grid is then built from the own drones and the halo.
+     *
+     * @param shards All the shards, indexed by their region.
+     * @param regions The regions of the servers.
+     * @param range The collision distance.
+     */
+    void gatherHalo(const QVector<RegionShard> &shards, const RegionMap &regions, float range);
+
+    /**
+     * @brief Get the positions of the drones that may collide with a drone of the shard.
+     *
+     * The positions are those of the cells of the grid around the drone (see CollisionGrid).
+     *
+     * @param self The index of the drone in the shard.
+     * @return The number of positions, stored in nearby. The distances array can hold them.
+     */
+    int gatherCandidates(int self);
+
+    /**
+     * @brief Move out of the shard the drones that are now over another region.
+     * @param regions The regions of the servers.
+     */
+    void collectEmigrants(const RegionMap &regions);
+
+    /**
+     * @brief Get the memory used by the shard, which only grows when the shard gets more drones.
+     * @return The capacity of the arrays of the shard, in bytes.
+     */
+    std::size_t capacity() const;
+
+    QVector<DroneId> drones; ///< Drones in the air over the region.
+    QVector<Drone*> records; ///< Records of the drones, resolved by snapshot().
+    QVector<Vector2D> positions; ///< Positions of the drones at the start of the step.
+    QVector<Vector2D> halo; ///< Positions of the drones of the other shards near the border.
+    CollisionGrid grid; ///< Grid of the own drones and the halo, built by gatherHalo().
+    QVector<Vector2D> nearby; ///< Collision candidates of the drone being updated.
+    QVector<float> distances; ///< Scratch array for the batch distance kernel.
+    QVector<DroneId> landings; ///< Drones that started landing during the step.
+    QVector<DroneId> arrivals; ///< Drones that reached a scheduled server without a landing slot during the step.
+    QVector<DroneId> emigrants; ///< Drones that have left the region during the step.
+    QVector<int> destinations; ///< Region of each emigrant.
+
+private:
+    int cell; ///< Index of the server of the region.
+};
+
+#endif // REGIONSHARD_H
@@ -0,0 +1,59 @@
+#include "rendergovernor.h"
+
+static const char *const qualityNames[] = { "full", "no antialiasing", "no rotor lights", "unrotated sprites", "point markers" }; ///< Names of RenderGovernor::Quality.
+static constexpr double smoothing = 0.25; ///< Weight of the last frame in the smoothed costs.
+
+/**
+ * @brief Constructs a governor at full quality.
+ * @param frameBudget The wall time between two frames, in ns.
+ */
+RenderGovernor::RenderGovernor(qint64 frameBudget)
+    : budget(frameBudget), frameInterval(double(frameBudget)) {}
+
+/**
+ * @brief Get the name of a quality level.
+ * @param quality The level.
+ * @return The name.
+ */
+const char *RenderGovernor::name(Quality quality) {
+    return qualityNames[quality];
+}
+
+/**
+ * @brief Account for the costs of a frame and update the quality.
+ *
+ * A frame is overloaded when the simulation is behind, or when the paint takes more
+ * than half of the frame budget. A higher quality is only tried when twice the paint
+ * cost fits in half of the budget and, with the steps, in the interval between frames.
+ *
+ * @param paint The wall time of the last paint of the canvas, in ns.
+ * @param simulation The wall time of the steps since the previous frame, in ns, 0 if they take whatever time is left.
+ * @param interval The wall time since the previous frame, in ns.
+ * @param behind True if the simulation cannot keep up with the requested speed.
+ * @return The quality of the next frames.
+ */
+RenderGovernor::Quality RenderGovernor::update(qint64 paint, qint64 simulation, qint64 interval, bool behind) {
+    paintCost += smoothing * (paint - paintCost);
+    simulationCost += smoothing * (simulation - simulationCost);
+    frameInterval += smoothing * (interval - frameInterval);
+
+    const double paintBudget = budget / 2.0;
+    if (behind || paintCost > paintBudget) {
+        quiet = 0;
+        if (++overloaded >= degradeFrames && level < lowest) {
+            level = Quality(level + 1);
+            overloaded = 0;
+            paintCost = 0;  // Measure the new level from scratch
+        }
+        return level;
+    }
+
+    overloaded = 0;
+    const bool room = 2 * paintCost <= paintBudget && simulationCost + 2 * paintCost <= frameInterval;
+    quiet = room ? quiet + 1 : 0;
+    if (quiet >= restoreFrames && level > full) {
+        level = Quality(level - 1);
+        quiet = 0;
+    }
+    return level;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file rendergovernor.h
+ * @brief Choice of the rendering quality from the cost of the frames.
+ *
+ * This file declares the RenderGovernor class, which lowers the quality of the canvas
+ * when painting takes time from the simulation, and raises it again once the load has
+ * dropped.
+ */
+
+#ifndef RENDERGOVERNOR_H
+#define RENDERGOVERNOR_H
+
+#include <QtGlobal>
+
+/**
+ * @class RenderGovernor
+ * @brief Steps the rendering quality down under load, and back up with hysteresis.
+ *
+ * The simulation comes first: when it falls behind the wall clock, or when painting
+ * takes more than half of the frame budget, the quality is lowered one level after
+ * degradeFrames overloaded frames in a row. It is raised one level after restoreFrames
+ * frames in a row with room for twice the current paint cost, both within the paint
+ * budget and next to the steps, so that the quality does not oscillate between two
+ * levels. The costs are smoothed over a few frames.
+ */
+class RenderGovernor {
+public:
+    /**
+     * @brief Rendering quality, each level dropping more cosmetic work than the previous one.
+     */
+    enum Quality {
+        full, ///< Antialiasing, rotated sprites with their rotor lights.
+        noAntialiasing, ///< Without antialiasing.
+        noRotorLights, ///< Without the lights of the rotors.
+        unrotatedSprites, ///< Sprites drawn without rotation.
+        pointMarkers, ///< Drones drawn as points instead of sprites.
+        lowest = pointMarkers ///< Lowest quality.
+    };
+
+    static constexpr int degradeFrames = 3; ///< Number of overloaded frames in a row before lowering the quality.
+    static constexpr int restoreFrames = 60; ///< Number of quiet frames in a row before raising the quality.
+
+    /**
+     * @brief Constructs a governor at full quality.
+     * @param frameBudget The wall time between two frames, in ns.
+     */
+    explicit RenderGovernor(qint64 frameBudget);
+
+    /**
+     * @brief Get the name of a quality level.
+     * @param quality The level.
+     * @return The name.
+     */
+    static const char *name(Quality quality);
+
+    /**
+     * @brief Account for the costs of a frame and update the quality.
+     * @param paint The wall time of the last paint of the canvas, in ns.
+     * @param simulation The wall time of the steps since the previous frame, in ns, 0 if they take whatever time is left.
+     * @param interval The wall time since the previous frame, in ns.
+     * @param behind True if the simulation cannot keep up with the requested speed.
+     * @return The quality of the next frames.
+     */
+    Quality update(qint64 paint, qint64 simulation, qint64 interval, bool behind);
+
+    /**
+     * @brief Get the quality of the next frames.
+     * @return The quality.
+     */
+    inline Quality quality() const { return level; }
+
+private:
+    qint64 budget; ///< Wall time between two frames, in ns.
+    Quality level = full; ///< Current quality.
+    double paintCost = 0; ///< Smoothed paint time, in ns.
+    double simulationCost = 0; ///< Smoothed step time per frame, in ns.
+    double frameInterval = 0; ///< Smoothed time between frames, in ns.
+    int overloaded = 0; ///< Number of overloaded frames in a row.
+    int quiet = 0; ///< Number of frames in a row with room for a higher quality.
+};
+
+#endif // RENDERGOVERNOR_H
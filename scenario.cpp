@@ -0,0 +1,504 @@
+#include "scenario.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+const char *const Scenario::binarySuffix = "dsb";
+
+/**
+ * @brief Parse a position written as "x,y".
+ * @param str The text to parse.
+ * @param position The parsed position.
+ * @return True if the text contains two valid coordinates.
+ */
+static bool parsePosition(const QString &str, Vector2D &position) {
+    QStringList posList = str.split(",");
+    if (posList.size() != 2) {
+        return false;
+    }
+    bool okX, okY;
+    position.set(posList[0].toFloat(&okX), posList[1].toFloat(&okY));
+    return okX && okY;
+}
+
+/**
+ * @brief Write a position as "x,y".
+ * @param position The position to write.
+ * @return The position as text.
+ */
+static QString positionToString(const Vector2D &position) {
+    return QString::number(position.x) + "," + QString::number(position.y);
+}
+
+/**
+ * @brief Read a flight model profile from JSON.
+ *
+ * Missing values keep the value of the default profile.
+ *
+ * @param obj The JSON object of the profile.
+ * @return The flight model.
+ */
+static FlightModel flightModelFromJson(const QJsonObject &obj) {
+    FlightModel model;
+    model.maxSpeed = obj["maxSpeed"].toDouble(model.maxSpeed);
+    model.maxPower = obj["maxPower"].toDouble(model.maxPower);
+    model.takeoffSpeed = obj["takeoffSpeed"].toDouble(model.takeoffSpeed);
+    model.hoveringHeight = obj["hoveringHeight"].toDouble(model.hoveringHeight);
+    model.coefCollision = obj["coefCollision"].toDouble(model.coefCollision);
+    model.damping = obj["damping"].toDouble(model.damping);
+    model.chargingSpeed = obj["chargingSpeed"].toDouble(model.chargingSpeed);
+    model.powerConsumption = obj["powerConsumption"].toDouble(model.powerConsumption);
+    return model;
+}
+
+/**
+ * @brief Check the values of a flight model profile.
+ *
+ * All the values must be finite; the speeds, the power and the charging speed must be
+ * positive, otherwise the drones never take off, fly or charge (and the times of their
+ * events are divided by zero).
+ *
+ * @param model The flight model.
+ * @return True if the profile can be simulated.
+ */
+static bool isValidFlightModel(const FlightModel &model) {
+    const double values[] = {model.maxSpeed, model.maxPower, model.takeoffSpeed, model.hoveringHeight,
+                             model.coefCollision, model.damping, model.chargingSpeed, model.powerConsumption};
+    for (double value : values) {
+        if (!qIsFinite(value)) {
+            return false;
+        }
+    }
+    return model.maxSpeed > 0 && model.maxPower > 0 && model.takeoffSpeed > 0 && model.chargingSpeed > 0;
+}
+
+/**
+ * @brief Write a flight model profile as JSON.
+ * @param model The flight model.
+ * @return The JSON object, without the name of the profile.
+ */
+static QJsonObject flightModelToJson(const FlightModel &model) {
+    QJsonObject obj;
+    obj["maxSpeed"] = model.maxSpeed;
+    obj["maxPower"] = model.maxPower;
+    obj["takeoffSpeed"] = model.takeoffSpeed;
+    obj["hoveringHeight"] = model.hoveringHeight;
+    obj["coefCollision"] = model.coefCollision;
+    obj["damping"] = model.damping;
+    obj["chargingSpeed"] = model.chargingSpeed;
+    obj["powerConsumption"] = model.powerConsumption;
+    return obj;
+}
+
+/**
+ * @brief Check that the rest of a binary stream is large enough for a number of records.
+ *
+ * Used before reserving memory for the counts read from a file, so that a corrupt or
+ * truncated file fails instead of allocating gigabytes.
+ *
+ * @param in The stream, positioned on the first record.
+ * @param count The number of records announced by the file.
+ * @param minRecordSize The smallest size of one record in bytes (an empty name takes 4 bytes).
+ * @return True if the remaining bytes can hold the records.
+ */
+static bool fitsInStream(const QDataStream &in, quint32 count, qint64 minRecordSize) {
+    const qint64 remaining = in.device()->size() - in.device()->pos();
+    return in.status() == QDataStream::Ok && qint64(count) <= remaining / minRecordSize;
+}
+
+/**
+ * @brief Check if a path designates a binary scenario file.
+ * @param filePath The path to test.
+ * @return True if the extension is the binary scenario extension.
+ */
+bool Scenario::isBinaryFile(const QString &filePath) {
+    return QFileInfo(filePath).suffix().toLower() == binarySuffix;
+}
+
+/**
+ * @brief Remove all flight models, servers, drones and no-fly zones.
+ */
+void Scenario::clear() {
+    flightModels.clear();
+    servers.clear();
+    drones.clear();
+    noFlyZones.clear();
+}
+
+/**
+ * @brief Load a scenario file, JSON or binary depending on its extension.
+ * @param filePath The path of the file to read.
+ * @return True if the file was read successfully.
+ */
+bool Scenario::load(const QString &filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open file:" << filePath;
+        return false;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    bool ok = isBinaryFile(filePath) ? fromBinary(data) : fromJson(data);
+    if (!ok) {
+        qWarning() << "Invalid scenario file:" << filePath;
+    }
+    return ok;
+}
+
+/**
+ * @brief Save the scenario, as JSON or binary depending on the extension.
+ * @param filePath The path of the file to write.
+ * @return True if the file was written successfully.
+ */
+bool Scenario::save(const QString &filePath) const {
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not open file:" << filePath;
+        return false;
+    }
+    QByteArray data = isBinaryFile(filePath) ? toBinary() : toJson();
+    bool ok = file.write(data) == data.size();
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Fill the scenario from a JSON document.
+ *
+ * Servers have a name, a position "x,y", a color, and optionally a number of
+ * "landingPads" and "chargingSlots" (0 or absent for no limit); drones have a name,
+ * a position, a target server, an optional color and an optional flight model.
+ * Flight models have a name and the values that differ from the default profile; the
+ * values must be finite, and the speeds, the power and the charging speed positive.
+ * No-fly zones have a name and a "polygon" array of at least three positions.
+ *
+ * @param data The JSON text.
+ * @return True if the document is a valid scenario.
+ */
+bool Scenario::fromJson(const QByteArray &data) {
+    QJsonParseError error;
+    QJsonDocument doc(QJsonDocument::fromJson(data, &error));
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "JSON parse error:" << error.errorString();
+        return false;
+    }
+    QJsonObject json = doc.object();
+    clear();
+
+    // Load flight models
+    QJsonArray modelArray = json["flightModels"].toArray();
+    flightModels.reserve(modelArray.size());
+    for (const QJsonValue &modelValue : modelArray) {
+        QJsonObject model = modelValue.toObject();
+        FlightModelSpec spec{model["name"].toString(), flightModelFromJson(model)};
+        if (!isValidFlightModel(spec.model)) {
+            qWarning() << "Invalid values for flight model:" << spec.name;
+            return false;
+        }
+        flightModels.append(spec);
+    }
+
+    // Load servers
+    QJsonArray serverArray = json["servers"].toArray();
+    servers.reserve(serverArray.size());
+    for (const QJsonValue &serverValue : serverArray) {
+        QJsonObject server = serverValue.toObject();
+        Vector2D position;
+        if (!parsePosition(server["position"].toString(), position)) {
+            qWarning() << "Invalid position for server:" << server["name"].toString();
+            return false;
+        }
+        servers.append(Server(server["name"].toString(), position, QColor(server["color"].toString())));
+        servers.last().setCapacity(server["landingPads"].toInt(), server["chargingSlots"].toInt());
+    }
+
+    // Load drones
+    QJsonArray droneArray = json["drones"].toArray();
+    drones.reserve(droneArray.size());
+    for (const QJsonValue &droneValue : droneArray) {
+        QJsonObject drone = droneValue.toObject();
+        DroneSpec spec;
+        spec.name = drone["name"].toString();
+        if (!parsePosition(drone["position"].toString(), spec.position)) {
+            qWarning() << "Invalid position for drone:" << spec.name;
+            return false;
+        }
+        spec.server = drone["server"].toString();
+        spec.color = QColor(drone["color"].toString());
+        spec.model = drone["model"].toString();
+        drones.append(spec);
+    }
+
+    // Load no-fly zones
+    QJsonArray zoneArray = json["noFlyZones"].toArray();
+    noFlyZones.reserve(zoneArray.size());
+    for (const QJsonValue &zoneValue : zoneArray) {
+        QJsonObject zone = zoneValue.toObject();
+        NoFlyZoneSpec spec;
+        spec.name = zone["name"].toString();
+        for (const QJsonValue &vertex : zone["polygon"].toArray()) {
+            Vector2D position;
+            if (!parsePosition(vertex.toString(), position)) {
+                qWarning() << "Invalid vertex for no-fly zone:" << spec.name;
+                return false;
+            }
+            spec.polygon.append(position);
+        }
+        if (spec.polygon.size() < 3) {
+            qWarning() << "No-fly zone with less than three vertices:" << spec.name;
+            return false;
+        }
+        noFlyZones.append(spec);
+    }
+    return true;
+}
+
+/**
+ * @brief Serialize the scenario as a JSON document.
+ * @return The JSON text.
+ */
+QByteArray Scenario::toJson() const {
+    QJsonArray modelArray;
+    for (const FlightModelSpec &spec : flightModels) {
+        QJsonObject obj = flightModelToJson(spec.model);
+        obj["name"] = spec.name;
+        modelArray.append(obj);
+    }
+
+    QJsonArray serverArray;
+    for (const Server &server : servers) {
+        QJsonObject obj;
+        obj["name"] = server.getName();
+        obj["position"] = positionToString(server.getPosition());
+        obj["color"] = server.getColor().name();
+        if (server.getLandingPads() > 0) {
+            obj["landingPads"] = server.getLandingPads();
+        }
+        if (server.getChargingSlots() > 0) {
+            obj["chargingSlots"] = server.getChargingSlots();
+        }
+        serverArray.append(obj);
+    }
+
+    QJsonArray droneArray;
+    for (const DroneSpec &spec : drones) {
+        QJsonObject obj;
+        obj["name"] = spec.name;
+        obj["position"] = positionToString(spec.position);
+        obj["server"] = spec.server;
+        if (spec.color.isValid()) {
+            obj["color"] = spec.color.name();
+        }
+        if (!spec.model.isEmpty()) {
+            obj["model"] = spec.model;
+        }
+        droneArray.append(obj);
+    }
+
+    QJsonArray zoneArray;
+    for (const NoFlyZoneSpec &spec : noFlyZones) {
+        QJsonArray polygon;
+        for (const Vector2D &vertex : spec.polygon) {
+            polygon.append(positionToString(vertex));
+        }
+        QJsonObject obj;
+        obj["name"] = spec.name;
+        obj["polygon"] = polygon;
+        zoneArray.append(obj);
+    }
+
+    QJsonObject json;
+    if (!flightModels.isEmpty()) {
+        json["flightModels"] = modelArray;
+    }
+    json["servers"] = serverArray;
+    json["drones"] = droneArray;
+    if (!noFlyZones.isEmpty()) {
+        json["noFlyZones"] = zoneArray;
+    }
+    return QJsonDocument(json).toJson(QJsonDocument::Indented);
+}
+
+/**
+ * @brief Fill the scenario from the binary format.
+ *
+ * The binary format stores a header (magic, version), the flight models (name and
+ * values, since version 2), the servers (name, position, color, and landing pads and
+ * charging slots since version 4) and the drones (name, position, index of the target
+ * server, color, and index of the flight model since version 2), then the no-fly zones
+ * (name and vertices, since version 3). Coordinates
+ * are stored as single precision floats, the values of the flight models as doubles.
+ * Each count is checked against the size of the rest of the data before it is reserved.
+ *
+ * @param data The binary content.
+ * @return True if the content is a valid binary scenario.
+ */
+bool Scenario::fromBinary(const QByteArray &data) {
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != binaryMagic || version < 1 || version > binaryVersion) {
+        return false;
+    }
+    clear();
+
+    if (version >= 2) {
+        quint32 modelCount;
+        in >> modelCount;
+        if (!fitsInStream(in, modelCount, 4 + 8 * 8)) {
+            qWarning() << "Truncated scenario, flight models:" << modelCount;
+            return false;
+        }
+        flightModels.reserve(modelCount);
+        for (quint32 i = 0; i < modelCount && in.status() == QDataStream::Ok; i++) {
+            FlightModelSpec spec;
+            in >> spec.name;
+            in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+            in >> spec.model.maxSpeed >> spec.model.maxPower >> spec.model.takeoffSpeed >> spec.model.hoveringHeight
+               >> spec.model.coefCollision >> spec.model.damping >> spec.model.chargingSpeed >> spec.model.powerConsumption;
+            in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+            if (in.status() == QDataStream::Ok && !isValidFlightModel(spec.model)) {
+                qWarning() << "Invalid values for flight model:" << spec.name;
+                return false;
+            }
+            flightModels.append(spec);
+        }
+    }
+
+    quint32 serverCount;
+    in >> serverCount;
+    if (!fitsInStream(in, serverCount, version >= 4 ? 4 + 5 * 4 : 4 + 3 * 4)) {
+        qWarning() << "Truncated scenario, servers:" << serverCount;
+        return false;
+    }
+    servers.reserve(serverCount);
+    for (quint32 i = 0; i < serverCount && in.status() == QDataStream::Ok; i++) {
+        QString name;
+        float x, y;
+        quint32 rgba;
+        in >> name >> x >> y >> rgba;
+        servers.append(Server(name, Vector2D(x, y), QColor::fromRgba(rgba)));
+        if (version >= 4) {
+            quint32 landingPads, chargingSlots;
+            in >> landingPads >> chargingSlots;
+            servers.last().setCapacity(int(landingPads), int(chargingSlots));
+        }
+    }
+
+    quint32 droneCount;
+    in >> droneCount;
+    if (!fitsInStream(in, droneCount, version >= 2 ? 4 + 5 * 4 : 4 + 4 * 4)) {
+        qWarning() << "Truncated scenario, drones:" << droneCount;
+        return false;
+    }
+    drones.resize(droneCount);
+    for (quint32 i = 0; i < droneCount && in.status() == QDataStream::Ok; i++) {
+        DroneSpec &spec = drones[i];
+        float x, y;
+        qint32 server;
+        quint32 rgba;
+        in >> spec.name >> x >> y >> server >> rgba;
+        spec.position.set(x, y);
+        if (server >= 0 && server < servers.size()) {
+            spec.server = servers[server].getName();
+        }
+        if (rgba != 0) {
+            spec.color = QColor::fromRgba(rgba);
+        }
+        if (version >= 2) {
+            qint32 model;
+            in >> model;
+            if (model >= 0 && model < flightModels.size()) {
+                spec.model = flightModels[model].name;
+            }
+        }
+    }
+
+    if (version >= 3) {
+        quint32 zoneCount;
+        in >> zoneCount;
+        if (!fitsInStream(in, zoneCount, 4 + 4)) {
+            qWarning() << "Truncated scenario, no-fly zones:" << zoneCount;
+            return false;
+        }
+        noFlyZones.reserve(zoneCount);
+        for (quint32 i = 0; i < zoneCount && in.status() == QDataStream::Ok; i++) {
+            NoFlyZoneSpec spec;
+            quint32 vertexCount;
+            in >> spec.name >> vertexCount;
+            if (vertexCount < 3) {
+                qWarning() << "No-fly zone with less than three vertices:" << spec.name;
+                return false;
+            }
+            if (!fitsInStream(in, vertexCount, 2 * 4)) {
+                qWarning() << "Truncated scenario, vertices of no-fly zone:" << spec.name;
+                return false;
+            }
+            spec.polygon.reserve(vertexCount);
+            for (quint32 v = 0; v < vertexCount && in.status() == QDataStream::Ok; v++) {
+                float x, y;
+                in >> x >> y;
+                spec.polygon.append(Vector2D(x, y));
+            }
+            noFlyZones.append(spec);
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+/**
+ * @brief Serialize the scenario in the binary format.
+ * @return The binary content.
+ */
+QByteArray Scenario::toBinary() const {
+    QHash<QString, qint32> serverIndex;
+    for (qint32 i = 0; i < servers.size(); i++) {
+        serverIndex.insert(servers[i].getName(), i);
+    }
+    QHash<QString, qint32> modelIndex;
+    for (qint32 i = 0; i < flightModels.size(); i++) {
+        modelIndex.insert(flightModels[i].name, i);
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << binaryMagic << binaryVersion;
+    out << quint32(flightModels.size());
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    for (const FlightModelSpec &spec : flightModels) {
+        out << spec.name << spec.model.maxSpeed << spec.model.maxPower << spec.model.takeoffSpeed << spec.model.hoveringHeight
+            << spec.model.coefCollision << spec.model.damping << spec.model.chargingSpeed << spec.model.powerConsumption;
+    }
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << quint32(servers.size());
+    for (const Server &server : servers) {
+        out << server.getName() << server.getPosition().x << server.getPosition().y << quint32(server.getColor().rgba())
+            << quint32(server.getLandingPads()) << quint32(server.getChargingSlots());
+    }
+    out << quint32(drones.size());
+    for (const DroneSpec &spec : drones) {
+        quint32 rgba = spec.color.isValid() ? spec.color.rgba() : 0;
+        out << spec.name << spec.position.x << spec.position.y << serverIndex.value(spec.server, -1) << rgba
+            << modelIndex.value(spec.model, -1);
+    }
+    out << quint32(noFlyZones.size());
+    for (const NoFlyZoneSpec &spec : noFlyZones) {
+        out << spec.name << quint32(spec.polygon.size());
+        for (const Vector2D &vertex : spec.polygon) {
+            out << vertex.x << vertex.y;
+        }
+    }
+    return data;
+}
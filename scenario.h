@@ -0,0 +1,122 @@
+/**
+ * @file scenario.h
+ * @brief Scenario description shared by the simulation and the scenario tools.
+ *
+ * This file declares the Scenario class, which holds the servers and drones of a
+ * simulation scenario and reads/writes them either in the JSON schema used by the
+ * files of the json/ directory, or in a compact binary format that loads much faster
+ * for large fleets.
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QString>
+#include <QColor>
+#include <QVector>
+#include "flightmodel.h"
+#include "server.h"
+#include "vector2d.h"
+
+/**
+ * @brief Named flight model profile as found in a scenario file.
+ */
+struct FlightModelSpec {
+    QString name; ///< Name of the profile, referenced by the drones.
+    FlightModel model; ///< Characteristics of the profile.
+};
+
+/**
+ * @brief Description of a drone as found in a scenario file.
+ */
+struct DroneSpec {
+    QString name; ///< Name of the drone.
+    Vector2D position; ///< Initial position of the drone.
+    QString server; ///< Name of the target server.
+    QColor color; ///< Display color of the drone (optional in the JSON schema).
+    QString model; ///< Name of the flight model profile, empty for the default one.
+};
+
+/**
+ * @brief Polygonal area that the drones must not enter, as found in a scenario file.
+ */
+struct NoFlyZoneSpec {
+    QString name; ///< Name of the zone.
+    QVector<Vector2D> polygon; ///< Vertices of the polygon, at least three, in any orientation.
+};
+
+/**
+ * @class Scenario
+ * @brief Servers and drones of a simulation scenario.
+ *
+ * A scenario can be stored as JSON (the "servers"/"drones" schema of the json/ files,
+ * with optional "flightModels" and "noFlyZones" arrays, and optional "landingPads" and
+ * "chargingSlots" capacities on the servers) or as a binary file with the extension given
+ * by Scenario::binarySuffix.
+ * The format is selected from the file extension.
+ */
+class Scenario {
+public:
+    static constexpr quint32 binaryMagic = 0x4453434E; ///< Magic number of binary scenario files ("DSCN").
+    static constexpr quint32 binaryVersion = 4; ///< Version of the binary scenario format.
+    static const char *const binarySuffix; ///< File extension of binary scenario files.
+
+    QVector<FlightModelSpec> flightModels; ///< List of flight model profiles.
+    QVector<Server> servers; ///< List of servers.
+    QVector<DroneSpec> drones; ///< List of drones.
+    QVector<NoFlyZoneSpec> noFlyZones; ///< List of no-fly zones.
+
+    /**
+     * @brief Load a scenario file, JSON or binary depending on its extension.
+     * @param filePath The path of the file to read.
+     * @return True if the file was read successfully.
+     */
+    bool load(const QString &filePath);
+
+    /**
+     * @brief Save the scenario, as JSON or binary depending on the extension.
+     * @param filePath The path of the file to write.
+     * @return True if the file was written successfully.
+     */
+    bool save(const QString &filePath) const;
+
+    /**
+     * @brief Fill the scenario from a JSON document.
+     * @param data The JSON text.
+     * @return True if the document is a valid scenario.
+     */
+    bool fromJson(const QByteArray &data);
+
+    /**
+     * @brief Serialize the scenario as a JSON document.
+     * @return The JSON text.
+     */
+    QByteArray toJson() const;
+
+    /**
+     * @brief Fill the scenario from the binary format.
+     * @param data The binary content.
+     * @return True if the content is a valid binary scenario.
+     */
+    bool fromBinary(const QByteArray &data);
+
+    /**
+     * @brief Serialize the scenario in the binary format.
+     * @return The binary content.
+     */
+    QByteArray toBinary() const;
+
+    /**
+     * @brief Remove all flight models, servers, drones and no-fly zones.
+     */
+    void clear();
+
+    /**
+     * @brief Check if a path designates a binary scenario file.
+     * @param filePath The path to test.
+     * @return True if the extension is the binary scenario extension.
+     */
+    static bool isBinaryFile(const QString &filePath);
+};
+
+#endif // SCENARIO_H
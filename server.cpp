@@ -34,6 +34,17 @@ Vector2D Server::getPosition() const {
     return position;
 }
 
+/**
+ * @brief Sets the position of the server.
+ *
+ * This method moves the server; the neighbors are not updated.
+ *
+ * @param position The new position of the server.
+ */
+void Server::setPosition(const Vector2D &position) {
+    this->position = position;
+}
+
 /**
  * @brief Gets the color of the server.
  *
@@ -45,6 +56,42 @@ QColor Server::getColor() const {
     return color;
 }
 
+/**
+ * @brief Gets the number of landing pads of the server.
+ *
+ * This method returns the number of drones that can land at the same time.
+ *
+ * @return The number of pads, 0 if the landings are not scheduled.
+ */
+int Server::getLandingPads() const {
+    return landingPads;
+}
+
+/**
+ * @brief Gets the number of charging slots of the server.
+ *
+ * This method returns the number of drones that can charge at the same time.
+ *
+ * @return The number of slots, 0 for unlimited.
+ */
+int Server::getChargingSlots() const {
+    return chargingSlots;
+}
+
+/**
+ * @brief Sets the landing capacity of the server.
+ *
+ * This method sets the number of pads and charging slots; a server with a capacity
+ * gives landing slots to the drones arriving at it (see LandingScheduler).
+ *
+ * @param landingPads The number of drones that can land at the same time, 0 if the landings are not scheduled.
+ * @param chargingSlots The number of drones that can charge at the same time, 0 for unlimited.
+ */
+void Server::setCapacity(int landingPads, int chargingSlots) {
+    this->landingPads = qMax(0, landingPads);
+    this->chargingSlots = qMax(0, chargingSlots);
+}
+
 /**
  * @brief Adds a neighboring server to the list of neighbors.
  *
@@ -38,6 +38,13 @@ public:
      */
     Vector2D getPosition() const;
 
+    /**
+     * @brief Sets the position of the server (mobile base station).
+     *
+     * @param position The new position of the server.
+     */
+    void setPosition(const Vector2D &position);
+
     /**
      * @brief Gets the color of the server.
      *
@@ -45,6 +52,28 @@ public:
      */
     QColor getColor() const;
 
+    /**
+     * @brief Gets the number of landing pads of the server.
+     *
+     * @return The number of pads, 0 if the landings are not scheduled.
+     */
+    int getLandingPads() const;
+
+    /**
+     * @brief Gets the number of charging slots of the server.
+     *
+     * @return The number of slots, 0 for unlimited.
+     */
+    int getChargingSlots() const;
+
+    /**
+     * @brief Sets the landing capacity of the server.
+     *
+     * @param landingPads The number of drones that can land at the same time, 0 if the landings are not scheduled.
+     * @param chargingSlots The number of drones that can charge at the same time, 0 for unlimited.
+     */
+    void setCapacity(int landingPads, int chargingSlots);
+
     /**
      * @brief Adds a neighboring server to the server.
      *
@@ -71,6 +100,8 @@ private:
     QString name; ///< The name of the server.
     Vector2D position; ///< The position of the server.
     QColor color; ///< The color of the server.
+    int landingPads = 0; ///< Number of landing pads, 0 if the landings are not scheduled.
+    int chargingSlots = 0; ///< Number of charging slots, 0 for unlimited.
     QVector<Server*> neighbors; ///< List of neighboring servers.
 };
 
@@ -0,0 +1,117 @@
+#include "sharedfleet.h"
+#include <new>
+
+/**
+ * @brief Constructs a handle on a segment, not attached yet.
+ * @param key The key of the segment.
+ */
+SharedFleet::SharedFleet(const QString &key) : memory(key) {}
+
+/**
+ * @brief Create the segment (coordinator).
+ * @param droneCount The number of drones.
+ * @param workerCount The number of worker processes.
+ * @return True if the segment was created.
+ */
+bool SharedFleet::create(int droneCount, int workerCount) {
+    if (workerCount < 1 || workerCount > maxWorkers) {
+        error = "Invalid number of workers";
+        return false;
+    }
+    if (!memory.create(qsizetype(headerSize() + 2 * std::size_t(droneCount) * sizeof(Drone)))) {
+        error = memory.errorString();
+        return false;
+    }
+    Header *h = new (memory.data()) Header();
+    h->magic = magic;
+    h->version = version;
+    h->droneCount = quint32(droneCount);
+    h->workerCount = quint32(workerCount);
+    h->front.store(0);
+    h->sequence[0].store(0);
+    h->sequence[1].store(0);
+    h->time[0] = h->time[1] = 0;
+    h->dt = 0;
+    h->epoch.store(0);
+    for (std::atomic<quint64> &done : h->done) {
+        done.store(0);
+    }
+    h->stopped.store(0, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Attach to an existing segment (workers and viewers).
+ * @param readOnly True to map the segment read-only.
+ * @return True if the segment exists and has the expected layout.
+ */
+bool SharedFleet::attach(bool readOnly) {
+    if (!memory.attach(readOnly ? QSharedMemory::ReadOnly : QSharedMemory::ReadWrite)) {
+        error = memory.errorString();
+        return false;
+    }
+    const Header *h = header();
+    if (std::size_t(memory.size()) < headerSize() || h->magic != magic || h->version != version
+        || std::size_t(memory.size()) < headerSize() + 2 * std::size_t(h->droneCount) * sizeof(Drone)) {
+        error = "Incompatible shared fleet segment";
+        memory.detach();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get a buffer of drone records.
+ * @param index The index of the buffer (0 or 1).
+ * @return The records.
+ */
+Drone *SharedFleet::buffer(int index) {
+    char *base = static_cast<char*>(memory.data()) + headerSize();
+    return reinterpret_cast<Drone*>(base) + std::size_t(index) * header()->droneCount;
+}
+
+/**
+ * @brief Get a buffer of drone records.
+ * @param index The index of the buffer (0 or 1).
+ * @return The records.
+ */
+const Drone *SharedFleet::buffer(int index) const {
+    const char *base = static_cast<const char*>(memory.constData()) + headerSize();
+    return reinterpret_cast<const Drone*>(base) + std::size_t(index) * header()->droneCount;
+}
+
+/**
+ * @brief Start reading the front buffer.
+ * @param sequence Receives the sequence to give to endRead().
+ * @return The index of the front buffer, or -1 if it is being written.
+ */
+int SharedFleet::beginRead(quint32 &sequence) const {
+    const Header *h = header();
+    int index = int(h->front.load(std::memory_order_acquire));
+    sequence = h->sequence[index].load(std::memory_order_acquire);
+    return (sequence & 1) ? -1 : index;
+}
+
+/**
+ * @brief Check that a buffer was not written while it was read.
+ * @param index The index of the buffer given by beginRead().
+ * @param sequence The sequence given by beginRead().
+ * @return True if what was read is consistent.
+ */
+bool SharedFleet::endRead(int index, quint32 sequence) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header()->sequence[index].load(std::memory_order_relaxed) == sequence;
+}
+
+/**
+ * @brief Get the range of drones stepped by a worker.
+ * @param rank The index of the worker.
+ * @param workerCount The number of workers.
+ * @param droneCount The number of drones.
+ * @param begin Receives the first drone of the range.
+ * @param end Receives the end of the range.
+ */
+void SharedFleet::workerRange(int rank, int workerCount, int droneCount, int &begin, int &end) {
+    begin = int(qint64(droneCount) * rank / workerCount);
+    end = int(qint64(droneCount) * (rank + 1) / workerCount);
+}
@@ -0,0 +1,153 @@
+/**
+ * @file sharedfleet.h
+ * @brief Fleet state shared between the processes of a multi-process simulation.
+ *
+ * This file declares the SharedFleet class, a shared-memory segment holding two
+ * buffers of drone records and the synchronization counters of the coordinator,
+ * worker and viewer processes.
+ */
+
+#ifndef SHAREDFLEET_H
+#define SHAREDFLEET_H
+
+#include <QSharedMemory>
+#include <QString>
+#include <atomic>
+#include "drone.h"
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "Atomics in shared memory must be lock-free");
+
+/**
+ * @class SharedFleet
+ * @brief Double-buffered drone records in shared memory, with a seqlock per buffer.
+ *
+ * The coordinator owns the tick. To request a tick, it marks the back buffer as being
+ * written (odd sequence), then publishes the tick number in the epoch counter. Each
+ * worker reads the front buffer, steps its own drones, writes them to the back
+ * buffer and publishes the tick number in its done counter. When all the workers are
+ * done, the coordinator closes the back buffer (even sequence), and makes it the
+ * front buffer.
+ *
+ * Readers never block the simulation: they read the front buffer in place, and the
+ * sequence of the buffer tells them afterwards if it was written meanwhile (seqlock).
+ * Drone records are trivially copyable, so they can be read by any process.
+ */
+class SharedFleet {
+public:
+    static constexpr quint32 magic = 0x44464C54; ///< Magic number of the segment ("DFLT").
+    static constexpr quint32 version = 1; ///< Version of the layout of the segment.
+    static constexpr int maxWorkers = 64; ///< Maximum number of worker processes.
+
+    /**
+     * @brief Header of the segment, followed by the two buffers of records.
+     */
+    struct Header {
+        quint32 magic; ///< SharedFleet::magic.
+        quint32 version; ///< SharedFleet::version.
+        quint32 droneCount; ///< Number of drones in each buffer.
+        quint32 workerCount; ///< Number of worker processes.
+        std::atomic<quint32> front; ///< Index of the published buffer.
+        std::atomic<quint32> sequence[2]; ///< Seqlock of each buffer, odd while the buffer is written.
+        double time[2]; ///< Simulated time of each buffer, in seconds.
+        double dt; ///< Duration of the requested tick, in seconds.
+        std::atomic<quint64> epoch; ///< Last tick requested by the coordinator.
+        std::atomic<quint64> done[maxWorkers]; ///< Last tick completed by each worker.
+        std::atomic<quint32> stopped; ///< Non-zero once the coordinator has stopped.
+    };
+
+    /**
+     * @brief Constructs a handle on a segment, not attached yet.
+     * @param key The key of the segment.
+     */
+    explicit SharedFleet(const QString &key);
+
+    /**
+     * @brief Create the segment (coordinator).
+     * @param droneCount The number of drones.
+     * @param workerCount The number of worker processes.
+     * @return True if the segment was created.
+     */
+    bool create(int droneCount, int workerCount);
+
+    /**
+     * @brief Attach to an existing segment (workers and viewers).
+     * @param readOnly True to map the segment read-only.
+     * @return True if the segment exists and has the expected layout.
+     */
+    bool attach(bool readOnly);
+
+    /**
+     * @brief Get the error of the last create() or attach().
+     * @return A description of the error.
+     */
+    inline QString errorString() const { return error; }
+
+    /**
+     * @brief Get the header of the segment.
+     * @return The header (the segment must be attached).
+     */
+    inline Header *header() { return static_cast<Header*>(memory.data()); }
+
+    /**
+     * @brief Get the header of the segment.
+     * @return The header (the segment must be attached).
+     */
+    inline const Header *header() const { return static_cast<const Header*>(memory.constData()); }
+
+    /**
+     * @brief Get the number of drones.
+     * @return The number of drones in each buffer.
+     */
+    inline int droneCount() const { return int(header()->droneCount); }
+
+    /**
+     * @brief Get a buffer of drone records.
+     * @param index The index of the buffer (0 or 1).
+     * @return The records.
+     */
+    Drone *buffer(int index);
+
+    /**
+     * @brief Get a buffer of drone records.
+     * @param index The index of the buffer (0 or 1).
+     * @return The records.
+     */
+    const Drone *buffer(int index) const;
+
+    /**
+     * @brief Start reading the front buffer.
+     * @param sequence Receives the sequence to give to endRead().
+     * @return The index of the front buffer, or -1 if it is being written.
+     */
+    int beginRead(quint32 &sequence) const;
+
+    /**
+     * @brief Check that a buffer was not written while it was read.
+     * @param index The index of the buffer given by beginRead().
+     * @param sequence The sequence given by beginRead().
+     * @return True if what was read is consistent.
+     */
+    bool endRead(int index, quint32 sequence) const;
+
+    /**
+     * @brief Get the range of drones stepped by a worker.
+     * @param rank The index of the worker.
+     * @param workerCount The number of workers.
+     * @param droneCount The number of drones.
+     * @param begin Receives the first drone of the range.
+     * @param end Receives the end of the range.
+     */
+    static void workerRange(int rank, int workerCount, int droneCount, int &begin, int &end);
+
+private:
+    /**
+     * @brief Size of the header, rounded up so that the records are aligned on a cache line.
+     * @return The offset of the first buffer.
+     */
+    static constexpr std::size_t headerSize() { return (sizeof(Header) + 63) / 64 * 64; }
+
+    QSharedMemory memory; ///< The segment.
+    QString error; ///< Error of the last create() or attach().
+};
+
+#endif // SHAREDFLEET_H
@@ -0,0 +1,785 @@
+#include "simulation.h"
+#include "vector2dbatch.h"
+#include <QDebug>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * @brief Constructs an empty simulation.
+ */
+Simulation::Simulation()
+    : collisionDistance(96), integrator(Integrator::semiImplicitEuler), commands(nullptr), fleetRevision(0), serverRevision(0),
+      indexStale(true), indexQueried(false) {
+    landing.setSpacing(float(collisionDistance));
+    clear();
+}
+
+/**
+ * @brief Remove all the servers and drones, and the flight models except the default one.
+ */
+void Simulation::clear() {
+    drones.clear();
+    airborne.clear();
+    events.clear();
+    time = 0;
+    servers.clear();
+    serverIndex.clear();
+    landing.setServers(servers);
+    noFlyZones.clear();
+    flightModels.clear();
+    flightModels.append(FlightModel());
+    flightModelIndex.clear();
+    flightModelIndex.insert("default", 0);
+    standardDefaultModel = true;
+    partitionBegin = 0;
+    partitionEnd = std::numeric_limits<int>::max();
+    partitionRank = 0;
+    partitionCount = 1;
+    indexStale = true;
+    updateShards();
+}
+
+/**
+ * @brief Replace the servers and drones by those of a scenario.
+ *
+ * The registry keeps its memory from one scenario to the next, and is sized once
+ * for the whole fleet, so loading does not reallocate the drone records one by one.
+ *
+ * @param scenario The scenario to load.
+ */
+void Simulation::load(const Scenario &scenario) {
+    clear();
+
+    for (const FlightModelSpec &spec : scenario.flightModels) {
+        int index = flightModelIndex.value(spec.name, -1);
+        if (index == 0) {
+            flightModels[0] = spec.model;  // The scenario redefines the default profile
+        } else if (index > 0) {
+            qWarning() << "Duplicate flight model name:" << spec.name;
+        } else {
+            flightModelIndex.insert(spec.name, flightModels.size());
+            flightModels.append(spec.model);
+        }
+    }
+    standardDefaultModel = flightModels[0].isDefault();
+
+    servers = scenario.servers;
+    serverIndex.reserve(servers.size());
+    for (int i = 0; i < servers.size(); i++) {
+        serverIndex.insert(servers[i].getName(), i);
+    }
+    landing.setServers(servers);
+    noFlyZones.setZones(scenario.noFlyZones);
+    updateShards();
+
+    drones.reserve(scenario.drones.size());
+    airborne.reserve(scenario.drones.size());
+    events.reserve(2 * scenario.drones.size());
+    QVector<int> targeting(servers.size(), 0);  // Drones targeting each server, which may all wait for a slot
+    for (const DroneSpec &spec : scenario.drones) {
+        DroneId id = addDrone(spec);
+        const int target = id.isValid() ? drones.find(id)->getTargetServer() : -1;
+        if (target >= 0) {
+            targeting[target]++;
+        }
+    }
+    for (int i = 0; i < servers.size(); i++) {
+        landing.reserve(i, targeting[i]);
+    }
+}
+
+/**
+ * @brief Add a landed drone to the fleet.
+ * @param spec The description of the drone.
+ * @return The handle of the drone, or an invalid handle if its name is already used.
+ */
+DroneId Simulation::addDrone(const DroneSpec &spec) {
+    int model = findFlightModel(spec.model);
+    if (model < 0) {
+        qWarning() << "Unknown flight model" << spec.model << "for drone:" << spec.name;
+        model = 0;
+    }
+    Drone newDrone(model, flightModels[model]);
+    newDrone.setInitialPosition(spec.position);
+    newDrone.setTargetServer(findServer(spec.server));
+    DroneId id = drones.add(spec.name, newDrone);
+    if (!id.isValid()) {
+        qWarning() << "Duplicate drone name:" << spec.name;
+        return id;
+    }
+    fleetRevision++;
+    indexStale = true;
+    scheduleNextEvent(id, newDrone);  // The drone is charging until it is full
+    return id;
+}
+
+/**
+ * @brief Remove a drone from the fleet.
+ *
+ * The events, the list of drones in the air, the shards and the landing queues keep
+ * the handle of the drone, which is detected as stale and dropped when they reach it.
+ * The pad and charging slot of the drone are given to the next waiting drone.
+ *
+ * @param id The handle of the drone.
+ * @return True if the drone was found and removed.
+ */
+bool Simulation::removeDrone(DroneId id) {
+    if (Drone *drone = drones.find(id)) {
+        landing.release(drones, *drone);
+    }
+    if (!drones.remove(id)) {
+        return false;
+    }
+    fleetRevision++;
+    indexStale = true;
+    return true;
+}
+
+/**
+ * @brief Move a server (mobile base station).
+ *
+ * The goal of the drones targeting the server is refreshed at once (the flying drones
+ * also take it at each step): its position, their pad, or their hold position, which
+ * moves with the holding ring. For the sharded engine, the triangulation of the
+ * regions is repaired around the server; the drones that are now in another region
+ * are given to its shard by collectEmigrants() at the next step.
+ *
+ * @param index The index of the server.
+ * @param position The new position of the server.
+ * @return False if there is no such server.
+ */
+bool Simulation::moveServer(int index, const Vector2D &position) {
+    if (index < 0 || index >= servers.size()) {
+        return false;
+    }
+    servers[index].setPosition(position);
+    landing.moveServer(index, position);
+    for (Drone &drone : drones) {
+        if (drone.getTargetServer() == index) {
+            switch (drone.getClearance()) {
+            case Drone::cleared:
+                drone.setGoalPosition(landing.padPosition(index, drone.getPad()));
+                break;
+            case Drone::holding:
+                drone.setGoalPosition(landing.holdPosition(index, drone.getPad()));
+                break;
+            default:
+                drone.setGoalPosition(position);
+                break;
+            }
+        }
+    }
+
+    serverPositions[index] = position;
+    if (!shards.isEmpty()) {
+        regions.moveServer(index, position);
+    }
+    serverRevision++;
+    return true;
+}
+
+/**
+ * @brief Apply a command to the fleet.
+ *
+ * A landing drone cannot be sent elsewhere (goto, retarget): the landing phase does not
+ * follow a new goal, and the drone is already descending. The command is refused
+ * rather than dropped, and a drone landing on its pad keeps it until it touches down.
+ *
+ * @param command The command.
+ * @return True if the command designates existing drones, servers and profiles, and can be applied to the drone.
+ */
+bool Simulation::apply(const DroneCommand &command) {
+    if (command.type == DroneCommand::add) {
+        if (!command.model.isEmpty() && findFlightModel(command.model) < 0) {
+            qWarning() << "Command on drone" << command.drone << ": unknown flight model" << command.model;
+            return false;
+        }
+        return addDrone(DroneSpec{command.drone, command.position, command.server, QColor(), command.model}).isValid();
+    }
+    if (command.type == DroneCommand::moveServer) {
+        if (!moveServer(findServer(command.server), command.position)) {
+            qWarning() << "Command on unknown server:" << command.server;
+            return false;
+        }
+        return true;
+    }
+
+    DroneId id = drones.findByName(command.drone);
+    Drone *drone = drones.find(id);
+    if (!drone) {
+        qWarning() << "Command on unknown drone:" << command.drone;
+        return false;
+    }
+    if ((command.type == DroneCommand::goTo || command.type == DroneCommand::retarget) && drone->getStatus() == Drone::landing) {
+        qWarning() << "Command on drone" << command.drone << ": the drone is landing";
+        return false;
+    }
+    switch (command.type) {
+    case DroneCommand::goTo:
+        landing.release(drones, *drone);  // Give up the landing slot
+        drone->setTargetServer(-1);
+        drone->setGoalPosition(command.position);
+        start(id);
+        break;
+    case DroneCommand::land: {
+        quint32 phase = drone->getPhase();
+        drone->stop(flightModels[drone->getFlightModel()], time);
+        if (drone->getPhase() != phase) {
+            scheduleNextEvent(id, *drone);  // Not already landing or landed
+        }
+        break;
+    }
+    case DroneCommand::retarget: {
+        int server = findServer(command.server);
+        if (server < 0) {
+            qWarning() << "Command on drone" << command.drone << ": unknown server" << command.server;
+            return false;
+        }
+        landing.release(drones, *drone);  // Give up the landing slot
+        drone->setTargetServer(server);
+        start(id);
+        break;
+    }
+    case DroneCommand::remove:
+        removeDrone(id);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief Apply the commands waiting in the command queue.
+ */
+void Simulation::drainCommands() {
+    for (int n = commands->capacity(); n > 0 && commands->tryPop(command); n--) {
+        apply(command);
+    }
+}
+
+/**
+ * @brief Make a landed drone take off.
+ *
+ * A drone charging at a scheduled server frees its charging slot.
+ *
+ * @param id The handle of the drone.
+ * @return True if the drone was landed and takes off.
+ */
+bool Simulation::start(DroneId id) {
+    Drone *drone = drones.find(id);
+    if (!drone || drone->getStatus() != Drone::landed) {
+        return false;
+    }
+    landing.release(drones, *drone);
+    drone->start(flightModels[drone->getFlightModel()], time);
+    airborne.append(id);
+    scheduleNextEvent(id, *drone);
+    return true;
+}
+
+/**
+ * @brief Restrict the drones updated by the simulation to those of one process.
+ * @param begin The dense index of the first drone of the range.
+ * @param end The dense index after the last drone of the range.
+ * @param rank The index of the process.
+ * @param count The number of processes.
+ */
+void Simulation::setPartition(int begin, int end, int rank, int count) {
+    partitionBegin = begin;
+    partitionEnd = end;
+    partitionCount = qMax(1, count);
+    partitionRank = qBound(0, rank, partitionCount - 1);
+}
+
+/**
+ * @brief Replace the state of all the drones by records of the same scenario.
+ * @param records The records of the drones, in the order of the registry.
+ * @param count The number of records, which must be the number of drones.
+ * @param t The simulated time of the records.
+ */
+void Simulation::restore(const Drone *records, int count, double t) {
+    Q_ASSERT(count == drones.size());
+    std::copy(records, records + count, drones.begin());
+    time = t;
+    rebuildSchedule();
+}
+
+/**
+ * @brief Rebuild the drones in the air and the events of the partition from the records.
+ *
+ * The cleared drones of the partition take back their pads and charging slots first,
+ * then the holding drones queue again, from the time of the records. The drones whose
+ * landing slot is not valid for the servers of the scenario (e.g. a checkpoint taken
+ * with other capacities) become unscheduled, and ask again when they approach.
+ */
+void Simulation::rebuildSchedule() {
+    indexStale = true;
+    airborne.clear();
+    events.clear();
+    landing.clear();
+    for (RegionShard &shard : shards) {
+        shard.clear();
+    }
+    for (int i = 0; i < drones.size(); i++) {
+        DroneId id = drones.idAt(i);
+        if (drones[i].getStatus() != Drone::landed) {
+            airborne.append(id);
+        }
+        const Drone::landingClearance clearance = drones[i].getClearance();
+        const int target = drones[i].getTargetServer();
+        if (clearance > Drone::cleared || (clearance == Drone::holding && !landing.isScheduled(target))
+            || (clearance == Drone::cleared && !landing.hasPad(target, drones[i].getPad()))) {
+            drones[i].setClearance(Drone::unscheduled);
+        }
+        if (owns(i) && drones[i].getClearance() == Drone::cleared) {
+            landing.adopt(drones[i]);
+        }
+        scheduleNextEvent(id, drones[i]);
+    }
+    for (int i = 0; i < drones.size(); i++) {
+        if (owns(i) && drones[i].getClearance() == Drone::holding) {
+            drones[i].setClearance(Drone::unscheduled);
+            requestLanding(drones.idAt(i), time);
+        }
+    }
+}
+
+/**
+ * @brief Take a snapshot of the fleet.
+ * @return The snapshot, sharing the arrays of the registry until the next step.
+ */
+SimulationSnapshot Simulation::takeSnapshot() const {
+    SimulationSnapshot snapshot;
+    snapshot.time = time;
+    snapshot.drones = drones.records();
+    snapshot.names = drones.nameList();
+    return snapshot;
+}
+
+/**
+ * @brief Replace the fleet by a snapshot taken on the same scenario.
+ *
+ * The landing slots of the drones are checked against the capacities of the servers
+ * by rebuildSchedule().
+ *
+ * @param snapshot The snapshot.
+ * @return False if the snapshot has invalid records, or references flight models or servers that the scenario does not have.
+ */
+bool Simulation::restoreSnapshot(const SimulationSnapshot &snapshot) {
+    for (const Drone &drone : snapshot.drones) {
+        if (!drone.hasValidState()) {
+            qWarning() << "The snapshot contains an invalid drone record";
+            return false;
+        }
+        if (drone.getFlightModel() >= flightModels.size() || drone.getTargetServer() < -1 || drone.getTargetServer() >= servers.size()) {
+            qWarning() << "The snapshot does not match the flight models and servers of the scenario";
+            return false;
+        }
+    }
+    drones.clear();
+    drones.reserve(snapshot.drones.size());
+    for (int i = 0; i < snapshot.drones.size(); i++) {
+        drones.add(snapshot.names[i], snapshot.drones[i]);
+    }
+    time = snapshot.time;
+    fleetRevision++;
+    rebuildSchedule();
+    return true;
+}
+
+/**
+ * @brief Replace the state of the drones of a range updated by another process.
+ *
+ * The records are taken at the start of the step, like the positions of the own drones.
+ * The drones of the partition in the range are kept. The drones that took off in the
+ * other process join the drones in the air; those that landed leave them at the next
+ * step.
+ *
+ * @param records The records of all the drones, in the order of the registry.
+ * @param begin The dense index of the first drone to import.
+ * @param end The dense index after the last drone to import.
+ */
+void Simulation::importDrones(const Drone *records, int begin, int end) {
+    indexStale = true;
+    for (int i = begin; i < end; i++) {
+        if (owns(i)) {
+            continue;
+        }
+        bool wasLanded = drones[i].getStatus() == Drone::landed;
+        drones[i] = records[i];
+        if (wasLanded && drones[i].getStatus() != Drone::landed) {
+            airborne.append(drones.idAt(i));
+        }
+    }
+}
+
+/**
+ * @brief Copy the drones of the partition to the records shared with the other processes.
+ * @param records The records of all the drones, in the order of the registry.
+ */
+void Simulation::exportDrones(Drone *records) const {
+    for (int i = 0; i < drones.size(); i++) {
+        if (owns(i)) {
+            records[i] = drones[i];
+        }
+    }
+}
+
+/**
+ * @brief Schedule the end of the current analytic phase of a drone, if any.
+ *
+ * The events of the drones outside the partition are handled by their own process.
+ *
+ * @param id The handle of the drone.
+ * @param drone The drone.
+ */
+void Simulation::scheduleNextEvent(DroneId id, const Drone &drone) {
+    if (!owns(drones.indexOf(id))) {
+        return;
+    }
+    double eventTime = drone.nextEventTime(flightModels[drone.getFlightModel()]);
+    if (eventTime != std::numeric_limits<double>::infinity()) {
+        events.schedule(SimulationEvent{eventTime, id, drone.getPhase()});
+    }
+}
+
+/**
+ * @brief End the analytic phases that finish before a given time, in time order.
+ * @param until The simulated time up to which the events are processed.
+ */
+void Simulation::processEvents(double until) {
+    while (events.hasEventBefore(until)) {
+        SimulationEvent event = events.takeNext();
+        Drone *drone = drones.find(event.drone);
+        if (!drone || drone->getPhase() != event.phase) {
+            continue;  // The drone was removed or changed its phase since the event was scheduled
+        }
+        Drone::phaseEvent ended = drone->endPhase(flightModels[drone->getFlightModel()], event.time);
+        if (ended == Drone::touchedDown && drone->getClearance() != Drone::unscheduled) {
+            landing.touchedDown(drones, *drone);  // The pad is free for the next drone
+        } else if (ended == Drone::fullyCharged && drone->getClearance() == Drone::cleared) {
+            landing.release(drones, *drone);  // The charging slot is free for the next drone
+        }
+        scheduleNextEvent(event.drone, *drone);
+    }
+}
+
+/**
+ * @brief Ask for a landing slot for a drone arriving at its target server.
+ *
+ * The drone is queued by its arrival time at the server at full speed, and by its
+ * power level.
+ *
+ * @param id The handle of the drone.
+ * @param now The simulated time of the arrival.
+ */
+void Simulation::requestLanding(DroneId id, double now) {
+    const Drone &drone = *drones.find(id);
+    const FlightModel &model = flightModels[drone.getFlightModel()];
+    const double distance = std::sqrt(drone.getPosition().distanceSquared(serverPositions[drone.getTargetServer()]));
+    landing.request(drones, id, now + distance / model.maxSpeed, drone.getPower(model, now));
+}
+
+/**
+ * @brief Advance the simulation by one step.
+ *
+ * The external commands are applied first, then the events due during the step.
+ * Then only the drones in the air are visited: their positions are copied to a contiguous array, so that the collision
+ * forces are computed from the positions at the start of the step (independently of
+ * the order of the drones), and sorted into a grid, so that each drone is only compared
+ * with the drones of the cells around it, with the batch distance kernel. The drones
+ * in a flight phase are then updated. Landed drones cost nothing until their next event.
+ * The drones that reached a scheduled server ask for a landing slot at the end of the
+ * step, in the order of the drones in the air.
+ * In sharded mode, this is done by stepShards().
+ *
+ * @param dt The duration of the step in seconds.
+ */
+void Simulation::step(double dt) {
+    scratch.reset();
+    drones.detach();  // Copy the records shared with a snapshot now, rather than from the threads of the shards
+    if (commands) {
+        drainCommands();
+    }
+    const double end = time + dt;
+    processEvents(end);
+    if (isSharded()) {
+        stepShards(dt);
+        time = end;
+        updateSpatialIndex();
+        return;
+    }
+
+    // Remove the drones that have landed from the list of drones in the air
+    const int n = airborne.size();
+    Drone **active = scratch.allocate<Drone*>(n);  // Drones in the air
+    Vector2D *positions = scratch.allocate<Vector2D>(n);  // Positions of these drones
+    float *distances = scratch.allocate<float>(n);  // Squared distances of the candidates to the current drone
+    DroneId *arrivals = scratch.allocate<DroneId>(n);  // Drones asking for a landing slot
+    int activeCount = 0;
+    for (int i = 0; i < n; i++) {
+        Drone *drone = drones.find(airborne[i]);
+        if (drone && drone->getStatus() != Drone::landed) {
+            airborne[activeCount] = airborne[i];
+            active[activeCount] = drone;
+            positions[activeCount] = drone->getPosition();
+            activeCount++;
+        }
+    }
+    airborne.resize(activeCount);
+
+    collisionGrid.build(positions, activeCount, nullptr, 0, float(collisionDistance));
+    int arrivalCount = 0;
+    for (int a = 0; a < activeCount; a++) {
+        int count = collisionGrid.candidates(a, nearby);  // At most activeCount - 1 positions
+        FlightEvent event = fly(*active[a], positions[a], nearby.constData(), count, distances, dt);
+        if (event == startedLanding) {
+            scheduleNextEvent(airborne[a], *active[a]);  // The drone starts landing at the end of the step
+        } else if (event == reachedApproach) {
+            arrivals[arrivalCount++] = airborne[a];
+        }
+    }
+    time = end;
+    for (int k = 0; k < arrivalCount; k++) {
+        requestLanding(arrivals[k], time);
+    }
+    updateSpatialIndex();
+}
+
+/**
+ * @brief Advance the drones in the air by one step with the sharded engine.
+ *
+ * The drones that took off since the last step join the shard of the region below
+ * them, found by walking the regions from their target server. The shards are then
+ * processed in parallel phases (see RegionShard): snapshot, then halo exchange, update
+ * of the drones and detection of the drones leaving the region. Finally, the landing events are scheduled, the drones that reached a
+ * scheduled server ask for a landing slot and the emigrants join their new shard, on
+ * the calling thread.
+ *
+ * @param dt The duration of the step in seconds.
+ */
+void Simulation::stepShards(double dt) {
+    const int serverCount = servers.size();
+
+    // New drones in the air
+    for (DroneId id : airborne) {
+        const Drone *drone = drones.find(id);
+        if (drone) {
+            shards[regions.locate(drone->getPosition(), drone->getTargetServer())].addDrone(id);
+        }
+    }
+    airborne.clear();
+
+    auto snapshot = [this](int i) {
+        shards[i].snapshot(drones);
+    };
+    workers->run(serverCount, snapshot);
+
+    const QVector<RegionShard> &constShards = shards;
+    auto update = [this, &constShards, dt](int i) {
+        RegionShard &shard = shards[i];
+        shard.gatherHalo(constShards, regions, float(collisionDistance));
+        int count = shard.drones.size();
+        for (int a = 0; a < count; a++) {
+            int candidates = shard.gatherCandidates(a);
+            FlightEvent event = fly(*shard.records[a], shard.positions[a], shard.nearby.constData(), candidates,
+                                    shard.distances.data(), dt);
+            if (event == startedLanding) {
+                shard.landings.append(shard.drones[a]);
+            } else if (event == reachedApproach) {
+                shard.arrivals.append(shard.drones[a]);
+            }
+        }
+        shard.collectEmigrants(regions);
+    };
+    workers->run(serverCount, update);
+
+    for (RegionShard &shard : shards) {
+        for (DroneId id : shard.landings) {
+            scheduleNextEvent(id, *drones.find(id));  // The drone starts landing at the end of the step
+        }
+        for (DroneId id : shard.arrivals) {
+            requestLanding(id, time + dt);
+        }
+        for (int k = 0; k < shard.emigrants.size(); k++) {
+            shards[shard.destinations[k]].addDrone(shard.emigrants[k]);  // Migration to the new region
+        }
+    }
+}
+
+/**
+ * @brief Compute the collision force of a drone in a flight phase and update it.
+ *
+ * Drones taking off or landing, and drones outside the partition, are not modified:
+ * they are only obstacles. A drone flying to its server heads for its pad once
+ * cleared, and stays at its place on the holding ring while it waits; the scheduler is
+ * only read here, the requests are made by the caller.
+ * This method only modifies the drone, so that it can be called from several threads
+ * for different drones.
+ *
+ * @param drone The drone.
+ * @param position The position of the drone at the start of the step.
+ * @param others The positions of the drones that may collide with the drone (not the drone itself).
+ * @param otherCount The number of positions in others.
+ * @param distances Scratch array for otherCount squared distances.
+ * @param dt The duration of the step in seconds.
+ * @return The event of the drone during the step.
+ */
+Simulation::FlightEvent Simulation::fly(Drone &drone, const Vector2D &position, const Vector2D *others, int otherCount,
+                                        float *distances, double dt) const {
+    if (drone.getStatus() < Drone::hovering || !owns(int(&drone - drones.begin()))) {
+        return noFlightEvent;  // Taking off, landing or updated by another process: only an obstacle for the other drones
+    }
+    const FlightModel &model = flightModels.at(drone.getFlightModel());
+    int target = drone.getTargetServer();
+    bool approaching = false;
+    if (target >= 0) {
+        const Drone::landingClearance clearance = drone.getClearance();
+        if (clearance == Drone::cleared) {
+            drone.setGoalPosition(landing.padPosition(target, drone.getPad()));  // Land on the pad given by the scheduler
+        } else if (clearance == Drone::unscheduled) {
+            const Vector2D &server = servers.at(target).getPosition();
+            drone.setGoalPosition(server);  // Set the drone's goal position
+            if (landing.isScheduled(target)) {
+                const float radius = landing.approachRadius(target);
+                approaching = position.distanceSquared(server) < radius * radius;
+            }
+        }
+    }
+
+    // Handle collisions between drones
+    const float threshold = float(collisionDistance);
+    drone.initCollision();  // Reset collision state
+    Vector2DBatch::distanceSquared(others, otherCount, position, distances);
+    for (int j = 0; j < otherCount; j++) {
+        if (distances[j] < threshold * threshold) {
+            drone.addCollision(others[j], threshold, model.coefCollision);  // Add collision force
+        }
+    }
+    if (!noFlyZones.isEmpty()) {
+        drone.addForce(noFlyZones.force(position, threshold, float(model.coefCollision)));  // Keep out of the zones
+    }
+
+    // Update the drone's state
+    if (drone.getFlightModel() == 0 && standardDefaultModel) {
+        drone.update(DefaultFlightModel(), integrator, time, dt);
+    } else {
+        drone.update(model, integrator, time, dt);
+    }
+    if (drone.getStatus() == Drone::landing) {
+        return startedLanding;
+    }
+    return approaching ? reachedApproach : noFlightEvent;
+}
+
+/**
+ * @brief Find the drones within a distance of a point.
+ * @param center The point.
+ * @param radius The distance in pixels.
+ * @return The handles of the drones, in no particular order.
+ */
+QVector<DroneId> Simulation::dronesInRadius(const Vector2D &center, float radius) const {
+    spatialIndex().inRadius(center, radius, queryResult);
+    return queryHandles();
+}
+
+/**
+ * @brief Find the drones inside a rectangle.
+ * @param rect The rectangle.
+ * @return The handles of the drones, in no particular order.
+ */
+QVector<DroneId> Simulation::dronesInRect(const QRectF &rect) const {
+    spatialIndex().inRect(rect, queryResult);
+    return queryHandles();
+}
+
+/**
+ * @brief Find the drones nearest to a point.
+ * @param center The point.
+ * @param k The number of drones.
+ * @return The handles of the k nearest drones (fewer if the fleet is smaller), nearest first.
+ */
+QVector<DroneId> Simulation::nearestDrones(const Vector2D &center, int k) const {
+    spatialIndex().nearest(center, k, queryResult);
+    return queryHandles();
+}
+
+/**
+ * @brief Get the spatial index of the drones, rebuilt if the drones moved since it was built.
+ * @return The index.
+ */
+const DroneIndex &Simulation::spatialIndex() const {
+    if (indexStale) {
+        droneIndex.build(drones.begin(), drones.size());
+        indexStale = false;
+    }
+    indexQueried = true;
+    return droneIndex;
+}
+
+/**
+ * @brief Mark the spatial index as outdated at the end of a step, or rebuild it if it is being queried.
+ *
+ * A user polling the queries gets an index already built with the step. When nobody
+ * queried the index during a step, it is only rebuilt by the next query.
+ */
+void Simulation::updateSpatialIndex() {
+    if (indexQueried) {
+        droneIndex.build(drones.begin(), drones.size());
+        indexStale = false;
+        indexQueried = false;
+    } else {
+        indexStale = true;
+    }
+}
+
+/**
+ * @brief Convert the dense indices of a query to handles.
+ * @return The handles of the drones of queryResult.
+ */
+QVector<DroneId> Simulation::queryHandles() const {
+    QVector<DroneId> ids;
+    ids.reserve(queryResult.size());
+    for (int i : queryResult) {
+        ids.append(drones.idAt(i));
+    }
+    return ids;
+}
+
+/**
+ * @brief Select the engine: single-threaded, or sharded by server region.
+ * @param threads The number of threads of the sharded engine, 0 for the single-threaded engine.
+ */
+void Simulation::setThreadCount(int threads) {
+    // Give the drones in the air back to the list of drones in the air, for any engine
+    for (RegionShard &shard : shards) {
+        airborne.append(shard.drones);
+        shard.clear();
+    }
+    workers.reset();
+    if (threads > 0) {
+        workers.reset(new WorkerPool(threads - 1));  // The calling thread also works
+    }
+    updateShards();
+}
+
+/**
+ * @brief Create the shards of the sharded engine, one per server region.
+ */
+void Simulation::updateShards() {
+    const int serverCount = servers.size();
+    serverPositions.resize(serverCount);
+    for (int i = 0; i < serverCount; i++) {
+        serverPositions[i] = servers[i].getPosition();
+    }
+    shards.clear();
+    if (workers) {
+        regions.build(serverPositions, float(collisionDistance));
+        shards.reserve(serverCount);
+        for (int i = 0; i < serverCount; i++) {
+            shards.append(RegionShard(i));
+        }
+    }
+}
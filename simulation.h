@@ -0,0 +1,499 @@
+/**
+ * @file simulation.h
+ * @brief Simulation engine of the drone fleet.
+ *
+ * This file declares the Simulation class, which owns the servers and the drones of
+ * a scenario and advances their state, independently of the user interface.
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QVector>
+#include <QHash>
+#include <memory>
+#include "collisiongrid.h"
+#include "dronecommand.h"
+#include "droneindex.h"
+#include "droneregistry.h"
+#include "eventscheduler.h"
+#include "flightmodel.h"
+#include "framearena.h"
+#include "integrator.h"
+#include "landingscheduler.h"
+#include "noflyzones.h"
+#include "regionmap.h"
+#include "regionshard.h"
+#include "scenario.h"
+#include "server.h"
+#include "workerpool.h"
+
+/**
+ * @brief State of the fleet at a given time, enough to continue a simulation of the same scenario.
+ *
+ * The events and the drones in the air are not stored: they are deduced from the
+ * records, whose analytic phases are defined by their start time. The simulation has
+ * no random state, the time is the only other state.
+ */
+struct SimulationSnapshot {
+    double time = 0; ///< Simulated time in seconds.
+    QVector<Drone> drones; ///< Drone records, in the dense order of the registry.
+    QVector<QString> names; ///< Names of the drones, parallel to the records.
+};
+
+/**
+ * @class Simulation
+ * @brief Owns the fleet and computes the simulation steps.
+ *
+ * Target servers are resolved from their names when the scenario is loaded, so that
+ * the simulation step only uses indices. Temporary arrays of a step are taken from a
+ * FrameArena reset at each step: once the arena has grown to the size needed by the
+ * fleet, a step does not allocate any heap memory.
+ *
+ * The flight model profiles of the scenario are stored once in the simulation and
+ * referenced by index from the drones. Profile 0 is the default one ("default" in the
+ * scenario, DefaultFlightModel otherwise); while it has the values of
+ * DefaultFlightModel, its drones are updated with the compile-time constants.
+ *
+ * Charging, takeoff and landing are computed analytically by the drones: the end of
+ * these phases is scheduled in an EventScheduler keyed on the simulated time, and a
+ * step only visits the drones in the air.
+ *
+ * The drones arriving at a server with a limited capacity get a landing pad and a
+ * charging slot from a LandingScheduler, and hold around the server until they do.
+ *
+ * The drones in the air are updated either on the calling thread, or by the sharded
+ * engine, which splits them by server region into RegionShard objects processed in
+ * parallel by a WorkerPool.
+ *
+ * External commands (see DroneCommand) are taken from a CommandQueue at the start of
+ * each step, so that they are applied between two steps, on the simulation thread.
+ *
+ * Spatial queries on the fleet (dronesInRadius(), dronesInRect(), nearestDrones()) use
+ * a DroneIndex. It is built at the first query after the drones moved, then at the end
+ * of each step as long as it is queried between steps, so that polling queries do not
+ * pay for the rebuild.
+ *
+ * For the multi-process engine (see SharedFleet), a simulation can own a partition of
+ * the drones only: the other drones are obstacles whose records are imported from the
+ * other processes before each step, and no events are scheduled for them. The drones
+ * targeting a server with a limited capacity belong to the process of that server, so
+ * that its pads and charging slots are given by a single LandingScheduler.
+ */
+class Simulation {
+public:
+    /**
+     * @brief Constructs an empty simulation.
+     */
+    Simulation();
+
+    /**
+     * @brief Replace the servers and drones by those of a scenario.
+     * @param scenario The scenario to load.
+     */
+    void load(const Scenario &scenario);
+
+    /**
+     * @brief Remove all the servers and drones, and the flight models except the default one.
+     */
+    void clear();
+
+    /**
+     * @brief Advance the simulation by one step.
+     * @param dt The duration of the step in seconds.
+     */
+    void step(double dt);
+
+    /**
+     * @brief Make a landed drone take off.
+     * @param id The handle of the drone.
+     * @return True if the drone was landed and takes off.
+     */
+    bool start(DroneId id);
+
+    /**
+     * @brief Add a landed drone to the fleet.
+     * @param spec The description of the drone.
+     * @return The handle of the drone, or an invalid handle if its name is already used.
+     */
+    DroneId addDrone(const DroneSpec &spec);
+
+    /**
+     * @brief Remove a drone from the fleet.
+     * @param id The handle of the drone.
+     * @return True if the drone was found and removed.
+     */
+    bool removeDrone(DroneId id);
+
+    /**
+     * @brief Get the number of drones added or removed since the simulation was created.
+     *
+     * The user interface compares it with the value of its last update to know when to
+     * rebuild its list of drones.
+     *
+     * @return The revision of the fleet.
+     */
+    inline quint64 getFleetRevision() const { return fleetRevision; }
+
+    /**
+     * @brief Move a server (mobile base station).
+     *
+     * The drones flying to the server head to its new position, and the regions of the
+     * sharded engine follow it: the drones change of shard at the next step if the
+     * server moved past them.
+     *
+     * @param index The index of the server.
+     * @param position The new position of the server.
+     * @return False if there is no such server.
+     */
+    bool moveServer(int index, const Vector2D &position);
+
+    /**
+     * @brief Get the number of server moves since the simulation was created.
+     *
+     * The user interface compares it with the value of its last update to know when to
+     * repair the Voronoi cells of the servers.
+     *
+     * @return The revision of the servers.
+     */
+    inline quint64 getServerRevision() const { return serverRevision; }
+
+    /**
+     * @brief Apply a command to the fleet.
+     * @param command The command.
+     * @return True if the command designates existing drones, servers and profiles, and can be applied to the drone.
+     */
+    bool apply(const DroneCommand &command);
+
+    /**
+     * @brief Set the queue whose commands are applied at the start of each step.
+     * @param queue The queue, or nullptr for no external commands.
+     */
+    inline void setCommandQueue(CommandQueue *queue) { commands = queue; }
+
+    /**
+     * @brief Take a snapshot of the fleet.
+     *
+     * The snapshot shares the arrays of the registry (copy-on-write): taking it costs
+     * nothing, and the next step copies the records once. It can then be saved by
+     * another thread while the simulation goes on.
+     *
+     * @return The snapshot.
+     */
+    SimulationSnapshot takeSnapshot() const;
+
+    /**
+     * @brief Replace the fleet by a snapshot taken on the same scenario.
+     *
+     * The handles of the drones change, see getFleetRevision().
+     *
+     * @param snapshot The snapshot.
+     * @return False if the snapshot has invalid records, or references flight models or servers that the scenario does not have.
+     */
+    bool restoreSnapshot(const SimulationSnapshot &snapshot);
+
+    /**
+     * @brief Restrict the drones updated by the simulation to those of one process.
+     *
+     * The partition holds the drones of a range of the registry, except those targeting
+     * a scheduled server (see LandingScheduler), which belong to the process of rank
+     * server % count whatever their range: each scheduled server is owned by one
+     * process, which gives all its pads and charging slots. The targets do not change
+     * in the multi-process engine, so the partition does not either.
+     *
+     * The other drones are only obstacles. Call restore() afterwards to schedule the
+     * events of the partition only.
+     *
+     * @param begin The dense index of the first drone of the range.
+     * @param end The dense index after the last drone of the range.
+     * @param rank The index of the process.
+     * @param count The number of processes.
+     */
+    void setPartition(int begin, int end, int rank = 0, int count = 1);
+
+    /**
+     * @brief Replace the state of all the drones by records of the same scenario.
+     *
+     * The drones in the air and the events of the partition are rebuilt from the records,
+     * so that a process can take over the drones of another one.
+     *
+     * @param records The records of the drones, in the order of the registry.
+     * @param count The number of records, which must be the number of drones.
+     * @param t The simulated time of the records.
+     */
+    void restore(const Drone *records, int count, double t);
+
+    /**
+     * @brief Replace the state of the drones of a range updated by another process.
+     * @param records The records of all the drones, in the order of the registry.
+     * @param begin The dense index of the first drone to import.
+     * @param end The dense index after the last drone to import.
+     */
+    void importDrones(const Drone *records, int begin, int end);
+
+    /**
+     * @brief Copy the drones of the partition to the records shared with the other processes.
+     * @param records The records of all the drones, in the order of the registry.
+     */
+    void exportDrones(Drone *records) const;
+
+    /**
+     * @brief Get the simulated time.
+     * @return The time in seconds since the scenario was loaded.
+     */
+    inline double getTime() const { return time; }
+
+    /**
+     * @brief Set the distance under which drones repel each other.
+     * @param distance The collision distance in pixels.
+     */
+    inline void setCollisionDistance(double distance) {
+        collisionDistance = distance;
+        landing.setSpacing(float(distance));  // The pads and the holding drones are one collision distance apart
+        if (!shards.isEmpty()) {
+            regions.setRange(float(distance));  // The halo regions are those within the collision distance
+        }
+    }
+
+    /**
+     * @brief Select the method used to integrate the motion of the flying drones.
+     * @param method The integration method.
+     */
+    inline void setIntegrator(Integrator::Method method) { integrator = method; }
+
+    /**
+     * @brief Get the method used to integrate the motion of the flying drones.
+     * @return The integration method.
+     */
+    inline Integrator::Method getIntegrator() const { return integrator; }
+
+    /**
+     * @brief Select the engine: single-threaded, or sharded by server region.
+     * @param threads The number of threads of the sharded engine, 0 for the single-threaded engine.
+     */
+    void setThreadCount(int threads);
+
+    /**
+     * @brief Check if the drones are updated by the sharded engine.
+     * @return True if the sharded engine is selected and there are servers to define the regions.
+     */
+    inline bool isSharded() const { return workers && !shards.isEmpty(); }
+
+    /**
+     * @brief Get the size of the memory reused by the steps (scratch memory, event queue and shards).
+     *
+     * The capacity only changes when a step needs more memory than the previous ones.
+     *
+     * @return The capacity in bytes.
+     */
+    inline std::size_t getScratchCapacity() const {
+        std::size_t capacity = scratch.capacity() + std::size_t(events.capacity()) * sizeof(SimulationEvent)
+                               + collisionGrid.capacity() + std::size_t(nearby.capacity()) * sizeof(Vector2D);
+        for (const RegionShard &shard : shards) {
+            capacity += shard.capacity();
+        }
+        return capacity;
+    }
+
+    /**
+     * @brief Get the registry of drones.
+     * @return The registry.
+     */
+    inline DroneRegistry &getDrones() { return drones; }
+
+    /**
+     * @brief Get the registry of drones.
+     * @return The registry.
+     */
+    inline const DroneRegistry &getDrones() const { return drones; }
+
+    /**
+     * @brief Find the drones within a distance of a point.
+     * @param center The point.
+     * @param radius The distance in pixels.
+     * @return The handles of the drones, in no particular order.
+     */
+    QVector<DroneId> dronesInRadius(const Vector2D &center, float radius) const;
+
+    /**
+     * @brief Find the drones inside a rectangle.
+     * @param rect The rectangle.
+     * @return The handles of the drones, in no particular order.
+     */
+    QVector<DroneId> dronesInRect(const QRectF &rect) const;
+
+    /**
+     * @brief Find the drones nearest to a point.
+     * @param center The point.
+     * @param k The number of drones.
+     * @return The handles of the k nearest drones (fewer if the fleet is smaller), nearest first.
+     */
+    QVector<DroneId> nearestDrones(const Vector2D &center, int k) const;
+
+    /**
+     * @brief Get the list of servers.
+     * @return The servers.
+     */
+    inline const QVector<Server> &getServers() const { return servers; }
+
+    /**
+     * @brief Get the no-fly zones of the scenario.
+     * @return The zones.
+     */
+    inline const NoFlyZones &getNoFlyZones() const { return noFlyZones; }
+
+    /**
+     * @brief Get a flight model profile.
+     * @param index The index of the profile, as given by Drone::getFlightModel().
+     * @return The profile.
+     */
+    inline const FlightModel &getFlightModel(int index) const { return flightModels[index]; }
+
+    /**
+     * @brief Find the index of a flight model profile from its name.
+     * @param name The name of the profile, empty for the default one.
+     * @return The index of the profile, or -1 if not found.
+     */
+    inline int findFlightModel(const QString &name) const { return name.isEmpty() ? 0 : flightModelIndex.value(name, -1); }
+
+    /**
+     * @brief Find the index of a server from its name.
+     * @param name The name of the server.
+     * @return The index of the server, or -1 if not found.
+     */
+    inline int findServer(const QString &name) const { return serverIndex.value(name, -1); }
+
+private:
+    /**
+     * @brief Event of a drone in a flight phase during a step.
+     */
+    enum FlightEvent {
+        noFlightEvent, ///< The drone goes on flying.
+        startedLanding, ///< The drone started landing.
+        reachedApproach ///< The drone entered the approach area of a scheduled server, without a slot.
+    };
+
+    /**
+     * @brief Check if a drone belongs to the partition of the simulation.
+     * @param index The dense index of the drone.
+     * @return True if the drone is updated by this simulation.
+     */
+    inline bool owns(int index) const {
+        if (partitionCount > 1) {
+            const int target = drones[index].getTargetServer();
+            if (landing.isScheduled(target)) {
+                return target % partitionCount == partitionRank;  // The drones of a scheduled server stay together
+            }
+        }
+        return index >= partitionBegin && index < partitionEnd;
+    }
+
+    /**
+     * @brief Schedule the end of the current analytic phase of a drone, if any.
+     * @param id The handle of the drone.
+     * @param drone The drone.
+     */
+    void scheduleNextEvent(DroneId id, const Drone &drone);
+
+    /**
+     * @brief Ask for a landing slot for a drone arriving at its target server.
+     * @param id The handle of the drone.
+     * @param now The simulated time of the arrival.
+     */
+    void requestLanding(DroneId id, double now);
+
+    /**
+     * @brief Rebuild the drones in the air and the events of the partition from the records.
+     */
+    void rebuildSchedule();
+
+    /**
+     * @brief Apply the commands waiting in the command queue.
+     *
+     * At most one queue capacity of commands is applied, so that producers faster than
+     * the simulation cannot delay the step indefinitely.
+     */
+    void drainCommands();
+
+    /**
+     * @brief End the analytic phases that finish before a given time, in time order.
+     * @param until The simulated time up to which the events are processed.
+     */
+    void processEvents(double until);
+
+    /**
+     * @brief Advance the drones in the air by one step with the sharded engine.
+     * @param dt The duration of the step in seconds.
+     */
+    void stepShards(double dt);
+
+    /**
+     * @brief Compute the collision force of a drone in a flight phase and update it.
+     * @param drone The drone.
+     * @param position The position of the drone at the start of the step.
+     * @param others The positions of the drones that may collide with the drone (not the drone itself).
+     * @param otherCount The number of positions in others.
+     * @param distances Scratch array for otherCount squared distances.
+     * @param dt The duration of the step in seconds.
+     * @return The event of the drone during the step.
+     */
+    FlightEvent fly(Drone &drone, const Vector2D &position, const Vector2D *others, int otherCount,
+                    float *distances, double dt) const;
+
+    /**
+     * @brief Create the shards of the sharded engine, one per server region.
+     */
+    void updateShards();
+
+    /**
+     * @brief Get the spatial index of the drones, rebuilt if the drones moved since it was built.
+     * @return The index.
+     */
+    const DroneIndex &spatialIndex() const;
+
+    /**
+     * @brief Mark the spatial index as outdated at the end of a step, or rebuild it if it is being queried.
+     */
+    void updateSpatialIndex();
+
+    /**
+     * @brief Convert the dense indices of a query to handles.
+     * @return The handles of the drones of queryResult.
+     */
+    QVector<DroneId> queryHandles() const;
+
+    DroneRegistry drones; ///< Drones of the simulation.
+    QVector<DroneId> airborne; ///< Drones that are not landed (only those not yet given to a shard in sharded mode).
+    EventScheduler events; ///< Scheduled ends of the analytic phases.
+    LandingScheduler landing; ///< Landing slots of the servers with a limited capacity.
+    double time; ///< Simulated time in seconds.
+    QVector<Server> servers; ///< Servers of the simulation.
+    QHash<QString, int> serverIndex; ///< Index of each server from its name.
+    QVector<FlightModel> flightModels; ///< Flight model profiles, the default one first.
+    QHash<QString, int> flightModelIndex; ///< Index of each flight model profile from its name.
+    bool standardDefaultModel; ///< True if the default profile has the values of DefaultFlightModel.
+    FrameArena scratch; ///< Scratch memory of the current step.
+    double collisionDistance; ///< Distance under which drones repel each other.
+    NoFlyZones noFlyZones; ///< Zones the drones are kept out of, within collisionDistance of their borders.
+    Integrator::Method integrator; ///< Method used to integrate the motion of the flying drones.
+    std::unique_ptr<WorkerPool> workers; ///< Threads of the sharded engine, null for the single-threaded engine.
+    QVector<RegionShard> shards; ///< Shards of the sharded engine, one per server.
+    QVector<Vector2D> serverPositions; ///< Positions of the servers, contiguous for the batch kernels.
+    RegionMap regions; ///< Neighbouring regions of the servers, for the sharded engine.
+    CollisionGrid collisionGrid; ///< Grid of the drones in the air, for the single-threaded engine.
+    QVector<Vector2D> nearby; ///< Collision candidates of the drone being updated by the single-threaded engine.
+    int partitionBegin; ///< Dense index of the first drone updated by the simulation.
+    int partitionEnd; ///< Dense index after the last drone updated by the simulation.
+    int partitionRank; ///< Index of the process, which updates the drones of the scheduled servers of this rank.
+    int partitionCount; ///< Number of processes sharing the drones.
+    CommandQueue *commands; ///< Queue of the external commands, may be null.
+    DroneCommand command; ///< Command being applied, reused so that draining does not construct strings.
+    quint64 fleetRevision; ///< Number of drones added or removed.
+    quint64 serverRevision; ///< Number of server moves.
+    mutable DroneIndex droneIndex; ///< Spatial index of the drones.
+    mutable bool indexStale; ///< True if the drones moved since the spatial index was built.
+    mutable bool indexQueried; ///< True if the spatial index was queried since the last step.
+    mutable QVector<int> queryResult; ///< Dense indices of the last query, reused from one query to the next.
+};
+
+#endif // SIMULATION_H
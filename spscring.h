@@ -0,0 +1,105 @@
+/**
+ * @file spscring.h
+ * @brief Lock-free ring buffer with one producer and one consumer.
+ *
+ * This file declares the SpscRing class template, used to hand telemetry records from
+ * the simulation thread to a writer thread.
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+/**
+ * @class SpscRing
+ * @brief Fixed-capacity ring of trivially copyable values.
+ *
+ * The producer only writes the head counter and the consumer only writes the tail
+ * counter, each on its own cache line. The consumer reads the values in place, as at
+ * most two contiguous spans (before and after the wrap), and releases them in one go,
+ * so that it can write large batches without copying.
+ *
+ * @tparam T The type of the values.
+ */
+template<typename T>
+class SpscRing {
+public:
+    /**
+     * @brief Constructs an empty ring.
+     * @param capacity The maximum number of values, rounded up to a power of two.
+     */
+    explicit SpscRing(int capacity) {
+        std::size_t size = 2;
+        while (size < std::size_t(capacity)) {
+            size *= 2;
+        }
+        mask = size - 1;
+        values.reset(new T[size]);
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief Get the maximum number of values.
+     * @return The capacity.
+     */
+    inline int capacity() const { return int(mask + 1); }
+
+    /**
+     * @brief Add a value (producer thread only).
+     * @param value The value.
+     * @return False if the ring is full.
+     */
+    inline bool tryPush(const T &value) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail > mask) {
+            cachedTail = tail.load(std::memory_order_acquire);  // Only read the shared counter when the ring looks full
+            if (h - cachedTail > mask) {
+                return false;
+            }
+        }
+        values[h & mask] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Get the values available to the consumer (consumer thread only).
+     * @param first Receives the first span of values.
+     * @param firstCount Receives the number of values of the first span.
+     * @param second Receives the second span, which follows the first one after the wrap.
+     * @param secondCount Receives the number of values of the second span.
+     * @return The total number of available values, to give to release() once they are used.
+     */
+    std::size_t peek(const T *&first, std::size_t &firstCount, const T *&second, std::size_t &secondCount) const {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        const std::size_t count = head.load(std::memory_order_acquire) - t;
+        const std::size_t start = t & mask;
+        firstCount = qMin(count, mask + 1 - start);
+        secondCount = count - firstCount;
+        first = values.get() + start;
+        second = values.get();
+        return count;
+    }
+
+    /**
+     * @brief Give values back to the producer (consumer thread only).
+     * @param count The number of values used, from the start of the spans given by peek().
+     */
+    inline void release(std::size_t count) {
+        tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<T[]> values; ///< The ring of values.
+    std::size_t mask; ///< Capacity - 1.
+    alignas(64) std::atomic<std::size_t> head{0}; ///< Number of values pushed, written by the producer.
+    std::size_t cachedTail = 0; ///< Last tail read by the producer.
+    alignas(64) std::atomic<std::size_t> tail{0}; ///< Number of values consumed, written by the consumer.
+};
+
+#endif // SPSCRING_H
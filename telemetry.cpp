@@ -0,0 +1,185 @@
+#include "telemetry.h"
+#include <QDebug>
+
+static const char *const statusNames[] = { "landed", "takeoff", "landing", "hovering", "turning", "flying" }; ///< Names of Drone::droneStatus.
+static const char *const formatNames[] = { "csv", "ndjson", "binary" }; ///< Names of TelemetryStream::Format.
+
+/**
+ * @brief Find a format from its name.
+ * @param name The name of the format ("csv", "ndjson" or "binary").
+ * @param format Receives the format.
+ * @return True if the name designates a format.
+ */
+bool TelemetryStream::formatFromName(const QString &name, Format &format) {
+    for (int i = 0; i < 3; i++) {
+        if (name.compare(formatNames[i], Qt::CaseInsensitive) == 0) {
+            format = Format(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Constructs a closed stream.
+ */
+TelemetryStream::TelemetryStream() {}
+
+/**
+ * @brief Writes the pending records and closes the stream.
+ */
+TelemetryStream::~TelemetryStream() {
+    close();
+}
+
+/**
+ * @brief Create the output file and start the writer thread.
+ * @param filePath The path of the file.
+ * @param opts The options of the stream.
+ * @return True if the file was created.
+ */
+bool TelemetryStream::open(const QString &filePath, const Options &opts) {
+    close();
+    options = opts;
+    options.droneStride = qMax(1, options.droneStride);
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = file.errorString();
+        return false;
+    }
+    if (options.format == binary) {
+        const quint32 header[4] = { binaryMagic, binaryVersion, quint32(sizeof(TelemetryRecord)), 0 };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    } else if (options.format == csv) {
+        file.write("time,drone,generation,status,x,y,vx,vy,power\n");
+    }
+
+    ring.reset(new SpscRing<TelemetryRecord>(options.capacity));
+    batch.reserve(2 * batchSize);
+    nextSample = 0;
+    dropped = 0;
+    stopping.store(false);
+    writer.reset(QThread::create([this]() { writeLoop(); }));
+    writer->start();
+    return true;
+}
+
+/**
+ * @brief Write the pending records, stop the writer thread and close the file.
+ */
+void TelemetryStream::close() {
+    if (!writer) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    writer->wait();
+    writer.reset();
+    file.close();
+    if (dropped > 0) {
+        qWarning() << "Telemetry dropped" << dropped << "records";
+    }
+}
+
+/**
+ * @brief Record the state of the sampled drones (simulation thread).
+ * @param simulation The simulation, after a step.
+ */
+void TelemetryStream::record(const Simulation &simulation) {
+    const double time = simulation.getTime();
+    if (!writer || time < nextSample) {
+        return;
+    }
+    nextSample = options.interval > 0 ? qMax(nextSample + options.interval, time) : time;
+
+    const DroneRegistry &drones = simulation.getDrones();
+    for (int i = 0; i < drones.size(); i++) {
+        const DroneId id = drones.idAt(i);
+        if (id.index % quint32(options.droneStride) != 0) {
+            continue;
+        }
+        const Drone &drone = drones[i];
+        TelemetryRecord record;
+        record.time = time;
+        record.drone = id.index;
+        record.status = quint32(drone.getStatus());
+        record.generation = id.generation;
+        record.x = drone.getPosition().x;
+        record.y = drone.getPosition().y;
+        record.vx = drone.getVelocity().x;
+        record.vy = drone.getVelocity().y;
+        record.power = float(drone.getPower(simulation.getFlightModel(drone.getFlightModel()), time));
+        if (!ring->tryPush(record)) {
+            dropped++;  // The writer cannot keep up: never wait for it
+        }
+    }
+}
+
+/**
+ * @brief Format records as text at the end of the batch.
+ * @param records The records.
+ * @param count The number of records.
+ */
+void TelemetryStream::format(const TelemetryRecord *records, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        const TelemetryRecord &r = records[i];
+        const char *status = r.status < 6 ? statusNames[r.status] : "unknown";
+        if (options.format == csv) {
+            batch.append(QByteArray::number(r.time, 'f', 3)).append(',')
+                .append(QByteArray::number(r.drone)).append(',')
+                .append(QByteArray::number(r.generation)).append(',')
+                .append(status).append(',')
+                .append(QByteArray::number(r.x, 'f', 2)).append(',')
+                .append(QByteArray::number(r.y, 'f', 2)).append(',')
+                .append(QByteArray::number(r.vx, 'f', 2)).append(',')
+                .append(QByteArray::number(r.vy, 'f', 2)).append(',')
+                .append(QByteArray::number(r.power, 'f', 1)).append('\n');
+        } else {
+            batch.append("{\"time\":").append(QByteArray::number(r.time, 'f', 3))
+                .append(",\"drone\":").append(QByteArray::number(r.drone))
+                .append(",\"generation\":").append(QByteArray::number(r.generation))
+                .append(",\"status\":\"").append(status)
+                .append("\",\"x\":").append(QByteArray::number(r.x, 'f', 2))
+                .append(",\"y\":").append(QByteArray::number(r.y, 'f', 2))
+                .append(",\"vx\":").append(QByteArray::number(r.vx, 'f', 2))
+                .append(",\"vy\":").append(QByteArray::number(r.vy, 'f', 2))
+                .append(",\"power\":").append(QByteArray::number(r.power, 'f', 1)).append("}\n");
+        }
+    }
+}
+
+/**
+ * @brief Body of the writer thread.
+ *
+ * The thread takes all the records available in the ring at once. Binary records are
+ * written directly from the ring; text records are formatted into a batch written when
+ * it exceeds batchSize, or when the ring is empty so that readers of the file are not
+ * kept waiting. The thread sleeps while the ring is empty.
+ */
+void TelemetryStream::writeLoop() {
+    for (;;) {
+        const bool last = stopping.load(std::memory_order_acquire);  // Checked before reading the ring
+        const TelemetryRecord *first, *second;
+        std::size_t firstCount, secondCount;
+        std::size_t count = ring->peek(first, firstCount, second, secondCount);
+        if (options.format == binary) {
+            file.write(reinterpret_cast<const char*>(first), qint64(firstCount * sizeof(TelemetryRecord)));
+            file.write(reinterpret_cast<const char*>(second), qint64(secondCount * sizeof(TelemetryRecord)));
+        } else {
+            format(first, firstCount);
+            format(second, secondCount);
+        }
+        ring->release(count);
+
+        if (batch.size() >= batchSize || (count == 0 && !batch.isEmpty())) {
+            file.write(batch);
+            batch.resize(0);  // Keeps the capacity
+        }
+        if (count == 0) {
+            if (last) {
+                file.flush();
+                return;
+            }
+            QThread::msleep(idleInterval);
+        }
+    }
+}
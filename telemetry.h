@@ -0,0 +1,164 @@
+/**
+ * @file telemetry.h
+ * @brief Streaming output of the state of the fleet at each step.
+ *
+ * This file declares the TelemetryStream class, which records the state of the drones
+ * after the steps of a simulation and writes it to a file on a background thread, as
+ * CSV, newline-delimited JSON or fixed-size binary records.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <memory>
+#include "simulation.h"
+#include "spscring.h"
+
+/**
+ * @brief State of a drone at a step, as written in the binary format.
+ *
+ * A binary telemetry file starts with 4 little-endian quint32 (TelemetryStream::binaryMagic,
+ * TelemetryStream::binaryVersion, sizeof(TelemetryRecord), 0), followed by the records
+ * in the byte order of the machine that wrote them.
+ */
+struct TelemetryRecord {
+    double time; ///< Simulated time in seconds.
+    quint32 drone; ///< Slot of the drone in the registry (DroneId::index), stable while the drone exists.
+    quint32 status; ///< Drone::droneStatus.
+    quint32 generation; ///< Generation of the slot (DroneId::generation): with the slot, identifies the drone.
+    float x; ///< Position.
+    float y; ///< Position.
+    float vx; ///< Velocity.
+    float vy; ///< Velocity.
+    float power; ///< Power level, between 0 and 100.
+};
+
+static_assert(sizeof(TelemetryRecord) == 40, "TelemetryRecord is a file format");
+
+/**
+ * @class TelemetryStream
+ * @brief Records drone states into a ring buffer flushed by a writer thread.
+ *
+ * record() is called by the simulation thread after a step. It only copies the state
+ * of the sampled drones into a SpscRing: it never waits and never allocates. When the
+ * writer thread cannot keep up and the ring is full, the records are dropped and
+ * counted. The writer thread formats the records and writes them in large batches.
+ *
+ * Decimation is done in time (one sample every Options::interval simulated seconds)
+ * and over the fleet (drones whose slot is a multiple of Options::droneStride), so
+ * that the same drones are followed from sample to sample.
+ */
+class TelemetryStream {
+public:
+    static constexpr quint32 binaryMagic = 0x444D4C54; ///< Magic number of binary telemetry files ("TLMD").
+    static constexpr quint32 binaryVersion = 2; ///< Version of the binary telemetry format.
+
+    /**
+     * @brief Format of the output file.
+     */
+    enum Format {
+        csv, ///< Comma-separated values with a header line.
+        ndjson, ///< One JSON object per line.
+        binary ///< Fixed-size TelemetryRecord.
+    };
+
+    /**
+     * @brief Options of the stream.
+     */
+    struct Options {
+        Format format = csv; ///< Format of the output file.
+        double interval = 0; ///< Simulated time between two samples in seconds, 0 for every step.
+        int droneStride = 1; ///< Only drones whose slot is a multiple of the stride are recorded.
+        int capacity = 1 << 20; ///< Number of records of the ring buffer.
+    };
+
+    /**
+     * @brief Find a format from its name.
+     * @param name The name of the format ("csv", "ndjson" or "binary").
+     * @param format Receives the format.
+     * @return True if the name designates a format.
+     */
+    static bool formatFromName(const QString &name, Format &format);
+
+    /**
+     * @brief Constructs a closed stream.
+     */
+    TelemetryStream();
+
+    /**
+     * @brief Writes the pending records and closes the stream.
+     */
+    ~TelemetryStream();
+
+    TelemetryStream(const TelemetryStream &) = delete;
+    TelemetryStream &operator=(const TelemetryStream &) = delete;
+
+    /**
+     * @brief Create the output file and start the writer thread.
+     * @param filePath The path of the file.
+     * @param options The options of the stream.
+     * @return True if the file was created.
+     */
+    bool open(const QString &filePath, const Options &options);
+
+    /**
+     * @brief Write the pending records, stop the writer thread and close the file.
+     */
+    void close();
+
+    /**
+     * @brief Check if the stream is open.
+     * @return True if open() succeeded and close() was not called.
+     */
+    inline bool isOpen() const { return writer != nullptr; }
+
+    /**
+     * @brief Get the error of the last open().
+     * @return A description of the error.
+     */
+    inline QString errorString() const { return error; }
+
+    /**
+     * @brief Record the state of the sampled drones (simulation thread).
+     * @param simulation The simulation, after a step.
+     */
+    void record(const Simulation &simulation);
+
+    /**
+     * @brief Get the number of records dropped because the ring buffer was full.
+     * @return The number of dropped records.
+     */
+    inline quint64 getDroppedCount() const { return dropped; }
+
+private:
+    static constexpr int batchSize = 1 << 20; ///< Size of the text written at once, in bytes.
+    static constexpr unsigned long idleInterval = 10; ///< Sleep of the writer thread when there is no record, in ms.
+
+    /**
+     * @brief Body of the writer thread.
+     */
+    void writeLoop();
+
+    /**
+     * @brief Format records as text at the end of the batch.
+     * @param records The records.
+     * @param count The number of records.
+     */
+    void format(const TelemetryRecord *records, std::size_t count);
+
+    Options options; ///< Options of the stream.
+    std::unique_ptr<SpscRing<TelemetryRecord>> ring; ///< Records waiting for the writer thread.
+    std::unique_ptr<QThread> writer; ///< Writer thread, null when the stream is closed.
+    std::atomic<bool> stopping{false}; ///< Set to make the writer thread write the last records and stop.
+    QFile file; ///< Output file, used by the writer thread.
+    QByteArray batch; ///< Text formatted by the writer thread and not written yet.
+    QString error; ///< Error of the last open().
+    double nextSample = 0; ///< Simulated time of the next sample.
+    quint64 dropped = 0; ///< Number of records dropped.
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,319 @@
+#include "tilepyramid.h"
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+static constexpr int coordinateBits = 29; ///< Bits of the column and of the row in a tile key.
+static constexpr int coordinateLimit = (1 << (coordinateBits - 1)) - 1; ///< Largest column or row, in absolute value.
+
+/**
+ * @brief Constructs an empty pyramid and starts its workers.
+ * @param workerCount The number of worker threads.
+ * @param memoryLimit The size of the tile cache in KiB.
+ * @param parent The parent object.
+ */
+TilePyramid::TilePyramid(int workerCount, int memoryLimit, QObject *parent)
+    : QObject(parent), tiles(memoryLimit) {
+    for (int i = 0; i < workerCount; i++) {
+        QThread *worker = QThread::create([this]() { work(); });
+        worker->start(QThread::LowPriority);  // The simulation and the display come first
+        workers.append(worker);
+    }
+}
+
+/**
+ * @brief Stops the workers, discarding the tiles being computed.
+ */
+TilePyramid::~TilePyramid() {
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.wakeAll();
+    for (QThread *worker : workers) {
+        worker->wait();
+    }
+    qDeleteAll(workers);
+}
+
+/**
+ * @brief Replace the sites, emptying the cache.
+ * @param sites The positions of the servers.
+ */
+void TilePyramid::setSites(const QVector<Vector2D> &sites) {
+    this->sites = sites;
+    sitesKey = TileStore::sitesKey(sites);
+    generation++;
+    cancelJobs();
+    tiles.clear();
+}
+
+/**
+ * @brief Set the colour of each cell, for the cached and the future tiles.
+ * @param colors The colours, indexed like the sites.
+ */
+void TilePyramid::setPalette(const QVector<QRgb> &colors) {
+    palette = colors;
+    for (quint64 key : tiles.keys()) {
+        tiles.object(key)->setPalette(palette);
+    }
+}
+
+/**
+ * @brief Move a site, repairing the cached tiles that overlap the area of the change.
+ *
+ * The tiles being computed are discarded, since they may use the old position; the
+ * cached tiles outside of the area do not change. The coarse tiles that extend beyond
+ * the exact area may change outside of the area (far parts of the cells on the convex
+ * hull), so they are removed and computed again.
+ *
+ * @param sites The positions of the servers, with the new position of the moved site.
+ * @param moved The index of the moved site.
+ * @param candidates The sites that can take the pixels of its old cell (its neighbours).
+ * @param area The world area containing the old and the new cell of the site.
+ * @param exact The world area where the area of the change is known to be exact.
+ */
+void TilePyramid::moveSite(const QVector<Vector2D> &sites, int moved, const QVector<int> &candidates, const QRectF &area, const QRectF &exact) {
+    this->sites = sites;
+    sitesKey.clear();  // Transient configuration: its tiles are not stored
+    generation++;
+    cancelJobs();
+    for (quint64 key : tiles.keys()) {
+        const QRectF rect = tileArea(key);
+        if (!exact.contains(rect)) {
+            tiles.remove(key);
+        } else if (rect.intersects(area)) {
+            tiles.object(key)->moveSite(sites, moved, candidates, area);
+        }
+    }
+}
+
+/**
+ * @brief Get the level of the tiles drawn at a zoom factor.
+ * @param zoom The number of screen pixels per world unit.
+ * @return The level, from 0 to maxLevel.
+ */
+int TilePyramid::levelFor(double zoom) {
+    if (zoom >= 1) {
+        return 0;  // Level 0 enlarged
+    }
+    return qMin(int(std::floor(std::log2(1 / zoom))), maxLevel);
+}
+
+/**
+ * @brief Draw the cells of an area, queuing or computing the missing tiles.
+ *
+ * A missing tile is replaced by the part of the nearest coarser tile that covers it,
+ * if there is one. The missing tiles are queued nearest to the centre of the area
+ * first, replacing those of the previous frame that are not being computed yet.
+ *
+ * When the drawing must be complete, the missing tiles are read or computed on the
+ * calling thread instead, and cached like those of the workers.
+ *
+ * @param painter The painter, in world coordinates.
+ * @param area The world area to draw.
+ * @param zoom The number of screen pixels per world unit.
+ * @param complete True to compute the missing tiles on the calling thread before drawing them.
+ */
+void TilePyramid::draw(QPainter &painter, const QRectF &area, double zoom, bool complete) {
+    collect();
+    cancelJobs();
+    if (sites.isEmpty() || area.isEmpty()) {
+        return;
+    }
+
+    const int level = levelFor(zoom);
+    const double span = std::ldexp(double(tileSize), level);
+    const int x0 = int(qBound<double>(-coordinateLimit, std::floor(area.left() / span), coordinateLimit));
+    const int x1 = int(qBound<double>(-coordinateLimit, std::floor(area.right() / span), coordinateLimit));
+    const int y0 = int(qBound<double>(-coordinateLimit, std::floor(area.top() / span), coordinateLimit));
+    const int y1 = int(qBound<double>(-coordinateLimit, std::floor(area.bottom() / span), coordinateLimit));
+    const QPointF center = area.center();
+    QVector<QPair<double, quint64>> missing;  // Squared distance to the centre, key
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const quint64 key = tileKey(level, x, y);
+            const QRectF rect(x * span, y * span, span, span);
+            const VoronoiRaster *tile = tiles.object(key);
+            if (!tile && complete) {
+                VoronoiRaster raster;
+                loadTile(key, sites, sitesKey, raster);
+                tile = store(key, std::move(raster));
+            }
+            if (tile) {
+                drawTile(painter, *tile, rect);
+                continue;
+            }
+            for (int up = level + 1; up <= maxLevel; up++) {
+                if (const VoronoiRaster *parent = tiles.object(tileKey(up, x >> (up - level), y >> (up - level)))) {
+                    drawTile(painter, *parent, rect);
+                    break;
+                }
+            }
+            if (!queued.contains(key)) {
+                const QPointF offset = rect.center() - center;
+                missing.append(qMakePair(QPointF::dotProduct(offset, offset), key));
+            }
+        }
+    }
+    if (missing.isEmpty()) {
+        return;
+    }
+
+    std::sort(missing.begin(), missing.end(), std::greater<QPair<double, quint64>>());  // The nearest last
+    QMutexLocker locker(&mutex);
+    for (const QPair<double, quint64> &tile : missing) {
+        jobs.append(Job{tile.second, generation, sites, sitesKey});
+        queued.insert(tile.second);
+    }
+    wake.wakeAll();
+}
+
+/**
+ * @brief Get the key of a tile.
+ * @param level The level.
+ * @param x The column of the tile in its level.
+ * @param y The row of the tile in its level.
+ * @return The key: the level, then the column and the row, biased to be positive.
+ */
+quint64 TilePyramid::tileKey(int level, int x, int y) {
+    const quint64 bias = quint64(1) << (coordinateBits - 1);
+    return (quint64(level) << (2 * coordinateBits)) | (quint64(qint64(x) + bias) << coordinateBits) | quint64(qint64(y) + bias);
+}
+
+/**
+ * @brief Get the world area of a tile.
+ * @param key The key of the tile.
+ * @return The area.
+ */
+QRectF TilePyramid::tileArea(quint64 key) {
+    const quint64 mask = (quint64(1) << coordinateBits) - 1;
+    const qint64 bias = qint64(1) << (coordinateBits - 1);
+    const double span = std::ldexp(double(tileSize), int(key >> (2 * coordinateBits)));
+    const qint64 x = qint64((key >> coordinateBits) & mask) - bias, y = qint64(key & mask) - bias;
+    return QRectF(x * span, y * span, span, span);
+}
+
+/**
+ * @brief Draw the pixels of a tile covering a world area.
+ *
+ * The area is clipped, since it is not aligned on the pixels of a coarser tile.
+ *
+ * @param painter The painter, in world coordinates.
+ * @param tile The tile.
+ * @param area The world area, inside the tile.
+ */
+void TilePyramid::drawTile(QPainter &painter, const VoronoiRaster &tile, const QRectF &area) {
+    const float scale = tile.scale();
+    const QRectF pixels((area.left() - tile.origin().x) / scale, (area.top() - tile.origin().y) / scale,
+                        area.width() / scale, area.height() / scale);
+    painter.save();
+    painter.setClipRect(area, Qt::IntersectClip);
+    painter.translate(tile.origin().x, tile.origin().y);
+    painter.scale(scale, scale);
+    tile.draw(painter, pixels.toAlignedRect());
+    painter.restore();
+}
+
+/**
+ * @brief Compute the cells of a tile.
+ * @param key The key of the tile.
+ * @param sites The positions of the servers.
+ * @param raster The raster receiving the cells.
+ */
+void TilePyramid::renderTile(quint64 key, const QVector<Vector2D> &sites, VoronoiRaster &raster) {
+    const QRectF area = tileArea(key);
+    raster.render(sites, QSize(tileSize, tileSize), Vector2D(float(area.left()), float(area.top())), float(area.width() / tileSize));
+}
+
+/**
+ * @brief Read a tile from the tile store, or compute it and write it there.
+ * @param key The key of the tile.
+ * @param sites The positions of the servers.
+ * @param sitesKey The key of the sites in the tile store, empty to compute the tile without the store.
+ * @param raster The raster receiving the cells.
+ */
+void TilePyramid::loadTile(quint64 key, const QVector<Vector2D> &sites, const QString &sitesKey, VoronoiRaster &raster) {
+    if (sitesKey.isEmpty()) {
+        renderTile(key, sites, raster);
+        return;
+    }
+    const QRectF area = tileArea(key);
+    if (disk.find(sitesKey, key, sites.size(), QSize(tileSize, tileSize), Vector2D(float(area.left()), float(area.top())),
+                  float(area.width() / tileSize), raster)) {
+        return;
+    }
+    renderTile(key, sites, raster);
+    disk.insert(sitesKey, key, raster);
+}
+
+/**
+ * @brief Colour a computed tile and move it to the cache.
+ * @param key The key of the tile.
+ * @param raster The cells of the tile, moved from.
+ * @return The cached tile, or nullptr if it is larger than the cache.
+ */
+VoronoiRaster *TilePyramid::store(quint64 key, VoronoiRaster &&raster) {
+    raster.setPalette(palette);
+    const qsizetype cost = qMax<qsizetype>(1, raster.memoryUsage() / 1024);
+    tiles.insert(key, new VoronoiRaster(std::move(raster)), cost);  // Deleted at once if it does not fit
+    return tiles.object(key);
+}
+
+/**
+ * @brief Remove the tiles that are queued and not being computed yet.
+ */
+void TilePyramid::cancelJobs() {
+    QMutexLocker locker(&mutex);
+    for (const Job &job : jobs) {
+        queued.remove(job.key);
+    }
+    jobs.clear();
+}
+
+/**
+ * @brief Move the computed tiles of the workers to the cache.
+ *
+ * The tiles computed from sites that changed since they were queued are dropped, and
+ * will be queued again if they are still in view.
+ */
+void TilePyramid::collect() {
+    QVector<Result> done;
+    {
+        QMutexLocker locker(&mutex);
+        done.swap(results);
+    }
+    for (Result &result : done) {
+        queued.remove(result.key);
+        if (result.generation != generation) {
+            continue;
+        }
+        store(result.key, std::move(result.raster));
+    }
+}
+
+/**
+ * @brief Compute queued tiles until the pyramid is destroyed (worker threads).
+ */
+void TilePyramid::work() {
+    QMutexLocker locker(&mutex);
+    for (;;) {
+        while (jobs.isEmpty() && !stopping) {
+            wake.wait(&mutex);
+        }
+        if (stopping) {
+            return;
+        }
+        Job job = jobs.takeLast();
+        locker.unlock();
+
+        Result result{job.key, job.generation, VoronoiRaster()};
+        loadTile(job.key, job.sites, job.sitesKey, result.raster);
+
+        locker.relock();
+        results.append(std::move(result));
+        emit tileReady();  // Queued to the thread of the pyramid
+    }
+}
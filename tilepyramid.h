@@ -0,0 +1,212 @@
+/**
+ * @file tilepyramid.h
+ * @brief Multi-resolution tiles of the Voronoi background, computed on worker threads.
+ *
+ * This file declares the TilePyramid class, which gives the canvas the Voronoi cells of
+ * any part of the map at any zoom level without a raster of the whole map.
+ */
+
+#ifndef TILEPYRAMID_H
+#define TILEPYRAMID_H
+
+#include <QCache>
+#include <QMutex>
+#include <QObject>
+#include <QPainter>
+#include <QRectF>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include "tilestore.h"
+#include "vector2d.h"
+#include "voronoiraster.h"
+
+/**
+ * @class TilePyramid
+ * @brief Voronoi cell rasters of tileSize pixels, by level and position.
+ *
+ * A pixel of a tile of level L covers 2^L world units, so the tiles of level L cut the
+ * map in squares of tileSize * 2^L units. draw() uses the coarsest level whose pixels
+ * are not larger than those of the screen.
+ *
+ * The tiles are computed lazily: a missing tile is queued for the worker threads, the
+ * nearest computed tile of a coarser level is drawn enlarged in the meantime, and
+ * tileReady() is emitted when the tile is done. The queue only holds the tiles of the
+ * last frame, nearest to its centre first. An offscreen frame that must be complete
+ * computes its missing tiles itself instead. The computed tiles are kept in a least
+ * recently used cache bounded in bytes. The tiles of the configurations given by
+ * setSites() are also kept in a TileStore on disk: a tile of a configuration that was
+ * already displayed is read instead of computed. The configurations reached by
+ * moveSite() (dragged or mobile servers) are transient, and their tiles are not stored.
+ *
+ * The workers compute the tiles from a copy of the sites (implicitly shared), tagged
+ * with a generation: when the sites change, the tiles being computed are discarded.
+ * A moved site is repaired in the cached tiles (see VoronoiRaster::moveSite), any
+ * other change empties the cache.
+ */
+class TilePyramid : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int tileSize = 256; ///< Side of a tile in pixels.
+    static constexpr int maxLevel = 24; ///< Coarsest level, whose pixels cover 2^maxLevel world units.
+    static constexpr int defaultMemoryLimit = 64 * 1024; ///< Default size of the tile cache in KiB.
+
+    /**
+     * @brief Constructs an empty pyramid and starts its workers.
+     * @param workerCount The number of worker threads.
+     * @param memoryLimit The size of the tile cache in KiB.
+     * @param parent The parent object.
+     */
+    explicit TilePyramid(int workerCount = qMax(1, QThread::idealThreadCount() / 2), int memoryLimit = defaultMemoryLimit, QObject *parent = nullptr);
+
+    /**
+     * @brief Stops the workers, discarding the tiles being computed.
+     */
+    ~TilePyramid();
+
+    /**
+     * @brief Replace the sites, emptying the cache.
+     * @param sites The positions of the servers.
+     */
+    void setSites(const QVector<Vector2D> &sites);
+
+    /**
+     * @brief Set the colour of each cell, for the cached and the future tiles.
+     * @param colors The colours, indexed like the sites.
+     */
+    void setPalette(const QVector<QRgb> &colors);
+
+    /**
+     * @brief Move a site, repairing the cached tiles that overlap the area of the change.
+     * @param sites The positions of the servers, with the new position of the moved site.
+     * @param moved The index of the moved site.
+     * @param candidates The sites that can take the pixels of its old cell (its neighbours).
+     * @param area The world area containing the old and the new cell of the site.
+     * @param exact The world area where the area of the change is known to be exact.
+     */
+    void moveSite(const QVector<Vector2D> &sites, int moved, const QVector<int> &candidates, const QRectF &area, const QRectF &exact);
+
+    /**
+     * @brief Get the level of the tiles drawn at a zoom factor.
+     * @param zoom The number of screen pixels per world unit.
+     * @return The level, from 0 to maxLevel.
+     */
+    static int levelFor(double zoom);
+
+    /**
+     * @brief Draw the cells of an area, queuing or computing the missing tiles.
+     * @param painter The painter, in world coordinates.
+     * @param area The world area to draw.
+     * @param zoom The number of screen pixels per world unit.
+     * @param complete True to compute the missing tiles on the calling thread before drawing them.
+     */
+    void draw(QPainter &painter, const QRectF &area, double zoom, bool complete = false);
+
+signals:
+    /**
+     * @brief Emitted by a worker thread when a tile is computed.
+     */
+    void tileReady();
+
+private:
+    /**
+     * @brief Tile to compute.
+     */
+    struct Job {
+        quint64 key; ///< Key of the tile.
+        quint64 generation; ///< Generation of the sites.
+        QVector<Vector2D> sites; ///< Positions of the servers (shared with the pyramid).
+        QString sitesKey; ///< Key of the sites in the tile store, empty if the tile is not stored.
+    };
+
+    /**
+     * @brief Tile computed by a worker.
+     */
+    struct Result {
+        quint64 key; ///< Key of the tile.
+        quint64 generation; ///< Generation of the sites it was computed from.
+        VoronoiRaster raster; ///< Cells of the tile.
+    };
+
+    /**
+     * @brief Get the key of a tile.
+     * @param level The level.
+     * @param x The column of the tile in its level.
+     * @param y The row of the tile in its level.
+     * @return The key.
+     */
+    static quint64 tileKey(int level, int x, int y);
+
+    /**
+     * @brief Get the world area of a tile.
+     * @param key The key of the tile.
+     * @return The area.
+     */
+    static QRectF tileArea(quint64 key);
+
+    /**
+     * @brief Draw the pixels of a tile covering a world area.
+     * @param painter The painter, in world coordinates.
+     * @param tile The tile.
+     * @param area The world area, inside the tile.
+     */
+    static void drawTile(QPainter &painter, const VoronoiRaster &tile, const QRectF &area);
+
+    /**
+     * @brief Compute the cells of a tile.
+     * @param key The key of the tile.
+     * @param sites The positions of the servers.
+     * @param raster The raster receiving the cells.
+     */
+    static void renderTile(quint64 key, const QVector<Vector2D> &sites, VoronoiRaster &raster);
+
+    /**
+     * @brief Read a tile from the tile store, or compute it and write it there.
+     * @param key The key of the tile.
+     * @param sites The positions of the servers.
+     * @param sitesKey The key of the sites in the tile store, empty to compute the tile without the store.
+     * @param raster The raster receiving the cells.
+     */
+    void loadTile(quint64 key, const QVector<Vector2D> &sites, const QString &sitesKey, VoronoiRaster &raster);
+
+    /**
+     * @brief Colour a computed tile and move it to the cache.
+     * @param key The key of the tile.
+     * @param raster The cells of the tile, moved from.
+     * @return The cached tile, or nullptr if it is larger than the cache.
+     */
+    VoronoiRaster *store(quint64 key, VoronoiRaster &&raster);
+
+    /**
+     * @brief Remove the tiles that are queued and not being computed yet.
+     */
+    void cancelJobs();
+
+    /**
+     * @brief Move the computed tiles of the workers to the cache.
+     */
+    void collect();
+
+    /**
+     * @brief Compute queued tiles until the pyramid is destroyed (worker threads).
+     */
+    void work();
+
+    QVector<QThread*> workers; ///< Worker threads.
+    QMutex mutex; ///< Protects jobs, results and stopping.
+    QWaitCondition wake; ///< Signalled when jobs are queued or the workers must stop.
+    QVector<Job> jobs; ///< Tiles to compute, the next one last.
+    QVector<Result> results; ///< Tiles computed and not collected yet.
+    bool stopping = false; ///< True when the workers must stop.
+    quint64 generation = 0; ///< Number of changes of the sites.
+    QSet<quint64> queued; ///< Tiles queued or being computed.
+    QVector<Vector2D> sites; ///< Positions of the servers.
+    QString sitesKey; ///< Key of the sites in the tile store, empty after a move.
+    QVector<QRgb> palette; ///< Colour of each cell.
+    QCache<quint64, VoronoiRaster> tiles; ///< Computed tiles, the cost being their size in KiB.
+    TileStore disk; ///< Computed tiles on disk, by configuration of the servers (used by the workers too).
+};
+
+#endif // TILEPYRAMID_H
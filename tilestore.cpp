@@ -0,0 +1,121 @@
+#include "tilestore.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QStandardPaths>
+
+static const char *const fileSuffix = ".png"; ///< Extension of the files (lossless).
+static constexpr int pruneMargin = 8; ///< The directory is pruned when it holds 1/pruneMargin more files than the limit.
+
+/**
+ * @brief Constructs a store.
+ * @param dir The directory of the files, empty for the default one (application cache location).
+ * @param files The number of tiles kept on disk, 0 to disable the store.
+ */
+TileStore::TileStore(const QString &dir, int files)
+    : fileLimit(files) {
+    if (fileLimit > 0) {
+        directory = dir.isEmpty() ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles" : dir;
+        if (!QDir().mkpath(directory)) {
+            directory.clear();  // No disk store
+        } else {
+            fileCount = QDir(directory).entryList({QString("*") + fileSuffix}, QDir::Files).size();
+        }
+    }
+}
+
+/**
+ * @brief Compute the key of a configuration of servers.
+ * @param sites The positions of the servers.
+ * @return The key, a hexadecimal hash.
+ */
+QString TileStore::sitesKey(const QVector<Vector2D> &sites) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const Vector2D &position : sites) {
+        hash.addData(reinterpret_cast<const char*>(&position), sizeof(position));
+    }
+    return QString::fromLatin1(hash.result().toHex().constData());
+}
+
+/**
+ * @brief Get the path of the file of a tile.
+ * @param sites The key of the configuration of servers.
+ * @param tile The key of the tile in the pyramid.
+ * @return The path of the file.
+ */
+QString TileStore::filePath(const QString &sites, quint64 tile) const {
+    return directory + "/" + sites + "-" + QString::number(tile, 16) + fileSuffix;
+}
+
+/**
+ * @brief Read a tile from the directory.
+ *
+ * A file that does not have the format or the size of the tile (e.g. written for
+ * another number of servers) is ignored.
+ *
+ * @param sites The key of the configuration of servers (see sitesKey()).
+ * @param tile The key of the tile in the pyramid.
+ * @param cells The number of servers.
+ * @param size The size of the tile in pixels.
+ * @param origin The world position of the top left pixel of the tile.
+ * @param scale The world size of a pixel of the tile.
+ * @param raster Receives the tile.
+ * @return True if the tile was found.
+ */
+bool TileStore::find(const QString &sites, quint64 tile, int cells, const QSize &size, const Vector2D &origin, float scale, VoronoiRaster &raster) {
+    if (directory.isEmpty()) {
+        return false;
+    }
+    QFile file(filePath(sites, tile));
+    QImage image;
+    if (!file.exists() || !image.load(file.fileName()) || image.size() != size
+        || !raster.fromImage(image, cells, origin, scale)) {
+        return false;
+    }
+    // Mark the file as recently used
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    return true;
+}
+
+/**
+ * @brief Write a computed tile to the directory.
+ *
+ * The files are counted as they are written, and the directory is only listed to be
+ * pruned when it exceeds the limit by a margin: then it is brought back to the limit,
+ * so that it is listed once per limit / pruneMargin new files at most.
+ *
+ * @param sites The key of the configuration of servers (see sitesKey()).
+ * @param tile The key of the tile in the pyramid.
+ * @param raster The tile.
+ */
+void TileStore::insert(const QString &sites, quint64 tile, const VoronoiRaster &raster) {
+    if (directory.isEmpty()) {
+        return;
+    }
+    const QString path = filePath(sites, tile);
+    const bool replaced = QFile::exists(path);  // e.g. a file of another format
+    if (!raster.toImage().save(path) || replaced) {
+        return;
+    }
+    if (fileCount.fetch_add(1, std::memory_order_relaxed) + 1 > fileLimit + fileLimit / pruneMargin && pruning.tryLock()) {
+        pruneDirectory();
+        pruning.unlock();
+    }
+}
+
+/**
+ * @brief Remove the least recently used files beyond the file limit.
+ */
+void TileStore::pruneDirectory() {
+    QList<QFileInfo> files = QDir(directory).entryInfoList({QString("*") + fileSuffix}, QDir::Files, QDir::Time);
+    // Sorted by time, the most recent first
+    for (int i = fileLimit; i < files.size(); i++) {
+        QFile::remove(files[i].absoluteFilePath());
+    }
+    fileCount.store(qMin(fileLimit, int(files.size())), std::memory_order_relaxed);
+}
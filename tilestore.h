@@ -0,0 +1,94 @@
+/**
+ * @file tilestore.h
+ * @brief Directory of the computed tiles of the Voronoi background.
+ *
+ * This file declares the TileStore class, which keeps the tiles of a TilePyramid on
+ * disk, so that reloading a server configuration, also after a restart, does not
+ * compute its tiles again.
+ */
+
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "vector2d.h"
+#include "voronoiraster.h"
+
+/**
+ * @class TileStore
+ * @brief Least recently used directory of tile rasters.
+ *
+ * A tile is stored as the image of its cell indices (see VoronoiRaster::toImage()). Its
+ * file is named after a hash of the positions of the servers and the key of the tile
+ * in the pyramid (level, column and row), so that the tiles of a configuration are
+ * found again whatever the view. The directory is bounded in number of files, the
+ * least recently used files (by modification time, refreshed on each hit) being
+ * removed when it exceeds the limit by a margin.
+ *
+ * The store is used by the worker threads of the pyramid: find() and insert() can be
+ * called from several threads at once, for different tiles.
+ */
+class TileStore {
+public:
+    static constexpr int defaultFileLimit = 4096; ///< Default number of tiles kept on disk.
+
+    /**
+     * @brief Constructs a store.
+     * @param directory The directory of the files, empty for the default one (application cache location).
+     * @param fileLimit The number of tiles kept on disk, 0 to disable the store.
+     */
+    explicit TileStore(const QString &directory = QString(), int fileLimit = defaultFileLimit);
+
+    /**
+     * @brief Compute the key of a configuration of servers.
+     * @param sites The positions of the servers.
+     * @return The key, a hexadecimal hash.
+     */
+    static QString sitesKey(const QVector<Vector2D> &sites);
+
+    /**
+     * @brief Read a tile from the directory.
+     * @param sites The key of the configuration of servers (see sitesKey()).
+     * @param tile The key of the tile in the pyramid.
+     * @param cells The number of servers.
+     * @param size The size of the tile in pixels.
+     * @param origin The world position of the top left pixel of the tile.
+     * @param scale The world size of a pixel of the tile.
+     * @param raster Receives the tile.
+     * @return True if the tile was found.
+     */
+    bool find(const QString &sites, quint64 tile, int cells, const QSize &size, const Vector2D &origin, float scale, VoronoiRaster &raster);
+
+    /**
+     * @brief Write a computed tile to the directory.
+     * @param sites The key of the configuration of servers (see sitesKey()).
+     * @param tile The key of the tile in the pyramid.
+     * @param raster The tile.
+     */
+    void insert(const QString &sites, quint64 tile, const VoronoiRaster &raster);
+
+private:
+    /**
+     * @brief Get the path of the file of a tile.
+     * @param sites The key of the configuration of servers.
+     * @param tile The key of the tile in the pyramid.
+     * @return The path of the file.
+     */
+    QString filePath(const QString &sites, quint64 tile) const;
+
+    /**
+     * @brief Remove the least recently used files beyond the file limit.
+     */
+    void pruneDirectory();
+
+    QString directory; ///< Directory of the files, empty if the store is disabled.
+    int fileLimit; ///< Number of tiles kept on disk.
+    std::atomic<int> fileCount{0}; ///< Number of files in the directory, counted when it is listed and as they are written.
+    QMutex pruning; ///< Held by the thread pruning the directory.
+};
+
+#endif // TILESTORE_H
@@ -0,0 +1,54 @@
+QT       += core gui
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Count every heap allocation of the process (see allocationcounter.h)
+DEFINES += DRONES_COUNT_ALLOCATIONS
+
+INCLUDEPATH += ../.. ../scenariogen
+
+SOURCES += \
+    main.cpp \
+    ../scenariogen/scenariogenerator.cpp \
+    ../../allocationcounter.cpp \
+    ../../collisiongrid.cpp \
+    ../../delaunay.cpp \
+    ../../drone.cpp \
+    ../../droneindex.cpp \
+    ../../droneregistry.cpp \
+    ../../eventscheduler.cpp \
+    ../../framearena.cpp \
+    ../../integrator.cpp \
+    ../../landingscheduler.cpp \
+    ../../noflyzones.cpp \
+    ../../regionmap.cpp \
+    ../../regionshard.cpp \
+    ../../scenario.cpp \
+    ../../server.cpp \
+    ../../simulation.cpp \
+    ../../workerpool.cpp
+
+HEADERS += \
+    ../scenariogen/scenariogenerator.h \
+    ../../allocationcounter.h \
+    ../../collisiongrid.h \
+    ../../delaunay.h \
+    ../../drone.h \
+    ../../droneindex.h \
+    ../../droneregistry.h \
+    ../../eventscheduler.h \
+    ../../flightmodel.h \
+    ../../framearena.h \
+    ../../integrator.h \
+    ../../landingscheduler.h \
+    ../../noflyzones.h \
+    ../../regionmap.h \
+    ../../regionshard.h \
+    ../../scenario.h \
+    ../../server.h \
+    ../../simulation.h \
+    ../../vector2d.h \
+    ../../vector2dbatch.h \
+    ../../workerpool.h
@@ -0,0 +1,120 @@
+/**
+ * @file main.cpp
+ * @brief Command line check that a steady-state simulation step makes no heap allocation.
+ *
+ * A scenario is loaded or generated, all the drones take off, and the simulation runs a
+ * number of warm-up steps, during which the scratch memory, the event queue and the
+ * shards grow to their final size. The next steps must not allocate: every call to
+ * operator new, malloc, calloc or realloc in the process is counted (see
+ * AllocationCounter), and the tool fails if any is made.
+ *
+ * Example:
+ *   alloccheck --drones 5000 --servers 32 --threads 4
+ *   alloccheck --scenario ../../json/config2.json --pads 2 --slots 4
+ *
+ * Exit code: 0 if the steps made no allocation, 2 if they did, 1 on invalid arguments.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "allocationcounter.h"
+#include "scenariogenerator.h"
+#include "simulation.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("alloccheck");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Check that the simulation step makes no heap allocation once warmed up.");
+    parser.addHelpOption();
+
+    ScenarioGenerator::Parameters defaults;
+    QCommandLineOption scenarioOption("scenario", "Scenario file (.json or .dsb); a scenario is generated otherwise.", "file");
+    QCommandLineOption serversOption({"s", "servers"}, "Number of servers of the generated scenario.", "count", QString::number(defaults.serverCount));
+    QCommandLineOption dronesOption({"d", "drones"}, "Number of drones of the generated scenario.", "count", QString::number(defaults.droneCount));
+    QCommandLineOption distributionOption("distribution", "Drone distribution of the generated scenario: uniform, clustered or hotspot.", "name", "hotspot");
+    QCommandLineOption seedOption("seed", "Seed of the generated scenario.", "seed", QString::number(defaults.seed));
+    QCommandLineOption padsOption("pads", "Landing pads given to every server (0 to keep those of the scenario).", "count", "0");
+    QCommandLineOption slotsOption("slots", "Charging slots given to every server, with --pads (0 for unlimited).", "count", "0");
+    QCommandLineOption threadsOption("threads", "Threads of the sharded engine (0 for the single-threaded engine).", "count", "0");
+    QCommandLineOption dtOption("dt", "Duration of a step.", "seconds", "0.02");
+    QCommandLineOption warmupOption("warmup", "Steps run before counting.", "count", "500");
+    QCommandLineOption stepsOption("steps", "Steps counted.", "count", "2000");
+    parser.addOptions({scenarioOption, serversOption, dronesOption, distributionOption, seedOption,
+                       padsOption, slotsOption, threadsOption, dtOption, warmupOption, stepsOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (!AllocationCounter::isEnabled()) {
+        err << "Built without DRONES_COUNT_ALLOCATIONS: the allocations cannot be counted\n";
+        return 1;
+    }
+
+    Scenario scenario;
+    if (parser.isSet(scenarioOption)) {
+        if (!scenario.load(parser.value(scenarioOption))) {
+            err << "Cannot load scenario: " << parser.value(scenarioOption) << "\n";
+            return 1;
+        }
+    } else {
+        ScenarioGenerator::Parameters params;
+        params.serverCount = parser.value(serversOption).toInt();
+        params.droneCount = parser.value(dronesOption).toInt();
+        params.seed = parser.value(seedOption).toUInt();
+        if (!ScenarioGenerator::parseDistribution(parser.value(distributionOption), params.distribution)) {
+            err << "Unknown distribution: " << parser.value(distributionOption) << "\n";
+            return 1;
+        }
+        scenario = ScenarioGenerator(params).generate();
+    }
+    const int pads = parser.value(padsOption).toInt();
+    if (pads > 0) {
+        for (Server &server : scenario.servers) {
+            server.setCapacity(pads, parser.value(slotsOption).toInt());
+        }
+    }
+    const double dt = parser.value(dtOption).toDouble();
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+    const int steps = qMax(1, parser.value(stepsOption).toInt());
+    if (dt <= 0) {
+        err << "Invalid step duration: " << parser.value(dtOption) << "\n";
+        return 1;
+    }
+
+    Simulation simulation;
+    simulation.load(scenario);
+    simulation.setThreadCount(qMax(0, parser.value(threadsOption).toInt()));
+    const DroneRegistry &drones = simulation.getDrones();
+    for (int i = 0; i < drones.size(); i++) {
+        simulation.start(drones.idAt(i));
+    }
+    for (int step = 0; step < warmup; step++) {
+        simulation.step(dt);
+    }
+
+    // Count the allocations step by step, to report the first step that allocates
+    quint64 total = 0;
+    int firstStep = -1;
+    for (int step = 0; step < steps; step++) {
+        const quint64 before = AllocationCounter::count();
+        simulation.step(dt);
+        const quint64 allocations = AllocationCounter::count() - before;
+        if (allocations > 0 && firstStep < 0) {
+            firstStep = warmup + step;
+        }
+        total += allocations;
+    }
+
+    out << drones.size() << " drones, " << warmup << " warm-up steps, " << steps << " steps counted: "
+        << total << " allocations\n";
+    if (total > 0) {
+        out << "FAIL: the first allocating step is step " << firstStep << "\n";
+        return 2;
+    }
+    out << "PASS\n";
+    return 0;
+}
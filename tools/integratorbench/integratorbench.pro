@@ -0,0 +1,49 @@
+QT       += core gui
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../.. ../scenariogen
+
+SOURCES += \
+    main.cpp \
+    ../scenariogen/scenariogenerator.cpp \
+    ../../collisiongrid.cpp \
+    ../../delaunay.cpp \
+    ../../drone.cpp \
+    ../../droneindex.cpp \
+    ../../droneregistry.cpp \
+    ../../eventscheduler.cpp \
+    ../../framearena.cpp \
+    ../../integrator.cpp \
+    ../../landingscheduler.cpp \
+    ../../noflyzones.cpp \
+    ../../regionmap.cpp \
+    ../../regionshard.cpp \
+    ../../scenario.cpp \
+    ../../server.cpp \
+    ../../simulation.cpp \
+    ../../workerpool.cpp
+
+HEADERS += \
+    ../scenariogen/scenariogenerator.h \
+    ../../collisiongrid.h \
+    ../../delaunay.h \
+    ../../drone.h \
+    ../../droneindex.h \
+    ../../droneregistry.h \
+    ../../eventscheduler.h \
+    ../../flightmodel.h \
+    ../../framearena.h \
+    ../../integrator.h \
+    ../../landingscheduler.h \
+    ../../noflyzones.h \
+    ../../regionmap.h \
+    ../../regionshard.h \
+    ../../scenario.h \
+    ../../server.h \
+    ../../simulation.h \
+    ../../vector2d.h \
+    ../../vector2dbatch.h \
+    ../../workerpool.h
@@ -0,0 +1,169 @@
+/**
+ * @file main.cpp
+ * @brief Command line tool measuring the accuracy and cost of the integrators.
+ *
+ * The same scenario is simulated with each integration method and several numbers of
+ * substeps per display tick, and the positions of the drones are compared at every
+ * tick with a reference run (fourth order Runge-Kutta with very small steps).
+ *
+ * Example:
+ *   integratorbench --drones 200 --duration 20 --substeps 1,2,5,10 --target 0.5
+ *   integratorbench --scenario ../../json/config2.json
+ *   integratorbench --drones 5000 --servers 32 --threads 8
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cmath>
+#include "scenariogenerator.h"
+#include "simulation.h"
+
+static constexpr double tickDuration = 0.1; ///< Duration of a display tick in seconds (timer of MainWindow).
+
+/**
+ * @brief Result of a run of the simulation.
+ */
+struct Run {
+    QVector<Vector2D> positions; ///< Positions of the drones at each tick, tick after tick.
+    qint64 nanoseconds = 0; ///< Time spent in the simulation steps.
+};
+
+/**
+ * @brief Simulate a scenario, all the drones taking off at the start.
+ * @param scenario The scenario.
+ * @param method The integration method.
+ * @param substeps The number of steps per tick.
+ * @param ticks The number of ticks to simulate.
+ * @param threads The number of threads of the sharded engine, 0 for the single-threaded engine.
+ * @return The positions of the drones at each tick and the duration of the steps.
+ */
+static Run simulate(const Scenario &scenario, Integrator::Method method, int substeps, int ticks, int threads) {
+    Simulation simulation;
+    simulation.load(scenario);
+    simulation.setIntegrator(method);
+    simulation.setThreadCount(threads);
+    const DroneRegistry &drones = simulation.getDrones();
+    for (int i = 0; i < drones.size(); i++) {
+        simulation.start(drones.idAt(i));
+    }
+
+    Run run;
+    run.positions.reserve(ticks * drones.size());
+    const double dt = tickDuration / substeps;
+    QElapsedTimer timer;
+    for (int tick = 0; tick < ticks; tick++) {
+        timer.start();
+        for (int step = 0; step < substeps; step++) {
+            simulation.step(dt);
+        }
+        run.nanoseconds += timer.nsecsElapsed();
+        for (const Drone &drone : drones) {
+            run.positions.append(drone.getPosition());
+        }
+    }
+    return run;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("integratorbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare the accuracy and cost of the integrators against a fine-step reference.");
+    parser.addHelpOption();
+
+    ScenarioGenerator::Parameters defaults;
+    QCommandLineOption scenarioOption("scenario", "Scenario file (.json or .dsb); a scenario is generated otherwise.", "file");
+    QCommandLineOption serversOption({"s", "servers"}, "Number of servers of the generated scenario.", "count", QString::number(defaults.serverCount));
+    QCommandLineOption dronesOption({"d", "drones"}, "Number of drones of the generated scenario.", "count", QString::number(defaults.droneCount));
+    QCommandLineOption seedOption("seed", "Seed of the generated scenario.", "seed", QString::number(defaults.seed));
+    QCommandLineOption durationOption("duration", "Simulated duration.", "seconds", "20");
+    QCommandLineOption substepsOption("substeps", "Comma separated numbers of substeps per tick to test.", "list", "1,2,5,10");
+    QCommandLineOption referenceOption("reference-substeps", "Substeps per tick of the RK4 reference.", "count", "1000");
+    QCommandLineOption targetOption("target", "Accuracy target: RMS position error.", "pixels", "1");
+    QCommandLineOption threadsOption("threads", "Threads of the sharded engine for the tested runs (0 for the single-threaded engine).", "count", "0");
+    parser.addOptions({scenarioOption, serversOption, dronesOption, seedOption, durationOption,
+                       substepsOption, referenceOption, targetOption, threadsOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    Scenario scenario;
+    if (parser.isSet(scenarioOption)) {
+        if (!scenario.load(parser.value(scenarioOption))) {
+            err << "Cannot load scenario: " << parser.value(scenarioOption) << "\n";
+            return 1;
+        }
+    } else {
+        ScenarioGenerator::Parameters params;
+        params.serverCount = parser.value(serversOption).toInt();
+        params.droneCount = parser.value(dronesOption).toInt();
+        params.seed = parser.value(seedOption).toUInt();
+        scenario = ScenarioGenerator(params).generate();
+    }
+
+    QVector<int> substepList;
+    for (const QString &value : parser.value(substepsOption).split(",")) {
+        int substeps = value.toInt();
+        if (substeps <= 0) {
+            err << "Invalid number of substeps: " << value << "\n";
+            return 1;
+        }
+        substepList.append(substeps);
+    }
+    const int ticks = qMax(1, int(std::lround(parser.value(durationOption).toDouble() / tickDuration)));
+    const int referenceSubsteps = qMax(1, parser.value(referenceOption).toInt());
+    const double target = parser.value(targetOption).toDouble();
+    const int threads = qMax(0, parser.value(threadsOption).toInt());
+
+    out << "Reference: rk4, " << referenceSubsteps << " substeps per tick, " << ticks << " ticks, "
+        << scenario.drones.size() << " drones\n";
+    out.flush();
+    const Run reference = simulate(scenario, Integrator::rungeKutta4, referenceSubsteps, ticks, 0);
+
+    out << qSetFieldWidth(8) << Qt::left << "method" << qSetFieldWidth(10) << Qt::right
+        << "substeps" << "rms err" << "max err" << "ms/tick" << qSetFieldWidth(0) << "\n";
+
+    QString bestName;
+    int bestSubsteps = 0;
+    double bestCost = 0;
+    for (int m = 0; m < Integrator::methodCount; m++) {
+        Integrator::Method method = Integrator::Method(m);
+        for (int substeps : substepList) {
+            const Run run = simulate(scenario, method, substeps, ticks, threads);
+
+            // Position errors over all the drones and all the ticks
+            double sum = 0, maximum = 0;
+            for (int i = 0; i < run.positions.size(); i++) {
+                double error = (run.positions[i] - reference.positions[i]).length();
+                sum += error * error;
+                maximum = qMax(maximum, error);
+            }
+            double rms = run.positions.isEmpty() ? 0 : std::sqrt(sum / run.positions.size());
+            double cost = run.nanoseconds / (1e6 * ticks);
+
+            out << qSetFieldWidth(8) << Qt::left << Integrator::name(method) << qSetFieldWidth(10) << Qt::right
+                << substeps << QString::number(rms, 'g', 4) << QString::number(maximum, 'g', 4)
+                << QString::number(cost, 'f', 3) << qSetFieldWidth(0) << "\n";
+            out.flush();
+
+            if (rms <= target && (bestName.isEmpty() || cost < bestCost)) {
+                bestName = Integrator::name(method);
+                bestSubsteps = substeps;
+                bestCost = cost;
+            }
+        }
+    }
+
+    if (bestName.isEmpty()) {
+        out << "No configuration meets the target of " << target << " pixels\n";
+        return 2;
+    }
+    out << "Cheapest configuration meeting the target of " << target << " pixels: "
+        << bestName << " with " << bestSubsteps << " substeps per tick\n";
+    return 0;
+}
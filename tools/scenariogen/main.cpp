@@ -0,0 +1,68 @@
+/**
+ * @file main.cpp
+ * @brief Command line tool generating synthetic scenarios.
+ *
+ * Example:
+ *   scenariogen --servers 100 --drones 100000 --distribution hotspot --seed 42 big.json
+ * The output format is selected from the extension of the output file (.json or .dsb).
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "scenariogenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("scenariogen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate a reproducible drone scenario (JSON or binary .dsb).");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "Output file (.json or .dsb).");
+
+    ScenarioGenerator::Parameters defaults;
+    QCommandLineOption serversOption({"s", "servers"}, "Number of servers.", "count", QString::number(defaults.serverCount));
+    QCommandLineOption dronesOption({"d", "drones"}, "Number of drones.", "count", QString::number(defaults.droneCount));
+    QCommandLineOption widthOption("width", "Width of the map.", "pixels", QString::number(defaults.width));
+    QCommandLineOption heightOption("height", "Height of the map.", "pixels", QString::number(defaults.height));
+    QCommandLineOption distributionOption("distribution", "Drone distribution: uniform, clustered or hotspot.", "name", "uniform");
+    QCommandLineOption seedOption("seed", "Seed of the random generator.", "seed", QString::number(defaults.seed));
+    QCommandLineOption clustersOption("clusters", "Number of clusters (clustered distribution).", "count", QString::number(defaults.clusterCount));
+    QCommandLineOption spreadOption("spread", "Standard deviation of clusters and hotspot.", "pixels", QString::number(defaults.spread));
+    QCommandLineOption ratioOption("hotspot-ratio", "Part of the fleet around the hotspot server.", "ratio", QString::number(defaults.hotspotRatio));
+    parser.addOptions({serversOption, dronesOption, widthOption, heightOption, distributionOption,
+                       seedOption, clustersOption, spreadOption, ratioOption});
+    parser.process(app);
+
+    QTextStream err(stderr);
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    ScenarioGenerator::Parameters params;
+    params.serverCount = parser.value(serversOption).toInt();
+    params.droneCount = parser.value(dronesOption).toInt();
+    params.width = parser.value(widthOption).toInt();
+    params.height = parser.value(heightOption).toInt();
+    params.seed = parser.value(seedOption).toUInt();
+    params.clusterCount = parser.value(clustersOption).toInt();
+    params.spread = parser.value(spreadOption).toDouble();
+    params.hotspotRatio = parser.value(ratioOption).toDouble();
+    if (!ScenarioGenerator::parseDistribution(parser.value(distributionOption), params.distribution)) {
+        err << "Unknown distribution: " << parser.value(distributionOption) << "\n";
+        return 1;
+    }
+    if (params.serverCount < 0 || params.droneCount < 0 || params.width <= 0 || params.height <= 0) {
+        err << "Invalid scenario size\n";
+        return 1;
+    }
+
+    ScenarioGenerator generator(params);
+    Scenario scenario = generator.generate();
+    if (!scenario.save(parser.positionalArguments().first())) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+QT       += core gui
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    scenariogenerator.cpp \
+    ../../scenario.cpp \
+    ../../server.cpp
+
+HEADERS += \
+    scenariogenerator.h \
+    ../../scenario.h \
+    ../../server.h \
+    ../../vector2d.h
@@ -0,0 +1,125 @@
+#include "scenariogenerator.h"
+#include <cmath>
+
+/**
+ * @brief Constructs a generator.
+ * @param parameters The parameters of the generated scenarios.
+ */
+ScenarioGenerator::ScenarioGenerator(const Parameters &parameters)
+    : params(parameters), random(parameters.seed) {}
+
+/**
+ * @brief Convert a distribution name ("uniform", "clustered", "hotspot").
+ * @param name The name of the distribution.
+ * @param distribution The corresponding distribution.
+ * @return True if the name is known.
+ */
+bool ScenarioGenerator::parseDistribution(const QString &name, Distribution &distribution) {
+    if (name == "uniform") {
+        distribution = uniform;
+    } else if (name == "clustered") {
+        distribution = clustered;
+    } else if (name == "hotspot") {
+        distribution = hotspot;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Draw a position uniformly over the map.
+ * @return The position.
+ */
+Vector2D ScenarioGenerator::uniformPosition() {
+    float x = float(random.generateDouble() * params.width);
+    float y = float(random.generateDouble() * params.height);
+    return Vector2D(x, y);
+}
+
+/**
+ * @brief Draw a position following a normal law around a center.
+ *
+ * The normal law is computed with the Box-Muller transform rather than
+ * std::normal_distribution, whose output depends on the standard library,
+ * so that a seed gives the same scenario on every platform.
+ *
+ * @param center The center of the distribution.
+ * @return The position, clamped to the map.
+ */
+Vector2D ScenarioGenerator::gaussianPosition(const Vector2D &center) {
+    double u1 = 1.0 - random.generateDouble();  // in ]0, 1] to avoid log(0)
+    double u2 = random.generateDouble();
+    double r = params.spread * sqrt(-2.0 * log(u1));
+    return clamp(Vector2D(float(center.x + r * cos(2.0 * M_PI * u2)), float(center.y + r * sin(2.0 * M_PI * u2))));
+}
+
+/**
+ * @brief Clamp a position to the map.
+ * @param p The position.
+ * @return The clamped position.
+ */
+Vector2D ScenarioGenerator::clamp(const Vector2D &p) const {
+    return Vector2D(qBound(0.0f, p.x, float(params.width)), qBound(0.0f, p.y, float(params.height)));
+}
+
+/**
+ * @brief Generate a scenario.
+ *
+ * Servers get evenly spaced hues (golden angle) so that neighboring cells stay
+ * distinguishable, and each drone targets a random server and takes its color.
+ *
+ * @return The generated scenario.
+ */
+Scenario ScenarioGenerator::generate() {
+    random.seed(params.seed);
+    Scenario scenario;
+
+    const int serverDigits = QString::number(qMax(params.serverCount - 1, 0)).size();
+    const int droneDigits = QString::number(qMax(params.droneCount - 1, 0)).size();
+
+    // Servers are spread uniformly over the map
+    scenario.servers.reserve(params.serverCount);
+    for (int i = 0; i < params.serverCount; i++) {
+        QString name = QString("S%1").arg(i, serverDigits, 10, QChar('0'));
+        QColor color = QColor::fromHsl(int(i * 137.508) % 360, 180, 150);
+        scenario.servers.append(Server(name, uniformPosition(), color));
+    }
+
+    // Centers of the clustered distribution
+    QVector<Vector2D> centers;
+    if (params.distribution == clustered) {
+        for (int i = 0; i < params.clusterCount; i++) {
+            centers.append(uniformPosition());
+        }
+    }
+    Vector2D hotspotCenter;
+    if (params.distribution == hotspot && params.serverCount > 0) {
+        hotspotCenter = scenario.servers[random.bounded(params.serverCount)].getPosition();
+    }
+
+    scenario.drones.resize(params.droneCount);
+    for (int i = 0; i < params.droneCount; i++) {
+        DroneSpec &spec = scenario.drones[i];
+        spec.name = QString("D%1").arg(i, droneDigits, 10, QChar('0'));
+
+        switch (params.distribution) {
+        case uniform:
+            spec.position = uniformPosition();
+            break;
+        case clustered:
+            spec.position = centers.isEmpty() ? uniformPosition() : gaussianPosition(centers[random.bounded(int(centers.size()))]);
+            break;
+        case hotspot:
+            spec.position = (params.serverCount > 0 && random.generateDouble() < params.hotspotRatio) ? gaussianPosition(hotspotCenter) : uniformPosition();
+            break;
+        }
+
+        if (params.serverCount > 0) {
+            const Server &server = scenario.servers[random.bounded(params.serverCount)];
+            spec.server = server.getName();
+            spec.color = server.getColor();
+        }
+    }
+    return scenario;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file scenariogenerator.h
+ * @brief Deterministic generator of synthetic scenarios.
+ *
+ * This file declares the ScenarioGenerator class, which creates scenarios with any
+ * number of servers and drones for scale testing. The same parameters (including the
+ * seed) always produce the same scenario.
+ */
+
+#ifndef SCENARIOGENERATOR_H
+#define SCENARIOGENERATOR_H
+
+#include <QRandomGenerator>
+#include "scenario.h"
+
+/**
+ * @class ScenarioGenerator
+ * @brief Generates reproducible scenarios with configurable spatial distributions.
+ *
+ * Servers are spread uniformly over the map. Drones follow one of the following
+ * distributions:
+ * - uniform: drones are spread over the whole map,
+ * - clustered: drones are grouped around random cluster centers,
+ * - hotspot: a part of the fleet is gathered around one server, the rest is uniform.
+ */
+class ScenarioGenerator {
+public:
+    /**
+     * @brief Spatial distribution of the drones.
+     */
+    enum Distribution { uniform, clustered, hotspot };
+
+    /**
+     * @brief Parameters of the generator.
+     */
+    struct Parameters {
+        int serverCount = 10; ///< Number of servers.
+        int droneCount = 100; ///< Number of drones.
+        int width = 1280; ///< Width of the map.
+        int height = 800; ///< Height of the map.
+        Distribution distribution = uniform; ///< Spatial distribution of the drones.
+        quint32 seed = 1; ///< Seed of the random generator.
+        int clusterCount = 8; ///< Number of clusters (clustered distribution).
+        double spread = 50; ///< Standard deviation of clusters and hotspot, in pixels.
+        double hotspotRatio = 0.8; ///< Part of the fleet gathered around the hotspot server.
+    };
+
+    /**
+     * @brief Constructs a generator.
+     * @param parameters The parameters of the generated scenarios.
+     */
+    explicit ScenarioGenerator(const Parameters &parameters);
+
+    /**
+     * @brief Generate a scenario.
+     *
+     * The random generator is reseeded at each call, so that successive calls
+     * return the same scenario.
+     *
+     * @return The generated scenario.
+     */
+    Scenario generate();
+
+    /**
+     * @brief Convert a distribution name ("uniform", "clustered", "hotspot").
+     * @param name The name of the distribution.
+     * @param distribution The corresponding distribution.
+     * @return True if the name is known.
+     */
+    static bool parseDistribution(const QString &name, Distribution &distribution);
+
+private:
+    Parameters params; ///< Parameters of the generator.
+    QRandomGenerator random; ///< Random generator seeded with params.seed.
+
+    /**
+     * @brief Draw a position uniformly over the map.
+     * @return The position.
+     */
+    Vector2D uniformPosition();
+
+    /**
+     * @brief Draw a position following a normal law around a center.
+     * @param center The center of the distribution.
+     * @return The position, clamped to the map.
+     */
+    Vector2D gaussianPosition(const Vector2D &center);
+
+    /**
+     * @brief Clamp a position to the map.
+     * @param p The position.
+     * @return The clamped position.
+     */
+    Vector2D clamp(const Vector2D &p) const;
+};
+
+#endif // SCENARIOGENERATOR_H
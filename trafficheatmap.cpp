@@ -0,0 +1,167 @@
+#include "trafficheatmap.h"
+#include <QColor>
+#include <cmath>
+
+static constexpr int levelsPerOctave = 4; ///< Levels of the overlay per doubling of the stored value.
+static constexpr int minLog = -10; ///< Base 2 logarithm of the smallest stored value drawn (level 1).
+static constexpr double visibleOctaves = 12; ///< Range of densities drawn below the peak, as a power of 2.
+static constexpr double renormalizeLimit = 1 << 20; ///< Weight over which the stored values are renormalised.
+
+/**
+ * @brief Constructs an empty heatmap without grid.
+ * @param workerCount The number of threads of the scatter in addition to the calling thread.
+ */
+TrafficHeatmap::TrafficHeatmap(int workerCount)
+    : pool(workerCount), lanes(workerCount + 1), colors(256) {}
+
+/**
+ * @brief Cover a world area with an empty grid.
+ *
+ * The cells are minCellSize wide, or larger so that a side of the grid has at most
+ * maxResolution cells. The drones outside of the area are not counted.
+ * @param area The world area.
+ */
+void TrafficHeatmap::reset(const QRectF &area) {
+    cellSize = qMax(minCellSize, float(qMax(area.width(), area.height()) / maxResolution));
+    origin = area.topLeft();
+    columns = area.isEmpty() ? 0 : qMin(maxResolution, int(std::ceil(area.width() / cellSize)));
+    rows = area.isEmpty() ? 0 : qMin(maxResolution, int(std::ceil(area.height() / cellSize)));
+    tileColumns = (columns + tileCells - 1) / tileCells;
+
+    const int cells = columns * rows;
+    density.fill(0, cells);
+    for (Lane &lane : lanes) {
+        lane.counts.fill(0, cells);
+        lane.touched.resize(0);
+    }
+    dirtyTiles.fill(1, tileColumns * ((rows + tileCells - 1) / tileCells));
+    image = QImage(qMax(1, columns), qMax(1, rows), QImage::Format_Indexed8);
+    weight = 1;
+    peak = 0;
+}
+
+/**
+ * @brief Count the drones in the air after a step, and decay the previous counts.
+ *
+ * Each range of drones is counted by one task of the pool in its own grid; the counts
+ * of the touched cells are then added to the density on the calling thread, scaled
+ * by the weight, and reset to zero for the next step.
+ *
+ * @param first The first drone.
+ * @param last The end of the drones.
+ * @param dt The duration of the step in seconds.
+ */
+void TrafficHeatmap::accumulate(const Drone *first, const Drone *last, double dt) {
+    if (columns == 0 || rows == 0) {
+        return;
+    }
+    weight *= std::exp2(dt / halfLife);
+    if (weight > renormalizeLimit) {
+        renormalize();
+    }
+
+    const int count = int(last - first);
+    const int laneCount = lanes.size();
+    const int chunk = (count + laneCount - 1) / laneCount;
+    for (Lane &lane : lanes) {
+        if (lane.touched.capacity() < chunk) {
+            lane.touched.reserve(chunk);  // Only grows with the fleet
+        }
+    }
+
+    const float inverseCell = 1 / cellSize;
+    const float left = float(origin.x()), top = float(origin.y());
+    auto scatter = [&](int index) {
+        Lane &lane = lanes[index];
+        quint32 *counts = lane.counts.data();
+        const Drone *end = first + qMin(count, (index + 1) * chunk);
+        for (const Drone *it = first + qMin(count, index * chunk); it < end; ++it) {
+            if (it->getStatus() == Drone::landed) {
+                continue;
+            }
+            const int column = int(std::floor((it->getPosition().x - left) * inverseCell));
+            const int row = int(std::floor((it->getPosition().y - top) * inverseCell));
+            if (column < 0 || column >= columns || row < 0 || row >= rows) {
+                continue;
+            }
+            const int cell = row * columns + column;
+            if (counts[cell]++ == 0) {
+                lane.touched.append(cell);
+            }
+        }
+    };
+    pool.run(laneCount, scatter);
+
+    const float increment = float(dt * weight);
+    for (Lane &lane : lanes) {
+        quint32 *counts = lane.counts.data();
+        for (int cell : lane.touched) {
+            float &value = density[cell];
+            value += counts[cell] * increment;
+            peak = qMax(peak, value);
+            counts[cell] = 0;
+            dirtyTiles[(cell / columns / tileCells) * tileColumns + (cell % columns) / tileCells] = 1;
+        }
+        lane.touched.resize(0);  // Keeps the capacity
+    }
+}
+
+/**
+ * @brief Get the overlay, quantizing the tiles that changed since the last call.
+ * @return An indexed image with one pixel per cell, to draw over area().
+ */
+const QImage &TrafficHeatmap::overlay() {
+    const float *values = density.constData();
+    for (int tile = 0; tile < dirtyTiles.size(); tile++) {
+        if (!dirtyTiles[tile]) {
+            continue;
+        }
+        dirtyTiles[tile] = 0;
+        const int x0 = (tile % tileColumns) * tileCells, y0 = (tile / tileColumns) * tileCells;
+        const int x1 = qMin(columns, x0 + tileCells), y1 = qMin(rows, y0 + tileCells);
+        for (int y = y0; y < y1; y++) {
+            uchar *line = image.scanLine(y);
+            for (int x = x0; x < x1; x++) {
+                const float value = values[y * columns + x];
+                // Level 0 is empty, level 1 starts at 2^minLog
+                const int level = value > 0 ? int(std::floor(levelsPerOctave * (std::log2(value) - minLog))) + 1 : 0;
+                line[x] = uchar(qBound(0, level, 255));
+            }
+        }
+    }
+    updatePalette();
+    return image;
+}
+
+/**
+ * @brief Divide the stored values by the weight, and reset the weight to 1.
+ *
+ * All the levels change, so the whole overlay is quantized again.
+ */
+void TrafficHeatmap::renormalize() {
+    const float scale = float(1 / weight);
+    for (float &value : density) {
+        value *= scale;
+    }
+    peak *= scale;
+    weight = 1;
+    dirtyTiles.fill(1);
+}
+
+/**
+ * @brief Compute the colour of each level for the current weight and peak.
+ *
+ * The densities from the peak down to visibleOctaves below it are drawn from red to
+ * blue, more transparent as they are lower; the lower ones are not drawn.
+ */
+void TrafficHeatmap::updatePalette() {
+    colors[0] = qRgba(0, 0, 0, 0);
+    const double offset = std::log2(weight);  // Logarithm of the stored value of a density of 1
+    const double top = peak > 0 ? std::log2(peak) - offset : 0;
+    for (int level = 1; level < 256; level++) {
+        const double density = (level - 0.5) / levelsPerOctave + minLog - offset;  // Middle of the level
+        const double heat = qMin(1.0, (density - top) / visibleOctaves + 1);
+        colors[level] = heat <= 0 ? qRgba(0, 0, 0, 0) : QColor::fromHsvF(0.66 * (1 - heat), 1, 1, 0.25 + 0.5 * heat).rgba();
+    }
+    image.setColorTable(colors);
+}
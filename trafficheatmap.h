@@ -0,0 +1,129 @@
+/**
+ * @file trafficheatmap.h
+ * @brief Decaying density of the drones in the air, accumulated at each step.
+ *
+ * This file declares the TrafficHeatmap class, which counts the flying drones of each
+ * cell of a grid over the map at each step, and gives the counts, with an exponential
+ * decay, as a colour-mapped overlay for the canvas.
+ */
+
+#ifndef TRAFFICHEATMAP_H
+#define TRAFFICHEATMAP_H
+
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <QThread>
+#include <QVector>
+#include "drone.h"
+#include "workerpool.h"
+
+/**
+ * @class TrafficHeatmap
+ * @brief Grid of drone-seconds in the air, with exponential decay, and its overlay.
+ *
+ * accumulate() scatters the drones in parallel: the drones are split in one range per
+ * thread of a WorkerPool, each range counted in its own grid, with the list of the cells
+ * it touched. The counts are then merged into the density of the touched cells only, so
+ * that an update costs the number of drones and not the size of the grid.
+ *
+ * The decay is not applied to the cells. The density of a cell is its stored value
+ * divided by a weight that grows by a factor of 2 every half-life, the new counts being
+ * multiplied by the weight; when the weight gets too large, all the cells are divided
+ * by it once.
+ *
+ * The overlay is an indexed image with one pixel per cell, holding the logarithm of the
+ * stored value in levelsPerOctave steps per doubling. The decay and the normalisation by
+ * the densest cell only change the colour table, so only the tiles of tileCells cells
+ * that received drones are quantized again by overlay().
+ */
+class TrafficHeatmap {
+public:
+    static constexpr int maxResolution = 512; ///< Maximum number of cells of a side of the grid.
+    static constexpr float minCellSize = 16; ///< Minimum side of a cell in world units.
+    static constexpr int tileCells = 32; ///< Side of the tiles of the overlay, in cells.
+    static constexpr double defaultHalfLife = 20; ///< Default half-life of the density, in simulated seconds.
+
+    /**
+     * @brief Constructs an empty heatmap without grid.
+     * @param workerCount The number of threads of the scatter in addition to the calling thread.
+     */
+    explicit TrafficHeatmap(int workerCount = qMax(0, QThread::idealThreadCount() - 1));
+
+    /**
+     * @brief Cover a world area with an empty grid.
+     *
+     * The cells are minCellSize wide, or larger so that a side of the grid has at most
+     * maxResolution cells. The drones outside of the area are not counted.
+     * @param area The world area.
+     */
+    void reset(const QRectF &area);
+
+    /**
+     * @brief Set the time in which the density of a cell is halved.
+     * @param seconds The half-life in simulated seconds.
+     */
+    inline void setHalfLife(double seconds) { halfLife = seconds; }
+
+    /**
+     * @brief Count the drones in the air after a step, and decay the previous counts.
+     * @param first The first drone.
+     * @param last The end of the drones.
+     * @param dt The duration of the step in seconds.
+     */
+    void accumulate(const Drone *first, const Drone *last, double dt);
+
+    /**
+     * @brief Get the world area of the grid.
+     * @return The area, empty before reset().
+     */
+    inline QRectF area() const { return QRectF(origin, QSizeF(columns * cellSize, rows * cellSize)); }
+
+    /**
+     * @brief Check if no drone was counted since reset().
+     * @return True if the density is zero everywhere.
+     */
+    inline bool isEmpty() const { return peak == 0; }
+
+    /**
+     * @brief Get the overlay, quantizing the tiles that changed since the last call.
+     * @return An indexed image with one pixel per cell, to draw over area().
+     */
+    const QImage &overlay();
+
+private:
+    /**
+     * @brief Counts of the drones of one range of the scatter.
+     */
+    struct Lane {
+        QVector<quint32> counts; ///< Number of drones in each cell, zero outside of a scatter.
+        QVector<int> touched; ///< Cells whose count is not zero.
+    };
+
+    /**
+     * @brief Divide the stored values by the weight, and reset the weight to 1.
+     */
+    void renormalize();
+
+    /**
+     * @brief Compute the colour of each level for the current weight and peak.
+     */
+    void updatePalette();
+
+    WorkerPool pool; ///< Threads of the scatter.
+    QVector<Lane> lanes; ///< Counts of each range of drones.
+    QVector<float> density; ///< Stored value of each cell, the density multiplied by the weight.
+    QVector<quint8> dirtyTiles; ///< True for the tiles of the overlay whose cells changed.
+    QImage image; ///< Overlay, one level per cell.
+    QVector<QRgb> colors; ///< Colour of each level.
+    QPointF origin; ///< World position of the top left corner of the grid.
+    float cellSize = minCellSize; ///< Side of a cell in world units.
+    int columns = 0; ///< Number of columns of the grid.
+    int rows = 0; ///< Number of rows of the grid.
+    int tileColumns = 0; ///< Number of columns of tiles.
+    double weight = 1; ///< Factor of the stored values, 2^(t / halfLife) since the last renormalisation.
+    float peak = 0; ///< Largest stored value.
+    double halfLife = defaultHalfLife; ///< Time in which the density is halved, in seconds.
+};
+
+#endif // TRAFFICHEATMAP_H
@@ -3,48 +3,62 @@
  * @author B.Piranda
  * @date Dec. 2024
  *
- * This file defines the Vector2D class that represents a 2D vector.
+ * This file defines the Vector2DT class template that represents a 2D vector.
  * It includes various vector operations such as addition, scalar multiplication,
  * dot product, and orthogonal normalization.
+ *
+ * The class is header-only and every operation that does not need a square root is
+ * constexpr, so that the compiler can inline and fold them in the simulation loops.
+ * Vector2D (float components) is the type used by the simulation; Vector2Dd
+ * (double components) can be used where extra precision is needed.
  */
 
 #ifndef VECTOR2D_H
 #define VECTOR2D_H
 
 #include <cmath>
+#include <type_traits>
 
 /**
- * @class Vector2D
- * @brief A class representing a 2D vector with basic vector operations.
+ * @class Vector2DT
+ * @brief A class template representing a 2D vector with basic vector operations.
  *
  * This class provides various methods to manipulate 2D vectors, including operations like
  * length calculation, normalization, and orthogonal vector generation.
+ * Scalars have the type of the components, so that no float/double conversion
+ * happens in the arithmetic operators.
+ *
+ * @tparam T The type of the components (float or double).
  */
-class Vector2D {
+template <typename T>
+class Vector2DT {
+    static_assert(std::is_floating_point<T>::value, "Vector2DT requires a floating point type");
+
 public:
-    float x, y; ///< Coordinates of the vector
+    T x, y; ///< Coordinates of the vector
 
     /**
-     * @brief Constructs a Vector2D with specified x and y components.
+     * @brief Constructs a Vector2DT with specified x and y components.
      *
      * @param p_x The x component of the vector.
      * @param p_y The y component of the vector.
      */
-    Vector2D(float p_x, float p_y) : x(p_x), y(p_y) {}
+    constexpr Vector2DT(T p_x, T p_y) : x(p_x), y(p_y) {}
 
     /**
-     * @brief Default constructor for Vector2D.
+     * @brief Default constructor for Vector2DT.
      *
      * Initializes the vector to (0, 0).
      */
-    Vector2D() : x(0), y(0) {}
+    constexpr Vector2DT() : x(0), y(0) {}
 
     /**
-     * @brief Copy constructor for Vector2D.
+     * @brief Conversion from a vector with another component type.
      *
-     * @param p The vector to copy.
+     * @param v The vector to convert.
      */
-    Vector2D(const Vector2D &p) : x(p.x), y(p.y) {}
+    template <typename U>
+    constexpr explicit Vector2DT(const Vector2DT<U> &v) : x(T(v.x)), y(T(v.y)) {}
 
     /**
      * @brief Set the components of the vector.
@@ -52,7 +66,19 @@ public:
      * @param p_x The new x component.
      * @param p_y The new y component.
      */
-    void set(float p_x, float p_y) { x = p_x; y = p_y; }
+    constexpr void set(T p_x, T p_y) { x = p_x; y = p_y; }
+
+    /**
+     * @brief Get the squared length of the vector.
+     *
+     * This method avoids the square root of length() and should be preferred
+     * for distance comparisons.
+     *
+     * @return The squared length of the vector.
+     */
+    constexpr T lengthSquared() const {
+        return x * x + y * y;
+    }
 
     /**
      * @brief Get the length (or norm) of the vector.
@@ -61,8 +87,18 @@ public:
      *
      * @return The length of the vector.
      */
-    double length() const {
-        return sqrt(x * x + y * y);
+    T length() const {
+        return std::sqrt(lengthSquared());
+    }
+
+    /**
+     * @brief Get the squared distance to another point.
+     *
+     * @param v The other point.
+     * @return The squared distance between the two points.
+     */
+    constexpr T distanceSquared(const Vector2DT &v) const {
+        return (v.x - x) * (v.x - x) + (v.y - y) * (v.y - y);
     }
 
     /**
@@ -72,9 +108,9 @@ public:
      * but with a length (norm) of 1.
      */
     void normalize() {
-        float l = float(length());
-        x /= l;
-        y /= l;
+        T l = T(1) / length();
+        x *= l;
+        y *= l;
     }
 
     /**
@@ -85,9 +121,9 @@ public:
      *
      * @return An orthogonal and normalized vector.
      */
-    Vector2D orthoNormed() const {
-        float l = float(length());
-        return Vector2D(y / l, -x / l);
+    Vector2DT orthoNormed() const {
+        T l = T(1) / length();
+        return Vector2DT(y * l, -x * l);
     }
 
     /**
@@ -96,7 +132,7 @@ public:
      * @param i The index (0 for x, 1 for y).
      * @return The x component if i is 0, otherwise the y component.
      */
-    float operator[](const int i) const {
+    constexpr T operator[](const int i) const {
         return (i == 0) ? x : y;
     }
 
@@ -106,112 +142,178 @@ public:
      * This method adds the components of another vector to the current vector.
      *
      * @param v The vector to add.
+     * @return A reference to this vector.
      */
-    void operator+=(const Vector2D& v) {
+    constexpr Vector2DT &operator+=(const Vector2DT &v) {
         x += v.x;
         y += v.y;
+        return *this;
     }
 
-    // Friend operators
-    friend double operator*(const Vector2D &, const Vector2D &);
-    friend const Vector2D operator*(double, const Vector2D &);
-    friend const Vector2D operator+(const Vector2D &, const Vector2D &);
-    friend const Vector2D operator-(const Vector2D &, const Vector2D &);
-    friend const Vector2D operator-(const Vector2D &);
-    friend double operator^(const Vector2D &, const Vector2D &);
-    friend bool operator==(const Vector2D &, const Vector2D &);
-    friend bool operator!=(const Vector2D &, const Vector2D &);
-};
+    /**
+     * @brief Subtract another vector from this vector.
+     *
+     * @param v The vector to subtract.
+     * @return A reference to this vector.
+     */
+    constexpr Vector2DT &operator-=(const Vector2DT &v) {
+        x -= v.x;
+        y -= v.y;
+        return *this;
+    }
 
-// Friend operator declarations
+    /**
+     * @brief Multiply this vector by a scalar.
+     *
+     * @param a The scalar value.
+     * @return A reference to this vector.
+     */
+    constexpr Vector2DT &operator*=(T a) {
+        x *= a;
+        y *= a;
+        return *this;
+    }
 
-/**
- * @brief Scalar multiplication of a vector.
- *
- * Multiplies a vector by a scalar (a real number).
- *
- * @param a The scalar value.
- * @param v The vector to multiply.
- * @return A new vector that is the result of the scalar multiplication.
- */
-const Vector2D operator*(double a, const Vector2D &v);
+    /**
+     * @brief Fused scaled addition: adds a * v to this vector.
+     *
+     * This is the operation of an explicit integration step (position += dt * V)
+     * without building the temporary vector a * v.
+     *
+     * @param a The scalar value.
+     * @param v The vector to scale and add.
+     * @return A reference to this vector.
+     */
+    constexpr Vector2DT &addScaled(T a, const Vector2DT &v) {
+        x += a * v.x;
+        y += a * v.y;
+        return *this;
+    }
 
-/**
- * @brief Dot product of two vectors.
- *
- * Calculates the dot product of two vectors, which is the sum of the products
- * of their corresponding components.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return The dot product of the two vectors.
- */
-double operator*(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Fused linear combination: sets this vector to a * this + b * v.
+     *
+     * @param a The scalar applied to this vector.
+     * @param b The scalar applied to v.
+     * @param v The other vector.
+     * @return A reference to this vector.
+     */
+    constexpr Vector2DT &scaleAndAdd(T a, T b, const Vector2DT &v) {
+        x = a * x + b * v.x;
+        y = a * y + b * v.y;
+        return *this;
+    }
 
-/**
- * @brief Addition of two vectors.
- *
- * Adds the components of two vectors and returns a new vector as the result.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return The resulting vector from adding u and v.
- */
-const Vector2D operator+(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Scalar multiplication of a vector.
+     *
+     * Multiplies a vector by a scalar (a real number).
+     *
+     * @param a The scalar value.
+     * @param v The vector to multiply.
+     * @return A new vector that is the result of the scalar multiplication.
+     */
+    friend constexpr Vector2DT operator*(T a, const Vector2DT &v) {
+        return Vector2DT(a * v.x, a * v.y);
+    }
 
-/**
- * @brief Subtraction of two vectors.
- *
- * Subtracts the components of one vector from another and returns a new vector.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return The resulting vector from subtracting v from u.
- */
-const Vector2D operator-(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Dot product of two vectors.
+     *
+     * Calculates the dot product of two vectors, which is the sum of the products
+     * of their corresponding components.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return The dot product of the two vectors.
+     */
+    friend constexpr T operator*(const Vector2DT &u, const Vector2DT &v) {
+        return u.x * v.x + u.y * v.y;
+    }
 
-/**
- * @brief Negation of a vector.
- *
- * Returns a new vector that is the negation of the current vector (flips its direction).
- *
- * @param v The vector to negate.
- * @return The negated vector.
- */
-const Vector2D operator-(const Vector2D &v);
+    /**
+     * @brief Addition of two vectors.
+     *
+     * Adds the components of two vectors and returns a new vector as the result.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return The resulting vector from adding u and v.
+     */
+    friend constexpr Vector2DT operator+(const Vector2DT &u, const Vector2DT &v) {
+        return Vector2DT(u.x + v.x, u.y + v.y);
+    }
 
-/**
- * @brief Cross product of two vectors.
- *
- * Calculates the 2D cross product of two vectors, which is the determinant of the
- * matrix formed by the vectors.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return The result of the cross product (a scalar value).
- */
-double operator^(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Subtraction of two vectors.
+     *
+     * Subtracts the components of one vector from another and returns a new vector.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return The resulting vector from subtracting v from u.
+     */
+    friend constexpr Vector2DT operator-(const Vector2DT &u, const Vector2DT &v) {
+        return Vector2DT(u.x - v.x, u.y - v.y);
+    }
 
-/**
- * @brief Equality comparison of two vectors.
- *
- * Checks if two vectors are equal by comparing their components.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return True if the vectors are equal, false otherwise.
- */
-bool operator==(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Negation of a vector.
+     *
+     * Returns a new vector that is the negation of the current vector (flips its direction).
+     *
+     * @param v The vector to negate.
+     * @return The negated vector.
+     */
+    friend constexpr Vector2DT operator-(const Vector2DT &v) {
+        return Vector2DT(-v.x, -v.y);
+    }
 
-/**
- * @brief Inequality comparison of two vectors.
- *
- * Checks if two vectors are not equal by comparing their components.
- *
- * @param u The first vector.
- * @param v The second vector.
- * @return True if the vectors are not equal, false otherwise.
- */
-bool operator!=(const Vector2D &u, const Vector2D &v);
+    /**
+     * @brief Cross product of two vectors.
+     *
+     * Calculates the 2D cross product of two vectors, which is the determinant of the
+     * matrix formed by the vectors.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return The result of the cross product (a scalar value).
+     */
+    friend constexpr T operator^(const Vector2DT &u, const Vector2DT &v) {
+        return u.x * v.y - u.y * v.x;
+    }
+
+    /**
+     * @brief Equality comparison of two vectors.
+     *
+     * Checks if two vectors are equal by comparing their components.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return True if the vectors are equal, false otherwise.
+     */
+    friend constexpr bool operator==(const Vector2DT &u, const Vector2DT &v) {
+        return u.x == v.x && u.y == v.y;
+    }
+
+    /**
+     * @brief Inequality comparison of two vectors.
+     *
+     * Checks if two vectors are not equal by comparing their components.
+     *
+     * @param u The first vector.
+     * @param v The second vector.
+     * @return True if the vectors are not equal, false otherwise.
+     */
+    friend constexpr bool operator!=(const Vector2DT &u, const Vector2DT &v) {
+        return !(u == v);
+    }
+};
+
+using Vector2D = Vector2DT<float>; ///< Vector with float components, used by the simulation.
+using Vector2Dd = Vector2DT<double>; ///< Vector with double components.
+
+static_assert(sizeof(Vector2D) == 2 * sizeof(float), "Vector2D must be two packed floats");
+static_assert(std::is_trivially_copyable<Vector2D>::value, "Vector2D must be trivially copyable");
 
 #endif // VECTOR2D_H
@@ -0,0 +1,225 @@
+/**
+ * @file vector2dbatch.h
+ * @brief Batch operations over arrays of 2D vectors.
+ *
+ * This file defines functions that apply the same operation to a contiguous range of
+ * vectors (pointer and count). The float versions use SSE or AVX kernels when the
+ * compiler targets these instruction sets, and fall back to scalar code otherwise.
+ * Vector2D being two packed floats, a range of n vectors is processed as 2n floats.
+ */
+
+#ifndef VECTOR2DBATCH_H
+#define VECTOR2DBATCH_H
+
+#include <cstddef>
+#include <type_traits>
+#include "vector2d.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define VECTOR2D_BATCH_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VECTOR2D_BATCH_SSE
+#endif
+
+namespace Vector2DBatch {
+
+/**
+ * @brief Add a range of vectors to another: dst[i] += src[i].
+ * @param dst The vectors to modify.
+ * @param src The vectors to add.
+ * @param n The number of vectors.
+ */
+template <typename T>
+inline void add(Vector2DT<T> *dst, const Vector2DT<T> *src, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        dst[i] += src[i];
+    }
+}
+
+/**
+ * @brief Multiply a range of vectors by a scalar: v[i] *= a.
+ * @param v The vectors to modify.
+ * @param a The scalar value.
+ * @param n The number of vectors.
+ */
+template <typename T>
+inline void scale(Vector2DT<T> *v, typename std::common_type<T>::type a, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        v[i] *= a;
+    }
+}
+
+/**
+ * @brief Fused scaled addition over a range: dst[i] += a * src[i].
+ * @param dst The vectors to modify.
+ * @param a The scalar value.
+ * @param src The vectors to scale and add.
+ * @param n The number of vectors.
+ */
+template <typename T>
+inline void addScaled(Vector2DT<T> *dst, typename std::common_type<T>::type a, const Vector2DT<T> *src, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        dst[i].addScaled(a, src[i]);
+    }
+}
+
+/**
+ * @brief Squared distances from a range of points to one point: out[i] = |v[i] - p|².
+ * @param v The points.
+ * @param n The number of points.
+ * @param p The reference point.
+ * @param out The n squared distances.
+ */
+template <typename T>
+inline void distanceSquared(const Vector2DT<T> *v, std::size_t n, const Vector2DT<T> &p, T *out) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = v[i].distanceSquared(p);
+    }
+}
+
+#if defined(VECTOR2D_BATCH_AVX)
+
+inline void add(Vector2D *dst, const Vector2D *src, std::size_t n) {
+    float *d = &dst->x;
+    const float *s = &src->x;
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_loadu_ps(d + i), _mm256_loadu_ps(s + i)));
+    }
+    for (; i < count; i++) {
+        d[i] += s[i];
+    }
+}
+
+inline void scale(Vector2D *v, float a, std::size_t n) {
+    float *d = &v->x;
+    const __m256 va = _mm256_set1_ps(a);
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_mul_ps(_mm256_loadu_ps(d + i), va));
+    }
+    for (; i < count; i++) {
+        d[i] *= a;
+    }
+}
+
+inline void addScaled(Vector2D *dst, float a, const Vector2D *src, std::size_t n) {
+    float *d = &dst->x;
+    const float *s = &src->x;
+    const __m256 va = _mm256_set1_ps(a);
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(d + i, _mm256_add_ps(_mm256_loadu_ps(d + i), _mm256_mul_ps(va, _mm256_loadu_ps(s + i))));
+    }
+    for (; i < count; i++) {
+        d[i] += a * s[i];
+    }
+}
+
+inline void distanceSquared(const Vector2D *v, std::size_t n, const Vector2D &p, float *out) {
+    const float *s = &v->x;
+    const __m256 vp = _mm256_setr_ps(p.x, p.y, p.x, p.y, p.x, p.y, p.x, p.y);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 a = _mm256_sub_ps(_mm256_loadu_ps(s + 2 * i), vp);  // v0 v1 | v2 v3
+        __m256 b = _mm256_sub_ps(_mm256_loadu_ps(s + 2 * i + 8), vp);  // v4 v5 | v6 v7
+        a = _mm256_mul_ps(a, a);
+        b = _mm256_mul_ps(b, b);
+        // Regroup the 128-bit lanes so that the in-lane shuffles keep the vector order
+        __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);  // v0 v1 | v4 v5
+        __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);  // v2 v3 | v6 v7
+        __m256 xs = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 ys = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(xs, ys));
+    }
+    for (; i < n; i++) {
+        out[i] = v[i].distanceSquared(p);
+    }
+}
+
+#elif defined(VECTOR2D_BATCH_SSE)
+
+inline void add(Vector2D *dst, const Vector2D *src, std::size_t n) {
+    float *d = &dst->x;
+    const float *s = &src->x;
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(d + i), _mm_loadu_ps(s + i)));
+    }
+    for (; i < count; i++) {
+        d[i] += s[i];
+    }
+}
+
+inline void scale(Vector2D *v, float a, std::size_t n) {
+    float *d = &v->x;
+    const __m128 va = _mm_set1_ps(a);
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(d + i, _mm_mul_ps(_mm_loadu_ps(d + i), va));
+    }
+    for (; i < count; i++) {
+        d[i] *= a;
+    }
+}
+
+inline void addScaled(Vector2D *dst, float a, const Vector2D *src, std::size_t n) {
+    float *d = &dst->x;
+    const float *s = &src->x;
+    const __m128 va = _mm_set1_ps(a);
+    std::size_t count = 2 * n, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(d + i, _mm_add_ps(_mm_loadu_ps(d + i), _mm_mul_ps(va, _mm_loadu_ps(s + i))));
+    }
+    for (; i < count; i++) {
+        d[i] += a * s[i];
+    }
+}
+
+inline void distanceSquared(const Vector2D *v, std::size_t n, const Vector2D &p, float *out) {
+    const float *s = &v->x;
+    const __m128 vp = _mm_setr_ps(p.x, p.y, p.x, p.y);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_sub_ps(_mm_loadu_ps(s + 2 * i), vp);  // v0 v1
+        __m128 b = _mm_sub_ps(_mm_loadu_ps(s + 2 * i + 4), vp);  // v2 v3
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 xs = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ys = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_add_ps(xs, ys));
+    }
+    for (; i < n; i++) {
+        out[i] = v[i].distanceSquared(p);
+    }
+}
+
+#endif
+
+/**
+ * @brief Index of the point of a range that is the closest to p.
+ * @param v The points.
+ * @param n The number of points.
+ * @param p The reference point.
+ * @param out Scratch buffer of n values receiving the squared distances.
+ * @return The index of the closest point, or -1 if the range is empty.
+ */
+template <typename T>
+inline int nearest(const Vector2DT<T> *v, std::size_t n, const Vector2DT<T> &p, T *out) {
+    distanceSquared(v, n, p, out);
+    int best = -1;
+    T bestDistance = T(0);
+    for (std::size_t i = 0; i < n; i++) {
+        if (best < 0 || out[i] < bestDistance) {
+            bestDistance = out[i];
+            best = int(i);
+        }
+    }
+    return best;
+}
+
+} // namespace Vector2DBatch
+
+#endif // VECTOR2DBATCH_H
@@ -35,14 +35,14 @@ QColor Voronoi::getColorForPoint(const Vector2D &point) {
 
     // Iterate over all servers to find the closest one
     for (const Server &server : servers) {
-        double distance = (server.getPosition() - point).length();  ///< Calculate the distance from the server to the point
+        double distance = server.getPosition().distanceSquared(point);  ///< Calculate the squared distance from the server to the point
         if (distance < minDistance) {
             minDistance = distance;  ///< Update the minimum distance
             color = server.getColor();  ///< Update the color with the closest server's color
 
             // Adjust the lightness of the color based on the distance
             int lightness = color.lightness();  ///< Get the current lightness of the color
-            if (distance < 50) {
+            if (distance < 50 * 50) {
                 lightness += 20;  ///< Lighten the color if the distance is small (closer to the server)
             } else {
                 lightness -= 10;  ///< Darken the color if the distance is larger
@@ -0,0 +1,147 @@
+#include "voronoiraster.h"
+#include "vector2dbatch.h"
+
+/**
+ * @brief Compute the cell of each pixel.
+ * @param sites The positions of the servers, indexed like the cells.
+ * @param size The size of the raster.
+ * @param origin The world position of the top left pixel.
+ * @param scale The world size of a pixel.
+ */
+void VoronoiRaster::render(const QVector<Vector2D> &sites, const QSize &size, const Vector2D &origin, float scale) {
+    worldOrigin = origin;
+    worldScale = scale;
+    cellCount = sites.size();
+    wide = cellCount > 256;
+    ids = QImage(size, formatFor(cellCount));
+    if (cellCount == 0) {
+        ids.fill(0);
+        return;
+    }
+    QVector<float> distances(cellCount);
+    for (int y = 0; y < size.height(); y++) {
+        uchar *row = ids.scanLine(y);
+        for (int x = 0; x < size.width(); x++) {
+            const Vector2D p = origin + scale * Vector2D(float(x), float(y));
+            int nearest = Vector2DBatch::nearest(sites.constData(), sites.size(), p, distances.data());
+            if (wide) {
+                reinterpret_cast<quint16*>(row)[x] = quint16(nearest);
+            } else {
+                row[x] = uchar(nearest);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Update the cells of an area after a site moved.
+ *
+ * The nearest site of a pixel outside of the moved cell can only change to the moved
+ * site, and the pixels of the moved cell can only go to the moved site or to one of
+ * its neighbours (those of its old position), so each pixel is compared with a few
+ * sites instead of all of them.
+ *
+ * @param sites The positions of the servers, with the new position of the moved site.
+ * @param moved The index of the moved site.
+ * @param candidates The sites that can take the pixels of the old cell (its neighbours).
+ * @param area The area to update, in world coordinates.
+ */
+void VoronoiRaster::moveSite(const QVector<Vector2D> &sites, int moved, const QVector<int> &candidates, const QRectF &area) {
+    // Pixels of the area, with one pixel of margin for the rounding
+    const QRectF pixels((area.left() - worldOrigin.x) / worldScale, (area.top() - worldOrigin.y) / worldScale,
+                        area.width() / worldScale, area.height() / worldScale);
+    const QRectF inside = pixels.intersected(QRectF(-1, -1, ids.width() + 2, ids.height() + 2));  // No int overflow
+    if (inside.isEmpty() || sites.size() != cellCount) {
+        return;
+    }
+    const QRect rect = inside.toAlignedRect().adjusted(-1, -1, 1, 1).intersected(ids.rect());
+    const Vector2D site = sites[moved];
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        uchar *row = ids.scanLine(y);
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            const Vector2D p = worldOrigin + worldScale * Vector2D(float(x), float(y));
+            int cell = wide ? reinterpret_cast<quint16*>(row)[x] : row[x];
+            float best = p.distanceSquared(site);
+            int nearest = moved;
+            if (cell == moved) {
+                for (int c : candidates) {
+                    float d = p.distanceSquared(sites[c]);
+                    if (d < best || (d == best && c < nearest)) {
+                        best = d;
+                        nearest = c;
+                    }
+                }
+            } else {
+                float d = p.distanceSquared(sites[cell]);
+                if (d < best || (d == best && cell < moved)) {
+                    nearest = cell;
+                }
+            }
+            if (nearest == cell) {
+                continue;
+            }
+            if (wide) {
+                reinterpret_cast<quint16*>(row)[x] = quint16(nearest);
+            } else {
+                row[x] = uchar(nearest);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Set the raster from an image given by toImage().
+ * @param image The image.
+ * @param cells The number of cells of the raster.
+ * @param origin The world position of the top left pixel.
+ * @param scale The world size of a pixel.
+ * @return False if the image does not have the format of a raster of this number of cells.
+ */
+bool VoronoiRaster::fromImage(const QImage &image, int cells, const Vector2D &origin, float scale) {
+    if (image.format() != formatFor(cells)) {
+        return false;
+    }
+    ids = image;
+    cellCount = cells;
+    wide = cells > 256;
+    worldOrigin = origin;
+    worldScale = scale;
+    return true;
+}
+
+/**
+ * @brief Draw a part of the raster with the colours of the cells.
+ *
+ * The area is coloured in strips of stripHeight rows into a reused image, which is
+ * drawn at once. Cells without colour are drawn white.
+ *
+ * @param painter The painter, in raster coordinates.
+ * @param area The area to draw.
+ */
+void VoronoiRaster::draw(QPainter &painter, const QRect &area) const {
+    const QRect rect = area.intersected(ids.rect());
+    if (rect.isEmpty()) {
+        return;
+    }
+    if (cellCount == 0) {
+        painter.fillRect(rect, Qt::white);
+        return;
+    }
+    if (strip.width() < rect.width()) {
+        strip = QImage(rect.width(), stripHeight, QImage::Format_RGB32);
+    }
+    const QRgb white = qRgb(255, 255, 255);
+    const int colorCount = palette.size();
+    for (int top = rect.top(); top <= rect.bottom(); top += stripHeight) {
+        const int rows = qMin(stripHeight, rect.bottom() + 1 - top);
+        for (int r = 0; r < rows; r++) {
+            QRgb *out = reinterpret_cast<QRgb*>(strip.scanLine(r));
+            const uchar *row = ids.constScanLine(top + r);
+            for (int x = 0; x < rect.width(); x++) {
+                int cell = wide ? reinterpret_cast<const quint16*>(row)[rect.left() + x] : row[rect.left() + x];
+                out[x] = cell < colorCount ? palette[cell] : white;
+            }
+        }
+        painter.drawImage(QPoint(rect.left(), top), strip, QRect(0, 0, rect.width(), rows));
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * @file voronoiraster.h
+ * @brief Raster of the Voronoi cells of the servers, coloured when it is drawn.
+ *
+ * This file declares the VoronoiRaster class, which stores the index of the nearest
+ * server of each pixel instead of its colour.
+ */
+
+#ifndef VORONOIRASTER_H
+#define VORONOIRASTER_H
+
+#include <QImage>
+#include <QPainter>
+#include <QRgb>
+#include <QVector>
+#include "vector2d.h"
+
+/**
+ * @class VoronoiRaster
+ * @brief Cell index per pixel (8 or 16 bits) plus a colour table.
+ *
+ * The cell indices are stored in a grayscale QImage, 8 bits per pixel up to 256
+ * servers and 16 bits beyond, which takes a quarter (or half) of the memory of a
+ * colour image. The colours are applied by draw(), strip by strip, for the exposed
+ * area only, so that no full colour image is kept. The same raster answers cellAt()
+ * lookups with a memory read.
+ *
+ * A raster covers a square of the map: pixel (x, y) is the cell of the world position
+ * origin() + scale() * (x, y), so that the tiles of a TilePyramid are rasters at
+ * several scales. The raster only depends on the server positions and its area, not
+ * on the colours, so it can be stored as an image.
+ */
+class VoronoiRaster {
+public:
+    static constexpr int stripHeight = 32; ///< Number of rows coloured at once by draw().
+
+    /**
+     * @brief Constructs an empty raster.
+     */
+    VoronoiRaster() {}
+
+    /**
+     * @brief Compute the cell of each pixel.
+     * @param sites The positions of the servers, indexed like the cells.
+     * @param size The size of the raster.
+     * @param origin The world position of the top left pixel.
+     * @param scale The world size of a pixel.
+     */
+    void render(const QVector<Vector2D> &sites, const QSize &size, const Vector2D &origin = Vector2D(), float scale = 1);
+
+    /**
+     * @brief Update the cells of an area after a site moved.
+     *
+     * Only the pixels of the area are visited: those of the moved cell go to the nearest
+     * of the moved site and the candidates, the others go to the moved site if it is now
+     * nearer. The area must contain the old and the new cell of the site.
+     *
+     * @param sites The positions of the servers, with the new position of the moved site.
+     * @param moved The index of the moved site.
+     * @param candidates The sites that can take the pixels of the old cell (its neighbours).
+     * @param area The area to update, in world coordinates.
+     */
+    void moveSite(const QVector<Vector2D> &sites, int moved, const QVector<int> &candidates, const QRectF &area);
+
+    /**
+     * @brief Set the colour of each cell.
+     * @param colors The colours, indexed like the cells.
+     */
+    inline void setPalette(const QVector<QRgb> &colors) { palette = colors; }
+
+    /**
+     * @brief Get the cell of a pixel.
+     * @param x The column of the pixel.
+     * @param y The row of the pixel.
+     * @return The index of the cell, or -1 outside of the raster or if there is no cell.
+     */
+    inline int cellAt(int x, int y) const {
+        if (cellCount == 0 || !ids.valid(x, y)) {
+            return -1;
+        }
+        return wide ? reinterpret_cast<const quint16*>(ids.constScanLine(y))[x] : ids.constScanLine(y)[x];
+    }
+
+    /**
+     * @brief Draw a part of the raster with the colours of the cells.
+     * @param painter The painter, in raster coordinates (pixels of the raster).
+     * @param area The area to draw.
+     */
+    void draw(QPainter &painter, const QRect &area) const;
+
+    /**
+     * @brief Get the raster as a grayscale image of cell indices, to store it.
+     * @return The image (shared with the raster).
+     */
+    inline const QImage &toImage() const { return ids; }
+
+    /**
+     * @brief Set the raster from an image given by toImage().
+     * @param image The image.
+     * @param cells The number of cells of the raster.
+     * @param origin The world position of the top left pixel.
+     * @param scale The world size of a pixel.
+     * @return False if the image does not have the format of a raster of this number of cells.
+     */
+    bool fromImage(const QImage &image, int cells, const Vector2D &origin = Vector2D(), float scale = 1);
+
+    /**
+     * @brief Get the size of the raster.
+     * @return The size in pixels.
+     */
+    inline QSize size() const { return ids.size(); }
+
+    /**
+     * @brief Get the world position of the top left pixel.
+     * @return The position.
+     */
+    inline const Vector2D &origin() const { return worldOrigin; }
+
+    /**
+     * @brief Get the world size of a pixel.
+     * @return The size.
+     */
+    inline float scale() const { return worldScale; }
+
+    /**
+     * @brief Get the memory used by the cell indices.
+     * @return The size in bytes.
+     */
+    inline qsizetype memoryUsage() const { return ids.sizeInBytes(); }
+
+private:
+    /**
+     * @brief Get the image format of a raster.
+     * @param cells The number of cells.
+     * @return Format_Grayscale8 up to 256 cells, Format_Grayscale16 beyond.
+     */
+    static inline QImage::Format formatFor(int cells) { return cells <= 256 ? QImage::Format_Grayscale8 : QImage::Format_Grayscale16; }
+
+    QImage ids; ///< Cell index of each pixel.
+    int cellCount = 0; ///< Number of cells.
+    Vector2D worldOrigin; ///< World position of the top left pixel.
+    float worldScale = 1; ///< World size of a pixel.
+    bool wide = false; ///< True if the indices are 16 bits.
+    QVector<QRgb> palette; ///< Colour of each cell.
+    mutable QImage strip; ///< Colour rows of draw(), reused from one call to the next.
+};
+
+#endif // VORONOIRASTER_H
@@ -0,0 +1,76 @@
+#include "workerpool.h"
+
+/**
+ * @brief Constructs a pool and starts its threads.
+ * @param workerCount The number of worker threads in addition to the calling thread.
+ */
+WorkerPool::WorkerPool(int workerCount) {
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; i++) {
+        Worker *worker = new Worker(this);
+        worker->start();
+        workers.append(worker);
+    }
+}
+
+/**
+ * @brief Stops the threads.
+ */
+WorkerPool::~WorkerPool() {
+    function = nullptr;  // Ask the workers to stop
+    start.release(workers.size());
+    for (Worker *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+/**
+ * @brief Run tasks given as a function pointer and a context.
+ *
+ * The semaphores order the memory accesses: the phase is published before the workers
+ * are released, and the results of the workers are visible once they are all done.
+ *
+ * @param count The number of tasks.
+ * @param f The function called with the context and each task number.
+ * @param c The context given to the function.
+ */
+void WorkerPool::runTasks(int count, void (*f)(void*, int), void *c) {
+    if (count <= 0) {
+        return;
+    }
+    taskCount = count;
+    function = f;
+    context = c;
+    nextTask.store(0, std::memory_order_relaxed);
+
+    // Only wake up the workers that can get a task
+    int helpers = qMin(int(workers.size()), count - 1);
+    start.release(helpers);
+    work();
+    done.acquire(helpers);
+}
+
+/**
+ * @brief Take task numbers until there are no more, running them.
+ */
+void WorkerPool::work() {
+    for (int index = nextTask.fetch_add(1, std::memory_order_relaxed); index < taskCount;
+         index = nextTask.fetch_add(1, std::memory_order_relaxed)) {
+        function(context, index);
+    }
+}
+
+/**
+ * @brief Wait for phases and run their tasks, until the pool is destroyed.
+ */
+void WorkerPool::Worker::run() {
+    forever {
+        pool->start.acquire();
+        if (!pool->function) {
+            return;
+        }
+        pool->work();
+        pool->done.release();
+    }
+}
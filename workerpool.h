@@ -0,0 +1,94 @@
+/**
+ * @file workerpool.h
+ * @brief Persistent worker threads running the parallel phases of a simulation step.
+ *
+ * This file declares the WorkerPool class. Its threads are created once and wait on
+ * a semaphore between phases, so that running a phase neither creates threads nor
+ * allocates memory.
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <QVector>
+#include <atomic>
+
+/**
+ * @class WorkerPool
+ * @brief Runs numbered tasks on a fixed set of threads.
+ *
+ * run() hands the same function to all the workers, which take task numbers from a
+ * shared counter until all the tasks are done. The calling thread works too, so a pool
+ * of n workers uses n + 1 threads, and a pool without workers runs the tasks in order
+ * on the calling thread.
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief Constructs a pool and starts its threads.
+     * @param workerCount The number of worker threads in addition to the calling thread.
+     */
+    explicit WorkerPool(int workerCount = 0);
+
+    /**
+     * @brief Stops the threads.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * @brief Get the number of worker threads.
+     * @return The number of threads, not counting the calling thread.
+     */
+    inline int workerCount() const { return workers.size(); }
+
+    /**
+     * @brief Run tasks in parallel and wait for their completion.
+     * @param taskCount The number of tasks.
+     * @param task The function called with each task number, from 0 to taskCount - 1.
+     */
+    template<typename Function>
+    void run(int taskCount, Function &task) {
+        runTasks(taskCount, [](void *context, int index) { (*static_cast<Function*>(context))(index); }, &task);
+    }
+
+private:
+    /**
+     * @brief Thread of the pool, waiting for phases to run.
+     */
+    class Worker : public QThread {
+    public:
+        explicit Worker(WorkerPool *pool) : pool(pool) {}
+    protected:
+        void run() override;
+    private:
+        WorkerPool *pool; ///< Pool of the worker.
+    };
+
+    /**
+     * @brief Run tasks given as a function pointer and a context.
+     * @param taskCount The number of tasks.
+     * @param function The function called with the context and each task number.
+     * @param context The context given to the function.
+     */
+    void runTasks(int taskCount, void (*function)(void*, int), void *context);
+
+    /**
+     * @brief Take task numbers until there are no more, running them.
+     */
+    void work();
+
+    QVector<Worker*> workers; ///< Worker threads.
+    QSemaphore start; ///< Released once per worker to start a phase.
+    QSemaphore done; ///< Released by each worker at the end of a phase.
+    std::atomic<int> nextTask{0}; ///< Next task number to take.
+    int taskCount = 0; ///< Number of tasks of the current phase.
+    void (*function)(void*, int) = nullptr; ///< Function of the current phase, nullptr to stop the workers.
+    void *context = nullptr; ///< Context of the function of the current phase.
+};
+
+#endif // WORKERPOOL_H